@@ -0,0 +1,203 @@
+// Constrained-decoding benchmark: naive per-token grammar checks vs. the
+// precomputed TokenMaskTable (with and without jump-ahead).
+//
+// Usage: grammar_mask_bench [grammar.gbnf] [vocab_size]
+//
+// The "model" is a deterministic oracle that replays a known-valid quiz or grade payload:
+// at each step it picks the longest allowed token that continues the target text,
+// so every variant emits the same token stream and only the masking cost differs.
+
+#include "../llm/grammar_mask.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+
+using namespace studyhive::core;
+
+namespace {
+
+const char* kTargetQuiz = R"({"topic": "Cell Biology", "difficulty": "medium", "questions": [)"
+    R"({"id": "mcq_001", "type": "multiple_choice", "prompt": "What is the primary function of mitochondria?", )"
+    R"("options": [{"value": "energy_production", "label": "Energy production"}, )"
+    R"({"value": "protein_synthesis", "label": "Protein synthesis"}], )"
+    R"("correctAnswer": "energy_production", "explanation": "Mitochondria produce ATP through cellular respiration."}, )"
+    R"({"id": "saq_001", "type": "short_answer", "prompt": "Explain the process of photosynthesis.", )"
+    R"("sampleAnswer": "Plants convert light energy, carbon dioxide and water into glucose and oxygen.", )"
+    R"("rubric": [{"criterion": "Process Description", "points": 3, "keywords": ["light energy", "glucose"]}]}], )"
+    R"("metadata": {"source": "device-llm", "generatedAt": "2024-01-01T00:00:00Z", "seed": 42}})";
+
+const char* kTargetGrade = R"({"questionId": "saq_001", "totalScore": 8.5, "maxScore": 10.0, "breakdown": [)"
+    R"({"criterion": "Concept Understanding", "awardedPoints": 4.0, "maxPoints": 5.0, )"
+    R"("reasoning": "Student demonstrates good understanding of the core concept.", )"
+    R"("keywords": ["concept", "understanding"]}, )"
+    R"({"criterion": "Explanation Quality", "awardedPoints": 4.5, "maxPoints": 5.0, )"
+    R"("reasoning": "Clear and well-structured explanation with good examples.", "keywords": ["clear"]}], )"
+    R"("feedback": "Good work! Consider adding more specific examples.", )"
+    R"("metadata": {"source": "device-llm", "gradedAt": "2024-01-01T00:00:00Z", "processingTimeMs": 250.0}})";
+
+std::shared_ptr<TokenVocabulary> buildVocabulary(const std::string& target, size_t vocab_size) {
+    auto vocab = std::make_shared<TokenVocabulary>();
+    std::unordered_map<std::string, int32_t> seen;
+
+    auto add = [&](const std::string& piece) {
+        if (piece.empty() || seen.count(piece) || vocab->pieces.size() >= vocab_size) return;
+        seen[piece] = static_cast<int32_t>(vocab->pieces.size());
+        vocab->pieces.push_back(piece);
+    };
+
+    // Byte fallback tokens guarantee every string is representable
+    for (int b = 0; b < 256; ++b) add(std::string(1, static_cast<char>(b)));
+
+    // JSON-ish pieces seen in real BPE vocabularies
+    for (const char* piece : {"{\"", "\":", "\": \"", "\", \"", "\"}", "\"},", "\"]", "\": [", "\": {",
+                              "\"}]", "}]", "}}", ", ", "[{", "\"id", "\"type", "\"prompt",
+                              "_choice", "_answer", "multiple", "short", "questions", "metadata"}) {
+        add(piece);
+    }
+
+    // Word and sub-word pieces of the target text
+    for (size_t i = 0; i < target.size(); ++i) {
+        for (size_t len = 2; len <= 8 && i + len <= target.size(); ++len) {
+            add(target.substr(i, len));
+        }
+    }
+
+    // Filler tokens up to the requested vocabulary size
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> len_dist(2, 10);
+    std::uniform_int_distribution<int> char_dist(0, 61);
+    const char* alphabet = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+    while (vocab->pieces.size() + 1 < vocab_size) {
+        std::string piece = (rng() % 3 == 0) ? " " : "";
+        int len = len_dist(rng);
+        for (int i = 0; i < len; ++i) piece += alphabet[char_dist(rng)];
+        add(piece);
+    }
+
+    vocab->eos_token = static_cast<int32_t>(vocab->pieces.size());
+    vocab->pieces.push_back("");
+    return vocab;
+}
+
+struct RunResult {
+    size_t tokens = 0;
+    size_t sampled_tokens = 0;
+    size_t forced_tokens = 0;
+    double seconds = 0.0;
+    bool accepted = false;
+};
+
+// Oracle sampler: longest allowed token that continues the target
+int32_t pickToken(const TokenMaskTable::Mask& mask, const TokenVocabulary& vocab,
+                  const std::unordered_map<std::string, int32_t>& lookup,
+                  const std::string& target, size_t pos) {
+    for (size_t len = std::min<size_t>(16, target.size() - pos); len > 0; --len) {
+        auto it = lookup.find(target.substr(pos, len));
+        if (it != lookup.end() && TokenMaskTable::isSet(mask, it->second)) {
+            return it->second;
+        }
+    }
+    return vocab.eos_token;
+}
+
+enum class Mode { NAIVE, MASK_TABLE, JUMP_AHEAD };
+
+RunResult run(TokenMaskTable& table, const std::unordered_map<std::string, int32_t>& lookup,
+              const std::string& target, Mode mode, int iterations) {
+    RunResult result;
+    const auto& vocab = table.vocabulary();
+    auto start = std::chrono::steady_clock::now();
+
+    for (int iter = 0; iter < iterations; ++iter) {
+        int32_t state = table.automaton().startState();
+        size_t pos = 0;
+
+        while (pos < target.size()) {
+            if (mode == Mode::JUMP_AHEAD) {
+                int32_t next_state;
+                auto forced = table.forcedTokens(state, next_state);
+                for (int32_t token : forced) {
+                    pos += vocab.pieces[token].size();
+                }
+                result.tokens += forced.size();
+                result.forced_tokens += forced.size();
+                if (!forced.empty()) {
+                    state = next_state;
+                    continue;
+                }
+            }
+
+            int32_t token;
+            if (mode == Mode::NAIVE) {
+                auto mask = table.allowedTokensNaive(state);
+                token = pickToken(mask, vocab, lookup, target, pos);
+            } else {
+                auto mask = table.allowedTokens(state);
+                token = pickToken(*mask, vocab, lookup, target, pos);
+            }
+
+            if (token == vocab.eos_token) break;
+            state = table.acceptToken(state, token);
+            pos += vocab.pieces[token].size();
+            result.tokens++;
+            result.sampled_tokens++;
+        }
+
+        result.accepted = table.automaton().isAccepting(state) && pos == target.size();
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+void report(const char* name, const RunResult& result) {
+    std::cout << "  " << name << ": " << static_cast<size_t>(result.tokens / result.seconds)
+              << " tokens/sec, " << result.sampled_tokens << " sampled + "
+              << result.forced_tokens << " forced tokens"
+              << (result.accepted ? "" : " [OUTPUT REJECTED]") << "\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string grammar_path = argc > 1 ? argv[1] : "core/grammars/quiz.gbnf";
+    size_t vocab_size = argc > 2 ? std::stoul(argv[2]) : 32000;
+
+    std::string error_msg;
+    auto automaton = GrammarAutomaton::compileFile(grammar_path, error_msg);
+    if (!automaton) {
+        std::cerr << "Grammar compilation failed: " << error_msg << "\n";
+        return 1;
+    }
+
+    // Replay whichever reference payload the grammar accepts
+    std::string target = kTargetQuiz;
+    if (!automaton->isAccepting(automaton->advance(automaton->startState(), target))) {
+        target = kTargetGrade;
+    }
+    auto vocab = buildVocabulary(target, vocab_size);
+    std::unordered_map<std::string, int32_t> lookup;
+    for (size_t i = 0; i < vocab->pieces.size(); ++i) {
+        if (!vocab->pieces[i].empty()) lookup[vocab->pieces[i]] = static_cast<int32_t>(i);
+    }
+
+    TokenMaskTable table(automaton, vocab);
+
+    auto precompute_start = std::chrono::steady_clock::now();
+    table.precompute();
+    double precompute_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - precompute_start).count();
+    auto stats = table.getStats();
+
+    std::cout << "grammar: " << grammar_path << " (" << automaton->stateCount() << " DFA states)\n"
+              << "vocabulary: " << vocab->pieces.size() << " tokens\n"
+              << "precompute: " << precompute_ms << " ms, " << stats.precomputed_states << " states, "
+              << stats.mask_bytes / 1024 << " KiB of masks\n";
+
+    report("naive per-token check", run(table, lookup, target, Mode::NAIVE, 1));
+    report("precomputed masks    ", run(table, lookup, target, Mode::MASK_TABLE, 20));
+    report("masks + jump-ahead   ", run(table, lookup, target, Mode::JUMP_AHEAD, 20));
+
+    return 0;
+}
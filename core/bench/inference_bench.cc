@@ -0,0 +1,317 @@
+// Inference benchmark for LLMBridge: time-to-first-token, tokens/sec, the
+// prefill/decode split and prompt-build time over a matrix of n_threads,
+// n_batch, n_ctx, prompt lengths and grammar on/off.
+//
+// Usage: inference_bench [--model model.gguf] [--out results.json] [--repeats N]
+//                        [--grammar-dir core/grammars] [--schema-dir core/schemas]
+//
+// With --model the bridge runs the given model as-is. Without it the bridge's
+// synthetic backend simulates fixed per-token costs, so runs are reproducible
+// and the pipeline overhead (prompt build, segment cache, validation) can be
+// read off on its own. Results are written as JSON (stdout without --out).
+
+#include "../llm/llama_bridge.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+using namespace studyhive::core;
+
+namespace {
+
+const char* kNotesSentences[] = {
+    "Photosynthesis converts light energy into chemical energy stored in glucose.",
+    "The light-dependent reactions take place in the thylakoid membranes of the chloroplast.",
+    "Water is split during the light reactions, releasing oxygen as a by-product.",
+    "The Calvin cycle fixes carbon dioxide into three-carbon sugars using ATP and NADPH.",
+    "Chlorophyll absorbs mostly blue and red light and reflects green light.",
+    "Stomata regulate gas exchange and water loss in the leaves of the plant.",
+    "Cellular respiration releases the energy stored in glucose to produce ATP.",
+    "Mitochondria are the site of the Krebs cycle and the electron transport chain."
+};
+
+// Deterministic notes of roughly the requested word count
+std::string makeNotes(size_t words) {
+    std::string notes;
+    size_t count = 0;
+    for (size_t i = 0; count < words; ++i) {
+        const std::string sentence = kNotesSentences[i % std::size(kNotesSentences)];
+        notes += sentence + ((i % 4 == 3) ? "\n\n" : " ");
+        count += std::count(sentence.begin(), sentence.end(), ' ') + 1;
+    }
+    return notes;
+}
+
+double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+double median(std::vector<double> values) {
+    if (values.empty()) return 0.0;
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+struct BenchOptions {
+    std::string model_path;
+    std::string out_path;
+    std::string grammar_dir = "core/grammars";
+    std::string schema_dir = "core/schemas";
+    int repeats = 3;
+};
+
+struct RunSample {
+    double prompt_build_ms = 0.0;  // Segment construction + tokenization
+    double prefill_ms = 0.0;
+    double ttft_ms = 0.0;
+    double decode_ms = 0.0;
+    double validation_ms = 0.0;
+    double total_ms = 0.0;
+    int prompt_tokens = 0;
+    int tokens_generated = 0;
+    int forced_tokens = 0;
+    bool success = false;
+};
+
+// Quiz prompt as requests build it: notes budgeted to fit the bridge's context
+PromptSegments quizPrompt(const LLMBridge& bridge, const std::string& notes) {
+    return prompts::buildQuizPromptSegments("Photosynthesis", "medium", 3, notes,
+                                            [&bridge](const std::string& text) { return bridge.countTokens(text); },
+                                            bridge.promptTokenBudget());
+}
+
+RunSample runQuiz(LLMBridge& bridge, const std::string& notes, const std::string& grammar_path) {
+    RunSample sample;
+    auto start = std::chrono::steady_clock::now();
+
+    PromptSegments prompt = quizPrompt(bridge, notes);
+    double segment_ms = msSince(start);
+
+    LLMResponse response = bridge.generateQuizAsync(prompt, grammar_path).get();
+
+    auto validation_start = std::chrono::steady_clock::now();
+    Quiz quiz;
+    std::string error_msg;
+    bool valid = response.success &&
+                 validation::parseQuiz(bridge.responseSchemas(), response.content, quiz, error_msg);
+    sample.validation_ms = msSince(validation_start);
+
+    sample.total_ms = msSince(start);
+    sample.prompt_build_ms = segment_ms + response.prompt_build_time_ms;
+    sample.prefill_ms = response.prefill_time_ms;
+    sample.ttft_ms = segment_ms + response.time_to_first_token_ms;
+    sample.decode_ms = response.decode_time_ms;
+    sample.prompt_tokens = response.prompt_tokens;
+    sample.tokens_generated = response.tokens_generated;
+    sample.forced_tokens = response.forced_tokens;
+    sample.success = valid;
+    return sample;
+}
+
+nlohmann::json summarize(const std::vector<RunSample>& samples) {
+    auto pick = [&](double RunSample::*field) {
+        std::vector<double> values;
+        for (const auto& sample : samples) values.push_back(sample.*field);
+        return median(values);
+    };
+
+    double decode_ms = pick(&RunSample::decode_ms);
+    int tokens = samples.front().tokens_generated;
+    bool success = std::all_of(samples.begin(), samples.end(), [](const RunSample& s) { return s.success; });
+
+    return {
+        {"prompt_tokens", samples.front().prompt_tokens},
+        {"tokens_generated", tokens},
+        {"forced_tokens", samples.front().forced_tokens},
+        {"prompt_build_ms", pick(&RunSample::prompt_build_ms)},
+        {"prefill_ms", pick(&RunSample::prefill_ms)},
+        {"ttft_ms", pick(&RunSample::ttft_ms)},
+        {"decode_ms", decode_ms},
+        // The first token is part of TTFT
+        {"tokens_per_sec", decode_ms > 0.0 ? (tokens - 1) * 1000.0 / decode_ms : 0.0},
+        {"validation_ms", pick(&RunSample::validation_ms)},
+        {"total_ms", pick(&RunSample::total_ms)},
+        {"success", success}
+    };
+}
+
+// Pipeline cost with the model cost removed: prompt build with a cold and a
+// warm segment cache, and validation of the output
+nlohmann::json measurePipeline(const LLMConfig& base, const std::string& notes, int iterations) {
+    LLMConfig config = base;
+    config.synthetic = SyntheticCosts();
+
+    std::vector<double> cold, warm, validation;
+    LLMBridge warm_bridge;
+    warm_bridge.initialize(config);
+
+    for (int i = 0; i < iterations; ++i) {
+        LLMBridge cold_bridge;
+        cold_bridge.initialize(config);
+        auto start = std::chrono::steady_clock::now();
+        cold_bridge.tokenizePrompt(quizPrompt(cold_bridge, notes));
+        cold.push_back(msSince(start));
+
+        start = std::chrono::steady_clock::now();
+        warm_bridge.tokenizePrompt(quizPrompt(warm_bridge, notes));
+        warm.push_back(msSince(start));
+    }
+
+    LLMResponse response = warm_bridge.generateQuizAsync(quizPrompt(warm_bridge, notes), config.grammar_path).get();
+    validation::ResponseSchemas schemas = warm_bridge.responseSchemas();
+    for (int i = 0; i < iterations; ++i) {
+        Quiz quiz;
+        std::string error_msg;
+        auto start = std::chrono::steady_clock::now();
+        validation::parseQuiz(schemas, response.content, quiz, error_msg);
+        validation.push_back(msSince(start));
+    }
+
+    return {
+        {"prompt_tokens", response.prompt_tokens},
+        {"prompt_build_cold_ms", median(cold)},
+        {"prompt_build_warm_ms", median(warm)},
+        {"validation_ms", median(validation)},
+        {"request_overhead_ms", response.processing_time_ms}
+    };
+}
+
+bool parseArgs(int argc, char** argv, BenchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) return false;
+        std::string value = argv[++i];
+        if (arg == "--model") options.model_path = value;
+        else if (arg == "--out") options.out_path = value;
+        else if (arg == "--repeats") options.repeats = std::max(1, std::stoi(value));
+        else if (arg == "--grammar-dir") options.grammar_dir = value;
+        else if (arg == "--schema-dir") options.schema_dir = value;
+        else return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    if (!parseArgs(argc, argv, options)) {
+        std::cerr << "Usage: inference_bench [--model model.gguf] [--out results.json] [--repeats N]"
+                     " [--grammar-dir dir] [--schema-dir dir]\n";
+        return 1;
+    }
+
+    // Each bridge compiles its own; this only reports a bad --schema-dir up front
+    std::string error_msg;
+    validation::ResponseSchemas schemas;
+    if (!validation::loadSchemas(options.schema_dir, schemas, error_msg)) {
+        std::cerr << "Schema loading failed: " << error_msg << "\n";
+        return 1;
+    }
+
+    LLMConfig base;
+    base.grammar_path = options.grammar_dir + "/quiz.gbnf";
+    base.schema_dir = options.schema_dir;
+    bool synthetic = options.model_path.empty();
+    if (!synthetic && !std::filesystem::exists(options.model_path)) {
+        std::cerr << "Model not found: " << options.model_path << "\n";
+        return 1;
+    }
+
+    if (synthetic) {
+        // The mock bridge only checks that a model file exists
+        base.model_path = (std::filesystem::temp_directory_path() / "studyhive_synthetic.gguf").string();
+        std::ofstream(base.model_path).put('\0');
+
+        // Scaled down so the whole matrix runs in about a minute; the prefill/decode
+        // ratio follows a 4-bit model on a laptop CPU
+        base.synthetic.prefill_us_per_token = 400.0f;
+        base.synthetic.decode_us_per_token = 2400.0f;
+        base.synthetic.context_us_per_token = 0.05f;
+        base.synthetic.batch_overhead_us = 200.0f;
+        base.synthetic.grammar_us_per_token = 30.0f;
+    } else {
+        base.model_path = options.model_path;
+    }
+
+    nlohmann::json results;
+    results["backend"] = synthetic ? "synthetic" : "model";
+    results["model"] = base.model_path;
+    results["repeats"] = options.repeats;
+    if (synthetic) {
+        results["synthetic_costs"] = {
+            {"prefill_us_per_token", base.synthetic.prefill_us_per_token},
+            {"decode_us_per_token", base.synthetic.decode_us_per_token},
+            {"context_us_per_token", base.synthetic.context_us_per_token},
+            {"batch_overhead_us", base.synthetic.batch_overhead_us},
+            {"grammar_us_per_token", base.synthetic.grammar_us_per_token}
+        };
+    }
+
+    const std::vector<size_t> notes_words = {0, 400, 1600};
+    const std::vector<int> thread_counts = {1, 4, 8};
+    const std::vector<int> batch_sizes = {64, 512};
+    const std::vector<int> context_sizes = {2048, 4096};
+
+    results["pipeline"] = nlohmann::json::array();
+    for (size_t words : notes_words) {
+        nlohmann::json entry = measurePipeline(base, makeNotes(words), 50);
+        entry["notes_words"] = words;
+        results["pipeline"].push_back(entry);
+    }
+
+    results["runs"] = nlohmann::json::array();
+    for (size_t words : notes_words) {
+        std::string notes = makeNotes(words);
+        for (int n_ctx : context_sizes) {
+            for (int n_threads : thread_counts) {
+                for (int n_batch : batch_sizes) {
+                    for (bool use_grammar : {true, false}) {
+                        LLMConfig config = base;
+                        config.n_ctx = n_ctx;
+                        config.n_threads = n_threads;
+                        config.n_batch = n_batch;
+
+                        LLMBridge bridge;
+                        if (!bridge.initialize(config)) {
+                            std::cerr << "Failed to initialize " << config.model_path << "\n";
+                            return 1;
+                        }
+
+                        std::string grammar_path = use_grammar ? config.grammar_path : "";
+                        std::vector<RunSample> samples;
+                        for (int r = 0; r < options.repeats; ++r) {
+                            samples.push_back(runQuiz(bridge, notes, grammar_path));
+                        }
+
+                        nlohmann::json run = summarize(samples);
+                        run["notes_words"] = words;
+                        run["n_ctx"] = n_ctx;
+                        run["n_threads"] = n_threads;
+                        run["n_batch"] = n_batch;
+                        run["grammar"] = use_grammar;
+                        run["fits_context"] = run["prompt_tokens"].get<int>() +
+                                              run["tokens_generated"].get<int>() <= n_ctx;
+                        results["runs"].push_back(run);
+
+                        std::cerr << "notes=" << words << " ctx=" << n_ctx << " threads=" << n_threads
+                                  << " batch=" << n_batch << " grammar=" << use_grammar
+                                  << ": ttft " << run["ttft_ms"].get<double>() << " ms, "
+                                  << run["tokens_per_sec"].get<double>() << " tok/s\n";
+                    }
+                }
+            }
+        }
+    }
+
+    if (options.out_path.empty()) {
+        std::cout << results.dump(2) << "\n";
+    } else {
+        std::ofstream out(options.out_path);
+        out << results.dump(2) << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,325 @@
+// Notes parsing benchmark: the previous five std::regex passes vs. the
+// single-pass parsing::scanContent, on generated lecture notes of growing size,
+// then allocation count and peak heap of ParsedContent vs. ParsedSpans at 1 MB,
+// then scanContentParallel on 8 MB of notes per thread count, then
+// IncrementalParser on a one-sentence edit of those notes, then streaming a
+// large notes file through parseNotesFile with sentences passed on, not kept.
+//
+// Usage: notes_parse_bench [max_kilobytes] [seed] [stream_megabytes]
+//
+// Also checks that all produce identical ParsedContent for every input,
+// including sentences built to hit the regex corner cases ("e.g." followed by
+// a word, cue words inside other words, digits glued to capitalized words).
+
+#include "../rules/qgen_rules.h"
+#include "../rules/incremental_parser.h"
+#include "../rules/notes_stream.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <random>
+#include <regex>
+#include <sstream>
+#include <thread>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+using namespace studyhive::core;
+
+namespace {
+
+// Heap accounting for the global operator new below (single-threaded)
+struct HeapStats {
+    size_t allocations = 0;
+    size_t live_bytes = 0;
+    size_t peak_bytes = 0;
+};
+
+HeapStats g_heap;
+
+// Blocks carry their size in a header of at least max_align_t, so every
+// replaced operator delete below can account for and free what any operator
+// new returned
+void* countedAlloc(std::size_t size, std::size_t alignment) {
+    size_t header = std::max(alignment, alignof(std::max_align_t));
+    size_t total = (size + header + alignment - 1) / alignment * alignment;
+    void* block = alignment > alignof(std::max_align_t) ? std::aligned_alloc(alignment, total)
+                                                        : std::malloc(total);
+    if (!block) return nullptr;
+    *static_cast<size_t*>(block) = size;
+    g_heap.allocations++;
+    g_heap.live_bytes += size;
+    g_heap.peak_bytes = std::max(g_heap.peak_bytes, g_heap.live_bytes);
+    return static_cast<char*>(block) + header;
+}
+
+void countedFree(void* ptr, std::size_t alignment) noexcept {
+    if (!ptr) return;
+    size_t header = std::max(alignment, alignof(std::max_align_t));
+    char* block = static_cast<char*>(ptr) - header;
+    g_heap.live_bytes -= *reinterpret_cast<size_t*>(block);
+    std::free(block);
+}
+
+void* countedNew(std::size_t size, std::size_t alignment) {
+    void* ptr = countedAlloc(size, alignment);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+constexpr size_t kDefaultAlignment = alignof(std::max_align_t);
+
+} // namespace
+
+void* operator new(std::size_t size) { return countedNew(size, kDefaultAlignment); }
+void* operator new[](std::size_t size) { return countedNew(size, kDefaultAlignment); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size, kDefaultAlignment); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size, kDefaultAlignment); }
+void* operator new(std::size_t size, std::align_val_t al) { return countedNew(size, static_cast<size_t>(al)); }
+void* operator new[](std::size_t size, std::align_val_t al) { return countedNew(size, static_cast<size_t>(al)); }
+
+void operator delete(void* ptr) noexcept { countedFree(ptr, kDefaultAlignment); }
+void operator delete[](void* ptr) noexcept { countedFree(ptr, kDefaultAlignment); }
+void operator delete(void* ptr, std::size_t) noexcept { countedFree(ptr, kDefaultAlignment); }
+void operator delete[](void* ptr, std::size_t) noexcept { countedFree(ptr, kDefaultAlignment); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { countedFree(ptr, kDefaultAlignment); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { countedFree(ptr, kDefaultAlignment); }
+void operator delete(void* ptr, std::align_val_t al) noexcept { countedFree(ptr, static_cast<size_t>(al)); }
+void operator delete[](void* ptr, std::align_val_t al) noexcept { countedFree(ptr, static_cast<size_t>(al)); }
+void operator delete(void* ptr, std::size_t, std::align_val_t al) noexcept { countedFree(ptr, static_cast<size_t>(al)); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t al) noexcept { countedFree(ptr, static_cast<size_t>(al)); }
+
+namespace {
+
+// The extract* implementations parseContent used before the scanner
+std::string regexClean(const std::string& text) {
+    std::string cleaned = std::regex_replace(text, std::regex(R"(\s+)"), " ");
+    cleaned.erase(0, cleaned.find_first_not_of(" \t\n\r"));
+    cleaned.erase(cleaned.find_last_not_of(" \t\n\r") + 1);
+    return cleaned;
+}
+
+std::vector<std::string> regexMatches(const std::string& text, const std::regex& pattern) {
+    std::vector<std::string> matches;
+    for (std::sregex_iterator iter(text.begin(), text.end(), pattern), end; iter != end; ++iter) {
+        matches.push_back(iter->str());
+    }
+    return matches;
+}
+
+ParsedContent regexParse(const std::string& text) {
+    static const std::regex concept_pattern(R"(\b[A-Z][a-zA-Z]*(?:\s+[A-Z][a-zA-Z]*)*\b)");
+    static const std::regex definition_pattern(R"([^.]*\b(is|are|means|refers to|can be defined as)\b[^.]*\.)",
+                                               std::regex_constants::icase);
+    static const std::regex formula_pattern(R"([^.]*[=+\-*/^()0-9\s]+[^.]*\.)");
+    static const std::regex example_pattern(R"([^.]*\b(for example|such as|including|e\.g\.)\b[^.]*\.)",
+                                            std::regex_constants::icase);
+    static const std::regex keyword_pattern(R"(\b[a-zA-Z]{4,}\b)");
+
+    ParsedContent content;
+    for (auto& match : regexMatches(text, concept_pattern)) {
+        if (match.length() > 2 && match.length() < 50) content.concepts.push_back(match);
+    }
+    for (auto& match : regexMatches(text, definition_pattern)) {
+        content.definitions.push_back(regexClean(match));
+    }
+    for (auto& match : regexMatches(text, formula_pattern)) {
+        if (match.find('=') != std::string::npos) content.formulas.push_back(regexClean(match));
+    }
+    for (auto& match : regexMatches(text, example_pattern)) {
+        content.examples.push_back(regexClean(match));
+    }
+    for (auto& match : regexMatches(text, keyword_pattern)) {
+        if (match.length() <= 20) content.keywords.push_back(match);
+    }
+    for (auto* values : {&content.concepts, &content.keywords}) {
+        std::sort(values->begin(), values->end());
+        values->erase(std::unique(values->begin(), values->end()), values->end());
+    }
+    return content;
+}
+
+const char* kSentences[] = {
+    "Photosynthesis is the process by which Green Plants convert light energy into chemical energy.",
+    "The Krebs Cycle refers to a series of reactions in the Mitochondrial Matrix.",
+    "Kinetic energy can be defined as E = 1/2 m v^2 for a body of mass m.",
+    "Many organelles, such as ribosomes and lysosomes, are found in Eukaryotic Cells.",
+    "Newton's second law states that F = m * a, for example when a cart accelerates.",
+    "Cell division happens in stages including prophase, metaphase and anaphase.",
+    "Enzymes lower activation energy, e.g.catalase breaks down hydrogen peroxide.",
+    "Water boils at 100 degrees Celsius at sea level.",
+    "This island has 3 species; Isotopes of Carbon14 decay slowly.",
+    "The ratio (a + b) / c means the sum divided by c.",
+    "DNA Replication is semiconservative\n\nand happens during the S phase.",
+    "Notes:\tsee Chapter 4 for the derivation of pV = nRT.",
+};
+
+std::string makeNotes(size_t bytes, std::mt19937& rng) {
+    std::string notes;
+    std::uniform_int_distribution<size_t> pick(0, sizeof(kSentences) / sizeof(kSentences[0]) - 1);
+    while (notes.size() < bytes) {
+        notes += kSentences[pick(rng)];
+        notes += (rng() % 5 == 0) ? "\n\n" : " ";
+    }
+    return notes;
+}
+
+bool sameContent(const ParsedContent& a, const ParsedContent& b) {
+    return a.concepts == b.concepts && a.definitions == b.definitions && a.formulas == b.formulas &&
+           a.examples == b.examples && a.keywords == b.keywords;
+}
+
+template <typename Fn>
+double msPerParse(const std::string& notes, int repeats, Fn&& parse, ParsedContent& out) {
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r) out = parse(notes);
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / repeats;
+}
+
+// Peak resident set of the process so far, 0 where unknown
+long maxResidentKB() {
+#ifndef _WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+        return usage.ru_maxrss / 1024;
+#else
+        return usage.ru_maxrss;
+#endif
+    }
+#endif
+    return 0;
+}
+
+// Allocations and peak heap while parsing, and heap still held by the result
+template <typename Fn>
+void reportHeap(const char* name, Fn&& parse) {
+    HeapStats before = g_heap;
+    g_heap.peak_bytes = g_heap.live_bytes;
+    {
+        [[maybe_unused]] auto result = parse();
+        std::cout << "  " << name << ": " << (g_heap.allocations - before.allocations) << " allocations, peak "
+                  << (g_heap.peak_bytes - before.live_bytes) / 1024 << " KB, result holds "
+                  << (g_heap.live_bytes - before.live_bytes) / 1024 << " KB\n";
+    }
+    g_heap.peak_bytes = std::max(g_heap.peak_bytes, before.peak_bytes);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t max_kb = argc > 1 ? std::stoul(argv[1]) : 1024;
+    unsigned seed = argc > 2 ? static_cast<unsigned>(std::stoul(argv[2])) : 42;
+    size_t stream_mb = argc > 3 ? std::stoul(argv[3]) : 100;
+    std::mt19937 rng(seed);
+    bool all_match = true;
+
+    for (size_t kb = 4; kb <= max_kb; kb *= 4) {
+        std::string notes = makeNotes(kb * 1024, rng);
+        int repeats = kb <= 64 ? 5 : 1;
+
+        ParsedContent expected, actual;
+        double regex_ms = msPerParse(notes, repeats, regexParse, expected);
+        double scan_ms = msPerParse(notes, repeats, parsing::scanContent, actual);
+
+        bool match = sameContent(expected, actual);
+        all_match = all_match && match;
+        std::cout << kb << " KB: regex " << regex_ms << " ms, scanner " << scan_ms << " ms ("
+                  << (scan_ms > 0.0 ? regex_ms / scan_ms : 0.0) << "x), "
+                  << actual.concepts.size() << " concepts, " << actual.definitions.size() << " definitions, "
+                  << actual.formulas.size() << " formulas, " << actual.examples.size() << " examples, "
+                  << actual.keywords.size() << " keywords" << (match ? "" : " [RESULTS DIFFER]") << "\n";
+    }
+
+    auto notes = std::make_shared<const std::string>(makeNotes(1024 * 1024, rng));
+    std::cout << "\nheap, 1 MB notes\n";
+    reportHeap("ParsedContent", [&] { return parsing::scanContent(*notes); });
+    reportHeap("ParsedSpans", [&] { return parsing::scanSpans(notes); });
+    reportHeap("ParsedSpans + text()", [&] {
+        auto spans = parsing::scanSpans(notes);
+        size_t chars = 0;
+        for (const auto& span : spans.definitions) chars += spans.text(span).size();
+        return chars;
+    });
+    all_match = all_match && sameContent(parsing::scanSpans(notes).materialize(), parsing::scanContent(*notes));
+
+    std::string large = makeNotes(8 * 1024 * 1024, rng);
+    ParsedContent serial;
+    double serial_ms = msPerParse(large, 1, parsing::scanContent, serial);
+    std::cout << "\nparallel, 8 MB notes (serial " << serial_ms << " ms)\n";
+    int max_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        ParallelParseOptions options;
+        options.threads = threads;
+        ParsedContent parallel;
+        double parallel_ms = msPerParse(large, 1, [&](const std::string& text) {
+            return parsing::scanContentParallel(text, options);
+        }, parallel);
+
+        bool match = sameContent(serial, parallel);
+        all_match = all_match && match;
+        std::cout << "  " << threads << " threads: " << parallel_ms << " ms (" << serial_ms / parallel_ms
+                  << "x)" << (match ? "" : " [RESULTS DIFFER]") << "\n";
+    }
+
+    IncrementalParser incremental;
+    auto first = incremental.update(large);
+    size_t edit_at = large.find("Water boils", large.size() / 2);
+    if (edit_at == std::string::npos) edit_at = large.size() / 2;
+    large.replace(edit_at, 5, "Steam");
+    auto edited = incremental.update(large, TextEdit{edit_at, 5, 5});
+    large.replace(edit_at, 5, "Water");
+    auto diffed = incremental.update(large);
+    double full_ms = msPerParse(large, 1, parsing::scanContent, serial);
+    bool match = sameContent(serial, incremental.content());
+    all_match = all_match && match;
+    std::cout << "\nincremental, 8 MB notes: first update " << first.time_ms << " ms (" << first.paragraphs
+              << " paragraphs), one-word edit " << edited.time_ms << " ms (" << edited.reparsed_paragraphs
+              << " paragraphs, " << edited.reparsed_bytes << " bytes re-parsed, " << edited.word_updates
+              << " word updates), same edit undone without a range " << diffed.time_ms << " ms, full scan "
+              << full_ms << " ms" << (match ? "" : " [RESULTS DIFFER]") << "\n";
+
+    // Same results as the in-memory scan, whatever the window
+    NotesStreamOptions small_windows;
+    small_windows.window_bytes = 4096;
+    std::istringstream input(large);
+    ParsedContent streamed;
+    NotesStreamStats stream_stats;
+    std::string error;
+    match = parseNotesStream(input, small_windows, streamed, stream_stats, error) && sameContent(serial, streamed);
+    all_match = all_match && match;
+    std::cout << "\nstream, 8 MB notes in 4 KB windows: " << stream_stats.time_ms << " ms, peak pending "
+              << stream_stats.peak_pending_bytes << " bytes" << (match ? "" : " [RESULTS DIFFER]") << "\n";
+    large.clear();
+    large.shrink_to_fit();
+
+    auto path = std::filesystem::temp_directory_path() / "notes_parse_bench.txt";
+    {
+        std::ofstream file(path, std::ios::binary);
+        std::string block = makeNotes(1024 * 1024, rng);
+        for (size_t mb = 0; mb < stream_mb; ++mb) file << block;
+    }
+    size_t sentences = 0;
+    NotesStreamOptions options;
+    options.on_sentences = [&](ParsedContent&& part) {
+        sentences += part.definitions.size() + part.formulas.size() + part.examples.size();
+    };
+    long rss_before = maxResidentKB();
+    if (parseNotesFile(path.string(), options, streamed, stream_stats, error)) {
+        std::cout << "stream, " << stream_mb << " MB file: " << stream_stats.time_ms << " ms, " << sentences
+                  << " sentences, peak pending " << stream_stats.peak_pending_bytes / 1024
+                  << " KB, max RSS " << rss_before / 1024 << " -> " << maxResidentKB() / 1024 << " MB\n";
+    } else {
+        std::cout << "stream: " << error << "\n";
+        all_match = false;
+    }
+    std::filesystem::remove(path);
+
+    return all_match ? 0 : 1;
+}
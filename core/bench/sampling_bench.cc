@@ -0,0 +1,161 @@
+// Sampling microbenchmark: a sort-everything reference sampler vs. the fused
+// TokenSampler kernels (scalar and vectorized) per vocabulary size, with no
+// grammar mask, a dense mask and a sparse one.
+//
+// Usage: sampling_bench [iterations]
+//
+// Also checks that the scalar and vectorized kernels pick the same token
+// stream for the same seed.
+
+#include "../llm/sampler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+using namespace studyhive::core;
+
+namespace {
+
+// Textbook sampler: full sort, std::exp softmax, top-k then top-p
+int32_t referenceSample(const std::vector<float>& logits, const TokenMaskTable::Mask* mask,
+                        const SamplingParams& params, std::mt19937& rng) {
+    std::vector<std::pair<float, int32_t>> items;
+    for (size_t i = 0; i < logits.size(); ++i) {
+        if (!mask || TokenMaskTable::isSet(*mask, static_cast<int32_t>(i))) {
+            items.emplace_back(logits[i] / params.temperature, static_cast<int32_t>(i));
+        }
+    }
+    if (items.empty()) return -1;
+
+    std::sort(items.begin(), items.end(), [](const auto& a, const auto& b) {
+        return a.first > b.first || (a.first == b.first && a.second < b.second);
+    });
+    if (params.top_k > 0 && items.size() > static_cast<size_t>(params.top_k)) {
+        items.resize(params.top_k);
+    }
+
+    std::vector<float> probs;
+    float sum = 0.0f;
+    for (const auto& item : items) {
+        probs.push_back(std::exp(item.first - items.front().first));
+        sum += probs.back();
+    }
+
+    size_t keep = probs.size();
+    float covered = 0.0f;
+    for (size_t i = 0; i < probs.size(); ++i) {
+        covered += probs[i];
+        if (covered >= params.top_p * sum) {
+            keep = i + 1;
+            break;
+        }
+    }
+
+    std::discrete_distribution<size_t> pick(probs.begin(), probs.begin() + keep);
+    return items[pick(rng)].second;
+}
+
+struct MaskCase {
+    const char* name;
+    std::unique_ptr<TokenMaskTable::Mask> mask;
+};
+
+std::vector<MaskCase> makeMasks(size_t n_vocab, std::mt19937& rng) {
+    std::vector<MaskCase> cases;
+    cases.push_back({"no mask", nullptr});
+
+    auto dense = std::make_unique<TokenMaskTable::Mask>((n_vocab + 63) / 64, 0);
+    for (size_t i = 0; i < n_vocab; ++i) {
+        if (rng() % 2) (*dense)[i >> 6] |= uint64_t(1) << (i & 63);
+    }
+    cases.push_back({"dense mask (50%)", std::move(dense)});
+
+    // Typical JSON-grammar state: a few dozen allowed tokens
+    auto sparse = std::make_unique<TokenMaskTable::Mask>((n_vocab + 63) / 64, 0);
+    for (int i = 0; i < 32; ++i) {
+        size_t token = rng() % n_vocab;
+        (*sparse)[token >> 6] |= uint64_t(1) << (token & 63);
+    }
+    cases.push_back({"sparse mask (32)", std::move(sparse)});
+    return cases;
+}
+
+template <typename SampleFn>
+double nsPerSample(const std::vector<std::vector<float>>& logits, int iterations, SampleFn&& sample,
+                   std::vector<int32_t>& tokens) {
+    tokens.clear();
+    auto start = std::chrono::steady_clock::now();
+    for (int iter = 0; iter < iterations; ++iter) {
+        tokens.push_back(sample(logits[iter % logits.size()]));
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+           iterations;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::stoi(argv[1]) : 200;
+
+    struct ParamCase {
+        const char* name;
+        SamplingParams params;
+    };
+
+    std::vector<ParamCase> param_cases(3);
+    param_cases[0].name = "top-k 40, top-p 0.95";
+    param_cases[1].name = "top-p 0.95 only";
+    param_cases[1].params.top_k = 0;
+    param_cases[2].name = "greedy";
+    param_cases[2].params.temperature = 0.0f;
+
+    std::cout << "kernels: " << sampling::kernelName() << "\n";
+    bool all_match = true;
+
+    for (size_t n_vocab : {32000, 50257, 128256, 151936}) {
+        std::mt19937 rng(42);
+        std::normal_distribution<float> dist(0.0f, 3.0f);
+        std::vector<std::vector<float>> logits(8, std::vector<float>(n_vocab));
+        for (auto& row : logits) {
+            for (float& value : row) value = dist(rng);
+        }
+        auto masks = makeMasks(n_vocab, rng);
+
+        std::cout << "\nvocabulary " << n_vocab << "\n";
+        for (const auto& param_case : param_cases) {
+            for (const auto& mask_case : masks) {
+                const TokenMaskTable::Mask* mask = mask_case.mask.get();
+                std::vector<int32_t> ref_tokens, scalar_tokens, vector_tokens;
+
+                std::mt19937 ref_rng(param_case.params.seed);
+                double ref_ns = param_case.params.temperature <= 0.0f ? 0.0 :
+                    nsPerSample(logits, iterations, [&](const std::vector<float>& row) {
+                        return referenceSample(row, mask, param_case.params, ref_rng);
+                    }, ref_tokens);
+
+                SamplingParams scalar_params = param_case.params;
+                scalar_params.vectorized = false;
+                TokenSampler scalar(scalar_params);
+                double scalar_ns = nsPerSample(logits, iterations, [&](const std::vector<float>& row) {
+                    return scalar.sample(row.data(), row.size(), mask);
+                }, scalar_tokens);
+
+                TokenSampler vectorized(param_case.params);
+                double vector_ns = nsPerSample(logits, iterations, [&](const std::vector<float>& row) {
+                    return vectorized.sample(row.data(), row.size(), mask);
+                }, vector_tokens);
+
+                bool match = scalar_tokens == vector_tokens;
+                all_match = all_match && match;
+                std::cout << "  " << param_case.name << ", " << mask_case.name << ": ";
+                if (ref_ns > 0.0) std::cout << "reference " << static_cast<long>(ref_ns) << " ns, ";
+                std::cout << "scalar " << static_cast<long>(scalar_ns) << " ns, "
+                          << sampling::kernelName() << " " << static_cast<long>(vector_ns) << " ns"
+                          << (match ? "" : " [TOKEN STREAMS DIFFER]") << "\n";
+            }
+        }
+    }
+
+    return all_match ? 0 : 1;
+}
@@ -1,4 +1,5 @@
 #include "kv_store.h"
+#include "../memory/memory_governor.h"
 #include <fstream>
 #include <sstream>
 #include <algorithm>
@@ -13,7 +14,7 @@ KVStore::KVStore(size_t max_size_bytes)
 }
 
 KVStore::~KVStore() {
-    std::lock_guard<std::mutex> lock(mutex_);
+    memory_registration_.reset();
     clear();
 }
 
@@ -69,6 +70,11 @@ bool KVStore::get(const std::string& key, std::string& value, std::string& sourc
     return false;
 }
 
+bool KVStore::get(const std::string& key, std::string& value) {
+    std::string source;
+    return get(key, value, source);
+}
+
 bool KVStore::remove(const std::string& key) {
     std::lock_guard<std::mutex> lock(mutex_);
     
@@ -311,6 +317,29 @@ void KVStore::cleanupOldEntries(size_t max_entries) {
     }
 }
 
+size_t KVStore::shrink(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t freed = 0;
+    while (freed < bytes && !lru_list_.empty()) {
+        freed += lru_list_.back().size_bytes;
+        evictLRU();
+    }
+    return freed;
+}
+
+void KVStore::attachMemoryGovernor(MemoryGovernor* governor) {
+    // Unregister outside mutex_: the governor may be inside shrink()
+    memory_registration_.reset();
+    if (!governor) return;
+
+    MemoryConsumer consumer;
+    consumer.name = "kv-store";
+    consumer.tier = ReclaimTier::CACHE;
+    consumer.usage = [this]() { return sizeBytes(); };
+    consumer.shrink = [this](size_t bytes) { return shrink(bytes); };
+    memory_registration_ = governor->registerConsumer(consumer);
+}
+
 void KVStore::evictLRU() {
     if (lru_list_.empty()) return;
     
@@ -381,6 +410,33 @@ bool getCachedGrade(KVStore& store, const std::string& question_id, const std::s
     return store.get(key, grade_json, source);
 }
 
+bool cacheQuiz(KVStore& store, const std::string& topic, const std::string& difficulty,
+              int num_questions, int seed, const std::string& engine, const Quiz& quiz) {
+    return cacheQuiz(store, topic, difficulty, num_questions, seed, engine, quiz_io::writeQuiz(quiz));
+}
+
+bool cacheGrade(KVStore& store, const std::string& question_id, const std::string& student_answer,
+               const std::string& engine, const GradePayload& grade) {
+    return cacheGrade(store, question_id, student_answer, engine, quiz_io::writeGradePayload(grade));
+}
+
+bool getCachedQuiz(KVStore& store, const std::string& topic, const std::string& difficulty,
+                  int num_questions, int seed, const std::string& engine,
+                  Quiz& quiz, std::string& source) {
+    std::string quiz_json;
+    std::string error_msg;
+    return getCachedQuiz(store, topic, difficulty, num_questions, seed, engine, quiz_json, source) &&
+           quiz_io::readQuiz(quiz_json, quiz, error_msg);
+}
+
+bool getCachedGrade(KVStore& store, const std::string& question_id, const std::string& student_answer,
+                   const std::string& engine, GradePayload& grade, std::string& source) {
+    std::string grade_json;
+    std::string error_msg;
+    return getCachedGrade(store, question_id, student_answer, engine, grade_json, source) &&
+           quiz_io::readGradePayload(grade_json, grade, error_msg);
+}
+
 } // namespace quiz_cache
 
 // Cache management utilities
@@ -6,10 +6,14 @@
 #include <mutex>
 #include <chrono>
 #include <memory>
+#include "../types/quiz_types.h"
 
 namespace studyhive {
 namespace core {
 
+class MemoryGovernor;
+class MemoryRegistration;
+
 struct CacheEntry {
     std::string key;
     std::string value;
@@ -33,7 +37,8 @@ public:
 
     // Basic operations
     bool put(const std::string& key, const std::string& value, const std::string& source = "");
-    bool get(const std::string& key, std::string& value, std::string& source = "");
+    bool get(const std::string& key, std::string& value, std::string& source);
+    bool get(const std::string& key, std::string& value);
     bool remove(const std::string& key);
     bool exists(const std::string& key);
     
@@ -72,6 +77,12 @@ public:
     void cleanupExpiredEntries(std::chrono::hours max_age = std::chrono::hours(24));
     void cleanupOldEntries(size_t max_entries);
 
+    // Evict least recently used entries until about bytes are freed; returns bytes freed
+    size_t shrink(size_t bytes);
+
+    // Register with the governor as a cache-tier consumer (null detaches)
+    void attachMemoryGovernor(MemoryGovernor* governor);
+
 private:
     mutable std::mutex mutex_;
     size_t max_size_bytes_;
@@ -92,6 +103,8 @@ private:
     void removeEntry(std::list<CacheEntry>::iterator it);
     std::string generateKey(const std::string& topic, const std::string& difficulty,
                           int num_items, int seed, const std::string& engine);
+
+    std::unique_ptr<MemoryRegistration> memory_registration_;
 };
 
 // Quiz-specific cache operations
@@ -123,6 +136,20 @@ bool getCachedQuiz(KVStore& store, const std::string& topic, const std::string&
 bool getCachedGrade(KVStore& store, const std::string& question_id, const std::string& student_answer,
                    const std::string& engine, std::string& grade_json, std::string& source);
 
+// Typed variants; values are stored in the same wire format
+bool cacheQuiz(KVStore& store, const std::string& topic, const std::string& difficulty,
+              int num_questions, int seed, const std::string& engine, const Quiz& quiz);
+
+bool cacheGrade(KVStore& store, const std::string& question_id, const std::string& student_answer,
+               const std::string& engine, const GradePayload& grade);
+
+bool getCachedQuiz(KVStore& store, const std::string& topic, const std::string& difficulty,
+                  int num_questions, int seed, const std::string& engine,
+                  Quiz& quiz, std::string& source);
+
+bool getCachedGrade(KVStore& store, const std::string& question_id, const std::string& student_answer,
+                   const std::string& engine, GradePayload& grade, std::string& source);
+
 } // namespace quiz_cache
 
 // Cache management utilities
@@ -0,0 +1,590 @@
+#include "model_delta.h"
+#include "positional_file.h"
+#include "../llm/gguf_reader.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <vector>
+
+namespace studyhive {
+namespace core {
+
+namespace {
+
+constexpr char kMagic[8] = {'S', 'H', 'D', 'E', 'L', 'T', 'A', '1'};
+constexpr size_t kHeaderBytes = 8 + 8 + 32 + 8 + 32 + 8;
+constexpr size_t kOpBytes = 1 + 8 * 3;
+
+enum class OpKind : uint8_t {
+    COPY = 0,
+    DATA = 1
+};
+
+struct Op {
+    OpKind kind = OpKind::DATA;
+    uint64_t target_offset = 0;
+    uint64_t length = 0;
+    uint64_t offset = 0;  // COPY: source offset; DATA: offset into the literal section
+};
+
+struct Header {
+    uint64_t source_size = 0;
+    Sha256::Digest source_sha{};
+    uint64_t target_size = 0;
+    Sha256::Digest target_sha{};
+    uint64_t op_count = 0;
+};
+
+void putU64(std::string& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+uint64_t getU64(const uint8_t* data) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) {
+        value = (value << 8) | data[i];
+    }
+    return value;
+}
+
+Sha256::Digest hashRange(const uint8_t* data, size_t size) {
+    Sha256 hasher;
+    hasher.update(data, size);
+    return hasher.finish();
+}
+
+// Collects ops in target order, merging a range into the previous op when
+// it continues it
+class OpBuilder {
+public:
+    void copy(uint64_t target_offset, uint64_t source_offset, uint64_t length) {
+        if (length == 0) return;
+        copy_bytes += length;
+        if (!ops.empty()) {
+            Op& last = ops.back();
+            if (last.kind == OpKind::COPY && last.target_offset + last.length == target_offset &&
+                last.offset + last.length == source_offset) {
+                last.length += length;
+                return;
+            }
+        }
+        ops.push_back({OpKind::COPY, target_offset, length, source_offset});
+    }
+
+    // Literal bytes are the target's own, laid out in op order
+    void data(uint64_t target_offset, uint64_t length) {
+        if (length == 0) return;
+        if (!ops.empty()) {
+            Op& last = ops.back();
+            if (last.kind == OpKind::DATA && last.target_offset + last.length == target_offset) {
+                last.length += length;
+                literal_bytes += length;
+                return;
+            }
+        }
+        ops.push_back({OpKind::DATA, target_offset, length, literal_bytes});
+        literal_bytes += length;
+    }
+
+    std::vector<Op> ops;
+    uint64_t copy_bytes = 0;
+    uint64_t literal_bytes = 0;
+};
+
+// Compare target[target_begin, +length) with source[source_begin, +length)
+// block by block; equal blocks are copied, the rest carried as literals
+void diffBlocks(const MappedFile& source, const MappedFile& target, uint64_t source_begin,
+                uint64_t target_begin, uint64_t length, uint64_t block_bytes, OpBuilder& builder) {
+    for (uint64_t done = 0; done < length; done += block_bytes) {
+        uint64_t size = std::min(block_bytes, length - done);
+        uint64_t source_offset = source_begin + done;
+        bool equal = source_offset + size <= source.size() &&
+                     std::memcmp(source.data() + source_offset, target.data() + target_begin + done, size) == 0;
+        if (equal) {
+            builder.copy(target_begin + done, source_offset, size);
+        } else {
+            builder.data(target_begin + done, size);
+        }
+    }
+}
+
+struct Region {
+    std::string name;
+    uint64_t begin = 0;
+    uint64_t size = 0;  // Up to the next tensor, so alignment padding is included
+};
+
+// Tensor byte ranges in file order; false if the table does not describe the file
+bool tensorRegions(const MappedFile& file, std::vector<Region>& regions) {
+    gguf::Metadata metadata;
+    std::string error;
+    if (!gguf::readMetadata(file.data(), file.size(), metadata, error) || metadata.tensors.empty()) {
+        return false;
+    }
+
+    regions.clear();
+    for (const auto& tensor : metadata.tensors) {
+        regions.push_back({tensor.name, metadata.data_offset + tensor.offset, 0});
+    }
+    std::sort(regions.begin(), regions.end(), [](const Region& a, const Region& b) { return a.begin < b.begin; });
+
+    for (size_t i = 0; i < regions.size(); ++i) {
+        uint64_t end = i + 1 < regions.size() ? regions[i + 1].begin : file.size();
+        if (regions[i].begin < metadata.data_offset || end > file.size() || end < regions[i].begin) {
+            return false;
+        }
+        regions[i].size = end - regions[i].begin;
+    }
+    return true;
+}
+
+void diffTensors(const MappedFile& source, const MappedFile& target, const std::vector<Region>& source_regions,
+                 const std::vector<Region>& target_regions, uint64_t block_bytes, OpBuilder& builder,
+                 DeltaStats& stats) {
+    std::map<std::string, size_t> by_name;
+    std::map<uint64_t, std::vector<size_t>> by_size;
+    for (size_t i = 0; i < source_regions.size(); ++i) {
+        by_name[source_regions[i].name] = i;
+        by_size[source_regions[i].size].push_back(i);
+    }
+    std::vector<std::optional<Sha256::Digest>> source_digests(source_regions.size());
+
+    // The header and tensor table change whenever any tensor moves; they are
+    // small, so a blockwise diff in place is enough
+    diffBlocks(source, target, 0, 0, target_regions.front().begin, block_bytes, builder);
+
+    for (const auto& region : target_regions) {
+        const uint8_t* bytes = target.data() + region.begin;
+
+        auto named = by_name.find(region.name);
+        if (named != by_name.end()) {
+            const Region& match = source_regions[named->second];
+            if (match.size == region.size && std::memcmp(source.data() + match.begin, bytes, region.size) == 0) {
+                builder.copy(region.begin, match.begin, region.size);
+                ++stats.tensors_matched;
+                continue;
+            }
+        }
+
+        // Renamed or reordered tensors: look for identical content of the same size
+        auto candidates = by_size.find(region.size);
+        if (candidates != by_size.end()) {
+            Sha256::Digest digest = hashRange(bytes, region.size);
+            std::optional<size_t> found;
+            for (size_t index : candidates->second) {
+                if (!source_digests[index]) {
+                    source_digests[index] = hashRange(source.data() + source_regions[index].begin, region.size);
+                }
+                if (*source_digests[index] == digest) {
+                    found = index;
+                    break;
+                }
+            }
+            if (found) {
+                builder.copy(region.begin, source_regions[*found].begin, region.size);
+                ++stats.tensors_matched;
+                continue;
+            }
+        }
+
+        // Fine-tuned or requantised in place: keep the blocks that survived
+        if (named != by_name.end() && source_regions[named->second].size == region.size) {
+            diffBlocks(source, target, source_regions[named->second].begin, region.begin, region.size,
+                       block_bytes, builder);
+        } else {
+            builder.data(region.begin, region.size);
+        }
+    }
+}
+
+bool readHeader(const MappedFile& delta, Header& header, std::string& error_msg) {
+    const uint8_t* data = delta.data();
+    if (delta.size() < kHeaderBytes || std::memcmp(data, kMagic, sizeof(kMagic)) != 0) {
+        error_msg = "Not a model delta";
+        return false;
+    }
+    size_t pos = sizeof(kMagic);
+    header.source_size = getU64(data + pos);
+    pos += 8;
+    std::memcpy(header.source_sha.data(), data + pos, 32);
+    pos += 32;
+    header.target_size = getU64(data + pos);
+    pos += 8;
+    std::memcpy(header.target_sha.data(), data + pos, 32);
+    pos += 32;
+    header.op_count = getU64(data + pos);
+
+    if (header.op_count > (delta.size() - kHeaderBytes) / kOpBytes) {
+        error_msg = "Truncated model delta";
+        return false;
+    }
+    return true;
+}
+
+// Ops must tile the target exactly and stay inside the source and literals
+bool readOps(const MappedFile& delta, const Header& header, std::vector<Op>& ops, std::string& error_msg) {
+    uint64_t literal_size = delta.size() - kHeaderBytes - header.op_count * kOpBytes;
+    const uint8_t* data = delta.data() + kHeaderBytes;
+
+    ops.resize(static_cast<size_t>(header.op_count));
+    uint64_t covered = 0;
+    for (auto& op : ops) {
+        if (data[0] > static_cast<uint8_t>(OpKind::DATA)) {
+            error_msg = "Unknown delta op";
+            return false;
+        }
+        op.kind = static_cast<OpKind>(data[0]);
+        op.target_offset = getU64(data + 1);
+        op.length = getU64(data + 9);
+        op.offset = getU64(data + 17);
+        data += kOpBytes;
+
+        uint64_t limit = op.kind == OpKind::COPY ? header.source_size : literal_size;
+        if (op.target_offset != covered || op.length > header.target_size - covered ||
+            op.offset > limit || op.length > limit - op.offset) {
+            error_msg = "Delta op out of range";
+            return false;
+        }
+        covered += op.length;
+    }
+    if (covered != header.target_size) {
+        error_msg = "Delta does not cover the target";
+        return false;
+    }
+    return true;
+}
+
+struct Move {
+    uint64_t source = 0;
+    uint64_t target = 0;
+    uint64_t length = 0;
+    bool stashed = false;
+    uint64_t stash_offset = 0;
+};
+
+// Order the in-file copies so none reads bytes another has already
+// overwritten: A must run before B when B's target overlaps A's source.
+// Cycles are broken by stashing the smallest pending source aside, which
+// drops its outgoing edges. Returns false if that needs more than max_stash.
+bool planMoves(std::vector<Move>& moves, uint64_t max_stash, std::vector<size_t>& order,
+               uint64_t& stash_bytes, std::string& error_msg) {
+    size_t count = moves.size();
+    std::vector<size_t> by_source(count);
+    for (size_t i = 0; i < count; ++i) by_source[i] = i;
+    std::sort(by_source.begin(), by_source.end(),
+              [&](size_t a, size_t b) { return moves[a].source < moves[b].source; });
+    std::vector<uint64_t> max_end(count);
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t end = moves[by_source[i]].source + moves[by_source[i]].length;
+        max_end[i] = i > 0 ? std::max(max_end[i - 1], end) : end;
+    }
+
+    std::vector<std::vector<size_t>> successors(count);
+    std::vector<size_t> pending_inputs(count, 0);
+    for (size_t b = 0; b < count; ++b) {
+        uint64_t begin = moves[b].target;
+        uint64_t end = begin + moves[b].length;
+        size_t upper = std::lower_bound(by_source.begin(), by_source.end(), end,
+                                        [&](size_t index, uint64_t value) { return moves[index].source < value; }) -
+                       by_source.begin();
+        for (size_t i = upper; i > 0 && max_end[i - 1] > begin; --i) {
+            size_t a = by_source[i - 1];
+            if (a != b && moves[a].source + moves[a].length > begin) {
+                successors[a].push_back(b);
+                ++pending_inputs[b];
+            }
+        }
+    }
+
+    std::vector<size_t> ready;
+    std::vector<char> released(count, 0);
+    std::vector<char> scheduled(count, 0);
+    auto release = [&](size_t node) {
+        if (released[node]) return;
+        released[node] = 1;
+        for (size_t next : successors[node]) {
+            if (--pending_inputs[next] == 0) ready.push_back(next);
+        }
+    };
+    for (size_t i = 0; i < count; ++i) {
+        if (pending_inputs[i] == 0) ready.push_back(i);
+    }
+
+    order.clear();
+    stash_bytes = 0;
+    while (order.size() < count) {
+        if (ready.empty()) {
+            std::optional<size_t> victim;
+            for (size_t i = 0; i < count; ++i) {
+                if (!scheduled[i] && !released[i] && (!victim || moves[i].length < moves[*victim].length)) {
+                    victim = i;
+                }
+            }
+            if (!victim) {
+                error_msg = "Cannot order delta copies";
+                return false;
+            }
+            moves[*victim].stashed = true;
+            moves[*victim].stash_offset = stash_bytes;
+            stash_bytes += moves[*victim].length;
+            if (stash_bytes > max_stash) {
+                error_msg = "Delta needs more than " + std::to_string(max_stash) + " bytes of stash space";
+                return false;
+            }
+            release(*victim);
+            continue;
+        }
+
+        size_t node = ready.back();
+        ready.pop_back();
+        scheduled[node] = 1;
+        order.push_back(node);
+        release(node);
+    }
+    return true;
+}
+
+bool copyBetween(PositionalFile& from, uint64_t from_offset, PositionalFile& to, uint64_t to_offset,
+                 uint64_t length, std::vector<char>& buffer) {
+    for (uint64_t done = 0; done < length; done += buffer.size()) {
+        size_t size = static_cast<size_t>(std::min<uint64_t>(buffer.size(), length - done));
+        if (!from.readAt(from_offset + done, buffer.data(), size) ||
+            !to.writeAt(to_offset + done, buffer.data(), size)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// memmove within one file: walk backwards when the target overlaps the
+// tail of the source
+bool moveWithin(PositionalFile& file, const Move& move, std::vector<char>& buffer) {
+    bool backwards = move.target > move.source && move.target < move.source + move.length;
+    if (!backwards) {
+        return copyBetween(file, move.source, file, move.target, move.length, buffer);
+    }
+    for (uint64_t remaining = move.length; remaining > 0;) {
+        size_t size = static_cast<size_t>(std::min<uint64_t>(buffer.size(), remaining));
+        remaining -= size;
+        if (!file.readAt(move.source + remaining, buffer.data(), size) ||
+            !file.writeAt(move.target + remaining, buffer.data(), size)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string markerPath(const std::string& path) { return path + ".patching"; }
+
+} // namespace
+
+namespace delta {
+
+bool create(const std::string& source_path, const std::string& target_path, const std::string& delta_path,
+            const DeltaOptions& options, DeltaStats& stats, std::string& error_msg) {
+    stats = DeltaStats();
+    MappedFile source;
+    MappedFile target;
+    if (!source.open(source_path, error_msg) || !target.open(target_path, error_msg)) {
+        return false;
+    }
+    uint64_t block_bytes = std::max<uint64_t>(options.block_bytes, 64);
+
+    OpBuilder builder;
+    std::vector<Region> source_regions;
+    std::vector<Region> target_regions;
+    stats.tensor_aware = tensorRegions(source, source_regions) && tensorRegions(target, target_regions);
+    if (stats.tensor_aware) {
+        diffTensors(source, target, source_regions, target_regions, block_bytes, builder, stats);
+    } else {
+        diffBlocks(source, target, 0, 0, target.size(), block_bytes, builder);
+    }
+
+    std::string head(kMagic, sizeof(kMagic));
+    Sha256::Digest source_sha = hashRange(source.data(), source.size());
+    Sha256::Digest target_sha = hashRange(target.data(), target.size());
+    putU64(head, source.size());
+    head.append(reinterpret_cast<const char*>(source_sha.data()), source_sha.size());
+    putU64(head, target.size());
+    head.append(reinterpret_cast<const char*>(target_sha.data()), target_sha.size());
+    putU64(head, builder.ops.size());
+    for (const auto& op : builder.ops) {
+        head.push_back(static_cast<char>(op.kind));
+        putU64(head, op.target_offset);
+        putU64(head, op.length);
+        putU64(head, op.offset);
+    }
+
+    std::ofstream out(delta_path, std::ios::binary | std::ios::trunc);
+    out.write(head.data(), static_cast<std::streamsize>(head.size()));
+    for (const auto& op : builder.ops) {
+        if (op.kind == OpKind::DATA) {
+            out.write(reinterpret_cast<const char*>(target.data() + op.target_offset),
+                      static_cast<std::streamsize>(op.length));
+        }
+    }
+    out.close();
+    if (!out) {
+        error_msg = "Cannot write " + delta_path;
+        return false;
+    }
+
+    stats.copy_bytes = builder.copy_bytes;
+    stats.literal_bytes = builder.literal_bytes;
+    stats.op_count = builder.ops.size();
+    return true;
+}
+
+PatchResult apply(const std::string& path, const std::string& delta_path, const PatchOptions& options) {
+    auto start = std::chrono::steady_clock::now();
+    PatchResult result;
+    auto finish = [&](const std::string& error) {
+        result.success = error.empty();
+        result.error_message = error;
+        result.time_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return result;
+    };
+    auto cancelled = [&]() { return options.cancel && *options.cancel; };
+
+    std::string error;
+    MappedFile delta_file;
+    Header header;
+    std::vector<Op> ops;
+    if (!delta_file.open(delta_path, error) || !readHeader(delta_file, header, error) ||
+        !readOps(delta_file, header, ops, error)) {
+        return finish(error);
+    }
+    const uint8_t* literals = delta_file.data() + kHeaderBytes + header.op_count * kOpBytes;
+
+    if (interrupted(path)) {
+        return finish("A previous patch of " + path + " was interrupted");
+    }
+    FileIdentity identity;
+    if (!integrity::identify(path, identity, error)) {
+        return finish(error);
+    }
+    if (identity.size != header.source_size) {
+        return finish("File is not the source revision of the delta");
+    }
+    if (options.verify_source) {
+        std::string digest;
+        if (!sha256::hashFile(path, digest, error)) {
+            return finish(error);
+        }
+        if (!sha256::digestEquals(digest, sha256::toHex(header.source_sha))) {
+            return finish("File is not the source revision of the delta");
+        }
+    }
+
+    // Plan everything before the first write, so a delta that cannot be
+    // applied within the stash budget leaves the file untouched
+    std::vector<Move> moves;
+    for (const auto& op : ops) {
+        if (op.kind != OpKind::COPY) continue;
+        if (op.offset == op.target_offset) {
+            result.skipped_bytes += op.length;
+        } else {
+            moves.push_back({op.offset, op.target_offset, op.length});
+        }
+    }
+    std::vector<size_t> order;
+    uint64_t stash_bytes = 0;
+    if (!planMoves(moves, options.max_stash_bytes, order, stash_bytes, error)) {
+        return finish(error);
+    }
+    if (cancelled()) {
+        return finish("Patch cancelled");
+    }
+
+    {
+        std::ofstream marker(markerPath(path), std::ios::trunc);
+        marker << sha256::toHex(header.target_sha) << "\n";
+        if (!marker) {
+            return finish("Cannot write " + markerPath(path));
+        }
+    }
+    result.file_modified = true;
+
+    PositionalFile file;
+    if (!file.open(path, std::max(header.source_size, header.target_size), true, error)) {
+        return finish(error);
+    }
+    std::vector<char> buffer(static_cast<size_t>(std::max<uint64_t>(options.buffer_bytes, 4096)));
+
+    std::string stash_path = path + ".stash";
+    PositionalFile stash;
+    if (stash_bytes > 0) {
+        if (!stash.open(stash_path, stash_bytes, false, error)) {
+            return finish(error);
+        }
+        for (const auto& move : moves) {
+            if (move.stashed && !copyBetween(file, move.source, stash, move.stash_offset, move.length, buffer)) {
+                return finish("Cannot stash a range of " + path);
+            }
+        }
+        stash.sync();
+        result.stashed_bytes = stash_bytes;
+    }
+
+    for (size_t index : order) {
+        const Move& move = moves[index];
+        bool ok = move.stashed ? copyBetween(stash, move.stash_offset, file, move.target, move.length, buffer)
+                               : moveWithin(file, move, buffer);
+        if (!ok) {
+            return finish("Cannot copy within " + path);
+        }
+        result.copied_bytes += move.length;
+    }
+
+    for (const auto& op : ops) {
+        if (op.kind != OpKind::DATA) continue;
+        if (!file.writeAt(op.target_offset, reinterpret_cast<const char*>(literals + op.offset), op.length)) {
+            return finish("Cannot write " + path);
+        }
+        result.literal_bytes += op.length;
+    }
+
+    if (!file.resize(header.target_size)) {
+        return finish("Cannot resize " + path);
+    }
+    file.sync();
+    file.close();
+    stash.close();
+    std::error_code ec;
+    std::filesystem::remove(stash_path, ec);
+
+    // The verifying pass also produces the chunk digests for the cache
+    integrity::HashOptions hash_options;
+    hash_options.chunk_bytes = options.verify_chunk_bytes;
+    if (!integrity::hashFile(path, hash_options, result.record, error)) {
+        return finish(error);
+    }
+    if (!sha256::digestEquals(result.record.sha256, sha256::toHex(header.target_sha))) {
+        return finish("Patched file does not match the target digest");
+    }
+
+    std::filesystem::remove(markerPath(path), ec);
+    return finish("");
+}
+
+bool interrupted(const std::string& path) {
+    std::error_code ec;
+    return std::filesystem::exists(markerPath(path), ec);
+}
+
+void clearInterrupted(const std::string& path) {
+    std::error_code ec;
+    std::filesystem::remove(markerPath(path), ec);
+    std::filesystem::remove(path + ".stash", ec);
+}
+
+} // namespace delta
+
+} // namespace core
+} // namespace studyhive
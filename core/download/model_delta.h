@@ -0,0 +1,76 @@
+#pragma once
+
+#include <string>
+#include <atomic>
+#include <cstdint>
+#include "verification_cache.h"
+
+namespace studyhive {
+namespace core {
+
+// Binary delta between two revisions of a model file. The target is described
+// as a sequence of ops covering it front to back: COPY a byte range of the
+// source, or write literal DATA carried in the delta. For GGUF files the ops
+// follow the tensor table, so unchanged tensors (even if they moved) cost a
+// few bytes and changed tensors only their differing blocks.
+//
+// Layout (little-endian):
+//   "SHDELTA1"  u64 source_size  u8[32] source_sha256  u64 target_size  u8[32] target_sha256
+//   u64 op_count, then per op: u8 kind  u64 target_offset  u64 length  u64 offset
+//   literal bytes (DATA offsets are relative to the start of this section)
+
+struct DeltaOptions {
+    uint64_t block_bytes = 64 * 1024;  // Granularity for diffing changed tensors
+};
+
+struct DeltaStats {
+    uint64_t copy_bytes = 0;     // Reused from the source
+    uint64_t literal_bytes = 0;  // Carried in the delta
+    size_t op_count = 0;
+    size_t tensors_matched = 0;  // Tensors copied whole (by name or content)
+    bool tensor_aware = false;   // False: both files were diffed as plain blocks
+};
+
+struct PatchOptions {
+    bool verify_source = true;                 // Hash the file first; off if already verified
+    uint64_t max_stash_bytes = 256ull << 20;   // Extra disk for ranges that must be saved aside
+    uint64_t buffer_bytes = 4 << 20;
+    uint64_t verify_chunk_bytes = 4 << 20;     // Chunk size of the returned verification record
+    const std::atomic<bool>* cancel = nullptr; // Honoured only before the file is modified
+};
+
+struct PatchResult {
+    bool success = false;
+    std::string error_message;
+    bool file_modified = false;  // On failure: the file is neither revision any more
+    uint64_t copied_bytes = 0;   // Moved within the file
+    uint64_t skipped_bytes = 0;  // Copies already in place
+    uint64_t literal_bytes = 0;
+    uint64_t stashed_bytes = 0;  // Peak extra disk used for stashed ranges
+    VerificationRecord record;   // Of the patched file (digests computed while verifying)
+    float time_ms = 0.0f;
+};
+
+namespace delta {
+
+// Diff source_path against target_path into delta_path (release tooling)
+bool create(const std::string& source_path, const std::string& target_path, const std::string& delta_path,
+            const DeltaOptions& options, DeltaStats& stats, std::string& error_msg);
+
+// Rewrite path from the source revision into the target revision in place.
+// Copies are ordered so none reads a range another has already overwritten;
+// cycles are broken by stashing ranges in path + ".stash" (at most
+// max_stash_bytes). Fails without touching the file if the plan needs more.
+// While the file is being rewritten, path + ".patching" exists.
+PatchResult apply(const std::string& path, const std::string& delta_path, const PatchOptions& options);
+
+// True if a previous apply on path was interrupted (the file is unusable)
+bool interrupted(const std::string& path);
+
+// Forget an interrupted apply once path has been replaced by other means
+void clearInterrupted(const std::string& path);
+
+} // namespace delta
+
+} // namespace core
+} // namespace studyhive
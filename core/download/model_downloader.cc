@@ -0,0 +1,756 @@
+#include "model_downloader.h"
+#include "sha256.h"
+#include "positional_file.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+namespace studyhive {
+namespace core {
+
+namespace {
+
+constexpr int kManifestVersion = 2;
+
+// ---------------------------------------------------------------------------
+// Plain HTTP/1.1 range client
+
+#ifndef _WIN32
+
+struct Url {
+    std::string host;
+    std::string port = "80";
+    std::string path = "/";
+};
+
+bool parseUrl(const std::string& url, Url& parsed, std::string& error_msg) {
+    const std::string scheme = "http://";
+    if (url.compare(0, scheme.size(), scheme) != 0) {
+        error_msg = "Only http:// URLs are supported by the built-in transport: " + url;
+        return false;
+    }
+
+    std::string rest = url.substr(scheme.size());
+    size_t slash = rest.find('/');
+    std::string authority = rest.substr(0, slash);
+    if (slash != std::string::npos) {
+        parsed.path = rest.substr(slash);
+    }
+
+    size_t colon = authority.rfind(':');
+    if (colon != std::string::npos && authority.find(']') == std::string::npos) {
+        parsed.host = authority.substr(0, colon);
+        parsed.port = authority.substr(colon + 1);
+    } else {
+        parsed.host = authority;
+    }
+    if (!parsed.host.empty() && parsed.host.front() == '[') {
+        parsed.host = parsed.host.substr(1, parsed.host.size() - 2);
+    }
+
+    if (parsed.host.empty()) {
+        error_msg = "Missing host in " + url;
+        return false;
+    }
+    return true;
+}
+
+class Socket {
+public:
+    ~Socket() {
+        if (fd_ >= 0) ::close(fd_);
+    }
+
+    bool connect(const Url& url, int timeout_ms, std::string& error_msg) {
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* addresses = nullptr;
+        int rc = getaddrinfo(url.host.c_str(), url.port.c_str(), &hints, &addresses);
+        if (rc != 0) {
+            error_msg = "Cannot resolve " + url.host + ": " + gai_strerror(rc);
+            return false;
+        }
+
+        timeval timeout{};
+        timeout.tv_sec = timeout_ms / 1000;
+        timeout.tv_usec = (timeout_ms % 1000) * 1000;
+
+        for (addrinfo* address = addresses; address; address = address->ai_next) {
+            fd_ = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+            if (fd_ < 0) continue;
+            setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            setsockopt(fd_, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+#ifdef SO_NOSIGPIPE
+            int one = 1;
+            setsockopt(fd_, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+            if (::connect(fd_, address->ai_addr, address->ai_addrlen) == 0) {
+                freeaddrinfo(addresses);
+                return true;
+            }
+            ::close(fd_);
+            fd_ = -1;
+        }
+
+        freeaddrinfo(addresses);
+        error_msg = "Cannot connect to " + url.host + ":" + url.port;
+        return false;
+    }
+
+    bool sendAll(const std::string& data) {
+#ifdef MSG_NOSIGNAL
+        const int flags = MSG_NOSIGNAL;
+#else
+        const int flags = 0;
+#endif
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t n = ::send(fd_, data.data() + sent, data.size() - sent, flags);
+            if (n <= 0) return false;
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    ssize_t receive(char* buffer, size_t size) {
+        return ::recv(fd_, buffer, size, 0);
+    }
+
+private:
+    int fd_ = -1;
+};
+
+bool parseSize(const std::string& text, uint64_t& value) {
+    char* end = nullptr;
+    errno = 0;
+    value = std::strtoull(text.c_str(), &end, 10);
+    return errno == 0 && end != text.c_str() && *end == '\0';
+}
+
+struct ResponseHead {
+    int status = 0;
+    std::map<std::string, std::string> headers;  // Lowercase names
+};
+
+// Reads the status line and headers; body bytes read past them go to leftover
+bool readHead(Socket& socket, ResponseHead& head, std::string& leftover, std::string& error_msg) {
+    std::string data;
+    char buffer[4096];
+    size_t end;
+    while ((end = data.find("\r\n\r\n")) == std::string::npos) {
+        ssize_t n = socket.receive(buffer, sizeof(buffer));
+        if (n <= 0) {
+            error_msg = "Connection closed before the response headers";
+            return false;
+        }
+        data.append(buffer, static_cast<size_t>(n));
+        if (data.size() > 64 * 1024) {
+            error_msg = "Response headers too large";
+            return false;
+        }
+    }
+    leftover = data.substr(end + 4);
+
+    size_t line_end = data.find("\r\n");
+    std::string status_line = data.substr(0, line_end);
+    size_t space = status_line.find(' ');
+    if (status_line.compare(0, 5, "HTTP/") != 0 || space == std::string::npos) {
+        error_msg = "Malformed status line: " + status_line;
+        return false;
+    }
+    head.status = std::atoi(status_line.c_str() + space + 1);
+
+    size_t pos = line_end + 2;
+    while (pos < end) {
+        size_t next = data.find("\r\n", pos);
+        std::string line = data.substr(pos, next - pos);
+        pos = next + 2;
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) continue;
+        std::string name = line.substr(0, colon);
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        size_t value_start = line.find_first_not_of(' ', colon + 1);
+        head.headers[name] = value_start == std::string::npos ? "" : line.substr(value_start);
+    }
+    return true;
+}
+
+class HttpTransport : public DownloadTransport {
+public:
+    explicit HttpTransport(int timeout_ms) : timeout_ms_(timeout_ms) {}
+
+    bool contentLength(const std::string& url, uint64_t& size, std::string& error_msg) override {
+        // A one-byte range reports the total in Content-Range and works on
+        // servers that do not answer HEAD
+        Socket socket;
+        ResponseHead head;
+        std::string leftover;
+        if (!open(socket, url, 0, 0, head, leftover, error_msg)) {
+            return false;
+        }
+
+        if (head.status == 206) {
+            const std::string& range = head.headers["content-range"];
+            size_t slash = range.rfind('/');
+            if (slash == std::string::npos || !parseSize(range.substr(slash + 1), size)) {
+                error_msg = "Server did not report the total size (Content-Range: " + range + ")";
+                return false;
+            }
+            return true;
+        }
+        if (head.status == 200 && parseSize(head.headers["content-length"], size)) {
+            return true;
+        }
+
+        error_msg = "Unexpected HTTP status " + std::to_string(head.status) + " for " + url;
+        return false;
+    }
+
+    bool fetchRange(const std::string& url, uint64_t offset, uint64_t length,
+                    const std::function<bool(const char*, size_t)>& sink,
+                    std::string& error_msg) override {
+        if (length == 0) {
+            return true;
+        }
+
+        Socket socket;
+        ResponseHead head;
+        std::string leftover;
+        if (!open(socket, url, offset, offset + length - 1, head, leftover, error_msg)) {
+            return false;
+        }
+
+        // 200 carries the whole resource; usable only for a range that covers it
+        uint64_t content_length = 0;
+        bool whole = head.status == 200 && offset == 0 &&
+                     parseSize(head.headers["content-length"], content_length) && content_length == length;
+        if (head.status != 206 && !whole) {
+            error_msg = head.status == 200 ? "Server does not support range requests"
+                                           : "Unexpected HTTP status " + std::to_string(head.status);
+            return false;
+        }
+        if (head.headers.count("transfer-encoding")) {
+            error_msg = "Chunked transfer encoding is not supported";
+            return false;
+        }
+
+        uint64_t remaining = length;
+        auto deliver = [&](const char* data, size_t size) {
+            size_t take = static_cast<size_t>(std::min<uint64_t>(size, remaining));
+            remaining -= take;
+            return take == 0 || sink(data, take);
+        };
+
+        if (!deliver(leftover.data(), leftover.size())) {
+            error_msg = "Cancelled";
+            return false;
+        }
+
+        std::vector<char> buffer(64 * 1024);
+        while (remaining > 0) {
+            ssize_t n = socket.receive(buffer.data(), buffer.size());
+            if (n <= 0) {
+                error_msg = n == 0 ? "Connection closed mid-range" : "Receive error or timeout";
+                return false;
+            }
+            if (!deliver(buffer.data(), static_cast<size_t>(n))) {
+                error_msg = "Cancelled";
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    int timeout_ms_;
+
+    bool open(Socket& socket, const std::string& url, uint64_t first, uint64_t last,
+              ResponseHead& head, std::string& leftover, std::string& error_msg) {
+        Url parsed;
+        if (!parseUrl(url, parsed, error_msg) || !socket.connect(parsed, timeout_ms_, error_msg)) {
+            return false;
+        }
+
+        std::string request = "GET " + parsed.path + " HTTP/1.1\r\n"
+                              "Host: " + parsed.host + "\r\n"
+                              "Range: bytes=" + std::to_string(first) + "-" + std::to_string(last) + "\r\n"
+                              "Accept-Encoding: identity\r\n"
+                              "Connection: close\r\n\r\n";
+        if (!socket.sendAll(request)) {
+            error_msg = "Failed to send request to " + parsed.host;
+            return false;
+        }
+        return readHead(socket, head, leftover, error_msg);
+    }
+};
+
+#endif
+
+enum class ChunkState : char {
+    PENDING = '0',
+    DONE = '1',
+    ACTIVE = '2'  // Never persisted
+};
+
+} // namespace
+
+std::shared_ptr<DownloadTransport> makeHttpTransport(int timeout_ms) {
+#ifdef _WIN32
+    (void)timeout_ms;
+    return nullptr;
+#else
+    return std::make_shared<HttpTransport>(timeout_ms);
+#endif
+}
+
+class ModelDownloader::Impl {
+public:
+    Impl(const DownloadConfig& config, std::shared_ptr<DownloadTransport> transport)
+        : config_(config), transport_(transport ? transport : makeHttpTransport()) {
+        config_.chunk_bytes = std::max<uint64_t>((config_.chunk_bytes + 63) / 64 * 64, 64);
+        config_.parallel_chunks = std::max(config_.parallel_chunks, 1);
+        part_path_ = config_.dest_path + ".part";
+        manifest_path_ = config_.dest_path + ".part.json";
+    }
+
+    DownloadResult run() {
+        auto start_time = std::chrono::steady_clock::now();
+        DownloadResult result;
+        cancelled_ = false;
+        failed_ = false;
+
+        if (!transport_) {
+            result.error_message = "No download transport available on this platform";
+            return result;
+        }
+        if (!transport_->contentLength(config_.url, total_bytes_, result.error_message)) {
+            return result;
+        }
+        result.total_bytes = total_bytes_;
+        chunk_count_ = static_cast<size_t>((total_bytes_ + config_.chunk_bytes - 1) / config_.chunk_bytes);
+
+        bool resumed = loadManifest();
+        if (!part_.open(part_path_, total_bytes_, resumed, result.error_message)) {
+            return result;
+        }
+        if (!resumed) {
+            states_.assign(chunk_count_, ChunkState::PENDING);
+            chunk_digests_.assign(chunk_count_, Sha256::Digest{});
+            hasher_.reset();
+            hashed_chunks_ = 0;
+            saved_hashed_chunks_ = 0;
+            hasher_.exportMidstate(saved_midstate_);
+        }
+
+        uint64_t present = 0;
+        for (size_t i = 0; i < chunk_count_; ++i) {
+            if (states_[i] == ChunkState::DONE) present += chunkLength(i);
+        }
+        result.resumed_bytes = present;
+        present_bytes_ = present;
+        downloaded_bytes_ = 0;
+        reread_bytes_ = 0;
+        retried_chunks_ = 0;
+        last_reported_permille_ = -1;
+        reportProgress();
+
+        // Chunks already on disk past the saved midstate are hashed first
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            advanceFrontier(lock);
+        }
+
+        std::vector<std::thread> workers;
+        size_t worker_count = std::min<size_t>(config_.parallel_chunks, chunk_count_);
+        for (size_t i = 0; i < worker_count; ++i) {
+            workers.emplace_back([this]() { worker(); });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+
+        result.downloaded_bytes = downloaded_bytes_;
+        result.reread_bytes = reread_bytes_;
+        result.retried_chunks = retried_chunks_;
+
+        if (cancelled_ || failed_) {
+            part_.close();
+            result.error_message = cancelled_ ? "Download cancelled" : error_message_;
+            result.time_ms = elapsedMs(start_time);
+            return result;
+        }
+
+        // All chunks done and hashed by the workers
+        part_.sync();
+        part_.close();
+        result.sha256 = hasher_.finishHex();
+        result.chunk_bytes = config_.chunk_bytes;
+        result.chunk_digests = chunk_digests_;
+
+        std::error_code ec;
+        if (!config_.expected_sha256.empty() && !sha256::digestEquals(result.sha256, config_.expected_sha256)) {
+            // The bytes on disk are bad; start over next time
+            std::filesystem::remove(part_path_, ec);
+            std::filesystem::remove(manifest_path_, ec);
+            result.error_message = "SHA-256 mismatch: expected " + config_.expected_sha256 + ", got " + result.sha256;
+            result.time_ms = elapsedMs(start_time);
+            return result;
+        }
+
+        std::filesystem::rename(part_path_, config_.dest_path, ec);
+        if (ec) {
+            result.error_message = "Cannot move download into place: " + ec.message();
+            result.time_ms = elapsedMs(start_time);
+            return result;
+        }
+        std::filesystem::remove(manifest_path_, ec);
+
+        result.success = true;
+        result.time_ms = elapsedMs(start_time);
+        return result;
+    }
+
+    void cancel() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancelled_ = true;
+        buffer_space_.notify_all();
+    }
+
+    void setProgressCallback(std::function<void(float)> callback) {
+        progress_callback_ = callback;
+    }
+
+private:
+    DownloadConfig config_;
+    std::shared_ptr<DownloadTransport> transport_;
+    std::string part_path_;
+    std::string manifest_path_;
+    PositionalFile part_;
+
+    uint64_t total_bytes_ = 0;
+    size_t chunk_count_ = 0;
+
+    // Chunk map and hash frontier, guarded by mutex_
+    std::mutex mutex_;
+    std::vector<ChunkState> states_;
+    std::vector<Sha256::Digest> chunk_digests_;
+    std::map<size_t, std::vector<char>> buffered_;  // Finished chunks past the frontier
+    std::condition_variable buffer_space_;
+    size_t hashed_chunks_ = 0;                       // Frontier: chunks [0, hashed_chunks_) are hashed
+    bool advancing_ = false;                         // A thread is hashing at the frontier
+    Sha256 hasher_;                                  // Touched only by the advancing thread
+    Sha256::Midstate saved_midstate_;                // Last block-aligned state, for the manifest
+    size_t saved_hashed_chunks_ = 0;
+    std::string error_message_;
+
+    std::atomic<bool> cancelled_{false};
+    std::atomic<bool> failed_{false};
+    std::atomic<uint64_t> present_bytes_{0};
+    std::atomic<uint64_t> downloaded_bytes_{0};
+    std::atomic<uint64_t> reread_bytes_{0};
+    std::atomic<int> retried_chunks_{0};
+    std::atomic<int> last_reported_permille_{-1};
+    std::function<void(float)> progress_callback_;
+
+    static float elapsedMs(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    uint64_t chunkOffset(size_t index) const { return index * config_.chunk_bytes; }
+
+    size_t chunkLength(size_t index) const {
+        return static_cast<size_t>(std::min<uint64_t>(config_.chunk_bytes, total_bytes_ - chunkOffset(index)));
+    }
+
+    void reportProgress() {
+        if (!progress_callback_ || total_bytes_ == 0) return;
+        int permille = static_cast<int>(present_bytes_.load() * 1000 / total_bytes_);
+        int last = last_reported_permille_.load();
+        // One report per 0.1%, never backwards (failed chunks drop bytes again)
+        while (permille > last) {
+            if (last_reported_permille_.compare_exchange_weak(last, permille)) {
+                progress_callback_(permille / 1000.0f);
+                return;
+            }
+        }
+    }
+
+    void worker() {
+        std::vector<char> buffer;
+        while (!cancelled_ && !failed_) {
+            size_t index = claimChunk();
+            if (index == chunk_count_) {
+                return;
+            }
+
+            size_t length = chunkLength(index);
+            buffer.resize(length);
+            size_t filled = 0;
+            std::string error_msg;
+
+            int attempt = 0;
+            bool ok = false;
+            while (!cancelled_ && !failed_ && !ok) {
+                filled = 0;
+                ok = transport_->fetchRange(config_.url, chunkOffset(index), length,
+                    [&](const char* data, size_t size) {
+                        if (cancelled_ || failed_ || filled + size > length) return false;
+                        std::memcpy(buffer.data() + filled, data, size);
+                        filled += size;
+                        present_bytes_ += size;
+                        reportProgress();
+                        return true;
+                    }, error_msg) && filled == length;
+
+                if (!ok) {
+                    present_bytes_ -= filled;
+                    if (++attempt > config_.max_retries) {
+                        fail("Chunk " + std::to_string(index) + " failed: " + error_msg);
+                        break;
+                    }
+                    ++retried_chunks_;
+                }
+            }
+
+            if (!ok || !part_.writeAt(chunkOffset(index), buffer.data(), length)) {
+                if (ok) fail("Cannot write " + part_path_);
+                std::lock_guard<std::mutex> lock(mutex_);
+                states_[index] = ChunkState::PENDING;
+                return;
+            }
+
+            downloaded_bytes_ += length;
+            // Independent per-chunk digest, computed in parallel by the workers
+            Sha256 chunk_hasher;
+            chunk_hasher.update(buffer.data(), length);
+            completeChunk(index, chunk_hasher.finish(), buffer);
+        }
+    }
+
+    void fail(const std::string& error_msg) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!failed_) {
+            error_message_ = error_msg;
+            failed_ = true;
+        }
+        buffer_space_.notify_all();
+    }
+
+    // Lowest pending chunk, so the hash frontier trails the downloads closely
+    size_t claimChunk() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < chunk_count_; ++i) {
+            if (states_[i] == ChunkState::PENDING) {
+                states_[i] = ChunkState::ACTIVE;
+                return i;
+            }
+        }
+        return chunk_count_;
+    }
+
+    // buffer is swapped out when kept for hashing
+    void completeChunk(size_t index, const Sha256::Digest& digest, std::vector<char>& buffer) {
+        part_.sync();
+
+        // Back-pressure: when the hash falls behind, wait for buffer space rather
+        // than dropping the chunk and reading it back from disk later
+        std::unique_lock<std::mutex> lock(mutex_);
+        buffer_space_.wait(lock, [&]() {
+            return index == hashed_chunks_ || buffered_.size() < config_.max_buffered_chunks ||
+                   cancelled_ || failed_;
+        });
+
+        states_[index] = ChunkState::DONE;
+        chunk_digests_[index] = digest;
+        if (index == hashed_chunks_ || buffered_.size() < config_.max_buffered_chunks) {
+            buffered_[index].swap(buffer);
+        }
+        advanceFrontier(lock);
+        saveManifest();
+    }
+
+    // Hash finished chunks in order from the frontier. Only one thread hashes at
+    // a time; others just leave their chunk behind and return.
+    void advanceFrontier(std::unique_lock<std::mutex>& lock) {
+        if (advancing_) {
+            return;
+        }
+        advancing_ = true;
+
+        std::vector<char> reread;
+        while (!cancelled_ && hashed_chunks_ < chunk_count_ && states_[hashed_chunks_] == ChunkState::DONE) {
+            size_t index = hashed_chunks_;
+            std::vector<char> data;
+            auto buffered = buffered_.find(index);
+            if (buffered != buffered_.end()) {
+                data.swap(buffered->second);
+                buffered_.erase(buffered);
+            }
+
+            lock.unlock();
+            bool ok = true;
+            if (data.empty()) {
+                // Written by an earlier run
+                reread.resize(chunkLength(index));
+                ok = part_.readAt(chunkOffset(index), reread.data(), reread.size());
+                if (ok) {
+                    hasher_.update(reread.data(), reread.size());
+                    reread_bytes_ += reread.size();
+                }
+            } else {
+                hasher_.update(data.data(), data.size());
+            }
+            lock.lock();
+
+            if (!ok) {
+                if (!failed_) {
+                    error_message_ = "Cannot read back " + part_path_;
+                    failed_ = true;
+                }
+                buffer_space_.notify_all();
+                break;
+            }
+
+            ++hashed_chunks_;
+            if (hasher_.exportMidstate(saved_midstate_)) {
+                saved_hashed_chunks_ = hashed_chunks_;
+            }
+            buffer_space_.notify_all();
+        }
+
+        advancing_ = false;
+    }
+
+    // Caller holds mutex_
+    void saveManifest() {
+        nlohmann::json manifest;
+        manifest["version"] = kManifestVersion;
+        manifest["url"] = config_.url;
+        manifest["size"] = total_bytes_;
+        manifest["chunk_bytes"] = config_.chunk_bytes;
+        manifest["expected_sha256"] = config_.expected_sha256;
+
+        std::string done(chunk_count_, static_cast<char>(ChunkState::PENDING));
+        for (size_t i = 0; i < chunk_count_; ++i) {
+            if (states_[i] == ChunkState::DONE) done[i] = static_cast<char>(ChunkState::DONE);
+        }
+        manifest["chunks"] = done;
+        manifest["hashed_chunks"] = saved_hashed_chunks_;
+        manifest["hashed_bytes"] = saved_midstate_.length;
+        manifest["midstate"] = std::vector<uint32_t>(saved_midstate_.h, saved_midstate_.h + 8);
+
+        nlohmann::json digests = nlohmann::json::array();
+        for (size_t i = 0; i < chunk_count_; ++i) {
+            digests.push_back(states_[i] == ChunkState::DONE ? sha256::toHex(chunk_digests_[i]) : "");
+        }
+        manifest["chunk_sha256"] = std::move(digests);
+
+        // Write-then-rename so an interruption never leaves a torn map
+        std::string tmp_path = manifest_path_ + ".tmp";
+        {
+            std::ofstream file(tmp_path, std::ios::trunc);
+            file << manifest.dump();
+            if (!file) return;
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmp_path, manifest_path_, ec);
+    }
+
+    // Restores the chunk map and hash midstate of an interrupted download of the
+    // same resource. False: start from scratch.
+    bool loadManifest() {
+        std::ifstream file(manifest_path_);
+        std::error_code ec;
+        if (!file || !std::filesystem::exists(part_path_, ec)) {
+            return false;
+        }
+
+        try {
+            nlohmann::json manifest = nlohmann::json::parse(file);
+            if (manifest.value("version", 0) != kManifestVersion ||
+                manifest.value("url", "") != config_.url ||
+                manifest.value("size", uint64_t(0)) != total_bytes_ ||
+                manifest.value("chunk_bytes", uint64_t(0)) != config_.chunk_bytes ||
+                manifest.value("expected_sha256", "") != config_.expected_sha256 ||
+                std::filesystem::file_size(part_path_, ec) != total_bytes_) {
+                return false;
+            }
+
+            std::string done = manifest.at("chunks").get<std::string>();
+            auto digests = manifest.at("chunk_sha256").get<std::vector<std::string>>();
+            auto words = manifest.at("midstate").get<std::vector<uint32_t>>();
+            size_t hashed = manifest.at("hashed_chunks").get<size_t>();
+            uint64_t hashed_bytes = manifest.at("hashed_bytes").get<uint64_t>();
+            if (done.size() != chunk_count_ || digests.size() != chunk_count_ || words.size() != 8 ||
+                hashed > chunk_count_ ||
+                hashed_bytes != std::min<uint64_t>(hashed * config_.chunk_bytes, total_bytes_)) {
+                return false;
+            }
+
+            states_.assign(chunk_count_, ChunkState::PENDING);
+            chunk_digests_.assign(chunk_count_, Sha256::Digest{});
+            for (size_t i = 0; i < chunk_count_; ++i) {
+                // A done chunk without a digest is fetched again
+                if (done[i] == static_cast<char>(ChunkState::DONE) &&
+                    sha256::fromHex(digests[i], chunk_digests_[i])) {
+                    states_[i] = ChunkState::DONE;
+                }
+            }
+            for (size_t i = 0; i < hashed; ++i) {
+                if (states_[i] != ChunkState::DONE) return false;
+            }
+
+            std::copy(words.begin(), words.end(), saved_midstate_.h);
+            saved_midstate_.length = hashed_bytes;
+            hasher_.importMidstate(saved_midstate_);
+            hashed_chunks_ = hashed;
+            saved_hashed_chunks_ = hashed;
+            return true;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+};
+
+// ModelDownloader implementation
+ModelDownloader::ModelDownloader(const DownloadConfig& config, std::shared_ptr<DownloadTransport> transport)
+    : impl_(std::make_unique<Impl>(config, transport)) {}
+
+ModelDownloader::~ModelDownloader() = default;
+
+DownloadResult ModelDownloader::run() {
+    return impl_->run();
+}
+
+void ModelDownloader::cancel() {
+    impl_->cancel();
+}
+
+void ModelDownloader::setProgressCallback(std::function<void(float)> callback) {
+    impl_->setProgressCallback(callback);
+}
+
+} // namespace core
+} // namespace studyhive
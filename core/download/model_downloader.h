@@ -0,0 +1,84 @@
+#pragma once
+
+#include <string>
+#include <functional>
+#include <memory>
+#include <cstdint>
+#include <vector>
+#include "sha256.h"
+
+namespace studyhive {
+namespace core {
+
+// Byte-range source for the downloader. The built-in transport speaks plain
+// HTTP/1.1 (enough for a local stand-in server); platform wrappers supply an
+// HTTPS transport backed by the OS networking stack.
+class DownloadTransport {
+public:
+    virtual ~DownloadTransport() = default;
+
+    // Total size of the resource
+    virtual bool contentLength(const std::string& url, uint64_t& size, std::string& error_msg) = 0;
+
+    // Stream bytes [offset, offset + length) into sink. sink returns false to abort.
+    virtual bool fetchRange(const std::string& url, uint64_t offset, uint64_t length,
+                            const std::function<bool(const char*, size_t)>& sink,
+                            std::string& error_msg) = 0;
+};
+
+// http://host[:port]/path over POSIX sockets (no TLS, no redirects)
+std::shared_ptr<DownloadTransport> makeHttpTransport(int timeout_ms = 30000);
+
+struct DownloadConfig {
+    std::string url;
+    std::string dest_path;
+    std::string expected_sha256;          // Empty: the digest is computed but not checked
+    uint64_t chunk_bytes = 8 << 20;       // Rounded up to a multiple of 64 (SHA-256 block)
+    int parallel_chunks = 4;
+    int max_retries = 3;                  // Per chunk, before the download fails
+    size_t max_buffered_chunks = 8;       // Finished chunks waiting in memory for the hash
+};
+
+struct DownloadResult {
+    bool success = false;
+    std::string error_message;
+    std::string sha256;                   // Digest of the complete file
+    uint64_t chunk_bytes = 0;             // Chunk size actually used
+    std::vector<Sha256::Digest> chunk_digests;  // Per-chunk digests, hashed by the workers
+    uint64_t total_bytes = 0;
+    uint64_t downloaded_bytes = 0;        // Fetched by this run
+    uint64_t resumed_bytes = 0;           // Already on disk from an interrupted run
+    uint64_t reread_bytes = 0;            // Read back from disk to hash (resumed chunks)
+    int retried_chunks = 0;
+    float time_ms = 0.0f;
+};
+
+// Downloads url into dest_path in parallel byte ranges. Data goes to
+// dest_path + ".part" and the chunk map to dest_path + ".part.json", so an
+// interrupted download resumes where it stopped. The SHA-256 is computed while
+// chunks arrive: whenever the contiguous prefix of finished chunks grows, it is
+// hashed from memory and the midstate is saved with the chunk map.
+// Verification therefore ends with the last chunk, with no second read of the
+// file. dest_path is only created once the digest matches.
+class ModelDownloader {
+public:
+    explicit ModelDownloader(const DownloadConfig& config,
+                             std::shared_ptr<DownloadTransport> transport = nullptr);
+    ~ModelDownloader();
+
+    // Blocks until done, failed or cancelled
+    DownloadResult run();
+
+    // Stop at the next read; progress on disk is kept for the next run
+    void cancel();
+
+    // Fraction of the file present on disk (0.0 to 1.0), from worker threads
+    void setProgressCallback(std::function<void(float)> callback);
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace core
+} // namespace studyhive
@@ -0,0 +1,107 @@
+#include "positional_file.h"
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace studyhive {
+namespace core {
+
+bool PositionalFile::open(const std::string& path, uint64_t size, bool keep, std::string& error_msg) {
+    close();
+#ifdef _WIN32
+    if (!keep || !std::filesystem::exists(path)) {
+        std::ofstream(path, std::ios::binary | std::ios::trunc).close();
+    }
+    std::error_code ec;
+    std::filesystem::resize_file(path, size, ec);
+    file_.open(path, std::ios::binary | std::ios::in | std::ios::out);
+    if (ec || !file_) {
+        error_msg = "Cannot open " + path;
+        return false;
+    }
+    path_ = path;
+#else
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | (keep ? 0 : O_TRUNC), 0644);
+    if (fd_ < 0 || ::ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+        error_msg = "Cannot open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+#endif
+    return true;
+}
+
+bool PositionalFile::writeAt(uint64_t offset, const char* data, size_t size) {
+#ifdef _WIN32
+    std::lock_guard<std::mutex> lock(mutex_);
+    file_.seekp(static_cast<std::streamoff>(offset));
+    file_.write(data, static_cast<std::streamsize>(size));
+    return static_cast<bool>(file_);
+#else
+    while (size > 0) {
+        ssize_t n = ::pwrite(fd_, data, size, static_cast<off_t>(offset));
+        if (n <= 0) return false;
+        data += n;
+        size -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+#endif
+}
+
+bool PositionalFile::readAt(uint64_t offset, char* data, size_t size) {
+#ifdef _WIN32
+    std::lock_guard<std::mutex> lock(mutex_);
+    file_.seekg(static_cast<std::streamoff>(offset));
+    file_.read(data, static_cast<std::streamsize>(size));
+    return static_cast<bool>(file_);
+#else
+    while (size > 0) {
+        ssize_t n = ::pread(fd_, data, size, static_cast<off_t>(offset));
+        if (n <= 0) return false;
+        data += n;
+        size -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+#endif
+}
+
+bool PositionalFile::resize(uint64_t size) {
+#ifdef _WIN32
+    std::lock_guard<std::mutex> lock(mutex_);
+    file_.flush();
+    std::error_code ec;
+    std::filesystem::resize_file(path_, size, ec);
+    return !ec;
+#else
+    return ::ftruncate(fd_, static_cast<off_t>(size)) == 0;
+#endif
+}
+
+void PositionalFile::sync() {
+#ifdef _WIN32
+    std::lock_guard<std::mutex> lock(mutex_);
+    file_.flush();
+#elif defined(__APPLE__)
+    ::fsync(fd_);
+#else
+    ::fdatasync(fd_);
+#endif
+}
+
+void PositionalFile::close() {
+#ifdef _WIN32
+    if (file_.is_open()) file_.close();
+#else
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+#endif
+}
+
+} // namespace core
+} // namespace studyhive
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+#ifdef _WIN32
+#include <fstream>
+#include <mutex>
+#endif
+
+namespace studyhive {
+namespace core {
+
+// Positional reads and writes on one file, safe to call from several threads
+// (pread/pwrite; a locked fstream on Windows)
+class PositionalFile {
+public:
+    PositionalFile() = default;
+    ~PositionalFile() { close(); }
+
+    PositionalFile(const PositionalFile&) = delete;
+    PositionalFile& operator=(const PositionalFile&) = delete;
+
+    // Opens (creating if needed) and sizes the file; keep tells whether the
+    // existing contents are preserved
+    bool open(const std::string& path, uint64_t size, bool keep, std::string& error_msg);
+
+    bool writeAt(uint64_t offset, const char* data, size_t size);
+    bool readAt(uint64_t offset, char* data, size_t size);
+    bool resize(uint64_t size);
+
+    // Data must be durable before anything on disk claims it
+    void sync();
+    void close();
+
+private:
+#ifdef _WIN32
+    std::string path_;
+    std::mutex mutex_;
+    std::fstream file_;
+#else
+    int fd_ = -1;
+#endif
+};
+
+} // namespace core
+} // namespace studyhive
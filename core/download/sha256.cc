@@ -0,0 +1,312 @@
+#include "sha256.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+// Hardware SHA-256 rounds: SHA-NI is picked at run time on x86-64 (GCC/Clang
+// target attributes, no special build flags); the ARMv8 SHA2 extension is used
+// when the compiler targets it (always the case for Apple silicon).
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define STUDYHIVE_SHA256_X86 1
+#elif defined(__aarch64__) && (defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO))
+#include <arm_neon.h>
+#define STUDYHIVE_SHA256_ARM 1
+#endif
+
+namespace studyhive {
+namespace core {
+
+namespace {
+
+constexpr uint32_t kRoundConstants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+constexpr uint32_t kInitialState[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+inline uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+inline uint32_t loadBigEndian(const uint8_t* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+#if defined(STUDYHIVE_SHA256_X86)
+
+// Message schedule and rounds four at a time; state held as ABEF/CDGH
+__attribute__((target("sha,sse4.1")))
+void compressShaNi(uint32_t state[8], const uint8_t* data, size_t count) {
+    const __m128i byte_swap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[0])), 0xB1);
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[4])), 0x1B);
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+    for (size_t block = 0; block < count; ++block, data += 64) {
+        __m128i abef = state0;
+        __m128i cdgh = state1;
+        __m128i w[4];
+
+        for (int j = 0; j < 16; ++j) {
+            if (j < 4) {
+                w[j] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * j)), byte_swap);
+            } else {
+                __m128i next = _mm_sha256msg1_epu32(w[j & 3], w[(j + 1) & 3]);
+                next = _mm_add_epi32(next, _mm_alignr_epi8(w[(j + 3) & 3], w[(j + 2) & 3], 4));
+                w[j & 3] = _mm_sha256msg2_epu32(next, w[(j + 3) & 3]);
+            }
+
+            __m128i message = _mm_add_epi32(w[j & 3],
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(&kRoundConstants[4 * j])));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, message);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(message, 0x0E));
+        }
+
+        state0 = _mm_add_epi32(state0, abef);
+        state1 = _mm_add_epi32(state1, cdgh);
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[0]), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[4]), state1);
+}
+
+bool hasShaNi() {
+    static const bool supported = __builtin_cpu_supports("sha") && __builtin_cpu_supports("sse4.1");
+    return supported;
+}
+
+#elif defined(STUDYHIVE_SHA256_ARM)
+
+void compressArm(uint32_t state[8], const uint8_t* data, size_t count) {
+    uint32x4_t state0 = vld1q_u32(&state[0]);
+    uint32x4_t state1 = vld1q_u32(&state[4]);
+
+    for (size_t block = 0; block < count; ++block, data += 64) {
+        uint32x4_t abcd = state0;
+        uint32x4_t efgh = state1;
+        uint32x4_t w[4];
+
+        for (int j = 0; j < 16; ++j) {
+            if (j < 4) {
+                w[j] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16 * j)));
+            } else {
+                w[j & 3] = vsha256su1q_u32(vsha256su0q_u32(w[j & 3], w[(j + 1) & 3]),
+                                           w[(j + 2) & 3], w[(j + 3) & 3]);
+            }
+
+            uint32x4_t message = vaddq_u32(w[j & 3], vld1q_u32(&kRoundConstants[4 * j]));
+            uint32x4_t previous = state0;
+            state0 = vsha256hq_u32(state0, state1, message);
+            state1 = vsha256h2q_u32(state1, previous, message);
+        }
+
+        state0 = vaddq_u32(state0, abcd);
+        state1 = vaddq_u32(state1, efgh);
+    }
+
+    vst1q_u32(&state[0], state0);
+    vst1q_u32(&state[4], state1);
+}
+
+#endif
+
+} // namespace
+
+Sha256::Sha256() {
+    reset();
+}
+
+void Sha256::reset() {
+    std::memcpy(h_, kInitialState, sizeof(h_));
+    block_size_ = 0;
+    length_ = 0;
+}
+
+void Sha256::compress(const uint8_t* blocks, size_t count) {
+#if defined(STUDYHIVE_SHA256_X86)
+    if (hasShaNi()) {
+        compressShaNi(h_, blocks, count);
+        return;
+    }
+#elif defined(STUDYHIVE_SHA256_ARM)
+    compressArm(h_, blocks, count);
+    return;
+#endif
+
+    uint32_t w[64];
+    for (size_t block = 0; block < count; ++block, blocks += 64) {
+        for (int i = 0; i < 16; ++i) {
+            w[i] = loadBigEndian(blocks + 4 * i);
+        }
+        for (int i = 16; i < 64; ++i) {
+            uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = h_[0], b = h_[1], c = h_[2], d = h_[3];
+        uint32_t e = h_[4], f = h_[5], g = h_[6], h = h_[7];
+        for (int i = 0; i < 64; ++i) {
+            uint32_t s1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+            uint32_t ch = (e & f) ^ (~e & g);
+            uint32_t t1 = h + s1 + ch + kRoundConstants[i] + w[i];
+            uint32_t s0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+            uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+            uint32_t t2 = s0 + maj;
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+
+        h_[0] += a; h_[1] += b; h_[2] += c; h_[3] += d;
+        h_[4] += e; h_[5] += f; h_[6] += g; h_[7] += h;
+    }
+}
+
+void Sha256::update(const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    length_ += size;
+
+    if (block_size_ > 0) {
+        size_t take = std::min(size, sizeof(block_) - block_size_);
+        std::memcpy(block_ + block_size_, bytes, take);
+        block_size_ += take;
+        bytes += take;
+        size -= take;
+        if (block_size_ < sizeof(block_)) {
+            return;
+        }
+        compress(block_, 1);
+        block_size_ = 0;
+    }
+
+    // Whole blocks straight from the caller's buffer
+    size_t whole = size / 64;
+    compress(bytes, whole);
+    bytes += whole * 64;
+    size -= whole * 64;
+
+    std::memcpy(block_, bytes, size);
+    block_size_ = size;
+}
+
+Sha256::Digest Sha256::finish() {
+    uint64_t bit_length = length_ * 8;
+    uint8_t padding[72] = {0x80};
+    size_t pad = (block_size_ < 56 ? 56 : 120) - block_size_;
+    for (int i = 0; i < 8; ++i) {
+        padding[pad + i] = static_cast<uint8_t>(bit_length >> (56 - 8 * i));
+    }
+    update(padding, pad + 8);
+
+    Digest digest;
+    for (int i = 0; i < 8; ++i) {
+        digest[4 * i] = static_cast<uint8_t>(h_[i] >> 24);
+        digest[4 * i + 1] = static_cast<uint8_t>(h_[i] >> 16);
+        digest[4 * i + 2] = static_cast<uint8_t>(h_[i] >> 8);
+        digest[4 * i + 3] = static_cast<uint8_t>(h_[i]);
+    }
+    return digest;
+}
+
+std::string Sha256::finishHex() {
+    return sha256::toHex(finish());
+}
+
+bool Sha256::exportMidstate(Midstate& state) const {
+    if (block_size_ != 0) {
+        return false;
+    }
+    std::memcpy(state.h, h_, sizeof(h_));
+    state.length = length_;
+    return true;
+}
+
+void Sha256::importMidstate(const Midstate& state) {
+    std::memcpy(h_, state.h, sizeof(h_));
+    length_ = state.length;
+    block_size_ = 0;
+}
+
+namespace sha256 {
+
+std::string toHex(const Sha256::Digest& digest) {
+    static const char* kHex = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(digest.size() * 2);
+    for (uint8_t byte : digest) {
+        hex += kHex[byte >> 4];
+        hex += kHex[byte & 0xf];
+    }
+    return hex;
+}
+
+bool fromHex(const std::string& hex, Sha256::Digest& digest) {
+    if (hex.size() != digest.size() * 2) {
+        return false;
+    }
+    for (size_t i = 0; i < hex.size(); ++i) {
+        char c = hex[i];
+        unsigned value;
+        if (c >= '0' && c <= '9') value = c - '0';
+        else if (c >= 'a' && c <= 'f') value = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') value = c - 'A' + 10;
+        else return false;
+        digest[i / 2] = static_cast<uint8_t>(i % 2 ? (digest[i / 2] << 4) | value : value);
+    }
+    return true;
+}
+
+bool hashFile(const std::string& path, std::string& hex_digest, std::string& error_msg) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error_msg = "Cannot open " + path;
+        return false;
+    }
+
+    Sha256 hasher;
+    std::vector<char> buffer(1 << 20);
+    while (file) {
+        file.read(buffer.data(), buffer.size());
+        hasher.update(buffer.data(), static_cast<size_t>(file.gcount()));
+    }
+    if (file.bad()) {
+        error_msg = "Read error in " + path;
+        return false;
+    }
+
+    hex_digest = hasher.finishHex();
+    return true;
+}
+
+bool digestEquals(const std::string& a, const std::string& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace sha256
+
+} // namespace core
+} // namespace studyhive
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace studyhive {
+namespace core {
+
+// Incremental SHA-256 (FIPS 180-4)
+class Sha256 {
+public:
+    using Digest = std::array<uint8_t, 32>;
+
+    // Chaining state after a whole number of 64-byte blocks. Lets a hash be
+    // persisted and resumed without rereading the bytes already hashed.
+    struct Midstate {
+        uint32_t h[8];
+        uint64_t length = 0;  // Bytes hashed; a multiple of 64
+    };
+
+    Sha256();
+
+    void update(const void* data, size_t size);
+
+    // Pads and returns the digest; the object must be reset before reuse
+    Digest finish();
+    std::string finishHex();
+
+    void reset();
+
+    // False if a partial block is buffered
+    bool exportMidstate(Midstate& state) const;
+    void importMidstate(const Midstate& state);
+
+    uint64_t length() const { return length_; }
+
+private:
+    uint32_t h_[8];
+    uint8_t block_[64];
+    size_t block_size_ = 0;
+    uint64_t length_ = 0;
+
+    void compress(const uint8_t* blocks, size_t count);
+};
+
+namespace sha256 {
+
+std::string toHex(const Sha256::Digest& digest);
+bool fromHex(const std::string& hex, Sha256::Digest& digest);
+
+// Lowercase hex digest of a whole file
+bool hashFile(const std::string& path, std::string& hex_digest, std::string& error_msg);
+
+// Case-insensitive comparison of hex digests
+bool digestEquals(const std::string& a, const std::string& b);
+
+} // namespace sha256
+
+} // namespace core
+} // namespace studyhive
@@ -0,0 +1,328 @@
+#include "verification_cache.h"
+#include "../llm/gguf_reader.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+namespace studyhive {
+namespace core {
+
+namespace {
+
+constexpr int kCacheVersion = 1;
+
+Sha256::Digest hashRange(const uint8_t* data, size_t size) {
+    Sha256 hasher;
+    hasher.update(data, size);
+    return hasher.finish();
+}
+
+int resolveThreads(int threads) {
+    if (threads > 0) return threads;
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Chunk digests of an open mapping on up to threads workers
+bool hashChunks(const MappedFile& file, uint64_t chunk_bytes, int threads,
+                const std::atomic<bool>* cancel, std::vector<Sha256::Digest>& digests) {
+    size_t chunk_count = static_cast<size_t>((file.size() + chunk_bytes - 1) / chunk_bytes);
+    digests.assign(chunk_count, Sha256::Digest{});
+
+    std::atomic<size_t> next{0};
+    auto work = [&]() {
+        for (size_t index = next++; index < chunk_count; index = next++) {
+            if (cancel && *cancel) return;
+            uint64_t offset = index * chunk_bytes;
+            size_t size = static_cast<size_t>(std::min<uint64_t>(chunk_bytes, file.size() - offset));
+            digests[index] = hashRange(file.data() + offset, size);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    size_t worker_count = std::min<size_t>(resolveThreads(threads), chunk_count);
+    for (size_t i = 1; i < worker_count; ++i) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return !(cancel && *cancel);
+}
+
+} // namespace
+
+bool FileIdentity::operator==(const FileIdentity& other) const {
+    return path == other.path && size == other.size && mtime_ns == other.mtime_ns && inode == other.inode;
+}
+
+VerificationCache::VerificationCache(const std::string& cache_path) : cache_path_(cache_path) {}
+
+bool VerificationCache::load(std::string& error_msg) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    records_.clear();
+
+    std::ifstream file(cache_path_);
+    if (!file) {
+        return true;  // Nothing verified yet
+    }
+
+    try {
+        nlohmann::json cache = nlohmann::json::parse(file);
+        if (cache.value("version", 0) != kCacheVersion) {
+            return true;
+        }
+
+        for (const auto& entry : cache.at("entries")) {
+            VerificationRecord record;
+            record.identity.path = entry.at("path").get<std::string>();
+            record.identity.size = entry.at("size").get<uint64_t>();
+            record.identity.mtime_ns = entry.at("mtime_ns").get<int64_t>();
+            record.identity.inode = entry.at("inode").get<uint64_t>();
+            record.sha256 = entry.at("sha256").get<std::string>();
+            record.chunk_bytes = entry.at("chunk_bytes").get<uint64_t>();
+            record.chunk_root = entry.at("chunk_root").get<std::string>();
+            record.verified_at = entry.value("verified_at", int64_t(0));
+
+            bool valid = record.chunk_bytes > 0;
+            for (const auto& hex : entry.at("chunks")) {
+                Sha256::Digest digest;
+                valid = valid && sha256::fromHex(hex.get<std::string>(), digest);
+                record.chunk_digests.push_back(digest);
+            }
+            uint64_t expected_chunks = valid ? (record.identity.size + record.chunk_bytes - 1) / record.chunk_bytes : 0;
+            if (valid && record.chunk_digests.size() == expected_chunks &&
+                integrity::chunkRoot(record.chunk_digests) == record.chunk_root) {
+                records_[record.identity.path] = std::move(record);
+            }
+        }
+        return true;
+    } catch (const std::exception& e) {
+        error_msg = std::string("Corrupt verification cache: ") + e.what();
+        return false;
+    }
+}
+
+bool VerificationCache::save(std::string& error_msg) const {
+    nlohmann::json entries = nlohmann::json::array();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& [path, record] : records_) {
+            nlohmann::json chunks = nlohmann::json::array();
+            for (const auto& digest : record.chunk_digests) {
+                chunks.push_back(sha256::toHex(digest));
+            }
+            entries.push_back({
+                {"path", path},
+                {"size", record.identity.size},
+                {"mtime_ns", record.identity.mtime_ns},
+                {"inode", record.identity.inode},
+                {"sha256", record.sha256},
+                {"chunk_bytes", record.chunk_bytes},
+                {"chunk_root", record.chunk_root},
+                {"verified_at", record.verified_at},
+                {"chunks", std::move(chunks)}
+            });
+        }
+    }
+
+    nlohmann::json cache = {{"version", kCacheVersion}, {"entries", std::move(entries)}};
+    std::string tmp_path = cache_path_ + ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::trunc);
+        file << cache.dump();
+        if (!file) {
+            error_msg = "Cannot write " + tmp_path;
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, cache_path_, ec);
+    if (ec) {
+        error_msg = "Cannot replace " + cache_path_ + ": " + ec.message();
+        return false;
+    }
+    return true;
+}
+
+bool VerificationCache::lookup(const FileIdentity& identity, VerificationRecord& record) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = records_.find(identity.path);
+    if (it == records_.end() || !(it->second.identity == identity)) {
+        return false;
+    }
+    record = it->second;
+    return true;
+}
+
+void VerificationCache::store(const VerificationRecord& record) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    records_[record.identity.path] = record;
+}
+
+void VerificationCache::invalidate(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    records_.erase(path);
+}
+
+namespace integrity {
+
+bool identify(const std::string& path, FileIdentity& identity, std::string& error_msg) {
+    identity = FileIdentity();
+    identity.path = path;
+#ifdef _WIN32
+    std::error_code ec;
+    identity.size = std::filesystem::file_size(path, ec);
+    auto mtime = std::filesystem::last_write_time(path, ec);
+    if (ec) {
+        error_msg = "Cannot stat " + path + ": " + ec.message();
+        return false;
+    }
+    identity.mtime_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(mtime.time_since_epoch()).count();
+#else
+    struct stat info;
+    if (::stat(path.c_str(), &info) != 0) {
+        error_msg = "Cannot stat " + path;
+        return false;
+    }
+    identity.size = static_cast<uint64_t>(info.st_size);
+    identity.inode = static_cast<uint64_t>(info.st_ino);
+#ifdef __APPLE__
+    identity.mtime_ns = int64_t(info.st_mtimespec.tv_sec) * 1000000000 + info.st_mtimespec.tv_nsec;
+#else
+    identity.mtime_ns = int64_t(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+#endif
+#endif
+    return true;
+}
+
+std::string chunkRoot(const std::vector<Sha256::Digest>& chunk_digests) {
+    Sha256 hasher;
+    for (const auto& digest : chunk_digests) {
+        hasher.update(digest.data(), digest.size());
+    }
+    return hasher.finishHex();
+}
+
+bool hashFile(const std::string& path, const HashOptions& options, VerificationRecord& record,
+              std::string& error_msg) {
+    if (!identify(path, record.identity, error_msg)) {
+        return false;
+    }
+
+    MappedFile file;
+    if (!file.open(path, error_msg)) {
+        return false;
+    }
+
+    // The whole-file digest is inherently sequential; it runs beside the chunk
+    // workers, which keep the pages it needs next in the page cache
+    std::thread whole_file;
+    std::string whole_digest;
+    if (options.whole_file) {
+        whole_file = std::thread([&]() {
+            Sha256 hasher;
+            const size_t step = 1 << 20;
+            for (size_t offset = 0; offset < file.size(); offset += step) {
+                if (options.cancel && *options.cancel) return;
+                hasher.update(file.data() + offset, std::min(step, file.size() - offset));
+            }
+            whole_digest = hasher.finishHex();
+        });
+    }
+
+    int chunk_threads = resolveThreads(options.threads) - (options.whole_file ? 1 : 0);
+    record.chunk_bytes = std::max<uint64_t>(options.chunk_bytes, 1);
+    bool ok = hashChunks(file, record.chunk_bytes, std::max(chunk_threads, 1), options.cancel,
+                         record.chunk_digests);
+    if (whole_file.joinable()) {
+        whole_file.join();
+    }
+
+    if (!ok || (options.cancel && *options.cancel)) {
+        error_msg = "Verification cancelled";
+        return false;
+    }
+
+    record.sha256 = whole_digest;
+    record.chunk_root = chunkRoot(record.chunk_digests);
+    record.verified_at = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    return true;
+}
+
+bool sampleCheck(const std::string& path, const VerificationRecord& record, int sample_count,
+                 std::string& error_msg) {
+    MappedFile file;
+    if (!file.open(path, error_msg)) {
+        return false;
+    }
+    if (file.size() != record.identity.size || record.chunk_digests.empty()) {
+        error_msg = "Size changed since verification";
+        return false;
+    }
+
+    size_t chunk_count = record.chunk_digests.size();
+    std::vector<size_t> samples = {0, chunk_count - 1};
+    std::mt19937_64 rng(std::random_device{}());
+    while (samples.size() < std::min<size_t>(std::max(sample_count, 2), chunk_count)) {
+        size_t index = rng() % chunk_count;
+        if (std::find(samples.begin(), samples.end(), index) == samples.end()) {
+            samples.push_back(index);
+        }
+    }
+
+    for (size_t index : samples) {
+        uint64_t offset = index * record.chunk_bytes;
+        size_t size = static_cast<size_t>(std::min<uint64_t>(record.chunk_bytes, file.size() - offset));
+        if (hashRange(file.data() + offset, size) != record.chunk_digests[index]) {
+            error_msg = "Chunk " + std::to_string(index) + " does not match its verified digest";
+            return false;
+        }
+    }
+    return true;
+}
+
+bool fullCheck(const std::string& path, const VerificationRecord& record, int threads,
+               const std::atomic<bool>* cancel, std::string& error_msg) {
+    MappedFile file;
+    if (!file.open(path, error_msg)) {
+        return false;
+    }
+    if (file.size() != record.identity.size) {
+        error_msg = "Size changed since verification";
+        return false;
+    }
+
+    std::vector<Sha256::Digest> digests;
+    if (!hashChunks(file, record.chunk_bytes, threads, cancel, digests)) {
+        error_msg = "Verification cancelled";
+        return false;
+    }
+
+    if (chunkRoot(digests) != record.chunk_root) {
+        for (size_t i = 0; i < digests.size(); ++i) {
+            if (digests[i] != record.chunk_digests[i]) {
+                error_msg = "Chunk " + std::to_string(i) + " does not match its verified digest";
+                return false;
+            }
+        }
+        error_msg = "Chunk root mismatch";
+        return false;
+    }
+    return true;
+}
+
+} // namespace integrity
+
+} // namespace core
+} // namespace studyhive
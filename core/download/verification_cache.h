@@ -0,0 +1,88 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include "sha256.h"
+
+namespace studyhive {
+namespace core {
+
+// What identifies one version of a file on disk. Any rewrite changes the
+// size, mtime or inode, so a matching identity means the bytes were not touched.
+struct FileIdentity {
+    std::string path;
+    uint64_t size = 0;
+    int64_t mtime_ns = 0;
+    uint64_t inode = 0;  // 0 where unavailable
+
+    bool operator==(const FileIdentity& other) const;
+};
+
+// Digests of a verified file. chunk_digests hash fixed-size chunks
+// independently, so they can be computed in parallel and spot-checked;
+// chunk_root is the SHA-256 of their concatenation.
+struct VerificationRecord {
+    FileIdentity identity;
+    std::string sha256;  // Whole-file digest, as published for the model
+    uint64_t chunk_bytes = 0;
+    std::vector<Sha256::Digest> chunk_digests;
+    std::string chunk_root;
+    int64_t verified_at = 0;  // Unix seconds
+};
+
+// Verified digests keyed by path, persisted as JSON. Entries whose file
+// identity no longer matches are treated as absent.
+class VerificationCache {
+public:
+    explicit VerificationCache(const std::string& cache_path);
+
+    bool load(std::string& error_msg);
+    bool save(std::string& error_msg) const;
+
+    bool lookup(const FileIdentity& identity, VerificationRecord& record) const;
+    void store(const VerificationRecord& record);
+    void invalidate(const std::string& path);
+
+private:
+    std::string cache_path_;
+    mutable std::mutex mutex_;
+    std::map<std::string, VerificationRecord> records_;
+};
+
+namespace integrity {
+
+struct HashOptions {
+    uint64_t chunk_bytes = 4 << 20;
+    int threads = 0;                          // 0: hardware concurrency
+    bool whole_file = true;                   // Also compute the sequential whole-file SHA-256
+    const std::atomic<bool>* cancel = nullptr;
+};
+
+bool identify(const std::string& path, FileIdentity& identity, std::string& error_msg);
+
+// SHA-256 of the concatenated chunk digests
+std::string chunkRoot(const std::vector<Sha256::Digest>& chunk_digests);
+
+// Hash an mmapped file: chunk digests on a thread pool and, if requested, the
+// whole-file digest on one more thread in the same pass over the page cache
+bool hashFile(const std::string& path, const HashOptions& options, VerificationRecord& record,
+              std::string& error_msg);
+
+// Rehash sample_count chunks (always the first and last, the rest random)
+// and compare them with the record. Catches truncation and most corruption
+// in a few milliseconds.
+bool sampleCheck(const std::string& path, const VerificationRecord& record, int sample_count,
+                 std::string& error_msg);
+
+// Rehash every chunk in parallel and compare the chunk root with the record
+bool fullCheck(const std::string& path, const VerificationRecord& record, int threads,
+               const std::atomic<bool>* cancel, std::string& error_msg);
+
+} // namespace integrity
+
+} // namespace core
+} // namespace studyhive
@@ -0,0 +1,244 @@
+#include "embedding_scorer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace studyhive {
+namespace core {
+
+class EmbeddingScorer::Impl {
+public:
+    Impl(LLMBridge& bridge, const EmbeddingScorerOptions& options)
+        : bridge_(bridge), options_(options), stats_{0, 0, 0, 0} {}
+
+    EmbeddingScore score(const ShortAnswerQuestion& question, const std::string& student_answer) {
+        auto start_time = std::chrono::high_resolution_clock::now();
+        EmbeddingScore result;
+
+        auto references = referenceEmbeddings(question);
+        EmbeddingResponse answer = bridge_.embed(student_answer);
+        result.prompt_tokens = answer.prompt_tokens;
+        if (!references || !answer.success) {
+            return result;
+        }
+
+        // Short criterion texts never sit close to a full answer, so coverage is
+        // measured against how close the sample answer (full marks) gets
+        std::vector<float> criterion_similarity;
+        std::vector<float> coverage;
+        float rubric_coverage = 0.0f;
+        float total_points = 0.0f;
+        for (size_t i = 0; i < question.rubric.size(); ++i) {
+            float similarity = dot(answer.embedding, references->criteria[i]);
+            float reference = references->sample_coverage[i];
+            criterion_similarity.push_back(similarity);
+            coverage.push_back(reference > 0.0f ? std::min(similarity / reference, 1.0f) : similarity);
+            rubric_coverage += coverage.back() * question.rubric[i].points;
+            total_points += question.rubric[i].points;
+        }
+        if (total_points > 0.0f) {
+            rubric_coverage /= total_points;
+        }
+
+        float sample_weight = references->sample.empty() ? 0.0f : options_.sample_weight;
+        float sample_similarity = references->sample.empty() ? 0.0f : dot(answer.embedding, references->sample);
+        result.similarity = sample_weight * sample_similarity + (1.0f - sample_weight) * rubric_coverage;
+
+        bool accept = result.similarity >= options_.accept_similarity;
+        bool reject = result.similarity <= options_.reject_similarity;
+        if (!accept && !reject) {
+            return result;
+        }
+
+        GradePayload& payload = result.payload;
+        payload.question_id = question.id;
+        for (size_t i = 0; i < question.rubric.size(); ++i) {
+            const auto& criterion = question.rubric[i];
+            GradeBreakdownItem item;
+            item.criterion = criterion.criterion;
+            item.max_points = criterion.points;
+            // Accepted answers earn each criterion by its coverage, in half-point steps
+            float fraction = accept ? calibrate(coverage[i]) : 0.0f;
+            item.awarded_points = std::round(fraction * criterion.points * 2.0f) / 2.0f;
+            char similarity[16];
+            std::snprintf(similarity, sizeof(similarity), "%.2f", criterion_similarity[i]);
+            item.reasoning = std::string("Embedding similarity to this criterion: ") + similarity;
+            payload.total_score += item.awarded_points;
+            payload.max_score += item.max_points;
+            payload.breakdown.push_back(std::move(item));
+        }
+        payload.feedback = accept ? "Your answer closely matches the expected answer."
+                                  : "Your answer does not address the question. Review the material and try again.";
+
+        auto end_time = std::chrono::high_resolution_clock::now();
+        GradeMetadata metadata;
+        metadata.source = "device-llm";
+        metadata.processing_time_ms = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+        payload.metadata = std::move(metadata);
+
+        result.decided = true;
+        return result;
+    }
+
+    bool grade(const ShortAnswerQuestion& question,
+               const std::string& student_answer,
+               const std::string& grammar_path,
+               GradePayload& payload,
+               std::string& error_msg,
+               const GenerationOptions& options) {
+        EmbeddingScore fast = score(question, student_answer);
+        if (fast.decided) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stats_.fast_path++;
+            payload = std::move(fast.payload);
+            return true;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stats_.escalated++;
+        }
+
+        std::string prompt = prompts::buildGradePrompt(question, student_answer);
+        LLMResponse response = bridge_.gradeAnswerAsync(prompt, grammar_path, options).get();
+        if (!response.success) {
+            error_msg = response.error_message;
+            return false;
+        }
+        return validation::parseGradePayload(bridge_.responseSchemas(), response.content, payload, error_msg);
+    }
+
+    void invalidate(const std::string& question_id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (cache_.erase(question_id)) {
+            cache_order_.erase(std::find(cache_order_.begin(), cache_order_.end(), question_id));
+        }
+    }
+
+    EmbeddingScorer::Stats getStats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+private:
+    struct ReferenceEmbeddings {
+        std::string source;                        // referenceSource() of the question embedded
+        std::vector<float> sample;
+        std::vector<std::vector<float>> criteria;  // Parallel to the rubric
+        std::vector<float> sample_coverage;        // Sample answer vs. each criterion
+    };
+
+    LLMBridge& bridge_;
+    EmbeddingScorerOptions options_;
+
+    // Reference embeddings keyed by question id, evicted oldest first. Ids are
+    // positional in the apps (saq_0 of every quiz), so a hit also has to match
+    // the text the embeddings were computed from.
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<const ReferenceEmbeddings>> cache_;
+    std::deque<std::string> cache_order_;
+    EmbeddingScorer::Stats stats_;
+
+    static std::string criterionText(const RubricCriterion& criterion) {
+        std::string text = criterion.criterion + ":";
+        for (const auto& keyword : criterion.keywords) {
+            text += " " + keyword;
+        }
+        return text;
+    }
+
+    // Everything the reference embeddings depend on, unit-separated
+    static std::string referenceSource(const ShortAnswerQuestion& question) {
+        std::string source = question.sample_answer;
+        for (const auto& criterion : question.rubric) {
+            source += '\x1f';
+            source += criterionText(criterion);
+        }
+        return source;
+    }
+
+    std::shared_ptr<const ReferenceEmbeddings> referenceEmbeddings(const ShortAnswerQuestion& question) {
+        std::string source = referenceSource(question);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = cache_.find(question.id);
+            if (it != cache_.end() && it->second->source == source) {
+                stats_.cache_hits++;
+                return it->second;
+            }
+            stats_.cache_misses++;
+        }
+
+        auto references = std::make_shared<ReferenceEmbeddings>();
+        references->source = std::move(source);
+        if (!question.sample_answer.empty()) {
+            EmbeddingResponse sample = bridge_.embed(question.sample_answer);
+            if (!sample.success) return nullptr;
+            references->sample = std::move(sample.embedding);
+        }
+
+        for (const auto& criterion : question.rubric) {
+            EmbeddingResponse embedding = bridge_.embed(criterionText(criterion));
+            if (!embedding.success) return nullptr;
+            references->sample_coverage.push_back(dot(references->sample, embedding.embedding));
+            references->criteria.push_back(std::move(embedding.embedding));
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!cache_.count(question.id)) {
+            cache_order_.push_back(question.id);
+        }
+        cache_[question.id] = references;
+        while (cache_.size() > options_.max_cached_questions && !cache_order_.empty()) {
+            cache_.erase(cache_order_.front());
+            cache_order_.pop_front();
+        }
+        return references;
+    }
+
+    float calibrate(float similarity) const {
+        float span = options_.accept_similarity - options_.reject_similarity;
+        if (span <= 0.0f) return similarity >= options_.accept_similarity ? 1.0f : 0.0f;
+        return std::clamp((similarity - options_.reject_similarity) / span, 0.0f, 1.0f);
+    }
+
+    static float dot(const std::vector<float>& a, const std::vector<float>& b) {
+        float sum = 0.0f;
+        size_t n = std::min(a.size(), b.size());
+        for (size_t i = 0; i < n; ++i) sum += a[i] * b[i];
+        return sum;
+    }
+};
+
+EmbeddingScorer::EmbeddingScorer(LLMBridge& bridge, const EmbeddingScorerOptions& options)
+    : impl_(std::make_unique<Impl>(bridge, options)) {}
+
+EmbeddingScorer::~EmbeddingScorer() = default;
+
+EmbeddingScore EmbeddingScorer::score(const ShortAnswerQuestion& question, const std::string& student_answer) {
+    return impl_->score(question, student_answer);
+}
+
+bool EmbeddingScorer::grade(const ShortAnswerQuestion& question,
+                            const std::string& student_answer,
+                            const std::string& grammar_path,
+                            GradePayload& payload,
+                            std::string& error_msg,
+                            const GenerationOptions& options) {
+    return impl_->grade(question, student_answer, grammar_path, payload, error_msg, options);
+}
+
+void EmbeddingScorer::invalidate(const std::string& question_id) {
+    impl_->invalidate(question_id);
+}
+
+EmbeddingScorer::Stats EmbeddingScorer::getStats() const {
+    return impl_->getStats();
+}
+
+} // namespace core
+} // namespace studyhive
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include "llama_bridge.h"
+#include "../types/quiz_types.h"
+
+namespace studyhive {
+namespace core {
+
+struct EmbeddingScorerOptions {
+    float accept_similarity = 0.75f;  // At or above: clearly correct
+    float reject_similarity = 0.25f;  // At or below: clearly wrong
+    float sample_weight = 0.5f;       // Sample answer vs. rubric criteria
+    size_t max_cached_questions = 256;
+};
+
+struct EmbeddingScore {
+    bool decided = false;      // false: ambiguous, needs generative grading
+    float similarity = 0.0f;   // Blended sample/rubric similarity
+    GradePayload payload;      // Filled when decided
+    int prompt_tokens = 0;     // Tokens prefilled for this answer
+};
+
+// Short-answer scoring from embeddings: the answer is compared with the
+// sample answer and each rubric criterion (name + keywords). Reference
+// embeddings are cached per question id and recomputed when the sample
+// answer or rubric under that id changes.
+class EmbeddingScorer {
+public:
+    explicit EmbeddingScorer(LLMBridge& bridge,
+                             const EmbeddingScorerOptions& options = EmbeddingScorerOptions());
+    ~EmbeddingScorer();
+
+    // Embedding-only score; decided is false when the answer is ambiguous
+    EmbeddingScore score(const ShortAnswerQuestion& question, const std::string& student_answer);
+
+    // Score on the fast path, escalating ambiguous answers to LLMBridge::gradeAnswer
+    bool grade(const ShortAnswerQuestion& question,
+               const std::string& student_answer,
+               const std::string& grammar_path,
+               GradePayload& payload,
+               std::string& error_msg,
+               const GenerationOptions& options = GenerationOptions());
+
+    // Drop cached reference embeddings (edits are also caught on the next score)
+    void invalidate(const std::string& question_id);
+
+    struct Stats {
+        size_t fast_path;
+        size_t escalated;
+        size_t cache_hits;
+        size_t cache_misses;
+    };
+
+    Stats getStats() const;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace core
+} // namespace studyhive
@@ -0,0 +1,318 @@
+#include "gguf_reader.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace studyhive {
+namespace core {
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path, std::string& error_msg) {
+    close();
+
+#ifdef _WIN32
+    // Plain read until a MapViewOfFile path is needed on Windows
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        error_msg = "Cannot open " + path;
+        return false;
+    }
+    buffer_.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(buffer_.data()), buffer_.size());
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+    return true;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error_msg = "Cannot open " + path;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        error_msg = "Cannot map empty or unreadable file " + path;
+        return false;
+    }
+
+    void* addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);  // The mapping keeps its own reference
+    if (addr == MAP_FAILED) {
+        error_msg = "mmap failed for " + path;
+        return false;
+    }
+
+    data_ = static_cast<const uint8_t*>(addr);
+    size_ = static_cast<size_t>(st.st_size);
+    return true;
+#endif
+}
+
+void MappedFile::close() {
+#ifdef _WIN32
+    buffer_.clear();
+    buffer_.shrink_to_fit();
+#else
+    if (data_) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+}
+
+void MappedFile::prefetch() const {
+#ifndef _WIN32
+    if (data_) {
+        madvise(const_cast<uint8_t*>(data_), size_, MADV_WILLNEED);
+    }
+#endif
+}
+
+void MappedFile::release(size_t offset, size_t length) const {
+#ifndef _WIN32
+    if (!data_ || offset >= size_) return;
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t begin = (offset + page - 1) / page * page;
+    size_t end = std::min(size_, offset + length) / page * page;
+    if (end > begin) {
+        madvise(const_cast<uint8_t*>(data_) + begin, end - begin, MADV_DONTNEED);
+    }
+#endif
+}
+
+namespace gguf {
+
+namespace {
+
+constexpr uint32_t kMagic = 0x46554747;  // "GGUF" little-endian
+
+enum ValueType : uint32_t {
+    UINT8 = 0, INT8 = 1, UINT16 = 2, INT16 = 3, UINT32 = 4, INT32 = 5,
+    FLOAT32 = 6, BOOL = 7, STRING = 8, ARRAY = 9, UINT64 = 10, INT64 = 11, FLOAT64 = 12
+};
+
+// Bounds-checked little-endian cursor; throws on truncation
+class Cursor {
+public:
+    Cursor(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+    template <typename T>
+    T read() {
+        need(sizeof(T));
+        T value;
+        std::memcpy(&value, data_ + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return value;
+    }
+
+    std::string readString() {
+        uint64_t length = read<uint64_t>();
+        need(length);
+        std::string value(reinterpret_cast<const char*>(data_ + pos_), length);
+        pos_ += length;
+        return value;
+    }
+
+    void skip(uint64_t bytes) {
+        need(bytes);
+        pos_ += bytes;
+    }
+
+    size_t position() const { return pos_; }
+
+private:
+    void need(uint64_t bytes) const {
+        if (bytes > size_ - pos_) {
+            throw std::runtime_error("truncated at byte " + std::to_string(pos_));
+        }
+    }
+
+    const uint8_t* data_;
+    size_t size_;
+    size_t pos_ = 0;
+};
+
+size_t scalarSize(uint32_t type) {
+    switch (type) {
+        case UINT8: case INT8: case BOOL: return 1;
+        case UINT16: case INT16: return 2;
+        case UINT32: case INT32: case FLOAT32: return 4;
+        case UINT64: case INT64: case FLOAT64: return 8;
+        default: return 0;
+    }
+}
+
+Value readValue(Cursor& cursor, uint32_t type) {
+    switch (type) {
+        case UINT8: return static_cast<uint64_t>(cursor.read<uint8_t>());
+        case INT8: return static_cast<int64_t>(cursor.read<int8_t>());
+        case UINT16: return static_cast<uint64_t>(cursor.read<uint16_t>());
+        case INT16: return static_cast<int64_t>(cursor.read<int16_t>());
+        case UINT32: return static_cast<uint64_t>(cursor.read<uint32_t>());
+        case INT32: return static_cast<int64_t>(cursor.read<int32_t>());
+        case FLOAT32: return static_cast<double>(cursor.read<float>());
+        case BOOL: return cursor.read<uint8_t>() != 0;
+        case STRING: return cursor.readString();
+        case UINT64: return cursor.read<uint64_t>();
+        case INT64: return cursor.read<int64_t>();
+        case FLOAT64: return cursor.read<double>();
+        case ARRAY: {
+            // Tokenizer vocabularies live here; skip the contents
+            ArrayInfo info;
+            info.element_type = cursor.read<uint32_t>();
+            info.length = cursor.read<uint64_t>();
+            if (info.element_type == STRING) {
+                for (uint64_t i = 0; i < info.length; ++i) {
+                    cursor.skip(cursor.read<uint64_t>());
+                }
+            } else if (size_t width = scalarSize(info.element_type)) {
+                if (info.length > UINT64_MAX / width) throw std::runtime_error("array too large");
+                cursor.skip(info.length * width);
+            } else {
+                throw std::runtime_error("unsupported array element type " + std::to_string(info.element_type));
+            }
+            return info;
+        }
+        default:
+            throw std::runtime_error("unknown value type " + std::to_string(type));
+    }
+}
+
+} // namespace
+
+uint64_t TensorInfo::elements() const {
+    uint64_t count = 1;
+    for (uint64_t dim : dims) count *= dim;
+    return count;
+}
+
+std::string Metadata::getString(const std::string& key, const std::string& fallback) const {
+    auto it = kv.find(key);
+    if (it == kv.end()) return fallback;
+    if (const auto* value = std::get_if<std::string>(&it->second)) return *value;
+    return fallback;
+}
+
+uint64_t Metadata::getUInt(const std::string& key, uint64_t fallback) const {
+    auto it = kv.find(key);
+    if (it == kv.end()) return fallback;
+    if (const auto* value = std::get_if<uint64_t>(&it->second)) return *value;
+    if (const auto* value = std::get_if<int64_t>(&it->second)) return *value < 0 ? fallback : *value;
+    return fallback;
+}
+
+std::string Metadata::architecture() const {
+    return getString("general.architecture", "llama");
+}
+
+std::string Metadata::name() const {
+    return getString("general.name");
+}
+
+uint64_t Metadata::parameterCount() const {
+    uint64_t total = 0;
+    for (const auto& tensor : tensors) total += tensor.elements();
+    return total;
+}
+
+std::string Metadata::fileTypeName() const {
+    static const std::map<uint64_t, std::string> names = {
+        {0, "F32"}, {1, "F16"}, {2, "Q4_0"}, {3, "Q4_1"}, {7, "Q8_0"}, {8, "Q5_0"}, {9, "Q5_1"},
+        {10, "Q2_K"}, {11, "Q3_K_S"}, {12, "Q3_K_M"}, {13, "Q3_K_L"}, {14, "Q4_K_S"},
+        {15, "Q4_K_M"}, {16, "Q5_K_S"}, {17, "Q5_K_M"}, {18, "Q6_K"}
+    };
+    auto it = kv.find("general.file_type");
+    if (it == kv.end()) return "unknown";
+    uint64_t type = getUInt("general.file_type");
+    auto name = names.find(type);
+    return name != names.end() ? name->second : "type " + std::to_string(type);
+}
+
+uint64_t Metadata::kvCacheBytes(uint32_t n_ctx) const {
+    std::string arch = architecture();
+    uint64_t n_layer = getUInt(arch + ".block_count");
+    uint64_t n_embd = getUInt(arch + ".embedding_length");
+    uint64_t n_head = getUInt(arch + ".attention.head_count", 1);
+    uint64_t n_head_kv = getUInt(arch + ".attention.head_count_kv", n_head);
+    if (n_head == 0) return 0;
+
+    // Grouped-query attention shrinks K/V to n_head_kv heads
+    uint64_t n_embd_kv = n_embd * n_head_kv / n_head;
+    return 2 * n_layer * static_cast<uint64_t>(n_ctx) * n_embd_kv * sizeof(uint16_t);
+}
+
+bool readMetadata(const uint8_t* data, size_t size, Metadata& metadata, std::string& error_msg) {
+    try {
+        Cursor cursor(data, size);
+        if (cursor.read<uint32_t>() != kMagic) {
+            error_msg = "Not a GGUF file";
+            return false;
+        }
+
+        metadata = Metadata();
+        metadata.version = cursor.read<uint32_t>();
+        if (metadata.version < 2) {
+            error_msg = "Unsupported GGUF version " + std::to_string(metadata.version);
+            return false;
+        }
+
+        uint64_t tensor_count = cursor.read<uint64_t>();
+        uint64_t kv_count = cursor.read<uint64_t>();
+
+        for (uint64_t i = 0; i < kv_count; ++i) {
+            std::string key = cursor.readString();
+            uint32_t type = cursor.read<uint32_t>();
+            metadata.kv[key] = readValue(cursor, type);
+        }
+
+        for (uint64_t i = 0; i < tensor_count; ++i) {
+            TensorInfo tensor;
+            tensor.name = cursor.readString();
+            uint32_t n_dims = cursor.read<uint32_t>();
+            if (n_dims > 8) throw std::runtime_error("tensor " + tensor.name + " has " + std::to_string(n_dims) + " dims");
+            for (uint32_t d = 0; d < n_dims; ++d) {
+                tensor.dims.push_back(cursor.read<uint64_t>());
+            }
+            tensor.type = cursor.read<uint32_t>();
+            tensor.offset = cursor.read<uint64_t>();
+            metadata.tensors.push_back(std::move(tensor));
+        }
+
+        // Tensor data starts at the next multiple of general.alignment
+        uint64_t alignment = std::max<uint64_t>(metadata.getUInt("general.alignment", 32), 1);
+        metadata.data_offset = (cursor.position() + alignment - 1) / alignment * alignment;
+
+        return true;
+    } catch (const std::exception& e) {
+        error_msg = std::string("Invalid GGUF: ") + e.what();
+        return false;
+    }
+}
+
+bool readFile(const std::string& path, Metadata& metadata, std::string& error_msg) {
+    MappedFile file;
+    if (!file.open(path, error_msg)) {
+        return false;
+    }
+    return readMetadata(file.data(), file.size(), metadata, error_msg);
+}
+
+} // namespace gguf
+
+} // namespace core
+} // namespace studyhive
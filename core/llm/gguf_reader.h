@@ -0,0 +1,91 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <variant>
+#include <cstdint>
+
+namespace studyhive {
+namespace core {
+
+// Read-only memory mapping of a whole file. Pages are faulted in lazily and
+// shared with any other mapping of the same file (e.g. llama.cpp's use_mmap).
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path, std::string& error_msg);
+    void close();
+
+    // Ask the OS to read the mapping ahead (no-op where unsupported)
+    void prefetch() const;
+
+    // Drop resident pages of [offset, offset + length) that lie wholly inside
+    // it; they are read back from the file if touched again (no-op where unsupported)
+    void release(size_t offset, size_t length) const;
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool isOpen() const { return data_ != nullptr; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    std::vector<uint8_t> buffer_;
+#endif
+};
+
+namespace gguf {
+
+// Scalar metadata values; arrays keep only their element count
+struct ArrayInfo {
+    uint32_t element_type = 0;
+    uint64_t length = 0;
+};
+
+using Value = std::variant<uint64_t, int64_t, double, bool, std::string, ArrayInfo>;
+
+struct TensorInfo {
+    std::string name;
+    std::vector<uint64_t> dims;
+    uint32_t type = 0;
+    uint64_t offset = 0;
+
+    uint64_t elements() const;
+};
+
+struct Metadata {
+    uint32_t version = 0;
+    uint64_t data_offset = 0;  // File offset of the tensor data; TensorInfo::offset is relative to it
+    std::map<std::string, Value> kv;
+    std::vector<TensorInfo> tensors;
+
+    std::string getString(const std::string& key, const std::string& fallback = "") const;
+    uint64_t getUInt(const std::string& key, uint64_t fallback = 0) const;
+
+    // Convenience accessors for llama.cpp conventions
+    std::string architecture() const;
+    std::string name() const;
+    uint64_t parameterCount() const;
+    std::string fileTypeName() const;
+
+    // f16 K and V cache size for n_ctx cells
+    uint64_t kvCacheBytes(uint32_t n_ctx) const;
+};
+
+// Parse the header, metadata and tensor table of a GGUF v2/v3 image
+bool readMetadata(const uint8_t* data, size_t size, Metadata& metadata, std::string& error_msg);
+
+// Map path and parse its header
+bool readFile(const std::string& path, Metadata& metadata, std::string& error_msg);
+
+} // namespace gguf
+
+} // namespace core
+} // namespace studyhive
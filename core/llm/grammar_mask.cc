@@ -0,0 +1,670 @@
+#include "grammar_mask.h"
+#include <fstream>
+#include <sstream>
+#include <bitset>
+#include <map>
+#include <set>
+#include <deque>
+#include <algorithm>
+#include <stdexcept>
+#include <cctype>
+
+namespace studyhive {
+namespace core {
+
+namespace {
+
+using ByteSet = std::bitset<256>;
+
+// GBNF syntax tree
+struct GrammarNode {
+    enum class Kind { LITERAL, CHARSET, RULE_REF, SEQUENCE, ALTERNATION, REPEAT };
+
+    Kind kind;
+    std::string text;  // literal bytes or rule name
+    ByteSet bytes;     // character class
+    std::vector<GrammarNode> children;
+    int min_repeat = 0;
+    int max_repeat = -1;  // -1 = unbounded
+};
+
+class GbnfParser {
+public:
+    explicit GbnfParser(const std::string& source) : src_(source), pos_(0) {}
+
+    bool parse(std::map<std::string, GrammarNode>& rules, std::string& error_msg) {
+        try {
+            skipSpace();
+            while (pos_ < src_.size()) {
+                std::string name = parseName();
+                if (name.empty()) {
+                    fail("expected rule name");
+                }
+                skipSpace();
+                if (src_.compare(pos_, 3, "::=") != 0) {
+                    fail("expected '::=' after rule '" + name + "'");
+                }
+                pos_ += 3;
+                if (rules.count(name)) {
+                    fail("duplicate rule '" + name + "'");
+                }
+                rules[name] = parseAlternation();
+                skipSpace();
+            }
+            return true;
+        } catch (const std::exception& e) {
+            error_msg = e.what();
+            return false;
+        }
+    }
+
+private:
+    const std::string& src_;
+    size_t pos_;
+
+    [[noreturn]] void fail(const std::string& message) {
+        throw std::runtime_error("GBNF parse error at offset " + std::to_string(pos_) + ": " + message);
+    }
+
+    static bool isNameChar(char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '-';
+    }
+
+    void skipSpace() {
+        while (pos_ < src_.size()) {
+            char c = src_[pos_];
+            if (c == '#') {
+                while (pos_ < src_.size() && src_[pos_] != '\n') pos_++;
+            } else if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+                pos_++;
+            } else {
+                break;
+            }
+        }
+    }
+
+    std::string parseName() {
+        size_t start = pos_;
+        while (pos_ < src_.size() && isNameChar(src_[pos_])) pos_++;
+        return src_.substr(start, pos_ - start);
+    }
+
+    // True if the upcoming text is "name ::=", i.e. the start of the next rule
+    bool atRuleStart() {
+        size_t saved = pos_;
+        std::string name = parseName();
+        skipSpace();
+        bool result = !name.empty() && src_.compare(pos_, 3, "::=") == 0;
+        pos_ = saved;
+        return result;
+    }
+
+    unsigned char parseEscapedChar() {
+        char c = src_[pos_++];
+        if (c != '\\') return static_cast<unsigned char>(c);
+        if (pos_ >= src_.size()) fail("dangling escape");
+        char e = src_[pos_++];
+        switch (e) {
+            case 'n': return '\n';
+            case 't': return '\t';
+            case 'r': return '\r';
+            case 'x': {
+                if (pos_ + 2 > src_.size()) fail("bad \\x escape");
+                int value = std::stoi(src_.substr(pos_, 2), nullptr, 16);
+                pos_ += 2;
+                return static_cast<unsigned char>(value);
+            }
+            default: return static_cast<unsigned char>(e);
+        }
+    }
+
+    GrammarNode parseAlternation() {
+        GrammarNode node;
+        node.kind = GrammarNode::Kind::ALTERNATION;
+        node.children.push_back(parseSequence());
+        skipSpace();
+        while (pos_ < src_.size() && src_[pos_] == '|') {
+            pos_++;
+            node.children.push_back(parseSequence());
+            skipSpace();
+        }
+        return node.children.size() == 1 ? node.children[0] : node;
+    }
+
+    GrammarNode parseSequence() {
+        GrammarNode node;
+        node.kind = GrammarNode::Kind::SEQUENCE;
+        while (true) {
+            skipSpace();
+            if (pos_ >= src_.size() || src_[pos_] == '|' || src_[pos_] == ')' || atRuleStart()) {
+                break;
+            }
+            node.children.push_back(parsePostfix(parseElement()));
+        }
+        return node;
+    }
+
+    GrammarNode parseElement() {
+        GrammarNode node;
+        char c = src_[pos_];
+
+        if (c == '"') {
+            pos_++;
+            node.kind = GrammarNode::Kind::LITERAL;
+            while (pos_ < src_.size() && src_[pos_] != '"') {
+                node.text.push_back(static_cast<char>(parseEscapedChar()));
+            }
+            if (pos_ >= src_.size()) fail("unterminated literal");
+            pos_++;
+        } else if (c == '[') {
+            pos_++;
+            node.kind = GrammarNode::Kind::CHARSET;
+            bool negated = pos_ < src_.size() && src_[pos_] == '^';
+            if (negated) pos_++;
+            while (pos_ < src_.size() && src_[pos_] != ']') {
+                unsigned char lo = parseEscapedChar();
+                unsigned char hi = lo;
+                if (pos_ + 1 < src_.size() && src_[pos_] == '-' && src_[pos_ + 1] != ']') {
+                    pos_++;
+                    hi = parseEscapedChar();
+                }
+                for (int b = lo; b <= hi; ++b) node.bytes.set(b);
+            }
+            if (pos_ >= src_.size()) fail("unterminated character class");
+            pos_++;
+            if (negated) node.bytes.flip();
+        } else if (c == '(') {
+            pos_++;
+            node = parseAlternation();
+            skipSpace();
+            if (pos_ >= src_.size() || src_[pos_] != ')') fail("expected ')'");
+            pos_++;
+        } else if (c == '.') {
+            pos_++;
+            node.kind = GrammarNode::Kind::CHARSET;
+            node.bytes.set();
+            node.bytes.reset('\n');
+        } else if (isNameChar(c)) {
+            node.kind = GrammarNode::Kind::RULE_REF;
+            node.text = parseName();
+        } else {
+            fail(std::string("unexpected character '") + c + "'");
+        }
+
+        return node;
+    }
+
+    GrammarNode parsePostfix(GrammarNode element) {
+        if (pos_ >= src_.size()) return element;
+        char c = src_[pos_];
+        if (c != '*' && c != '+' && c != '?') return element;
+        pos_++;
+
+        GrammarNode node;
+        node.kind = GrammarNode::Kind::REPEAT;
+        node.min_repeat = (c == '+') ? 1 : 0;
+        node.max_repeat = (c == '?') ? 1 : -1;
+        node.children.push_back(std::move(element));
+        return node;
+    }
+};
+
+} // namespace
+
+// Thompson NFA construction followed by subset construction
+class GrammarCompiler {
+public:
+    explicit GrammarCompiler(const std::map<std::string, GrammarNode>& rules) : rules_(rules) {}
+
+    std::shared_ptr<const GrammarAutomaton> compile(const std::string& root_rule, std::string& error_msg) {
+        try {
+            if (!rules_.count(root_rule)) {
+                throw std::runtime_error("missing root rule '" + root_rule + "'");
+            }
+            GrammarNode root;
+            root.kind = GrammarNode::Kind::RULE_REF;
+            root.text = root_rule;
+            Fragment fragment = build(root, 0);
+            final_state_ = fragment.end;
+            return determinize(fragment.start);
+        } catch (const std::exception& e) {
+            error_msg = e.what();
+            return nullptr;
+        }
+    }
+
+private:
+    struct NfaState {
+        std::vector<int> epsilon;
+        std::vector<std::pair<ByteSet, int>> edges;
+    };
+
+    struct Fragment {
+        int start;
+        int end;
+    };
+
+    struct RuleFrame {
+        std::string name;
+        int start;
+        int end;
+    };
+
+    static constexpr size_t kMaxExpansionDepth = 64;
+    static constexpr size_t kMaxDfaStates = 65536;
+
+    const std::map<std::string, GrammarNode>& rules_;
+    std::vector<NfaState> nfa_;
+    std::vector<RuleFrame> frames_;
+    int final_state_ = -1;
+
+    int newState() {
+        nfa_.emplace_back();
+        return static_cast<int>(nfa_.size()) - 1;
+    }
+
+    // tail_from: index of the outermost rule frame for which this node is in tail position
+    Fragment build(const GrammarNode& node, size_t tail_from) {
+        switch (node.kind) {
+            case GrammarNode::Kind::LITERAL: {
+                int start = newState();
+                int current = start;
+                for (unsigned char c : node.text) {
+                    int next = newState();
+                    ByteSet set;
+                    set.set(c);
+                    nfa_[current].edges.emplace_back(set, next);
+                    current = next;
+                }
+                return {start, current};
+            }
+            case GrammarNode::Kind::CHARSET: {
+                int start = newState();
+                int end = newState();
+                nfa_[start].edges.emplace_back(node.bytes, end);
+                return {start, end};
+            }
+            case GrammarNode::Kind::SEQUENCE: {
+                int start = newState();
+                int current = start;
+                for (size_t i = 0; i < node.children.size(); ++i) {
+                    bool last = (i + 1 == node.children.size());
+                    Fragment child = build(node.children[i], last ? tail_from : frames_.size());
+                    nfa_[current].epsilon.push_back(child.start);
+                    current = child.end;
+                }
+                return {start, current};
+            }
+            case GrammarNode::Kind::ALTERNATION: {
+                int start = newState();
+                int end = newState();
+                for (const auto& child_node : node.children) {
+                    Fragment child = build(child_node, tail_from);
+                    nfa_[start].epsilon.push_back(child.start);
+                    nfa_[child.end].epsilon.push_back(end);
+                }
+                return {start, end};
+            }
+            case GrammarNode::Kind::REPEAT: {
+                int start = newState();
+                int end = newState();
+                Fragment child = build(node.children[0], frames_.size());
+                nfa_[start].epsilon.push_back(child.start);
+                if (node.min_repeat == 0) {
+                    nfa_[start].epsilon.push_back(end);
+                }
+                nfa_[child.end].epsilon.push_back(end);
+                if (node.max_repeat < 0) {
+                    nfa_[child.end].epsilon.push_back(child.start);
+                }
+                return {start, end};
+            }
+            case GrammarNode::Kind::RULE_REF:
+                return buildRuleRef(node.text, tail_from);
+        }
+        throw std::runtime_error("unknown grammar node");
+    }
+
+    Fragment buildRuleRef(const std::string& name, size_t tail_from) {
+        // Recursive reference: only tail recursion keeps the language regular
+        for (size_t i = frames_.size(); i-- > 0;) {
+            if (frames_[i].name != name) continue;
+            if (i < tail_from) {
+                throw std::runtime_error("rule '" + name + "' is recursive outside tail position");
+            }
+            int start = newState();
+            nfa_[start].epsilon.push_back(frames_[i].start);
+            return {start, newState()};
+        }
+
+        auto it = rules_.find(name);
+        if (it == rules_.end()) {
+            throw std::runtime_error("undefined rule '" + name + "'");
+        }
+        if (frames_.size() >= kMaxExpansionDepth) {
+            throw std::runtime_error("rule expansion too deep at '" + name + "'");
+        }
+
+        int start = newState();
+        int end = newState();
+        frames_.push_back({name, start, end});
+        size_t body_tail = std::min(tail_from, frames_.size() - 1);
+        Fragment body = build(it->second, body_tail);
+        frames_.pop_back();
+
+        nfa_[start].epsilon.push_back(body.start);
+        nfa_[body.end].epsilon.push_back(end);
+        return {start, end};
+    }
+
+    std::vector<int> closure(std::vector<int> states) const {
+        std::vector<bool> seen(nfa_.size(), false);
+        std::vector<int> stack = states;
+        for (int s : states) seen[s] = true;
+        while (!stack.empty()) {
+            int s = stack.back();
+            stack.pop_back();
+            for (int t : nfa_[s].epsilon) {
+                if (!seen[t]) {
+                    seen[t] = true;
+                    states.push_back(t);
+                    stack.push_back(t);
+                }
+            }
+        }
+        std::sort(states.begin(), states.end());
+        return states;
+    }
+
+    std::shared_ptr<const GrammarAutomaton> determinize(int nfa_start) {
+        auto automaton = std::make_shared<GrammarAutomaton>();
+        std::map<std::vector<int>, int32_t> ids;
+        std::deque<std::vector<int>> worklist;
+
+        auto intern = [&](std::vector<int> set) -> int32_t {
+            auto found = ids.find(set);
+            if (found != ids.end()) return found->second;
+            if (ids.size() >= kMaxDfaStates) {
+                throw std::runtime_error("grammar automaton exceeds state limit");
+            }
+            int32_t id = static_cast<int32_t>(ids.size());
+            ids.emplace(set, id);
+            automaton->transitions_.emplace_back();
+            automaton->transitions_.back().fill(GrammarAutomaton::kDeadState);
+            automaton->accepting_.push_back(
+                std::binary_search(set.begin(), set.end(), final_state_));
+            worklist.push_back(std::move(set));
+            return id;
+        };
+
+        intern(closure({nfa_start}));
+
+        while (!worklist.empty()) {
+            std::vector<int> current = std::move(worklist.front());
+            worklist.pop_front();
+            int32_t current_id = ids[current];
+
+            std::array<std::vector<int>, 256> moves;
+            for (int s : current) {
+                for (const auto& edge : nfa_[s].edges) {
+                    for (int b = 0; b < 256; ++b) {
+                        if (edge.first.test(b)) moves[b].push_back(edge.second);
+                    }
+                }
+            }
+
+            for (int b = 0; b < 256; ++b) {
+                if (moves[b].empty()) continue;
+                int32_t target = intern(closure(std::move(moves[b])));
+                automaton->transitions_[current_id][b] = target;
+            }
+        }
+
+        // Record states with exactly one continuation byte for jump-ahead
+        automaton->forced_byte_.assign(automaton->transitions_.size(), -1);
+        for (size_t state = 0; state < automaton->transitions_.size(); ++state) {
+            if (automaton->accepting_[state]) continue;
+            int choices = 0;
+            int16_t byte = -1;
+            for (int b = 0; b < 256 && choices < 2; ++b) {
+                if (automaton->transitions_[state][b] != GrammarAutomaton::kDeadState) {
+                    byte = static_cast<int16_t>(b);
+                    choices++;
+                }
+            }
+            if (choices == 1) automaton->forced_byte_[state] = byte;
+        }
+
+        return automaton;
+    }
+};
+
+std::shared_ptr<const GrammarAutomaton> GrammarAutomaton::compile(const std::string& gbnf_source,
+                                                                  std::string& error_msg,
+                                                                  const std::string& root_rule) {
+    std::map<std::string, GrammarNode> rules;
+    GbnfParser parser(gbnf_source);
+    if (!parser.parse(rules, error_msg)) {
+        return nullptr;
+    }
+
+    GrammarCompiler compiler(rules);
+    return compiler.compile(root_rule, error_msg);
+}
+
+std::shared_ptr<const GrammarAutomaton> GrammarAutomaton::compileFile(const std::string& path,
+                                                                      std::string& error_msg) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        error_msg = "Cannot open grammar file: " + path;
+        return nullptr;
+    }
+
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return compile(buffer.str(), error_msg);
+}
+
+int32_t GrammarAutomaton::advance(int32_t state, const std::string& bytes) const {
+    for (unsigned char c : bytes) {
+        state = step(state, c);
+        if (state == kDeadState) break;
+    }
+    return state;
+}
+
+std::string GrammarAutomaton::forcedBytes(int32_t state, size_t max_len) const {
+    std::string forced;
+    while (state != kDeadState && forced_byte_[state] >= 0 && forced.size() < max_len) {
+        unsigned char byte = static_cast<unsigned char>(forced_byte_[state]);
+        forced.push_back(static_cast<char>(byte));
+        state = transitions_[state][byte];
+    }
+    return forced;
+}
+
+// TokenMaskTable implementation
+TokenMaskTable::TokenMaskTable(std::shared_ptr<const GrammarAutomaton> automaton,
+                               std::shared_ptr<const TokenVocabulary> vocab,
+                               const MaskTableOptions& options)
+    : automaton_(std::move(automaton)),
+      vocab_(std::move(vocab)),
+      options_(options),
+      mask_words_((vocab_->pieces.size() + 63) / 64),
+      masks_(automaton_->stateCount()),
+      precomputed_states_(0),
+      fallback_lookups_(0) {
+    buildTrie();
+}
+
+TokenMaskTable::~TokenMaskTable() = default;
+
+void TokenMaskTable::buildTrie() {
+    trie_.clear();
+    trie_.emplace_back();
+
+    for (size_t token = 0; token < vocab_->pieces.size(); ++token) {
+        const std::string& piece = vocab_->pieces[token];
+        if (piece.empty() || static_cast<int32_t>(token) == vocab_->eos_token) {
+            continue;
+        }
+
+        int32_t node = 0;
+        for (unsigned char c : piece) {
+            auto& children = trie_[node].children;
+            auto it = std::find_if(children.begin(), children.end(),
+                                   [c](const auto& child) { return child.first == c; });
+            if (it != children.end()) {
+                node = it->second;
+            } else {
+                int32_t child = static_cast<int32_t>(trie_.size());
+                trie_[node].children.emplace_back(c, child);
+                trie_.emplace_back();
+                node = child;
+            }
+        }
+        trie_[node].tokens.push_back(static_cast<int32_t>(token));
+    }
+
+    // Sorted children make greedy matching and walks cache-friendlier
+    for (auto& node : trie_) {
+        std::sort(node.children.begin(), node.children.end());
+    }
+}
+
+void TokenMaskTable::walkTrie(int32_t node, int32_t state, Mask& mask) const {
+    for (const auto& child : trie_[node].children) {
+        int32_t next = automaton_->step(state, child.first);
+        if (next == GrammarAutomaton::kDeadState) {
+            continue;  // prune every token sharing this prefix
+        }
+        for (int32_t token : trie_[child.second].tokens) {
+            mask[token >> 6] |= uint64_t{1} << (token & 63);
+        }
+        walkTrie(child.second, next, mask);
+    }
+}
+
+TokenMaskTable::Mask TokenMaskTable::computeMask(int32_t state) const {
+    Mask mask(mask_words_, 0);
+    if (state == GrammarAutomaton::kDeadState) {
+        return mask;
+    }
+
+    walkTrie(0, state, mask);
+
+    int32_t eos = vocab_->eos_token;
+    if (eos >= 0 && automaton_->isAccepting(state)) {
+        mask[eos >> 6] |= uint64_t{1} << (eos & 63);
+    }
+    return mask;
+}
+
+void TokenMaskTable::precompute() {
+    size_t limit = std::min(options_.max_precomputed_states, automaton_->stateCount());
+
+    // DFA states are numbered breadth-first from the start state, so the budget
+    // covers the states closest to the start first
+    for (size_t state = 0; state < limit; ++state) {
+        auto mask = std::make_shared<const Mask>(computeMask(static_cast<int32_t>(state)));
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!masks_[state]) {
+            masks_[state] = std::move(mask);
+            precomputed_states_++;
+        }
+    }
+}
+
+std::shared_ptr<const TokenMaskTable::Mask> TokenMaskTable::allowedTokens(int32_t state) {
+    if (state >= 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (masks_[state]) {
+            return masks_[state];
+        }
+        fallback_lookups_++;
+    }
+
+    // Fallback: scan the vocabulary for this state and keep the result if the budget allows
+    auto mask = std::make_shared<const Mask>(allowedTokensNaive(state));
+    if (state >= 0) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!masks_[state] && precomputed_states_ < options_.max_precomputed_states) {
+            masks_[state] = mask;
+            precomputed_states_++;
+        }
+    }
+    return mask;
+}
+
+TokenMaskTable::Mask TokenMaskTable::allowedTokensNaive(int32_t state) const {
+    Mask mask(mask_words_, 0);
+    for (size_t token = 0; token < vocab_->pieces.size(); ++token) {
+        if (acceptToken(state, static_cast<int32_t>(token)) != GrammarAutomaton::kDeadState) {
+            mask[token >> 6] |= uint64_t{1} << (token & 63);
+        }
+    }
+    return mask;
+}
+
+int32_t TokenMaskTable::acceptToken(int32_t state, int32_t token) const {
+    if (state == GrammarAutomaton::kDeadState || token < 0 ||
+        static_cast<size_t>(token) >= vocab_->pieces.size()) {
+        return GrammarAutomaton::kDeadState;
+    }
+    if (token == vocab_->eos_token) {
+        return automaton_->isAccepting(state) ? state : GrammarAutomaton::kDeadState;
+    }
+
+    const std::string& piece = vocab_->pieces[token];
+    if (piece.empty()) {
+        return GrammarAutomaton::kDeadState;
+    }
+    return automaton_->advance(state, piece);
+}
+
+std::vector<int32_t> TokenMaskTable::forcedTokens(int32_t state, int32_t& next_state) const {
+    std::vector<int32_t> tokens;
+    next_state = state;
+
+    std::string forced = automaton_->forcedBytes(state);
+    size_t pos = 0;
+
+    // Greedy longest-piece tokenization of the forced run
+    while (pos < forced.size() && tokens.size() < options_.max_forced_tokens) {
+        int32_t node = 0;
+        int32_t best_token = -1;
+        size_t best_len = 0;
+
+        for (size_t i = pos; i < forced.size(); ++i) {
+            const auto& children = trie_[node].children;
+            unsigned char c = static_cast<unsigned char>(forced[i]);
+            auto it = std::lower_bound(children.begin(), children.end(),
+                                       std::make_pair(c, int32_t{0}));
+            if (it == children.end() || it->first != c) break;
+            node = it->second;
+            if (!trie_[node].tokens.empty()) {
+                best_token = trie_[node].tokens.front();
+                best_len = i - pos + 1;
+            }
+        }
+
+        if (best_token < 0) break;
+        tokens.push_back(best_token);
+        next_state = automaton_->advance(next_state, forced.substr(pos, best_len));
+        pos += best_len;
+    }
+
+    return tokens;
+}
+
+TokenMaskTable::Stats TokenMaskTable::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return {
+        precomputed_states_,
+        fallback_lookups_,
+        precomputed_states_ * mask_words_ * sizeof(uint64_t)
+    };
+}
+
+} // namespace core
+} // namespace studyhive
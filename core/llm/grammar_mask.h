@@ -0,0 +1,136 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+namespace studyhive {
+namespace core {
+
+// Model vocabulary as raw byte pieces (token id -> bytes)
+struct TokenVocabulary {
+    std::vector<std::string> pieces;
+    int32_t eos_token = -1;
+};
+
+// Byte-level DFA compiled from a GBNF grammar.
+// Supports the regular subset of GBNF used by core/grammars: literals, character
+// classes, groups, * + ? repetition, alternation and tail-recursive rules
+// (e.g. "list ::= item | item ws "," ws list").
+class GrammarAutomaton {
+public:
+    static constexpr int32_t kDeadState = -1;
+
+    // Compile GBNF source; returns nullptr and sets error_msg on failure
+    static std::shared_ptr<const GrammarAutomaton> compile(const std::string& gbnf_source,
+                                                           std::string& error_msg,
+                                                           const std::string& root_rule = "root");
+
+    // Load and compile a .gbnf file
+    static std::shared_ptr<const GrammarAutomaton> compileFile(const std::string& path,
+                                                               std::string& error_msg);
+
+    int32_t startState() const { return 0; }
+
+    // Transition on a single byte (kDeadState if rejected)
+    int32_t step(int32_t state, unsigned char byte) const {
+        return state < 0 ? kDeadState : transitions_[state][byte];
+    }
+
+    // Transition on a byte string (kDeadState if any byte is rejected)
+    int32_t advance(int32_t state, const std::string& bytes) const;
+
+    // True if the input consumed so far is a complete sentence of the grammar
+    bool isAccepting(int32_t state) const {
+        return state >= 0 && accepting_[state];
+    }
+
+    // Bytes the grammar forces from this state (single continuation, not accepting)
+    std::string forcedBytes(int32_t state, size_t max_len = 256) const;
+
+    size_t stateCount() const { return transitions_.size(); }
+
+private:
+    std::vector<std::array<int32_t, 256>> transitions_;
+    std::vector<bool> accepting_;
+    std::vector<int16_t> forced_byte_;  // sole continuation byte, or -1
+
+    friend class GrammarCompiler;
+};
+
+struct MaskTableOptions {
+    // States whose masks are precomputed and kept resident; the rest fall back
+    // to a per-token scan on demand
+    size_t max_precomputed_states = 4096;
+    // Maximum tokens appended per jump-ahead
+    size_t max_forced_tokens = 64;
+};
+
+// Per-state allowed-token bitmasks over the model vocabulary
+class TokenMaskTable {
+public:
+    using Mask = std::vector<uint64_t>;
+
+    TokenMaskTable(std::shared_ptr<const GrammarAutomaton> automaton,
+                   std::shared_ptr<const TokenVocabulary> vocab,
+                   const MaskTableOptions& options = MaskTableOptions());
+    ~TokenMaskTable();
+
+    // Precompute masks for every state reachable from the start state (up to the budget)
+    void precompute();
+
+    // Allowed tokens in a state; precomputed when possible, otherwise a per-token scan
+    std::shared_ptr<const Mask> allowedTokens(int32_t state);
+
+    // Naive reference check: run every vocabulary piece through the automaton
+    Mask allowedTokensNaive(int32_t state) const;
+
+    static bool isSet(const Mask& mask, int32_t token) {
+        return (mask[token >> 6] >> (token & 63)) & 1u;
+    }
+
+    // State after appending a token (kDeadState if the grammar rejects it)
+    int32_t acceptToken(int32_t state, int32_t token) const;
+
+    // Jump-ahead: tokens for the literal run the grammar forces from this state.
+    // next_state receives the state after the forced tokens.
+    std::vector<int32_t> forcedTokens(int32_t state, int32_t& next_state) const;
+
+    struct Stats {
+        size_t precomputed_states;
+        size_t fallback_lookups;
+        size_t mask_bytes;
+    };
+
+    Stats getStats() const;
+
+    const GrammarAutomaton& automaton() const { return *automaton_; }
+    const TokenVocabulary& vocabulary() const { return *vocab_; }
+
+private:
+    struct TrieNode {
+        std::vector<std::pair<unsigned char, int32_t>> children;
+        std::vector<int32_t> tokens;  // tokens whose piece ends at this node
+    };
+
+    std::shared_ptr<const GrammarAutomaton> automaton_;
+    std::shared_ptr<const TokenVocabulary> vocab_;
+    MaskTableOptions options_;
+    std::vector<TrieNode> trie_;
+    size_t mask_words_;
+
+    mutable std::mutex mutex_;
+    std::vector<std::shared_ptr<const Mask>> masks_;  // indexed by state
+    size_t precomputed_states_;
+    size_t fallback_lookups_;
+
+    void buildTrie();
+    Mask computeMask(int32_t state) const;
+    void walkTrie(int32_t node, int32_t state, Mask& mask) const;
+};
+
+} // namespace core
+} // namespace studyhive
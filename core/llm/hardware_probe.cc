@@ -0,0 +1,521 @@
+#include "hardware_probe.h"
+#include "gguf_reader.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <thread>
+
+#if defined(__APPLE__)
+#include <sys/sysctl.h>
+#elif defined(_WIN32)
+// Keep std::min/std::max usable and skip the parts of the API not needed here
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#endif
+
+namespace studyhive {
+namespace core {
+
+namespace {
+
+constexpr int kProfileVersion = 2;
+
+#if defined(__linux__)
+
+std::string readFirstLine(const std::string& path) {
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+// Parse a sysfs cpu list such as "0-7,16-23"
+std::set<int> parseCpuList(const std::string& list) {
+    std::set<int> cpus;
+    std::stringstream stream(list);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        if (range.empty()) continue;
+        size_t dash = range.find('-');
+        try {
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; ++cpu) cpus.insert(cpu);
+        } catch (const std::exception&) {
+            // Ignore malformed entries
+        }
+    }
+    return cpus;
+}
+
+void probeLinux(HardwareInfo& info) {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.rfind("model name", 0) == 0 || line.rfind("Model", 0) == 0) {
+            size_t colon = line.find(':');
+            if (colon != std::string::npos) {
+                info.cpu_model = line.substr(line.find_first_not_of(' ', colon + 1));
+                break;
+            }
+        }
+    }
+
+    // Physical cores are distinct (package, core) pairs; capacity tells big from little on ARM
+    std::set<int> online = parseCpuList(readFirstLine("/sys/devices/system/cpu/online"));
+    std::map<int, std::pair<int, int>> core_of;
+    std::map<int, int> capacity_of;
+    for (int cpu : online) {
+        std::string base = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+        std::string package = readFirstLine(base + "/topology/physical_package_id");
+        std::string core = readFirstLine(base + "/topology/core_id");
+        std::string capacity = readFirstLine(base + "/cpu_capacity");
+        try {
+            core_of[cpu] = {package.empty() ? 0 : std::stoi(package), core.empty() ? cpu : std::stoi(core)};
+            if (!capacity.empty()) capacity_of[cpu] = std::stoi(capacity);
+        } catch (const std::exception&) {
+            core_of[cpu] = {0, cpu};
+        }
+    }
+
+    if (!online.empty()) {
+        info.logical_cores = static_cast<int>(online.size());
+        std::set<std::pair<int, int>> physical;
+        for (const auto& [cpu, core] : core_of) physical.insert(core);
+        info.physical_cores = static_cast<int>(physical.size());
+    }
+
+    auto countPhysical = [&](const std::set<int>& cpus) {
+        std::set<std::pair<int, int>> physical;
+        for (int cpu : cpus) {
+            if (core_of.count(cpu)) physical.insert(core_of[cpu]);
+        }
+        return static_cast<int>(physical.size());
+    };
+
+    // Intel hybrid parts expose separate PMUs for P- and E-cores
+    std::set<int> p_cpus = parseCpuList(readFirstLine("/sys/devices/cpu_core/cpus"));
+    std::set<int> e_cpus = parseCpuList(readFirstLine("/sys/devices/cpu_atom/cpus"));
+    if (p_cpus.empty() && e_cpus.empty() && !capacity_of.empty()) {
+        int max_capacity = 0;
+        for (const auto& [cpu, capacity] : capacity_of) max_capacity = std::max(max_capacity, capacity);
+        for (const auto& [cpu, capacity] : capacity_of) {
+            (capacity == max_capacity ? p_cpus : e_cpus).insert(cpu);
+        }
+    }
+    if (!p_cpus.empty() && !e_cpus.empty()) {
+        info.performance_cores = countPhysical(p_cpus);
+        info.efficiency_cores = countPhysical(e_cpus);
+    }
+
+    std::ifstream meminfo("/proc/meminfo");
+    while (std::getline(meminfo, line)) {
+        std::istringstream fields(line);
+        std::string key;
+        uint64_t kib = 0;
+        fields >> key >> kib;
+        if (key == "MemTotal:") info.total_ram_bytes = kib * 1024;
+        else if (key == "MemAvailable:") info.available_ram_bytes = kib * 1024;
+    }
+}
+
+#elif defined(__APPLE__)
+
+template <typename T>
+bool sysctlValue(const char* name, T& value) {
+    size_t size = sizeof(value);
+    return sysctlbyname(name, &value, &size, nullptr, 0) == 0;
+}
+
+void probeApple(HardwareInfo& info) {
+    char brand[256] = {};
+    size_t size = sizeof(brand);
+    if (sysctlbyname("machdep.cpu.brand_string", brand, &size, nullptr, 0) == 0) {
+        info.cpu_model = brand;
+    }
+
+    int32_t value = 0;
+    if (sysctlValue("hw.logicalcpu", value)) info.logical_cores = value;
+    if (sysctlValue("hw.physicalcpu", value)) info.physical_cores = value;
+
+    // Apple silicon: perflevel0 = performance cores, perflevel1 = efficiency cores
+    int32_t nlevels = 0;
+    if (sysctlValue("hw.nperflevels", nlevels) && nlevels > 1) {
+        if (sysctlValue("hw.perflevel0.physicalcpu", value)) info.performance_cores = value;
+        if (sysctlValue("hw.perflevel1.physicalcpu", value)) info.efficiency_cores = value;
+    }
+
+    uint64_t memsize = 0;
+    if (sysctlValue("hw.memsize", memsize)) info.total_ram_bytes = memsize;
+}
+
+#elif defined(_WIN32)
+
+void probeWindows(HardwareInfo& info) {
+    DWORD length = 0;
+    GetLogicalProcessorInformationEx(RelationProcessorCore, nullptr, &length);
+    std::vector<char> buffer(length);
+    auto* records = reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data());
+    if (GetLogicalProcessorInformationEx(RelationProcessorCore, records, &length)) {
+        int physical = 0;
+        std::map<int, int> cores_per_class;
+        for (DWORD offset = 0; offset < length;) {
+            auto* record = reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data() + offset);
+            physical++;
+            cores_per_class[record->Processor.EfficiencyClass]++;
+            offset += record->Size;
+        }
+        info.physical_cores = physical;
+        // Higher EfficiencyClass = faster core
+        if (cores_per_class.size() > 1) {
+            info.performance_cores = cores_per_class.rbegin()->second;
+            info.efficiency_cores = physical - info.performance_cores;
+        }
+    }
+
+    MEMORYSTATUSEX memory;
+    memory.dwLength = sizeof(memory);
+    if (GlobalMemoryStatusEx(&memory)) {
+        info.total_ram_bytes = memory.ullTotalPhys;
+        info.available_ram_bytes = memory.ullAvailPhys;
+    }
+}
+
+#endif
+
+SimdLevel detectSimd() {
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return SimdLevel::AVX2;
+    return SimdLevel::SCALAR;
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+    return SimdLevel::NEON;
+#else
+    return SimdLevel::SCALAR;
+#endif
+}
+
+struct Measurement {
+    float prefill_tokens_per_sec = 0.0f;  // 0 if too fast to measure
+    float decode_tokens_per_sec = 0.0f;
+};
+
+// Unconstrained prefill + short decode; best of two runs to damp scheduler noise
+Measurement measure(const LLMConfig& config, int prefill_tokens) {
+    Measurement measurement;
+    LLMBridge bridge;
+    if (!bridge.initialize(config)) {
+        return measurement;
+    }
+
+    std::string prompt;
+    for (int i = 0; i < prefill_tokens; ++i) prompt += " calibration";
+
+    for (int run = 0; run < 2; ++run) {
+        LLMResponse response = bridge.generateQuizAsync(prompt, "").get();
+        if (response.prefill_time_ms > 0.0f) {
+            measurement.prefill_tokens_per_sec = std::max(measurement.prefill_tokens_per_sec,
+                response.prompt_tokens * 1000.0f / response.prefill_time_ms);
+        }
+        if (response.decode_time_ms > 0.0f && response.tokens_generated > 1) {
+            measurement.decode_tokens_per_sec = std::max(measurement.decode_tokens_per_sec,
+                (response.tokens_generated - 1) * 1000.0f / response.decode_time_ms);
+        }
+    }
+    return measurement;
+}
+
+// Fastest candidate; anything within 5% of it that uses less is preferred
+int pickCandidate(const std::vector<std::pair<int, float>>& rates, int fallback) {
+    float best = 0.0f;
+    for (const auto& [value, rate] : rates) best = std::max(best, rate);
+    if (best <= 0.0f) return fallback;
+
+    for (const auto& [value, rate] : rates) {
+        if (rate >= best * 0.95f) return value;  // rates are in ascending order of value
+    }
+    return fallback;
+}
+
+// Time each thread count on decode and each batch size on prefill; keeps the
+// cheapest candidate close to the fastest
+void measureRates(const HardwareInfo& hardware, const LLMConfig& base, const CalibrationOptions& options,
+                  TuningProfile& profile) {
+    LLMConfig config = base;
+    config.max_tokens = options.decode_tokens;
+
+    // Decode is memory-bound: more threads than fast physical cores rarely helps
+    std::vector<int> threads = options.thread_candidates;
+    if (threads.empty()) {
+        threads = {hardware.performance_cores, hardware.physical_cores, hardware.logical_cores};
+    }
+    threads.erase(std::remove_if(threads.begin(), threads.end(), [](int t) { return t <= 0; }), threads.end());
+    std::sort(threads.begin(), threads.end());
+    threads.erase(std::unique(threads.begin(), threads.end()), threads.end());
+
+    std::vector<std::pair<int, float>> decode_rates;
+    for (int n_threads : threads) {
+        config.n_threads = n_threads;
+        decode_rates.emplace_back(n_threads, measure(config, options.prefill_tokens).decode_tokens_per_sec);
+    }
+    profile.n_threads = pickCandidate(decode_rates, base.n_threads);
+    config.n_threads = profile.n_threads;
+    for (const auto& [n_threads, rate] : decode_rates) {
+        if (n_threads == profile.n_threads) profile.decode_tokens_per_sec = rate;
+    }
+
+    std::vector<int> batches = options.batch_candidates;
+    std::sort(batches.begin(), batches.end());
+    std::vector<std::pair<int, float>> prefill_rates;
+    for (int n_batch : batches) {
+        config.n_batch = n_batch;
+        prefill_rates.emplace_back(n_batch, measure(config, options.prefill_tokens).prefill_tokens_per_sec);
+    }
+    profile.n_batch = pickCandidate(prefill_rates, base.n_batch);
+    for (const auto& [n_batch, rate] : prefill_rates) {
+        if (n_batch == profile.n_batch) profile.prefill_tokens_per_sec = rate;
+    }
+}
+
+uint64_t fileSize(const std::string& path) {
+    std::error_code ec;
+    auto size = std::filesystem::file_size(path, ec);
+    return ec ? 0 : static_cast<uint64_t>(size);
+}
+
+// The profile is stale once the configured model or any candidate variant changes
+std::string modelKey(const LLMConfig& base, const CalibrationOptions& options) {
+    std::string key = hardware::modelFingerprint(base.model_path);
+    for (const auto& variant : options.variants) {
+        key += ";" + variant.name + "=" + hardware::modelFingerprint(variant.model_path);
+    }
+    return key;
+}
+
+} // namespace
+
+std::string HardwareInfo::fingerprint() const {
+    // RAM rounded to GiB so small reservations don't invalidate the profile
+    return cpu_model + "|" + std::to_string(logical_cores) + "L" + std::to_string(physical_cores) + "P" +
+           std::to_string(performance_cores) + "+" + std::to_string(efficiency_cores) + "|" +
+           hardware::simdName(simd) + "|" + std::to_string(total_ram_bytes >> 30) + "G";
+}
+
+namespace hardware {
+
+HardwareInfo probe() {
+    HardwareInfo info;
+    info.logical_cores = std::max(1u, std::thread::hardware_concurrency());
+    info.physical_cores = info.logical_cores;
+
+#if defined(__linux__)
+    probeLinux(info);
+#elif defined(__APPLE__)
+    probeApple(info);
+#elif defined(_WIN32)
+    probeWindows(info);
+#endif
+
+    info.simd = detectSimd();
+    info.physical_cores = std::clamp(info.physical_cores, 1, info.logical_cores);
+    return info;
+}
+
+const char* simdName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::AVX512: return "avx512";
+        case SimdLevel::AVX2: return "avx2";
+        case SimdLevel::NEON: return "neon";
+        default: return "scalar";
+    }
+}
+
+std::string modelFingerprint(const std::string& model_path) {
+    std::error_code ec;
+    auto modified = std::filesystem::last_write_time(model_path, ec);
+    if (ec) return model_path + "|missing";
+    return model_path + "|" + std::to_string(fileSize(model_path)) + "|" +
+           std::to_string(modified.time_since_epoch().count());
+}
+
+TuningProfile calibrate(const HardwareInfo& hardware, const LLMConfig& base, const CalibrationOptions& options) {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    TuningProfile profile;
+    profile.n_threads = base.n_threads;
+    profile.n_batch = base.n_batch;
+    profile.n_ctx = base.n_ctx;
+    profile.model_path = base.model_path;
+    profile.hardware_fingerprint = hardware.fingerprint();
+
+    // Timing the mock backend would only measure SyntheticCosts
+    if (LLMBridge().isSynthetic()) {
+        profile.synthetic = true;
+        profile.n_threads = hardware.performance_cores > 0 ? hardware.performance_cores : hardware.physical_cores;
+    } else {
+        measureRates(hardware, base, options, profile);
+    }
+
+    uint64_t ram = hardware.available_ram_bytes ? hardware.available_ram_bytes : hardware.total_ram_bytes;
+    uint64_t budget = static_cast<uint64_t>(ram * options.ram_fraction);
+    uint64_t base_size = fileSize(base.model_path);
+
+    // Highest-quality (largest) variant that fits with a 2048-token cache and
+    // is fast enough; decode speed scales with the bytes streamed per token
+    if (!options.variants.empty()) {
+        std::vector<QuantizationVariant> variants = options.variants;
+        for (auto& variant : variants) {
+            if (variant.size_bytes == 0) variant.size_bytes = fileSize(variant.model_path);
+        }
+        std::sort(variants.begin(), variants.end(), [](const auto& a, const auto& b) {
+            return a.size_bytes > b.size_bytes;
+        });
+
+        const QuantizationVariant* chosen = &variants.back();
+        for (const auto& variant : variants) {
+            if (variant.size_bytes == 0) continue;
+            gguf::Metadata metadata;
+            std::string error_msg;
+            uint64_t kv = gguf::readFile(variant.model_path, metadata, error_msg) ? metadata.kvCacheBytes(2048) : 0;
+            bool fits = budget == 0 || variant.size_bytes + kv <= budget;
+            bool fast_enough = profile.decode_tokens_per_sec <= 0.0f || base_size == 0 ||
+                               profile.decode_tokens_per_sec * base_size / variant.size_bytes >= options.min_tokens_per_sec;
+            if (fits && fast_enough) {
+                chosen = &variant;
+                break;
+            }
+        }
+        profile.quantization = chosen->name;
+        profile.model_path = chosen->model_path;
+    }
+
+    // Largest context whose KV cache fits beside the weights, up to the trained length
+    gguf::Metadata metadata;
+    std::string error_msg;
+    if (gguf::readFile(profile.model_path, metadata, error_msg)) {
+        if (profile.quantization.empty()) profile.quantization = metadata.fileTypeName();
+        uint64_t kv_per_token = metadata.kvCacheBytes(1);
+        uint64_t trained = metadata.getUInt(metadata.architecture() + ".context_length", 0);
+        uint64_t weights = fileSize(profile.model_path);
+        if (kv_per_token > 0 && budget > weights) {
+            profile.n_ctx = 512;
+            for (int n_ctx : {1024, 2048, 4096, 8192, 16384}) {
+                if (kv_per_token * n_ctx > budget - weights) break;
+                if (trained > 0 && static_cast<uint64_t>(n_ctx) > trained) break;
+                profile.n_ctx = n_ctx;
+            }
+        }
+    } else if (ram > 0) {
+        profile.n_ctx = ram >= (uint64_t(8) << 30) ? 4096 : 2048;
+    }
+
+    profile.model_fingerprint = modelKey(base, options);
+    auto end_time = std::chrono::high_resolution_clock::now();
+    profile.calibration_time_ms = std::chrono::duration<float, std::milli>(end_time - start_time).count();
+    return profile;
+}
+
+bool saveProfile(const std::string& path, const TuningProfile& profile, std::string& error_msg) {
+    try {
+        nlohmann::json j = {
+            {"version", kProfileVersion},
+            {"nThreads", profile.n_threads},
+            {"nBatch", profile.n_batch},
+            {"nCtx", profile.n_ctx},
+            {"quantization", profile.quantization},
+            {"modelPath", profile.model_path},
+            {"decodeTokensPerSec", profile.decode_tokens_per_sec},
+            {"prefillTokensPerSec", profile.prefill_tokens_per_sec},
+            {"calibrationTimeMs", profile.calibration_time_ms},
+            {"hardwareFingerprint", profile.hardware_fingerprint},
+            {"modelFingerprint", profile.model_fingerprint},
+            {"synthetic", profile.synthetic}
+        };
+
+        std::ofstream file(path);
+        if (!file) {
+            error_msg = "Cannot write " + path;
+            return false;
+        }
+        file << j.dump(2);
+        return true;
+    } catch (const std::exception& e) {
+        error_msg = std::string("Failed to save tuning profile: ") + e.what();
+        return false;
+    }
+}
+
+bool loadProfile(const std::string& path, TuningProfile& profile, std::string& error_msg) {
+    try {
+        std::ifstream file(path);
+        if (!file) {
+            error_msg = "No tuning profile at " + path;
+            return false;
+        }
+
+        nlohmann::json j = nlohmann::json::parse(file);
+        if (j.value("version", 0) != kProfileVersion) {
+            error_msg = "Tuning profile version mismatch";
+            return false;
+        }
+
+        profile.n_threads = j.at("nThreads").get<int>();
+        profile.n_batch = j.at("nBatch").get<int>();
+        profile.n_ctx = j.at("nCtx").get<int>();
+        profile.quantization = j.value("quantization", "");
+        profile.model_path = j.at("modelPath").get<std::string>();
+        profile.decode_tokens_per_sec = j.value("decodeTokensPerSec", 0.0f);
+        profile.prefill_tokens_per_sec = j.value("prefillTokensPerSec", 0.0f);
+        profile.calibration_time_ms = j.value("calibrationTimeMs", 0.0f);
+        profile.hardware_fingerprint = j.at("hardwareFingerprint").get<std::string>();
+        profile.model_fingerprint = j.at("modelFingerprint").get<std::string>();
+        profile.synthetic = j.value("synthetic", false);
+        return true;
+    } catch (const std::exception& e) {
+        error_msg = std::string("Invalid tuning profile: ") + e.what();
+        return false;
+    }
+}
+
+TuningProfile loadOrCalibrate(const std::string& path, const LLMConfig& base,
+                              const CalibrationOptions& options, bool& recalibrated) {
+    HardwareInfo hardware = probe();
+
+    TuningProfile profile;
+    std::string error_msg;
+    if (loadProfile(path, profile, error_msg) &&
+        profile.hardware_fingerprint == hardware.fingerprint() &&
+        profile.model_fingerprint == modelKey(base, options) &&
+        (!profile.synthetic || LLMBridge().isSynthetic())) {
+        recalibrated = false;
+        return profile;
+    }
+
+    profile = calibrate(hardware, base, options);
+    saveProfile(path, profile, error_msg);  // Best effort; calibrate again next time if this fails
+    recalibrated = true;
+    return profile;
+}
+
+void applyProfile(const TuningProfile& profile, LLMConfig& config) {
+    config.n_threads = profile.n_threads;
+    config.n_batch = profile.n_batch;
+    config.n_ctx = profile.n_ctx;
+    if (!profile.model_path.empty()) {
+        config.model_path = profile.model_path;
+    }
+}
+
+} // namespace hardware
+
+} // namespace core
+} // namespace studyhive
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "llama_bridge.h"
+
+namespace studyhive {
+namespace core {
+
+enum class SimdLevel {
+    SCALAR,
+    NEON,
+    AVX2,
+    AVX512
+};
+
+struct HardwareInfo {
+    std::string cpu_model;
+    int logical_cores = 1;
+    int physical_cores = 1;
+    int performance_cores = 0;  // Both 0 on non-hybrid CPUs
+    int efficiency_cores = 0;
+    SimdLevel simd = SimdLevel::SCALAR;
+    uint64_t total_ram_bytes = 0;
+    uint64_t available_ram_bytes = 0;  // 0 if unknown
+
+    // Stable identity of the machine (changes only with the hardware)
+    std::string fingerprint() const;
+};
+
+// A model file the probe may pick, e.g. the same model in several quantizations
+struct QuantizationVariant {
+    std::string name;  // e.g. "Q4_K_M"
+    std::string model_path;
+    uint64_t size_bytes = 0;  // 0: read from the file
+};
+
+struct CalibrationOptions {
+    std::vector<int> thread_candidates;               // Empty: derived from the core topology
+    std::vector<int> batch_candidates = {64, 128, 256, 512};
+    int prefill_tokens = 256;
+    int decode_tokens = 32;
+    float min_tokens_per_sec = 8.0f;                  // Slowest acceptable decode for a variant
+    float ram_fraction = 0.5f;                        // Share of RAM for weights + KV cache
+    std::vector<QuantizationVariant> variants;        // Empty: keep LLMConfig::model_path
+};
+
+struct TuningProfile {
+    int n_threads = 4;
+    int n_batch = 512;
+    int n_ctx = 2048;
+    std::string quantization;
+    std::string model_path;
+    float decode_tokens_per_sec = 0.0f;   // Measured during calibration
+    float prefill_tokens_per_sec = 0.0f;
+    float calibration_time_ms = 0.0f;
+    std::string hardware_fingerprint;
+    std::string model_fingerprint;
+    bool synthetic = false;   // No real backend to time: threads and batch are static defaults
+};
+
+namespace hardware {
+
+// Detect cores, hybrid topology, SIMD level and memory
+HardwareInfo probe();
+
+const char* simdName(SimdLevel level);
+
+// Identity of a model file (path, size and modification time)
+std::string modelFingerprint(const std::string& model_path);
+
+// Run short prefill/decode passes on the model in base and pick threads,
+// batch, context size and quantization variant. Without a real backend
+// (LLMBridge::isSynthetic) nothing is timed: threads and batch come from the
+// core topology and base, and the profile is marked synthetic.
+TuningProfile calibrate(const HardwareInfo& hardware, const LLMConfig& base,
+                        const CalibrationOptions& options = CalibrationOptions());
+
+bool saveProfile(const std::string& path, const TuningProfile& profile, std::string& error_msg);
+bool loadProfile(const std::string& path, TuningProfile& profile, std::string& error_msg);
+
+// Reuse the profile at path while hardware and model are unchanged (and it
+// was measured, once a real backend is available); otherwise calibrate and
+// store a new one
+TuningProfile loadOrCalibrate(const std::string& path, const LLMConfig& base,
+                              const CalibrationOptions& options, bool& recalibrated);
+
+// Copy the tuned values into config
+void applyProfile(const TuningProfile& profile, LLMConfig& config);
+
+} // namespace hardware
+
+} // namespace core
+} // namespace studyhive
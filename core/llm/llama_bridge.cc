@@ -1,8 +1,20 @@
 #include "llama_bridge.h"
+#include "grammar_mask.h"
+#include "schema_validator.h"
+#include "gguf_reader.h"
+#include "../memory/memory_governor.h"
 #include <fstream>
 #include <chrono>
 #include <thread>
 #include <filesystem>
+#include <map>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <cctype>
+#include <cmath>
+#include <algorithm>
 
 // Note: In a real implementation, this would include llama.cpp headers
 // #include "llama.h"
@@ -28,6 +40,29 @@ public:
             return false;
         }
 
+        // Compile the grammar and its token masks up front so the first request doesn't pay for it
+        std::string grammar_error;
+        if (!loadMaskTable(config.grammar_path, grammar_error)) {
+            return false;
+        }
+
+        // Responses are validated against these; without them nothing would pass
+        std::string schema_dir = config.schema_dir.empty() ? validation::defaultSchemaDir(config.grammar_path)
+                                                           : config.schema_dir;
+        validation::ResponseSchemas schemas;
+        std::string schema_error;
+        if (!validation::loadSchemas(schema_dir, schemas, schema_error)) {
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> lock(schemas_mutex_);
+            schemas_ = std::move(schemas);
+        }
+
+        // Model identity comes from the GGUF header when the file has one
+        std::string metadata_error;
+        has_metadata_ = gguf::readFile(config.model_path, model_metadata_, metadata_error);
+
         // TODO: Initialize llama.cpp context
         // For now, simulate initialization
         ready_ = true;
@@ -35,20 +70,812 @@ public:
         return true;
     }
 
-    LLMResponse generateQuiz(const std::string& prompt, const std::string& grammar_path) {
-        LLMResponse response;
-        response.success = false;
+    LLMResponse generateQuiz(const PromptSegments& prompt, const std::string& grammar_path,
+                             const GenerationOptions& options) {
+        return runInference(RequestKind::QUIZ, prompt, grammar_path, options);
+    }
+
+    LLMResponse gradeAnswer(const PromptSegments& prompt, const std::string& grammar_path,
+                            const GenerationOptions& options) {
+        return runInference(RequestKind::GRADE, prompt, grammar_path, options);
+    }
+
+    std::future<LLMResponse> generateQuizAsync(const PromptSegments& prompt, const std::string& grammar_path,
+                                               const GenerationOptions& options) {
+        return launchAsync(RequestKind::QUIZ, prompt, grammar_path, options);
+    }
+
+    std::future<LLMResponse> gradeAnswerAsync(const PromptSegments& prompt, const std::string& grammar_path,
+                                              const GenerationOptions& options) {
+        return launchAsync(RequestKind::GRADE, prompt, grammar_path, options);
+    }
+
+    std::vector<LLMResponse> gradeAnswers(const nlohmann::json& question,
+                                          const nlohmann::json& rubric,
+                                          const std::vector<std::string>& answers,
+                                          const std::string& grammar_path,
+                                          const GenerationOptions& options) {
+        // Counted as a whole: cleanup() waits for the waves, and those after it
+        // started stop at their first token
+        ActiveRequest active(*this);
+        std::vector<LLMResponse> responses;
+        responses.reserve(answers.size());
+
+        PromptSegments prefix = prompts::buildGradePromptPrefix(question, rubric);
+        size_t wave_size = static_cast<size_t>(std::max(1, config_.n_parallel));
+
+        // Decode in waves of at most n_parallel sequences
+        for (size_t begin = 0; begin < answers.size(); begin += wave_size) {
+            size_t end = std::min(answers.size(), begin + wave_size);
+            std::vector<PromptSegments> suffixes;
+            for (size_t i = begin; i < end; ++i) {
+                suffixes.push_back(prompts::buildGradePromptSuffix(answers[i]));
+            }
+
+            auto wave = runBatch(RequestKind::GRADE, prefix, suffixes, grammar_path, options);
+            responses.insert(responses.end(), wave.begin(), wave.end());
+        }
+
+        return responses;
+    }
+
+    PrewarmResult prewarm(const PrewarmOptions& options) {
+        PrewarmResult result;
+        auto start_time = std::chrono::high_resolution_clock::now();
+        auto elapsedMs = [](std::chrono::high_resolution_clock::time_point since) {
+            return std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - since).count();
+        };
+        auto finish = [&]() {
+            result.total_time_ms = elapsedMs(start_time);
+            return result;
+        };
+
+        if (!ready_) {
+            result.error_message = "LLM not initialized";
+            return finish();
+        }
+
+        // Real requests take precedence: any request entering the decoder stops the prewarm
+        auto yielded = [&]() {
+            result.cancelled = result.cancelled || options.cancel_token.isCancelled() || shutting_down_ ||
+                               foreground_requests_ > 0;
+            return result.cancelled;
+        };
+
+        std::string error_msg;
+        std::lock_guard<std::mutex> lock(prewarm_mutex_);
+        resident_weight_bytes_ = 0;
+        if (options.read_weights && !weights_.open(config_.model_path, error_msg)) {
+            result.error_message = error_msg;
+            return finish();
+        }
+        uint64_t kv_bytes = options.touch_kv_cache && has_metadata_ ? model_metadata_.kvCacheBytes(config_.n_ctx) : 0;
+        uint64_t total_bytes = (options.read_weights ? weights_.size() : 0) + kv_bytes;
+        uint64_t done_bytes = 0;
+        auto report = [&](uint64_t bytes) {
+            done_bytes += bytes;
+            if (options.progress && total_bytes > 0) options.progress(static_cast<float>(done_bytes) / total_bytes);
+        };
+
+        // TODO: With llama.cpp, walk the mapping llama_model holds (use_mmap) and the
+        // context's KV buffer instead of our own. For now the bridge maps the file
+        // itself, which warms the same page cache.
+        if (options.read_weights) {
+            auto weights_start = std::chrono::high_resolution_clock::now();
+            weights_.prefetch();
+            const size_t step = 8 << 20;
+            uint8_t checksum = 0;
+            for (size_t offset = 0; offset < weights_.size(); offset += step) {
+                if (yielded()) return finish();
+                size_t end = std::min(weights_.size(), offset + step);
+                for (size_t page = offset; page < end; page += kPageBytes) {
+                    checksum ^= weights_.data()[page];
+                }
+                result.weight_bytes += end - offset;
+                report(end - offset);
+            }
+            page_checksum_ = checksum;  // Keeps the reads from being optimized away
+            resident_weight_bytes_ = weights_.size();
+            result.weights_time_ms = elapsedMs(weights_start);
+        }
+
+        if (kv_bytes > 0) {
+            auto kv_start = std::chrono::high_resolution_clock::now();
+            if (kv_cache_size_ != kv_bytes) {
+                kv_cache_.reset(new uint8_t[kv_bytes]);
+                kv_cache_size_ = kv_bytes;
+            }
+            const size_t step = 8 << 20;
+            for (size_t offset = 0; offset < kv_bytes; offset += step) {
+                if (yielded()) return finish();
+                size_t end = std::min<size_t>(kv_bytes, offset + step);
+                for (size_t page = offset; page < end; page += kPageBytes) {
+                    kv_cache_[page] = 0;
+                }
+                result.kv_cache_bytes += end - offset;
+                report(end - offset);
+            }
+            result.kv_cache_time_ms = elapsedMs(kv_start);
+        }
+
+        if (options.warm_decode) {
+            if (yielded()) return finish();
+            auto decode_start = std::chrono::high_resolution_clock::now();
+            std::vector<int32_t> tokens = tokenize("warm up");
+            // A busy decoder is already warm
+            std::unique_lock<std::mutex> inference_lock(inference_mutex_, std::try_to_lock);
+            if (inference_lock.owns_lock()) {
+                simulatePrefill(tokens.size());
+                simulateDecodeStep(1, static_cast<int>(tokens.size()), false);
+            }
+            result.decode_time_ms = elapsedMs(decode_start);
+        }
+
+        result.completed = true;
+        return finish();
+    }
+
+    void attachMemoryGovernor(MemoryGovernor* governor) {
+        memory_registrations_.clear();
+        if (!governor) return;
+
+        std::string name = std::filesystem::path(config_.model_path).stem().string();
+        MemoryConsumer kv_cache;
+        kv_cache.name = "llm-kv:" + name;
+        kv_cache.tier = ReclaimTier::KV_CONTEXT;
+        kv_cache.usage = [this]() { return static_cast<size_t>(kv_cache_size_); };
+        kv_cache.shrink = [this](size_t) { return releaseIfIdle(false); };
+        memory_registrations_.push_back(governor->registerConsumer(kv_cache));
+
+        MemoryConsumer weights;
+        weights.name = "llm-weights:" + name;
+        weights.tier = ReclaimTier::IDLE_MODEL;
+        weights.usage = [this]() { return static_cast<size_t>(resident_weight_bytes_); };
+        weights.shrink = [this](size_t) { return releaseIfIdle(true); };
+        memory_registrations_.push_back(governor->registerConsumer(weights));
+    }
+
+    bool isReady() const {
+        return ready_;
+    }
+
+    bool isSynthetic() const {
+        return true;  // Mock backend until llama.cpp is wired in
+    }
+
+    validation::ResponseSchemas responseSchemas() const {
+        std::lock_guard<std::mutex> lock(schemas_mutex_);
+        return schemas_;
+    }
+
+    LLMBridge::ModelInfo getModelInfo() const {
+        ModelInfo info;
+        info.name = std::filesystem::path(config_.model_path).stem().string();
+        info.version = "unknown";
+        info.parameters = 0;
+        info.context_size = config_.n_ctx;
+        info.kv_cache_bytes = 0;
 
+        if (has_metadata_) {
+            if (!model_metadata_.name().empty()) info.name = model_metadata_.name();
+            info.version = model_metadata_.fileTypeName() + " GGUF v" + std::to_string(model_metadata_.version);
+            info.parameters = model_metadata_.parameterCount();
+            info.kv_cache_bytes = model_metadata_.kvCacheBytes(config_.n_ctx);
+        }
+        
+        if (std::filesystem::exists(config_.model_path)) {
+            auto size = std::filesystem::file_size(config_.model_path);
+            info.file_size = std::to_string(size / (1024 * 1024)) + " MB";
+        }
+        
+        return info;
+    }
+
+    void setProgressCallback(std::function<void(float)> callback) {
+        std::lock_guard<std::mutex> lock(progress_mutex_);
+        progress_callback_ = std::move(callback);
+    }
+
+    EmbeddingResponse embed(const std::string& text) {
+        EmbeddingResponse response;
         if (!ready_) {
             response.error_message = "LLM not initialized";
             return response;
         }
 
+        ActiveRequest active(*this);
+        ForegroundRequest foreground(foreground_requests_);
+        auto start_time = std::chrono::high_resolution_clock::now();
+        std::vector<std::string> pieces = splitTokens(text);
+        response.prompt_tokens = static_cast<int>(pieces.size());
+
+        // TODO: Implement with llama.cpp: llama_set_embeddings(ctx, true), decode the
+        // prompt as one batch (no sampling) and read llama_get_embeddings_seq with
+        // mean pooling. For now, hash lowercased word unigrams and bigrams into a
+        // fixed-size vector so lexically similar texts land close together.
+        std::lock_guard<std::mutex> lock(inference_mutex_);
+        response.embedding.assign(kMockEmbeddingDim, 0.0f);
+        std::hash<std::string> hasher;
+        std::string previous;
+
+        auto addFeature = [&](const std::string& feature) {
+            size_t hash = hasher(feature);
+            float sign = ((hash >> 31) & 1) ? 1.0f : -1.0f;
+            response.embedding[hash % kMockEmbeddingDim] += sign;
+        };
+
+        for (const auto& piece : pieces) {
+            std::string word;
+            for (char c : piece) {
+                if (std::isalnum(static_cast<unsigned char>(c))) {
+                    word += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+                }
+            }
+            if (word.empty()) continue;
+            addFeature(word);
+            if (!previous.empty()) addFeature(previous + " " + word);
+            previous = word;
+        }
+
+        float norm = 0.0f;
+        for (float value : response.embedding) norm += value * value;
+        if (norm > 0.0f) {
+            norm = std::sqrt(norm);
+            for (float& value : response.embedding) value /= norm;
+        }
+
+        auto end_time = std::chrono::high_resolution_clock::now();
+        response.processing_time_ms = std::chrono::duration<float, std::milli>(end_time - start_time).count();
+        response.success = true;
+        return response;
+    }
+
+    std::vector<int32_t> tokenize(const std::string& text) {
+        // TODO: Use llama_tokenize once the llama.cpp context is wired in.
+        // For now, intern mock token pieces into a growing vocabulary.
+        std::vector<int32_t> ids;
+        std::lock_guard<std::mutex> lock(vocab_mutex_);
+        for (auto& piece : splitTokens(text)) {
+            auto it = vocab_ids_.find(piece);
+            if (it == vocab_ids_.end()) {
+                it = vocab_ids_.emplace(std::move(piece), static_cast<int32_t>(vocab_ids_.size())).first;
+            }
+            ids.push_back(it->second);
+        }
+        return ids;
+    }
+
+    size_t countTokens(const std::string& text) const {
+        return splitTokens(text).size();
+    }
+
+    size_t promptTokenBudget() const {
+        size_t context = static_cast<size_t>(std::max(0, config_.n_ctx));
+        size_t output = std::min(static_cast<size_t>(std::max(0, config_.max_tokens)), context / 2);
+        return context - output;
+    }
+
+    LLMBridge::TokenizedPrompt tokenizePrompt(const PromptSegments& prompt) {
         auto start_time = std::chrono::high_resolution_clock::now();
 
-        // TODO: Implement actual llama.cpp inference with grammar
-        // For now, return a mock response
-        response.content = R"({
+        LLMBridge::TokenizedPrompt result;
+        result.tokenizer_calls = 0;
+
+        for (const auto& segment : prompt) {
+            if (segment.text.empty()) continue;
+
+            std::shared_ptr<const std::vector<int32_t>> tokens = segment.tokens;
+            if (!tokens && segment.is_static) {
+                tokens = cachedSegmentTokens(segment.text, result.tokenizer_calls);
+            }
+
+            if (tokens) {
+                result.tokens.insert(result.tokens.end(), tokens->begin(), tokens->end());
+            } else {
+                auto dynamic_tokens = tokenize(segment.text);
+                result.tokenizer_calls++;
+                result.tokens.insert(result.tokens.end(), dynamic_tokens.begin(), dynamic_tokens.end());
+            }
+        }
+
+        auto end_time = std::chrono::high_resolution_clock::now();
+        result.build_time_ms = std::chrono::duration<float, std::milli>(end_time - start_time).count();
+        return result;
+    }
+
+    void cleanup() {
+        // Stop in-flight requests (async, batched, synchronous calls on other
+        // threads) at their next token boundary and wait for them
+        shutting_down_ = true;
+        {
+            std::unique_lock<std::mutex> lock(active_mutex_);
+            active_cv_.wait(lock, [this]() { return active_requests_ == 0; });
+        }
+
+        // TODO: Cleanup llama.cpp resources
+        {
+            std::lock_guard<std::mutex> lock(prewarm_mutex_);
+            weights_.close();
+            resident_weight_bytes_ = 0;
+            kv_cache_.reset();
+            kv_cache_size_ = 0;
+        }
+        ready_ = false;
+        shutting_down_ = false;
+    }
+
+private:
+    enum class RequestKind { QUIZ, GRADE };
+
+    LLMConfig config_;
+    mutable std::mutex schemas_mutex_;
+    validation::ResponseSchemas schemas_;
+    std::atomic<bool> ready_;
+    gguf::Metadata model_metadata_;
+    bool has_metadata_ = false;
+
+    // Set by the app, called from whichever thread is decoding
+    std::mutex progress_mutex_;
+    std::function<void(float)> progress_callback_;
+
+    // One llama.cpp context: decodes are serialized
+    std::mutex inference_mutex_;
+    std::atomic<int> foreground_requests_{0};  // Requests in runBatch or embed; prewarm yields to them
+
+    // Prewarm state: the weights mapping and KV buffer stay resident once touched
+    static constexpr size_t kPageBytes = 4096;
+    std::mutex prewarm_mutex_;
+    MappedFile weights_;
+    std::unique_ptr<uint8_t[]> kv_cache_;
+    std::atomic<uint64_t> kv_cache_size_{0};
+    std::atomic<uint64_t> resident_weight_bytes_{0};  // Mapped by prewarm, read without prewarm_mutex_
+    uint8_t page_checksum_ = 0;
+
+    // Governor shrink callback. Busy contexts (a request or a prewarm in
+    // progress) keep their memory. TODO: With llama.cpp, free the context
+    // (KV) or the model (weights) here and recreate them on the next request.
+    size_t releaseIfIdle(bool weights) {
+        std::unique_lock<std::mutex> lock(prewarm_mutex_, std::try_to_lock);
+        if (!lock.owns_lock() || foreground_requests_ > 0) {
+            return 0;
+        }
+        size_t freed = 0;
+        if (weights) {
+            freed = weights_.isOpen() ? weights_.size() : 0;
+            weights_.close();
+            resident_weight_bytes_ = 0;
+        } else {
+            freed = static_cast<size_t>(kv_cache_size_);
+            kv_cache_.reset();
+            kv_cache_size_ = 0;
+        }
+        return freed;
+    }
+
+    // Counts a real request for the lifetime of the scope
+    struct ForegroundRequest {
+        explicit ForegroundRequest(std::atomic<int>& count) : count_(count) { ++count_; }
+        ~ForegroundRequest() { --count_; }
+        std::atomic<int>& count_;
+    };
+
+    // Width of the mock embedding (n_embd of the real model)
+    static constexpr size_t kMockEmbeddingDim = 384;
+
+    // Mock tokenizer vocabulary
+    std::mutex vocab_mutex_;
+    std::map<std::string, int32_t> vocab_ids_;
+
+    // Token ids of static prompt segments, keyed by segment text
+    static constexpr size_t kMaxCachedSegments = 512;
+    std::mutex segment_mutex_;
+    std::unordered_map<std::string, std::shared_ptr<const std::vector<int32_t>>> segment_cache_;
+
+    std::shared_ptr<const std::vector<int32_t>> cachedSegmentTokens(const std::string& text,
+                                                                    int& tokenizer_calls) {
+        {
+            std::lock_guard<std::mutex> lock(segment_mutex_);
+            auto it = segment_cache_.find(text);
+            if (it != segment_cache_.end()) {
+                return it->second;
+            }
+        }
+
+        auto tokens = std::make_shared<const std::vector<int32_t>>(tokenize(text));
+        tokenizer_calls++;
+
+        std::lock_guard<std::mutex> lock(segment_mutex_);
+        if (segment_cache_.size() >= kMaxCachedSegments) {
+            segment_cache_.clear();  // static segments are few; overflow means misuse
+        }
+        segment_cache_.emplace(text, tokens);
+        return tokens;
+    }
+
+    // In-flight request tracking so cleanup() can drain every request
+    std::atomic<bool> shutting_down_{false};
+    std::mutex active_mutex_;
+    std::condition_variable active_cv_;
+    int active_requests_ = 0;
+
+    void beginRequest() {
+        std::lock_guard<std::mutex> lock(active_mutex_);
+        active_requests_++;
+    }
+
+    void endRequest() {
+        std::lock_guard<std::mutex> lock(active_mutex_);
+        active_requests_--;
+        active_cv_.notify_all();
+    }
+
+    // Counts a request cleanup() waits for, for the lifetime of the scope
+    struct ActiveRequest {
+        explicit ActiveRequest(Impl& impl) : impl_(impl) { impl_.beginRequest(); }
+        ~ActiveRequest() { impl_.endRequest(); }
+        Impl& impl_;
+    };
+
+    // Compiled grammars and their token mask tables, keyed by path
+    std::mutex grammar_mutex_;
+    std::map<std::string, std::shared_ptr<const GrammarAutomaton>> grammars_;
+    std::map<std::string, std::shared_ptr<TokenMaskTable>> mask_tables_;
+
+    // Mock model vocabulary the mask tables are built over; set once, with the
+    // first table, and read-only after that
+    std::shared_ptr<const TokenVocabulary> mock_vocab_;
+    std::unordered_map<std::string, int32_t> mock_piece_ids_;
+    size_t mock_max_piece_ = 0;
+
+    std::shared_ptr<const GrammarAutomaton> loadGrammar(const std::string& path, std::string& error_msg) {
+        std::lock_guard<std::mutex> lock(grammar_mutex_);
+
+        auto it = grammars_.find(path);
+        if (it != grammars_.end()) {
+            return it->second;
+        }
+
+        auto automaton = GrammarAutomaton::compileFile(path, error_msg);
+        if (!automaton) {
+            error_msg = "Grammar compilation failed: " + error_msg;
+            return nullptr;
+        }
+
+        grammars_[path] = automaton;
+        return automaton;
+    }
+
+    // TODO: Build the vocabulary from llama_token_get_text once the model is loaded
+    std::shared_ptr<TokenMaskTable> loadMaskTable(const std::string& path, std::string& error_msg) {
+        auto automaton = loadGrammar(path, error_msg);
+        if (!automaton) {
+            return nullptr;
+        }
+
+        std::lock_guard<std::mutex> lock(grammar_mutex_);
+        auto it = mask_tables_.find(path);
+        if (it != mask_tables_.end()) {
+            return it->second;
+        }
+
+        if (!mock_vocab_) {
+            buildMockVocabulary();
+        }
+        auto table = std::make_shared<TokenMaskTable>(automaton, mock_vocab_);
+        table->precompute();
+        mask_tables_[path] = table;
+        return table;
+    }
+
+    // Byte fallback pieces (every string is representable) plus the mock
+    // tokenizer's pieces of both mock responses; EOS is the empty last piece
+    void buildMockVocabulary() {
+        auto vocab = std::make_shared<TokenVocabulary>();
+        auto add = [&](const std::string& piece) {
+            if (mock_piece_ids_.emplace(piece, static_cast<int32_t>(vocab->pieces.size())).second) {
+                vocab->pieces.push_back(piece);
+                mock_max_piece_ = std::max(mock_max_piece_, piece.size());
+            }
+        };
+        for (int b = 0; b < 256; ++b) {
+            add(std::string(1, static_cast<char>(b)));
+        }
+        for (const std::string* output : {&mockQuizOutput(), &mockGradeOutput()}) {
+            for (const auto& piece : splitTokens(*output)) {
+                add(piece);
+            }
+        }
+        vocab->eos_token = static_cast<int32_t>(vocab->pieces.size());
+        vocab->pieces.push_back("");
+        mock_vocab_ = std::move(vocab);
+    }
+
+    // Mock sampler: the longest allowed piece that continues the output (-1 if none)
+    int32_t sampleMockToken(const TokenMaskTable::Mask& mask, const std::string& output, size_t offset) const {
+        for (size_t len = std::min(mock_max_piece_, output.size() - offset); len > 0; --len) {
+            auto it = mock_piece_ids_.find(output.substr(offset, len));
+            if (it != mock_piece_ids_.end() && TokenMaskTable::isSet(mask, it->second)) {
+                return it->second;
+            }
+        }
+        return -1;
+    }
+
+    std::future<LLMResponse> launchAsync(RequestKind kind, const PromptSegments& prompt,
+                                         const std::string& grammar_path,
+                                         const GenerationOptions& options) {
+        // Counted from launch, so cleanup() also waits for requests not yet running
+        beginRequest();
+        return std::async(std::launch::async, [this, kind, prompt, grammar_path, options]() {
+            LLMResponse response = runInference(kind, prompt, grammar_path, options);
+            endRequest();
+            return response;
+        });
+    }
+
+    LLMResponse runInference(RequestKind kind, const PromptSegments& prompt,
+                             const std::string& grammar_path,
+                             const GenerationOptions& options) {
+        return runBatch(kind, prompt, {PromptSegments()}, grammar_path, options).front();
+    }
+
+    // Decode loop shared by all request types. Every sequence shares the prompt
+    // prefix and has its own suffix; each step decodes one token for every live
+    // sequence. Cancellation, the deadline and max_tokens are checked at every
+    // token boundary; on early stop the partial output is returned together
+    // with the reason.
+    std::vector<LLMResponse> runBatch(RequestKind kind, const PromptSegments& shared_prefix,
+                                      const std::vector<PromptSegments>& suffixes,
+                                      const std::string& grammar_path,
+                                      const GenerationOptions& options) {
+        LLMResponse initial;
+        initial.success = false;
+        initial.tokens_generated = 0;
+        initial.forced_tokens = 0;
+        initial.processing_time_ms = 0.0f;
+        initial.stop_reason = StopReason::FAILED;
+        initial.prompt_tokens = 0;
+        initial.tokenizer_calls = 0;
+        initial.prompt_build_time_ms = 0.0f;
+        initial.prefill_time_ms = 0.0f;
+        initial.time_to_first_token_ms = 0.0f;
+        initial.decode_time_ms = 0.0f;
+
+        std::vector<LLMResponse> responses(suffixes.size(), initial);
+        if (responses.empty()) {
+            return responses;
+        }
+        ActiveRequest active(*this);
+        ForegroundRequest foreground(foreground_requests_);
+
+        if (!ready_) {
+            for (auto& response : responses) response.error_message = "LLM not initialized";
+            return responses;
+        }
+
+        std::shared_ptr<TokenMaskTable> masks;
+        if (!grammar_path.empty()) {
+            std::string grammar_error;
+            masks = loadMaskTable(grammar_path, grammar_error);
+            if (!masks) {
+                for (auto& response : responses) response.error_message = grammar_error;
+                return responses;
+            }
+        }
+
+        auto start_time = std::chrono::high_resolution_clock::now();
+
+        // The shared prefix is tokenized once; its tokenizer calls are charged to the first sequence
+        LLMBridge::TokenizedPrompt prefix = tokenizePrompt(shared_prefix);
+        for (size_t i = 0; i < suffixes.size(); ++i) {
+            LLMBridge::TokenizedPrompt suffix = tokenizePrompt(suffixes[i]);
+            responses[i].prompt_tokens = static_cast<int>(prefix.tokens.size() + suffix.tokens.size());
+            responses[i].tokenizer_calls = suffix.tokenizer_calls + (i == 0 ? prefix.tokenizer_calls : 0);
+            responses[i].prompt_build_time_ms = prefix.build_time_ms + suffix.build_time_ms;
+        }
+
+        std::function<void(float)> progress_callback;
+        {
+            std::lock_guard<std::mutex> lock(progress_mutex_);
+            progress_callback = progress_callback_;
+        }
+
+        std::lock_guard<std::mutex> inference_lock(inference_mutex_);
+
+        auto prefill_start = std::chrono::high_resolution_clock::now();
+        size_t prefill_tokens = prefix.tokens.size();
+        for (const auto& response : responses) {
+            prefill_tokens += response.prompt_tokens - prefix.tokens.size();
+        }
+        simulatePrefill(prefill_tokens);
+        auto prefill_end = std::chrono::high_resolution_clock::now();
+        float prefill_ms = std::chrono::duration<float, std::milli>(prefill_end - prefill_start).count();
+
+        // TODO: Implement actual llama.cpp inference: prefill the prefix once on
+        // sequence 0, llama_kv_cache_seq_cp it to the other sequences, prefill all
+        // suffixes in one llama_batch, then decode one token per live sequence per
+        // batch, sampling each sequence with its own TokenSampler (seeded from
+        // config_.seed) under the grammar's token mask.
+        // For now, every sequence replays a mock response over the mock vocabulary:
+        // without a grammar one mock token per step, with one the longest allowed
+        // token that continues the response, after any forced run.
+        const std::string& output = kind == RequestKind::QUIZ ? mockQuizOutput() : mockGradeOutput();
+        const std::vector<std::string> tokens = splitTokens(output);
+
+        struct Sequence {
+            int32_t grammar_state;
+            size_t next_token;  // Unconstrained: index into tokens
+            size_t offset;      // Constrained: output bytes emitted
+            bool live;
+        };
+
+        std::vector<Sequence> sequences(responses.size(),
+                                        {masks ? masks->automaton().startState() : 0, 0, 0, true});
+        int max_tokens = config_.max_tokens > 0 ? config_.max_tokens : static_cast<int>(output.size());
+        size_t total_budget = static_cast<size_t>(max_tokens) * sequences.size();
+        size_t total_generated = 0;
+        size_t live_count = sequences.size();
+        std::chrono::high_resolution_clock::time_point first_token_time;
+        bool first_token = true;
+
+        auto emit = [&](LLMResponse& response, const std::string& piece) {
+            if (first_token) {
+                first_token_time = std::chrono::high_resolution_clock::now();
+                first_token = false;
+            }
+            response.content += piece;
+            response.tokens_generated++;
+            total_generated++;
+        };
+
+        while (live_count > 0) {
+            simulateDecodeStep(live_count, responses.front().prompt_tokens + responses.front().tokens_generated,
+                               masks != nullptr);
+            size_t step_forced = 0;
+
+            StopReason early_stop = StopReason::COMPLETED;
+            if (options.cancel_token.isCancelled() || shutting_down_) {
+                early_stop = StopReason::CANCELLED;
+            } else if (std::chrono::steady_clock::now() >= options.deadline) {
+                early_stop = StopReason::DEADLINE_EXCEEDED;
+            }
+
+            for (size_t i = 0; i < sequences.size(); ++i) {
+                Sequence& sequence = sequences[i];
+                LLMResponse& response = responses[i];
+                if (!sequence.live) continue;
+
+                if (early_stop != StopReason::COMPLETED) {
+                    response.stop_reason = early_stop;
+                } else if (masks) {
+                    // Jump-ahead: the literal run the grammar forces is appended
+                    // without sampling
+                    int32_t forced_state;
+                    for (int32_t token : masks->forcedTokens(sequence.grammar_state, forced_state)) {
+                        const std::string& piece = mock_vocab_->pieces[token];
+                        if (response.tokens_generated >= max_tokens ||
+                            output.compare(sequence.offset, piece.size(), piece) != 0) {
+                            break;
+                        }
+                        sequence.grammar_state = masks->acceptToken(sequence.grammar_state, token);
+                        sequence.offset += piece.size();
+                        emit(response, piece);
+                        response.forced_tokens++;
+                        step_forced++;
+                    }
+
+                    if (sequence.offset >= output.size()) {
+                        response.stop_reason = StopReason::COMPLETED;
+                        if (!masks->automaton().isAccepting(sequence.grammar_state)) {
+                            response.stop_reason = StopReason::FAILED;
+                            response.error_message = "Output ended before the grammar was complete";
+                        }
+                    } else if (response.tokens_generated >= max_tokens) {
+                        response.stop_reason = StopReason::MAX_TOKENS;
+                    } else {
+                        int32_t token = sampleMockToken(*masks->allowedTokens(sequence.grammar_state),
+                                                        output, sequence.offset);
+                        if (token >= 0) {
+                            const std::string& piece = mock_vocab_->pieces[token];
+                            sequence.grammar_state = masks->acceptToken(sequence.grammar_state, token);
+                            sequence.offset += piece.size();
+                            emit(response, piece);
+                            continue;
+                        }
+                        response.stop_reason = StopReason::FAILED;
+                        response.error_message = "Output violates grammar at token " +
+                                                 std::to_string(response.tokens_generated);
+                    }
+                } else if (sequence.next_token >= tokens.size()) {
+                    response.stop_reason = StopReason::COMPLETED;
+                } else if (response.tokens_generated >= max_tokens) {
+                    response.stop_reason = StopReason::MAX_TOKENS;
+                } else {
+                    emit(response, tokens[sequence.next_token++]);
+                    continue;
+                }
+
+                sequence.live = false;
+                live_count--;
+            }
+
+            // Forced tokens are evaluated in one batch, like prompt tokens
+            if (step_forced > 0) {
+                simulatePrefill(step_forced);
+            }
+
+            if (progress_callback && live_count > 0) {
+                progress_callback(static_cast<float>(total_generated) / total_budget);
+            }
+        }
+
+        bool all_completed = true;
+        auto end_time = std::chrono::high_resolution_clock::now();
+        float elapsed_ms = std::chrono::duration<float, std::milli>(end_time - start_time).count();
+
+        for (auto& response : responses) {
+            response.success = (response.stop_reason == StopReason::COMPLETED);
+            response.processing_time_ms = elapsed_ms;
+            response.prefill_time_ms = prefill_ms;
+            if (!first_token) {
+                response.time_to_first_token_ms =
+                    std::chrono::duration<float, std::milli>(first_token_time - start_time).count();
+                response.decode_time_ms =
+                    std::chrono::duration<float, std::milli>(end_time - first_token_time).count();
+            }
+            all_completed = all_completed && response.success;
+        }
+
+        if (all_completed && progress_callback) {
+            progress_callback(1.0f);
+        }
+
+        return responses;
+    }
+
+    // Synthetic backend: sleep for the configured per-token costs
+    void simulatePrefill(size_t n_tokens) const {
+        const SyntheticCosts& costs = config_.synthetic;
+        if (costs.prefill_us_per_token <= 0.0f && costs.batch_overhead_us <= 0.0f) return;
+
+        size_t n_batch = static_cast<size_t>(std::max(1, config_.n_batch));
+        size_t n_calls = (n_tokens + n_batch - 1) / n_batch;
+        float us = n_calls * costs.batch_overhead_us +
+                   n_tokens * costs.prefill_us_per_token / std::max(1, config_.n_threads);
+        std::this_thread::sleep_for(std::chrono::duration<float, std::micro>(us));
+    }
+
+    void simulateDecodeStep(size_t n_live, int n_past, bool constrained) const {
+        const SyntheticCosts& costs = config_.synthetic;
+        if (costs.decode_us_per_token <= 0.0f && costs.batch_overhead_us <= 0.0f) return;
+
+        // Weights are streamed once per step, so extra sequences mostly pay for attention
+        float step_us = costs.batch_overhead_us +
+                        costs.decode_us_per_token / std::min(std::max(1, config_.n_threads), 4) +
+                        n_live * costs.context_us_per_token * n_past +
+                        (constrained ? n_live * costs.grammar_us_per_token : 0.0f);
+        std::this_thread::sleep_for(std::chrono::duration<float, std::micro>(step_us));
+    }
+
+    // Mock tokenizer: whitespace-prefixed words, digit runs and single punctuation marks
+    static std::vector<std::string> splitTokens(const std::string& text) {
+        std::vector<std::string> tokens;
+        size_t i = 0;
+        while (i < text.size()) {
+            size_t start = i;
+            while (i < text.size() && (text[i] == ' ' || text[i] == '\n')) i++;
+            if (i < text.size() && std::isalnum(static_cast<unsigned char>(text[i]))) {
+                while (i < text.size() && std::isalnum(static_cast<unsigned char>(text[i]))) i++;
+            } else if (i < text.size()) {
+                i++;
+            }
+            tokens.push_back(text.substr(start, i - start));
+        }
+        return tokens;
+    }
+
+    static const std::string& mockQuizOutput() {
+        static const std::string output = R"({
             "topic": "Sample Topic",
             "difficulty": "medium",
             "questions": [
@@ -72,29 +899,11 @@ public:
                 "seed": 42
             }
         })";
-
-        auto end_time = std::chrono::high_resolution_clock::now();
-        response.processing_time_ms = std::chrono::duration<float, std::milli>(end_time - start_time).count();
-        response.tokens_generated = 150; // Mock value
-        response.success = true;
-
-        return response;
+        return output;
     }
 
-    LLMResponse gradeAnswer(const std::string& prompt, const std::string& grammar_path) {
-        LLMResponse response;
-        response.success = false;
-
-        if (!ready_) {
-            response.error_message = "LLM not initialized";
-            return response;
-        }
-
-        auto start_time = std::chrono::high_resolution_clock::now();
-
-        // TODO: Implement actual llama.cpp inference with grammar
-        // For now, return a mock response
-        response.content = R"({
+    static const std::string& mockGradeOutput() {
+        static const std::string output = R"({
             "questionId": "saq_001",
             "totalScore": 8.5,
             "maxScore": 10.0,
@@ -121,47 +930,11 @@ public:
                 "processingTimeMs": 250.0
             }
         })";
-
-        auto end_time = std::chrono::high_resolution_clock::now();
-        response.processing_time_ms = std::chrono::duration<float, std::milli>(end_time - start_time).count();
-        response.tokens_generated = 100; // Mock value
-        response.success = true;
-
-        return response;
-    }
-
-    bool isReady() const {
-        return ready_;
-    }
-
-    LLMBridge::ModelInfo getModelInfo() const {
-        ModelInfo info;
-        info.name = "Phi-3 Mini Instruct";
-        info.version = "4-bit GGUF";
-        info.parameters = 3800000000; // 3.8B parameters
-        info.context_size = config_.n_ctx;
-        
-        if (std::filesystem::exists(config_.model_path)) {
-            auto size = std::filesystem::file_size(config_.model_path);
-            info.file_size = std::to_string(size / (1024 * 1024)) + " MB";
-        }
-        
-        return info;
+        return output;
     }
 
-    void setProgressCallback(std::function<void(float)> callback) {
-        progress_callback_ = callback;
-    }
-
-    void cleanup() {
-        // TODO: Cleanup llama.cpp resources
-        ready_ = false;
-    }
-
-private:
-    LLMConfig config_;
-    bool ready_;
-    std::function<void(float)> progress_callback_;
+    // Declared last: unregistered before the state its callbacks read is destroyed
+    std::vector<std::unique_ptr<MemoryRegistration>> memory_registrations_;
 };
 
 // LLMBridge implementation
@@ -175,22 +948,109 @@ bool LLMBridge::initialize(const LLMConfig& config) {
     return impl_->initialize(config);
 }
 
+namespace {
+
+// Unsegmented prompts are a single dynamic segment
+PromptSegments singleSegment(const std::string& prompt) {
+    PromptSegment segment;
+    segment.text = prompt;
+    return {segment};
+}
+
+} // namespace
+
 LLMResponse LLMBridge::generateQuiz(const std::string& prompt, const std::string& grammar_path) {
-    return impl_->generateQuiz(prompt, grammar_path);
+    return impl_->generateQuiz(singleSegment(prompt), grammar_path, GenerationOptions());
 }
 
 LLMResponse LLMBridge::gradeAnswer(const std::string& prompt, const std::string& grammar_path) {
-    return impl_->gradeAnswer(prompt, grammar_path);
+    return impl_->gradeAnswer(singleSegment(prompt), grammar_path, GenerationOptions());
+}
+
+std::future<LLMResponse> LLMBridge::generateQuizAsync(const std::string& prompt,
+                                                      const std::string& grammar_path,
+                                                      const GenerationOptions& options) {
+    return impl_->generateQuizAsync(singleSegment(prompt), grammar_path, options);
+}
+
+std::future<LLMResponse> LLMBridge::gradeAnswerAsync(const std::string& prompt,
+                                                     const std::string& grammar_path,
+                                                     const GenerationOptions& options) {
+    return impl_->gradeAnswerAsync(singleSegment(prompt), grammar_path, options);
+}
+
+LLMResponse LLMBridge::generateQuiz(const PromptSegments& prompt, const std::string& grammar_path) {
+    return impl_->generateQuiz(prompt, grammar_path, GenerationOptions());
+}
+
+LLMResponse LLMBridge::gradeAnswer(const PromptSegments& prompt, const std::string& grammar_path) {
+    return impl_->gradeAnswer(prompt, grammar_path, GenerationOptions());
+}
+
+std::future<LLMResponse> LLMBridge::generateQuizAsync(const PromptSegments& prompt,
+                                                      const std::string& grammar_path,
+                                                      const GenerationOptions& options) {
+    return impl_->generateQuizAsync(prompt, grammar_path, options);
+}
+
+std::future<LLMResponse> LLMBridge::gradeAnswerAsync(const PromptSegments& prompt,
+                                                     const std::string& grammar_path,
+                                                     const GenerationOptions& options) {
+    return impl_->gradeAnswerAsync(prompt, grammar_path, options);
+}
+
+std::vector<LLMResponse> LLMBridge::gradeAnswers(const nlohmann::json& question,
+                                                 const nlohmann::json& rubric,
+                                                 const std::vector<std::string>& answers,
+                                                 const std::string& grammar_path,
+                                                 const GenerationOptions& options) {
+    return impl_->gradeAnswers(question, rubric, answers, grammar_path, options);
+}
+
+EmbeddingResponse LLMBridge::embed(const std::string& text) {
+    return impl_->embed(text);
+}
+
+PrewarmResult LLMBridge::prewarm(const PrewarmOptions& options) {
+    return impl_->prewarm(options);
 }
 
 bool LLMBridge::isReady() const {
     return impl_->isReady();
 }
 
+bool LLMBridge::isSynthetic() const {
+    return impl_->isSynthetic();
+}
+
+validation::ResponseSchemas LLMBridge::responseSchemas() const {
+    return impl_->responseSchemas();
+}
+
 LLMBridge::ModelInfo LLMBridge::getModelInfo() const {
     return impl_->getModelInfo();
 }
 
+std::vector<int32_t> LLMBridge::tokenize(const std::string& text) const {
+    return impl_->tokenize(text);
+}
+
+size_t LLMBridge::countTokens(const std::string& text) const {
+    return impl_->countTokens(text);
+}
+
+size_t LLMBridge::promptTokenBudget() const {
+    return impl_->promptTokenBudget();
+}
+
+LLMBridge::TokenizedPrompt LLMBridge::tokenizePrompt(const PromptSegments& prompt) const {
+    return impl_->tokenizePrompt(prompt);
+}
+
+void LLMBridge::attachMemoryGovernor(MemoryGovernor* governor) {
+    impl_->attachMemoryGovernor(governor);
+}
+
 void LLMBridge::setProgressCallback(std::function<void(float)> callback) {
     impl_->setProgressCallback(callback);
 }
@@ -220,7 +1080,7 @@ Difficulty Guidelines:
 }
 
 std::string getQuizFewShotPrompt() {
-    return R"(Example 1 - Multiple Choice:
+    return R"PROMPT(Example 1 - Multiple Choice:
 {
   "id": "mcq_001",
   "type": "multiple_choice",
@@ -253,7 +1113,7 @@ Example 2 - Short Answer:
       "keywords": ["oxygen production", "food chain", "life support"]
     }
   ]
-})";
+})PROMPT";
 }
 
 std::string getGradeSystemPrompt() {
@@ -278,123 +1138,472 @@ std::string buildQuizPrompt(const std::string& topic,
                            const std::string& difficulty,
                            int num_questions,
                            const std::string& notes_content) {
-    std::string prompt = getQuizSystemPrompt() + "\n\n";
-    prompt += getQuizFewShotPrompt() + "\n\n";
-    prompt += "Now generate a quiz with the following requirements:\n";
-    prompt += "Topic: " + topic + "\n";
-    prompt += "Difficulty: " + difficulty + "\n";
-    prompt += "Number of questions: " + std::to_string(num_questions) + "\n\n";
-    prompt += "Notes content:\n" + notes_content + "\n\n";
-    prompt += "Generate the quiz in the exact JSON format shown in the examples above.";
-    
+    return joinSegments(buildQuizPromptSegments(topic, difficulty, num_questions, notes_content));
+}
+
+namespace {
+
+// Notes chunks for what prompt_token_budget leaves after the prompt built without notes
+std::string budgetNotes(const std::string& fixed_prompt,
+                        const std::string& notes_content,
+                        const std::string& topic,
+                        const TokenCounter& count_tokens,
+                        size_t prompt_token_budget) {
+    size_t fixed_tokens = count_tokens(fixed_prompt);
+    size_t notes_budget = prompt_token_budget > fixed_tokens ? prompt_token_budget - fixed_tokens : 0;
+    return selectRelevantNotes(notes_content, topic, notes_budget, count_tokens);
+}
+
+} // namespace
+
+std::string buildQuizPrompt(const std::string& topic,
+                           const std::string& difficulty,
+                           int num_questions,
+                           const std::string& notes_content,
+                           const TokenCounter& count_tokens,
+                           size_t prompt_token_budget) {
+    return joinSegments(buildQuizPromptSegments(topic, difficulty, num_questions, notes_content,
+                                                count_tokens, prompt_token_budget));
+}
+
+std::string buildQuizTopUpPrompt(const std::string& topic,
+                                 const std::string& difficulty,
+                                 int num_questions,
+                                 const std::string& notes_content,
+                                 const std::vector<std::string>& existing_prompts) {
+    std::string prompt = buildQuizPrompt(topic, difficulty, num_questions, notes_content);
+    if (existing_prompts.empty()) {
+        return prompt;
+    }
+
+    prompt += "\n\nThe quiz already contains these questions; do not repeat them:\n";
+    for (const auto& existing : existing_prompts) {
+        prompt += "- " + existing + "\n";
+    }
     return prompt;
 }
 
+std::string buildQuizTopUpPrompt(const std::string& topic,
+                                 const std::string& difficulty,
+                                 int num_questions,
+                                 const std::string& notes_content,
+                                 const std::vector<std::string>& existing_prompts,
+                                 const TokenCounter& count_tokens,
+                                 size_t prompt_token_budget) {
+    std::string fixed_prompt = buildQuizTopUpPrompt(topic, difficulty, num_questions, "", existing_prompts);
+    std::string notes = budgetNotes(fixed_prompt, notes_content, topic, count_tokens, prompt_token_budget);
+    return buildQuizTopUpPrompt(topic, difficulty, num_questions, notes, existing_prompts);
+}
+
+std::vector<std::string> chunkNotes(const std::string& notes, size_t max_chunk_chars) {
+    std::vector<std::string> chunks;
+
+    auto add_paragraph = [&](const std::string& paragraph) {
+        size_t begin = paragraph.find_first_not_of(" \t\r\n");
+        if (begin == std::string::npos) return;
+        size_t end = paragraph.find_last_not_of(" \t\r\n") + 1;
+
+        // Split oversized paragraphs at sentence ends so one wall of text can't
+        // monopolize the budget
+        while (end - begin > max_chunk_chars) {
+            size_t cut = paragraph.find_last_of(".!?", begin + max_chunk_chars - 1);
+            cut = (cut == std::string::npos || cut < begin) ? begin + max_chunk_chars : cut + 1;
+            chunks.push_back(paragraph.substr(begin, cut - begin));
+            begin = paragraph.find_first_not_of(" \t\r\n", cut);
+            if (begin == std::string::npos || begin >= end) return;
+        }
+        chunks.push_back(paragraph.substr(begin, end - begin));
+    };
+
+    // Paragraphs are separated by blank lines
+    size_t start = 0;
+    while (start < notes.size()) {
+        size_t blank = notes.find("\n\n", start);
+        size_t stop = (blank == std::string::npos) ? notes.size() : blank;
+        add_paragraph(notes.substr(start, stop - start));
+        start = (blank == std::string::npos) ? notes.size() : blank + 2;
+    }
+
+    return chunks;
+}
+
+namespace {
+
+std::vector<std::string> lexicalTerms(const std::string& text) {
+    std::vector<std::string> terms;
+    std::string term;
+    for (char c : text) {
+        if (std::isalnum(static_cast<unsigned char>(c))) {
+            term.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+        } else if (!term.empty()) {
+            if (term.size() > 1) terms.push_back(term);
+            term.clear();
+        }
+    }
+    if (term.size() > 1) terms.push_back(term);
+    return terms;
+}
+
+} // namespace
+
+std::vector<float> scoreChunksBM25(const std::vector<std::string>& chunks,
+                                   const std::string& query,
+                                   float k1,
+                                   float b) {
+    std::vector<float> scores(chunks.size(), 0.0f);
+    if (chunks.empty()) return scores;
+
+    std::vector<std::string> query_terms = lexicalTerms(query);
+    std::sort(query_terms.begin(), query_terms.end());
+    query_terms.erase(std::unique(query_terms.begin(), query_terms.end()), query_terms.end());
+    if (query_terms.empty()) return scores;
+
+    // Term frequencies of query terms per chunk, plus chunk lengths
+    std::vector<std::map<std::string, int>> term_freqs(chunks.size());
+    std::vector<size_t> lengths(chunks.size());
+    std::map<std::string, int> doc_freqs;
+    size_t total_length = 0;
+
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        auto terms = lexicalTerms(chunks[i]);
+        lengths[i] = terms.size();
+        total_length += terms.size();
+        for (const auto& term : terms) {
+            if (std::binary_search(query_terms.begin(), query_terms.end(), term)) {
+                term_freqs[i][term]++;
+            }
+        }
+        for (const auto& entry : term_freqs[i]) {
+            doc_freqs[entry.first]++;
+        }
+    }
+
+    float n = static_cast<float>(chunks.size());
+    float avg_length = std::max(1.0f, static_cast<float>(total_length) / n);
+
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        float length_norm = 1.0f - b + b * static_cast<float>(lengths[i]) / avg_length;
+        for (const auto& entry : term_freqs[i]) {
+            float df = static_cast<float>(doc_freqs[entry.first]);
+            float idf = std::log((n - df + 0.5f) / (df + 0.5f) + 1.0f);
+            float tf = static_cast<float>(entry.second);
+            scores[i] += idf * tf * (k1 + 1.0f) / (tf + k1 * length_norm);
+        }
+    }
+
+    return scores;
+}
+
+std::string selectRelevantNotes(const std::string& notes,
+                                const std::string& topic,
+                                size_t token_budget,
+                                const TokenCounter& count_tokens) {
+    auto chunks = chunkNotes(notes);
+    auto scores = scoreChunksBM25(chunks, topic);
+
+    // Best chunks first; ties (including "no term matched") keep document order
+    std::vector<size_t> order(chunks.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(),
+                     [&scores](size_t a, size_t b) { return scores[a] > scores[b]; });
+
+    // When the topic matches anything, unmatched chunks only cost prefill
+    bool any_match = !scores.empty() && scores[order.front()] > 0.0f;
+
+    const size_t separator_tokens = count_tokens("\n\n");
+    std::vector<bool> selected(chunks.size(), false);
+    size_t used = 0;
+
+    for (size_t index : order) {
+        if (any_match && scores[index] <= 0.0f) {
+            break;
+        }
+        size_t cost = count_tokens(chunks[index]) + (used > 0 ? separator_tokens : 0);
+        if (used + cost > token_budget) {
+            continue;  // a smaller, less relevant chunk may still fit
+        }
+        selected[index] = true;
+        used += cost;
+    }
+
+    std::string result;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        if (!selected[i]) continue;
+        if (!result.empty()) result += "\n\n";
+        result += chunks[i];
+    }
+    return result;
+}
+
 std::string buildGradePrompt(const nlohmann::json& question,
                             const std::string& student_answer,
                             const nlohmann::json& rubric) {
-    std::string prompt = getGradeSystemPrompt() + "\n\n";
-    prompt += "Question: " + question["prompt"].get<std::string>() + "\n\n";
-    
+    return joinSegments(buildGradePromptSegments(question, student_answer, rubric));
+}
+
+std::string buildGradePrompt(const ShortAnswerQuestion& question,
+                            const std::string& student_answer) {
+    return joinSegments(buildGradePromptSegments(question, student_answer));
+}
+
+namespace {
+
+void addStatic(PromptSegments& segments, std::string text) {
+    // Merge adjacent static text so each cache entry covers as much as possible
+    if (!segments.empty() && segments.back().is_static) {
+        segments.back().text += text;
+        return;
+    }
+    PromptSegment segment;
+    segment.text = std::move(text);
+    segment.is_static = true;
+    segments.push_back(std::move(segment));
+}
+
+void addDynamic(PromptSegments& segments, std::string text) {
+    PromptSegment segment;
+    segment.text = std::move(text);
+    segments.push_back(std::move(segment));
+}
+
+// Re-adds the suffix so static text merges across the prefix boundary
+PromptSegments appendSuffix(PromptSegments segments, const std::string& student_answer) {
+    for (auto& segment : buildGradePromptSuffix(student_answer)) {
+        if (segment.is_static) {
+            addStatic(segments, std::move(segment.text));
+        } else {
+            addDynamic(segments, std::move(segment.text));
+        }
+    }
+    return segments;
+}
+
+} // namespace
+
+PromptSegments buildQuizPromptSegments(const std::string& topic,
+                                      const std::string& difficulty,
+                                      int num_questions,
+                                      const std::string& notes_content) {
+    PromptSegments segments;
+    addStatic(segments, getQuizSystemPrompt() + "\n\n" + getQuizFewShotPrompt() + "\n\n" +
+                        "Now generate a quiz with the following requirements:\n" + "Topic: ");
+    addDynamic(segments, topic);
+    addStatic(segments, "\nDifficulty: ");
+    addDynamic(segments, difficulty);
+    addStatic(segments, "\nNumber of questions: ");
+    addDynamic(segments, std::to_string(num_questions));
+    addStatic(segments, "\n\nNotes content:\n");
+    addDynamic(segments, notes_content);
+    addStatic(segments, "\n\nGenerate the quiz in the exact JSON format shown in the examples above.");
+    return segments;
+}
+
+PromptSegments buildQuizPromptSegments(const std::string& topic,
+                                      const std::string& difficulty,
+                                      int num_questions,
+                                      const std::string& notes_content,
+                                      const TokenCounter& count_tokens,
+                                      size_t prompt_token_budget) {
+    // Size the fixed part of the prompt first; whatever remains goes to notes
+    std::string fixed_prompt = joinSegments(buildQuizPromptSegments(topic, difficulty, num_questions, ""));
+    std::string notes = budgetNotes(fixed_prompt, notes_content, topic, count_tokens, prompt_token_budget);
+    return buildQuizPromptSegments(topic, difficulty, num_questions, notes);
+}
+
+PromptSegments buildGradePromptSegments(const nlohmann::json& question,
+                                       const std::string& student_answer,
+                                       const nlohmann::json& rubric) {
+    return appendSuffix(buildGradePromptPrefix(question, rubric), student_answer);
+}
+
+PromptSegments buildGradePromptSegments(const ShortAnswerQuestion& question,
+                                       const std::string& student_answer) {
+    return appendSuffix(buildGradePromptPrefix(question), student_answer);
+}
+
+PromptSegments buildGradePromptPrefix(const nlohmann::json& question,
+                                     const nlohmann::json& rubric) {
+    ShortAnswerQuestion typed;
+    typed.prompt = question["prompt"].get<std::string>();
     if (question.contains("sampleAnswer")) {
-        prompt += "Sample Answer: " + question["sampleAnswer"].get<std::string>() + "\n\n";
+        typed.sample_answer = question["sampleAnswer"].get<std::string>();
     }
-    
-    prompt += "Rubric:\n";
     for (const auto& criterion : rubric) {
-        prompt += "- " + criterion["criterion"].get<std::string>() + 
-                 " (" + std::to_string(criterion["points"].get<int>()) + " points)\n";
-        prompt += "  Keywords: ";
-        for (const auto& keyword : criterion["keywords"]) {
-            prompt += keyword.get<std::string>() + ", ";
-        }
-        prompt += "\n";
-    }
-    
-    prompt += "\nStudent Answer: " + student_answer + "\n\n";
-    prompt += "Grade this answer according to the rubric and provide detailed feedback.";
-    
-    return prompt;
+        typed.rubric.push_back(RubricCriterion{criterion["criterion"].get<std::string>(),
+                                               criterion["points"].get<int>(),
+                                               criterion["keywords"].get<std::vector<std::string>>()});
+    }
+    return buildGradePromptPrefix(typed);
 }
 
-} // namespace prompts
+PromptSegments buildGradePromptPrefix(const ShortAnswerQuestion& question) {
+    PromptSegments segments;
+    addStatic(segments, getGradeSystemPrompt() + "\n\n" + "Question: ");
+    addDynamic(segments, question.prompt);
+    addStatic(segments, "\n\n");
 
-// JSON validation utilities
-namespace validation {
+    if (!question.sample_answer.empty()) {
+        addStatic(segments, "Sample Answer: ");
+        addDynamic(segments, question.sample_answer);
+        addStatic(segments, "\n\n");
+    }
 
-bool validateQuizJson(const std::string& json_str, std::string& error_msg) {
-    try {
-        auto json = nlohmann::json::parse(json_str);
-        
-        // Basic validation
-        if (!json.contains("topic") || !json.contains("difficulty") || !json.contains("questions")) {
-            error_msg = "Missing required fields: topic, difficulty, or questions";
-            return false;
-        }
-        
-        if (!json["questions"].is_array() || json["questions"].empty()) {
-            error_msg = "Questions must be a non-empty array";
-            return false;
+    addStatic(segments, "Rubric:\n");
+    for (const auto& criterion : question.rubric) {
+        addStatic(segments, "- ");
+        addDynamic(segments, criterion.criterion);
+        addStatic(segments, " (");
+        addDynamic(segments, std::to_string(criterion.points));
+        addStatic(segments, " points)\n  Keywords: ");
+
+        std::string keywords;
+        for (const auto& keyword : criterion.keywords) {
+            keywords += keyword + ", ";
         }
-        
-        // TODO: Add more comprehensive validation against schema
-        return true;
-        
-    } catch (const std::exception& e) {
-        error_msg = "Invalid JSON: " + std::string(e.what());
-        return false;
+        addDynamic(segments, keywords);
+        addStatic(segments, "\n");
     }
+
+    return segments;
 }
 
-bool validateGradeJson(const std::string& json_str, std::string& error_msg) {
-    try {
-        auto json = nlohmann::json::parse(json_str);
-        
-        // Basic validation
-        if (!json.contains("questionId") || !json.contains("totalScore") || 
-            !json.contains("maxScore") || !json.contains("breakdown")) {
-            error_msg = "Missing required fields: questionId, totalScore, maxScore, or breakdown";
-            return false;
-        }
-        
-        if (!json["breakdown"].is_array() || json["breakdown"].empty()) {
-            error_msg = "Breakdown must be a non-empty array";
-            return false;
-        }
-        
-        // TODO: Add more comprehensive validation against schema
-        return true;
-        
-    } catch (const std::exception& e) {
-        error_msg = "Invalid JSON: " + std::string(e.what());
-        return false;
+PromptSegments buildGradePromptSuffix(const std::string& student_answer) {
+    PromptSegments segments;
+    addStatic(segments, "\nStudent Answer: ");
+    addDynamic(segments, student_answer);
+    addStatic(segments, "\n\nGrade this answer according to the rubric and provide detailed feedback.");
+    return segments;
+}
+
+std::string joinSegments(const PromptSegments& segments) {
+    size_t length = 0;
+    for (const auto& segment : segments) length += segment.text.size();
+
+    std::string text;
+    text.reserve(length);
+    for (const auto& segment : segments) text += segment.text;
+    return text;
+}
+
+} // namespace prompts
+
+// JSON validation utilities
+namespace validation {
+
+namespace {
+
+std::shared_ptr<const CompiledSchema> compiledSchema(const ResponseSchemas& schemas, bool quiz,
+                                                     std::string& error_msg) {
+    const auto& schema = quiz ? schemas.quiz : schemas.grade;
+    if (!schema) {
+        error_msg = "Schemas not loaded (see LLMConfig::schema_dir)";
     }
+    return schema;
 }
 
-nlohmann::json parseQuizJson(const std::string& json_str, std::string& error_msg) {
-    if (!validateQuizJson(json_str, error_msg)) {
+nlohmann::json validate(const ResponseSchemas& schemas, bool quiz, const std::string& json_str,
+                        bool build_document, std::string& error_msg, bool& valid) {
+    valid = false;
+    auto schema = compiledSchema(schemas, quiz, error_msg);
+    if (!schema) {
         return nullptr;
     }
-    
-    try {
-        return nlohmann::json::parse(json_str);
-    } catch (const std::exception& e) {
-        error_msg = "JSON parsing failed: " + std::string(e.what());
+
+    SchemaValidationResult result = validateWithSchema(*schema, json_str, build_document);
+    if (!result.valid) {
+        error_msg = result.error_message;
         return nullptr;
     }
+
+    valid = true;
+    return std::move(result.document);
 }
 
-nlohmann::json parseGradeJson(const std::string& json_str, std::string& error_msg) {
-    if (!validateGradeJson(json_str, error_msg)) {
-        return nullptr;
+// Validate as an observer of the quiz_io reader, so the text is parsed once
+template <typename T, typename Read>
+bool readValidated(const ResponseSchemas& schemas, bool quiz, const std::string& json_str, T& out,
+                   std::string& error_msg, Read&& read) {
+    auto schema = compiledSchema(schemas, quiz, error_msg);
+    if (!schema) {
+        return false;
     }
-    
-    try {
-        return nlohmann::json::parse(json_str);
-    } catch (const std::exception& e) {
-        error_msg = "JSON parsing failed: " + std::string(e.what());
-        return nullptr;
+
+    SchemaEventValidator validator(*schema);
+    T value;
+    std::string read_error;
+    bool read_ok = read(json_str, value, read_error, validator.handler());
+    if (!validator.error().empty()) {
+        error_msg = validator.error();
+        return false;
+    }
+    if (!read_ok || !validator.valid()) {
+        error_msg = read_ok ? "Invalid JSON" : read_error;
+        return false;
+    }
+
+    out = std::move(value);
+    return true;
+}
+
+} // namespace
+
+std::string defaultSchemaDir(const std::string& grammar_path) {
+    std::filesystem::path grammars = std::filesystem::path(grammar_path).parent_path();
+    return (grammars.parent_path() / "schemas").string();
+}
+
+bool loadSchemas(const std::string& schema_dir, ResponseSchemas& schemas, std::string& error_msg) {
+    auto quiz = CompiledSchema::compileFile(schema_dir + "/quiz.json", error_msg);
+    if (!quiz) {
+        return false;
+    }
+    auto grade = CompiledSchema::compileFile(schema_dir + "/grade.json", error_msg);
+    if (!grade) {
+        return false;
     }
+
+    schemas.quiz = std::move(quiz);
+    schemas.grade = std::move(grade);
+    return true;
+}
+
+bool validateQuizJson(const ResponseSchemas& schemas, const std::string& json_str, std::string& error_msg) {
+    bool valid;
+    validate(schemas, true, json_str, false, error_msg, valid);
+    return valid;
+}
+
+bool validateGradeJson(const ResponseSchemas& schemas, const std::string& json_str, std::string& error_msg) {
+    bool valid;
+    validate(schemas, false, json_str, false, error_msg, valid);
+    return valid;
+}
+
+nlohmann::json parseQuizJson(const ResponseSchemas& schemas, const std::string& json_str, std::string& error_msg) {
+    bool valid;
+    return validate(schemas, true, json_str, true, error_msg, valid);
+}
+
+nlohmann::json parseGradeJson(const ResponseSchemas& schemas, const std::string& json_str, std::string& error_msg) {
+    bool valid;
+    return validate(schemas, false, json_str, true, error_msg, valid);
+}
+
+bool parseQuiz(const ResponseSchemas& schemas, const std::string& json_str, Quiz& quiz, std::string& error_msg) {
+    return readValidated(schemas, true, json_str, quiz, error_msg, [](const std::string& text, Quiz& out,
+                                                                      std::string& error,
+                                                                      quiz_io::ReadObserver* observer) {
+        return quiz_io::readQuiz(text, out, error, observer);
+    });
+}
+
+bool parseGradePayload(const ResponseSchemas& schemas, const std::string& json_str, GradePayload& grade,
+                       std::string& error_msg) {
+    return readValidated(schemas, false, json_str, grade, error_msg, [](const std::string& text, GradePayload& out,
+                                                                        std::string& error,
+                                                                        quiz_io::ReadObserver* observer) {
+        return quiz_io::readGradePayload(text, out, error, observer);
+    });
 }
 
 } // namespace validation
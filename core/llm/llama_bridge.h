@@ -4,30 +4,138 @@
 #include <vector>
 #include <functional>
 #include <memory>
+#include <atomic>
+#include <chrono>
+#include <future>
 #include <nlohmann/json.hpp>
+#include "../types/quiz_types.h"
 
 namespace studyhive {
 namespace core {
 
+class MemoryGovernor;
+class CompiledSchema;
+
+// Per-token costs the mock backend simulates (by sleeping) until llama.cpp is
+// wired in. Prefill is compute-bound and scales with n_threads; decode is
+// bandwidth-bound and stops scaling past 4 threads. All zero: no latency.
+struct SyntheticCosts {
+    float prefill_us_per_token = 0.0f;
+    float decode_us_per_token = 0.0f;
+    float context_us_per_token = 0.0f;  // Extra decode cost per token already in the KV cache
+    float batch_overhead_us = 0.0f;     // Per llama_decode call (prefill runs n_batch tokens per call)
+    float grammar_us_per_token = 0.0f;  // Grammar-constrained sampling
+};
+
 struct LLMConfig {
     std::string model_path;
     std::string grammar_path;
+    std::string schema_dir;  // quiz.json and grade.json, compiled by initialize(); empty:
+                             // the schemas directory installed beside the grammars one
     int max_tokens = 2048;
     float temperature = 0.7f;
+    int top_k = 40;       // <= 0: disabled
+    float top_p = 0.95f;  // >= 1: disabled
     int seed = 42;
     int n_threads = 4;
     int n_ctx = 2048;
     int n_batch = 512;
+    int n_parallel = 8;  // Sequences decoded together by batched requests
+    SyntheticCosts synthetic;
+};
+
+// Why decoding stopped
+enum class StopReason {
+    COMPLETED,          // Grammar reached an end state
+    MAX_TOKENS,         // LLMConfig::max_tokens reached
+    CANCELLED,          // CancellationToken fired (or the bridge is shutting down)
+    DEADLINE_EXCEEDED,  // GenerationOptions::deadline passed
+    FAILED              // Not initialized, bad grammar or grammar violation
+};
+
+// Shared cancellation flag; copies observe the same state
+class CancellationToken {
+public:
+    CancellationToken() : cancelled_(std::make_shared<std::atomic<bool>>(false)) {}
+
+    void cancel() { cancelled_->store(true); }
+    bool isCancelled() const { return cancelled_->load(); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> cancelled_;
+};
+
+struct GenerationOptions {
+    // Decoding stops at the first token boundary past the deadline
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    CancellationToken cancel_token;
 };
 
 struct LLMResponse {
-    std::string content;
+    std::string content;  // Partial output when stop_reason != COMPLETED
     bool success;
     std::string error_message;
     int tokens_generated;
+    int forced_tokens;           // Of tokens_generated: appended by grammar jump-ahead, not sampled
     float processing_time_ms;
+    StopReason stop_reason;
+    int prompt_tokens;
+    int tokenizer_calls;         // Segments tokenized for this request (cache misses)
+    float prompt_build_time_ms;  // Tokenization and token-level concatenation
+    float prefill_time_ms;         // Prompt evaluation
+    float time_to_first_token_ms;  // Request start to first decoded token
+    float decode_time_ms;          // First to last decoded token
+};
+
+struct EmbeddingResponse {
+    std::vector<float> embedding;  // Mean-pooled and L2-normalized
+    bool success = false;
+    std::string error_message;
+    int prompt_tokens = 0;
+    float processing_time_ms = 0.0f;
+};
+
+struct PrewarmOptions {
+    bool read_weights = true;    // Stream the model file through the page cache
+    bool touch_kv_cache = true;  // Allocate the KV cache and fault in every page
+    bool warm_decode = true;     // One-token decode through the whole stack
+    CancellationToken cancel_token;
+    std::function<void(float)> progress;  // Fraction of the bytes to page in
 };
 
+struct PrewarmResult {
+    bool completed = false;
+    bool cancelled = false;       // Cancelled, or yielded to a real request
+    std::string error_message;
+    uint64_t weight_bytes = 0;    // Model bytes read
+    uint64_t kv_cache_bytes = 0;  // KV cache bytes touched
+    float weights_time_ms = 0.0f;
+    float kv_cache_time_ms = 0.0f;
+    float decode_time_ms = 0.0f;
+    float total_time_ms = 0.0f;
+};
+
+// Piece of a prompt. Static segments are identical across requests, so their
+// token ids are cached and reused; dynamic segments are tokenized per request.
+// Segment boundaries sit at newlines/separators where tokenizer merges rarely cross.
+struct PromptSegment {
+    std::string text;
+    bool is_static = false;
+    std::shared_ptr<const std::vector<int32_t>> tokens;  // Filled from the segment cache
+};
+
+using PromptSegments = std::vector<PromptSegment>;
+
+namespace validation {
+
+// Compiled quiz.json and grade.json; copies share the compiled schemas
+struct ResponseSchemas {
+    std::shared_ptr<const CompiledSchema> quiz;
+    std::shared_ptr<const CompiledSchema> grade;
+};
+
+} // namespace validation
+
 class LLMBridge {
 public:
     LLMBridge();
@@ -36,15 +144,68 @@ public:
     // Initialize the LLM with model and grammar
     bool initialize(const LLMConfig& config);
 
-    // Generate quiz JSON using GBNF grammar
+    // Generate quiz JSON using GBNF grammar (an empty grammar_path decodes unconstrained)
     LLMResponse generateQuiz(const std::string& prompt, const std::string& grammar_path);
 
     // Grade answer JSON using GBNF grammar
     LLMResponse gradeAnswer(const std::string& prompt, const std::string& grammar_path);
 
+    // Asynchronous variants; decoding stops at the next token boundary once the
+    // deadline passes or the token is cancelled. The bridge must outlive the futures.
+    std::future<LLMResponse> generateQuizAsync(const std::string& prompt,
+                                               const std::string& grammar_path,
+                                               const GenerationOptions& options = GenerationOptions());
+
+    std::future<LLMResponse> gradeAnswerAsync(const std::string& prompt,
+                                              const std::string& grammar_path,
+                                              const GenerationOptions& options = GenerationOptions());
+
+    // Grade many answers to one question in a batched pass. The question and rubric
+    // prefix is prefilled once and shared by all sequences (n_parallel at a time).
+    // Returns one response per answer, in order.
+    std::vector<LLMResponse> gradeAnswers(const nlohmann::json& question,
+                                          const nlohmann::json& rubric,
+                                          const std::vector<std::string>& answers,
+                                          const std::string& grammar_path,
+                                          const GenerationOptions& options = GenerationOptions());
+
+    // Segmented prompts: static segments are tokenized once and cached
+    LLMResponse generateQuiz(const PromptSegments& prompt, const std::string& grammar_path);
+    LLMResponse gradeAnswer(const PromptSegments& prompt, const std::string& grammar_path);
+
+    std::future<LLMResponse> generateQuizAsync(const PromptSegments& prompt,
+                                               const std::string& grammar_path,
+                                               const GenerationOptions& options = GenerationOptions());
+
+    std::future<LLMResponse> gradeAnswerAsync(const PromptSegments& prompt,
+                                              const std::string& grammar_path,
+                                              const GenerationOptions& options = GenerationOptions());
+
+    // Run the loaded model in embedding mode (prefill only, no decoding)
+    EmbeddingResponse embed(const std::string& text);
+
+    // Page in the weights, first-touch the KV cache and decode one token, so the
+    // first real request does not pay for page faults. Stops at the next step
+    // when cancelled or when a real request starts. Blocks; meant for an
+    // idle-priority thread.
+    PrewarmResult prewarm(const PrewarmOptions& options = PrewarmOptions());
+
+    // Report the KV cache (KV_CONTEXT tier) and resident weights (IDLE_MODEL
+    // tier) to the governor, which may release them while no request is in
+    // flight; the next prewarm or request brings them back (null detaches)
+    void attachMemoryGovernor(MemoryGovernor* governor);
+
     // Check if the model is loaded and ready
     bool isReady() const;
 
+    // Schemas compiled by initialize() from LLMConfig::schema_dir, for
+    // validating this bridge's output (empty until initialize() succeeds)
+    validation::ResponseSchemas responseSchemas() const;
+
+    // True while decoding runs on the mock backend, whose timings are just
+    // SyntheticCosts: nothing measured through it says anything about the device
+    bool isSynthetic() const;
+
     // Get model information
     struct ModelInfo {
         std::string name;
@@ -52,14 +213,35 @@ public:
         size_t parameters;
         size_t context_size;
         std::string file_size;
+        size_t kv_cache_bytes;  // f16 K/V cache for context_size (0 if unknown)
     };
     
     ModelInfo getModelInfo() const;
 
-    // Set progress callback for long operations
+    // Tokenize text with the model tokenizer
+    std::vector<int32_t> tokenize(const std::string& text) const;
+
+    // Number of tokens the model tokenizer produces for text
+    size_t countTokens(const std::string& text) const;
+
+    // Prompt tokens that leave room in n_ctx for the output (max_tokens, capped
+    // at half the context so the notes are never squeezed out entirely)
+    size_t promptTokenBudget() const;
+
+    // Concatenate segment tokens, tokenizing only dynamic segments and static cache misses
+    struct TokenizedPrompt {
+        std::vector<int32_t> tokens;
+        int tokenizer_calls;
+        float build_time_ms;
+    };
+
+    TokenizedPrompt tokenizePrompt(const PromptSegments& prompt) const;
+
+    // Set progress callback, invoked once per decoded token (fraction of max_tokens)
     void setProgressCallback(std::function<void(float)> callback);
 
-    // Cleanup resources
+    // Cancel in-flight requests (async, batched and synchronous calls made on
+    // other threads), wait for them and release resources
     void cleanup();
 
 private:
@@ -70,6 +252,9 @@ private:
 // Utility functions for prompt construction
 namespace prompts {
 
+// Token counter backed by the model tokenizer (e.g. LLMBridge::countTokens)
+using TokenCounter = std::function<size_t(const std::string&)>;
+
 // System prompt for quiz generation
 std::string getQuizSystemPrompt();
 
@@ -85,27 +270,118 @@ std::string buildQuizPrompt(const std::string& topic,
                            int num_questions,
                            const std::string& notes_content);
 
+// Construct quiz generation prompt whose total size stays within prompt_token_budget.
+// Only the notes chunks most relevant to the topic are included.
+std::string buildQuizPrompt(const std::string& topic,
+                           const std::string& difficulty,
+                           int num_questions,
+                           const std::string& notes_content,
+                           const TokenCounter& count_tokens,
+                           size_t prompt_token_budget);
+
+// Quiz prompt for the questions still missing after a partial generation
+std::string buildQuizTopUpPrompt(const std::string& topic,
+                                 const std::string& difficulty,
+                                 int num_questions,
+                                 const std::string& notes_content,
+                                 const std::vector<std::string>& existing_prompts);
+
+// Same, within prompt_token_budget (notes selected as in the budgeted buildQuizPrompt)
+std::string buildQuizTopUpPrompt(const std::string& topic,
+                                 const std::string& difficulty,
+                                 int num_questions,
+                                 const std::string& notes_content,
+                                 const std::vector<std::string>& existing_prompts,
+                                 const TokenCounter& count_tokens,
+                                 size_t prompt_token_budget);
+
+// Split notes into paragraph chunks (long paragraphs are split at sentence ends)
+std::vector<std::string> chunkNotes(const std::string& notes, size_t max_chunk_chars = 1200);
+
+// BM25 relevance of each chunk to the query
+std::vector<float> scoreChunksBM25(const std::vector<std::string>& chunks,
+                                   const std::string& query,
+                                   float k1 = 1.2f,
+                                   float b = 0.75f);
+
+// Most relevant notes chunks that fit in token_budget, kept in document order
+std::string selectRelevantNotes(const std::string& notes,
+                                const std::string& topic,
+                                size_t token_budget,
+                                const TokenCounter& count_tokens);
+
 // Construct grading prompt
 std::string buildGradePrompt(const nlohmann::json& question,
                             const std::string& student_answer,
                             const nlohmann::json& rubric);
 
+std::string buildGradePrompt(const ShortAnswerQuestion& question,
+                            const std::string& student_answer);
+
+// Segmented forms of the builders above (joinSegments gives the same text)
+PromptSegments buildQuizPromptSegments(const std::string& topic,
+                                      const std::string& difficulty,
+                                      int num_questions,
+                                      const std::string& notes_content);
+
+// Segments of the budgeted buildQuizPrompt: the notes segment holds only the
+// selected chunks, so prefill stays bounded however long the notes are
+PromptSegments buildQuizPromptSegments(const std::string& topic,
+                                      const std::string& difficulty,
+                                      int num_questions,
+                                      const std::string& notes_content,
+                                      const TokenCounter& count_tokens,
+                                      size_t prompt_token_budget);
+
+PromptSegments buildGradePromptSegments(const nlohmann::json& question,
+                                       const std::string& student_answer,
+                                       const nlohmann::json& rubric);
+
+PromptSegments buildGradePromptSegments(const ShortAnswerQuestion& question,
+                                       const std::string& student_answer);
+
+// Shared question/rubric part of the grading prompt
+PromptSegments buildGradePromptPrefix(const nlohmann::json& question,
+                                     const nlohmann::json& rubric);
+
+PromptSegments buildGradePromptPrefix(const ShortAnswerQuestion& question);
+
+// Per-answer part of the grading prompt
+PromptSegments buildGradePromptSuffix(const std::string& student_answer);
+
+// Concatenate segment texts
+std::string joinSegments(const PromptSegments& segments);
+
 } // namespace prompts
 
 // JSON validation utilities
 namespace validation {
 
+// Where schema_dir defaults to: the schemas directory next to the one holding
+// the grammars directory (core/grammars/quiz.gbnf -> core/schemas), so it
+// does not depend on the working directory
+std::string defaultSchemaDir(const std::string& grammar_path);
+
+// Compile quiz.json and grade.json from schema_dir (LLMBridge::initialize
+// does this per bridge). The validators below fail on unloaded schemas.
+bool loadSchemas(const std::string& schema_dir, ResponseSchemas& schemas, std::string& error_msg);
+
 // Validate quiz JSON against schema
-bool validateQuizJson(const std::string& json_str, std::string& error_msg);
+bool validateQuizJson(const ResponseSchemas& schemas, const std::string& json_str, std::string& error_msg);
 
 // Validate grade JSON against schema
-bool validateGradeJson(const std::string& json_str, std::string& error_msg);
+bool validateGradeJson(const ResponseSchemas& schemas, const std::string& json_str, std::string& error_msg);
+
+// Parse and validate quiz JSON (single pass; null on failure)
+nlohmann::json parseQuizJson(const ResponseSchemas& schemas, const std::string& json_str, std::string& error_msg);
 
-// Parse and validate quiz JSON
-nlohmann::json parseQuizJson(const std::string& json_str, std::string& error_msg);
+// Parse and validate grade JSON (single pass; null on failure)
+nlohmann::json parseGradeJson(const ResponseSchemas& schemas, const std::string& json_str, std::string& error_msg);
 
-// Parse and validate grade JSON
-nlohmann::json parseGradeJson(const std::string& json_str, std::string& error_msg);
+// Read into typed structs, validating in the same pass (no DOM, one parse)
+bool parseQuiz(const ResponseSchemas& schemas, const std::string& json_str, Quiz& quiz, std::string& error_msg);
+bool parseGradePayload(const ResponseSchemas& schemas, const std::string& json_str, GradePayload& grade,
+                       std::string& error_msg);
 
 } // namespace validation
 
@@ -0,0 +1,369 @@
+#include "model_manager.h"
+#include "gguf_reader.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <map>
+#include <mutex>
+
+namespace studyhive {
+namespace core {
+
+class ModelManager::Impl {
+public:
+    explicit Impl(const ModelManagerConfig& config) : config_(config) {
+        stats_.budget_bytes = config.memory_budget_bytes;
+    }
+
+    ~Impl() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& [id, entry] : models_) {
+            release(*entry);
+        }
+    }
+
+    bool registerModel(const ModelSpec& spec, std::string& error_msg) {
+        if (spec.id.empty()) {
+            error_msg = "Model id is empty";
+            return false;
+        }
+        if (!std::filesystem::exists(spec.config.model_path)) {
+            error_msg = "Model file not found: " + spec.config.model_path;
+            return false;
+        }
+
+        auto entry = std::make_shared<Entry>();
+        entry->spec = spec;
+        entry->weight_bytes = std::filesystem::file_size(spec.config.model_path);
+
+        gguf::Metadata metadata;
+        std::string metadata_error;
+        if (gguf::readFile(spec.config.model_path, metadata, metadata_error)) {
+            entry->kv_cache_bytes = metadata.kvCacheBytes(static_cast<uint32_t>(spec.config.n_ctx));
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = models_.find(spec.id);
+        if (it != models_.end()) {
+            if (it->second->bridge || it->second->loading) {
+                error_msg = "Model " + spec.id + " is loaded; unload it before re-registering";
+                return false;
+            }
+        }
+        models_[spec.id] = std::move(entry);
+        return true;
+    }
+
+    bool setRoute(ModelRole role, const std::string& model_id, std::string& error_msg) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!models_.count(model_id)) {
+            error_msg = "Unknown model: " + model_id;
+            return false;
+        }
+        routes_[role] = model_id;
+        return true;
+    }
+
+    std::shared_ptr<LLMBridge> acquire(ModelRole role, std::string& error_msg) {
+        std::string model_id;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto route = routes_.find(role);
+            if (route == routes_.end()) {
+                error_msg = "No model routed for this request type";
+                return nullptr;
+            }
+            model_id = route->second;
+        }
+        return acquireModel(model_id, error_msg);
+    }
+
+    // Evicts and reserves the footprint under mutex_, then maps and
+    // initializes the model without it
+    std::shared_ptr<LLMBridge> acquireModel(const std::string& model_id, std::string& error_msg) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        std::shared_ptr<Entry> entry;
+        for (;;) {
+            auto it = models_.find(model_id);
+            if (it == models_.end()) {
+                error_msg = "Unknown model: " + model_id;
+                return nullptr;
+            }
+            entry = it->second;
+            if (!entry->loading) break;
+            // Another caller is loading it; looked up again in case it was re-registered after a failure
+            load_cv_.wait(lock);
+        }
+        entry->last_used = ++clock_;
+        if (entry->bridge) {
+            return pin(entry);
+        }
+
+        if (entry->footprint() > config_.memory_budget_bytes) {
+            error_msg = "Model " + model_id + " needs " + std::to_string(entry->footprint() >> 20) +
+                        " MB, more than the whole budget";
+            return nullptr;
+        }
+
+        auto start_time = std::chrono::high_resolution_clock::now();
+        int evicted = makeRoom(entry->footprint(), entry.get());
+        if (evicted < 0) {
+            error_msg = "Not enough memory for " + model_id + ": resident models are in use";
+            return nullptr;
+        }
+
+        // Reserved, so concurrent loads of other models count it against the budget
+        entry->loading = true;
+        stats_.resident_bytes += entry->footprint();
+        lock.unlock();
+
+        float load_time_ms = 0.0f;
+        std::shared_ptr<LLMBridge> bridge = load(*entry, load_time_ms, error_msg);
+
+        lock.lock();
+        entry->loading = false;
+        load_cv_.notify_all();
+        if (!bridge) {
+            stats_.resident_bytes -= entry->footprint();
+            return nullptr;
+        }
+
+        auto end_time = std::chrono::high_resolution_clock::now();
+        entry->bridge = std::move(bridge);
+        entry->last_load_time_ms = load_time_ms;
+        entry->loads++;
+        stats_.loads++;
+        stats_.total_load_time_ms += entry->last_load_time_ms;
+        if (evicted > 0) {
+            stats_.swaps++;
+            stats_.last_swap_time_ms = std::chrono::duration<float, std::milli>(end_time - start_time).count();
+        }
+        return pin(entry);
+    }
+
+    bool unload(const std::string& model_id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = models_.find(model_id);
+        if (it == models_.end() || !it->second->bridge || isPinned(*it->second)) {
+            return false;
+        }
+        evict(*it->second);
+        return true;
+    }
+
+    void setMemoryBudget(size_t bytes) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        config_.memory_budget_bytes = bytes;
+        stats_.budget_bytes = bytes;
+        makeRoom(0, nullptr);
+    }
+
+    std::vector<ModelResidency> getResidency() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<ModelResidency> residency;
+        for (const auto& [id, entry] : models_) {
+            ModelResidency item;
+            item.id = id;
+            item.resident = entry->bridge != nullptr;
+            item.pinned = isPinned(*entry);
+            item.loading = entry->loading;
+            item.weight_bytes = entry->weight_bytes;
+            item.kv_cache_bytes = entry->kv_cache_bytes;
+            item.last_load_time_ms = entry->last_load_time_ms;
+            item.loads = entry->loads;
+            item.evictions = entry->evictions;
+            residency.push_back(std::move(item));
+        }
+        return residency;
+    }
+
+    ModelManagerStats getStats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+private:
+    struct Entry {
+        ModelSpec spec;
+        size_t weight_bytes = 0;
+        size_t kv_cache_bytes = 0;
+        MappedFile mapping;                 // Written only by the loading caller or under mutex_
+        std::shared_ptr<LLMBridge> bridge;  // Null when not resident
+        bool loading = false;               // Reserved and being loaded outside mutex_
+        std::atomic<int> pins{0};           // Live pointers returned by acquire
+        uint64_t last_used = 0;
+        float last_load_time_ms = 0.0f;
+        int loads = 0;
+        int evictions = 0;
+
+        size_t footprint() const { return weight_bytes + kv_cache_bytes; }
+    };
+
+    ModelManagerConfig config_;
+    mutable std::mutex mutex_;
+    std::condition_variable load_cv_;  // An entry finished loading
+    std::map<std::string, std::shared_ptr<Entry>> models_;
+    std::map<ModelRole, std::string> routes_;
+    ModelManagerStats stats_;
+    uint64_t clock_ = 0;
+
+    static bool isPinned(const Entry& entry) {
+        return entry.pins > 0;
+    }
+
+    // Unpins when the last copy of the returned pointer goes. It shares
+    // ownership of the entry, so it may outlive the manager.
+    struct Pin {
+        explicit Pin(std::shared_ptr<Entry> pinned) : entry(std::move(pinned)), bridge(entry->bridge) {
+            entry->pins++;
+        }
+        ~Pin() { entry->pins--; }
+
+        std::shared_ptr<Entry> entry;
+        std::shared_ptr<LLMBridge> bridge;
+    };
+
+    // Caller holds mutex_ and entry has a bridge
+    static std::shared_ptr<LLMBridge> pin(const std::shared_ptr<Entry>& entry) {
+        auto holder = std::make_shared<Pin>(entry);
+        return std::shared_ptr<LLMBridge>(holder, holder->bridge.get());
+    }
+
+    // Evict least recently used unpinned models until needed bytes fit. Returns
+    // the number evicted, or -1 if pinned models make it impossible.
+    int makeRoom(size_t needed, const Entry* keep) {
+        int evicted = 0;
+        while (stats_.resident_bytes + needed > config_.memory_budget_bytes) {
+            Entry* victim = nullptr;
+            for (auto& [id, entry] : models_) {
+                if (entry.get() == keep || !entry->bridge || isPinned(*entry)) continue;
+                if (!victim || entry->last_used < victim->last_used) victim = entry.get();
+            }
+            if (!victim) return -1;
+            evict(*victim);
+            evicted++;
+        }
+        return evicted;
+    }
+
+    // Runs without mutex_ on an entry marked loading, which registerModel,
+    // unload and makeRoom leave alone; only the mapping is written
+    std::shared_ptr<LLMBridge> load(Entry& entry, float& load_time_ms, std::string& error_msg) {
+        auto start_time = std::chrono::high_resolution_clock::now();
+
+        if (!entry.mapping.open(entry.spec.config.model_path, error_msg)) {
+            return nullptr;
+        }
+        if (config_.prefetch_on_load) {
+            entry.mapping.prefetch();
+        }
+
+        auto bridge = std::make_shared<LLMBridge>();
+        if (!bridge->initialize(entry.spec.config)) {
+            entry.mapping.close();
+            error_msg = "Failed to initialize model " + entry.spec.id;
+            return nullptr;
+        }
+
+        auto end_time = std::chrono::high_resolution_clock::now();
+        load_time_ms = std::chrono::duration<float, std::milli>(end_time - start_time).count();
+        return bridge;
+    }
+
+    void evict(Entry& entry) {
+        release(entry);
+        entry.evictions++;
+        stats_.resident_bytes -= entry.footprint();
+        stats_.evictions++;
+    }
+
+    static void release(Entry& entry) {
+        if (entry.bridge) {
+            entry.bridge->cleanup();
+            entry.bridge.reset();
+        }
+        entry.mapping.close();
+    }
+};
+
+ModelManager::ModelManager(const ModelManagerConfig& config)
+    : impl_(std::make_unique<Impl>(config)) {}
+
+ModelManager::~ModelManager() = default;
+
+bool ModelManager::registerModel(const ModelSpec& spec, std::string& error_msg) {
+    return impl_->registerModel(spec, error_msg);
+}
+
+bool ModelManager::setRoute(ModelRole role, const std::string& model_id, std::string& error_msg) {
+    return impl_->setRoute(role, model_id, error_msg);
+}
+
+std::shared_ptr<LLMBridge> ModelManager::acquire(ModelRole role, std::string& error_msg) {
+    return impl_->acquire(role, error_msg);
+}
+
+std::shared_ptr<LLMBridge> ModelManager::acquireModel(const std::string& model_id, std::string& error_msg) {
+    return impl_->acquireModel(model_id, error_msg);
+}
+
+LLMResponse ModelManager::generateQuiz(const std::string& prompt,
+                                       const std::string& grammar_path,
+                                       const GenerationOptions& options) {
+    std::string error_msg;
+    auto bridge = impl_->acquire(ModelRole::QUIZ, error_msg);
+    if (!bridge) {
+        LLMResponse response{};
+        response.success = false;
+        response.error_message = error_msg;
+        response.stop_reason = StopReason::FAILED;
+        return response;
+    }
+    return bridge->generateQuizAsync(prompt, grammar_path, options).get();
+}
+
+LLMResponse ModelManager::gradeAnswer(const std::string& prompt,
+                                      const std::string& grammar_path,
+                                      const GenerationOptions& options) {
+    std::string error_msg;
+    auto bridge = impl_->acquire(ModelRole::GRADE, error_msg);
+    if (!bridge) {
+        LLMResponse response{};
+        response.success = false;
+        response.error_message = error_msg;
+        response.stop_reason = StopReason::FAILED;
+        return response;
+    }
+    return bridge->gradeAnswerAsync(prompt, grammar_path, options).get();
+}
+
+EmbeddingResponse ModelManager::embed(const std::string& text) {
+    std::string error_msg;
+    auto bridge = impl_->acquire(ModelRole::EMBED, error_msg);
+    if (!bridge) {
+        EmbeddingResponse response;
+        response.error_message = error_msg;
+        return response;
+    }
+    return bridge->embed(text);
+}
+
+bool ModelManager::unload(const std::string& model_id) {
+    return impl_->unload(model_id);
+}
+
+void ModelManager::setMemoryBudget(size_t bytes) {
+    impl_->setMemoryBudget(bytes);
+}
+
+std::vector<ModelResidency> ModelManager::getResidency() const {
+    return impl_->getResidency();
+}
+
+ModelManagerStats ModelManager::getStats() const {
+    return impl_->getStats();
+}
+
+} // namespace core
+} // namespace studyhive
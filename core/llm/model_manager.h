@@ -0,0 +1,98 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include "llama_bridge.h"
+
+namespace studyhive {
+namespace core {
+
+// Request types that can be routed to different models
+enum class ModelRole {
+    QUIZ,
+    GRADE,
+    EMBED
+};
+
+struct ModelSpec {
+    std::string id;
+    LLMConfig config;  // model_path, grammar_path, n_ctx, ...
+};
+
+struct ModelManagerConfig {
+    size_t memory_budget_bytes = size_t(4) << 30;  // Weights + KV caches of resident models
+    bool prefetch_on_load = true;                   // Read weights ahead instead of faulting per page
+};
+
+struct ModelResidency {
+    std::string id;
+    bool resident = false;
+    bool pinned = false;        // Held by a caller, cannot be evicted
+    bool loading = false;       // Being mapped and initialized
+    size_t weight_bytes = 0;    // Mapped file size
+    size_t kv_cache_bytes = 0;  // From the GGUF header and n_ctx
+    float last_load_time_ms = 0.0f;
+    int loads = 0;
+    int evictions = 0;
+};
+
+struct ModelManagerStats {
+    size_t resident_bytes = 0;
+    size_t budget_bytes = 0;
+    int loads = 0;
+    int evictions = 0;
+    int swaps = 0;  // Loads that had to evict another model first
+    float total_load_time_ms = 0.0f;
+    float last_swap_time_ms = 0.0f;  // Evictions plus the load that needed them
+};
+
+// Keeps several GGUF models memory-mapped within a memory budget. Each request
+// type is routed to its configured model; models are loaded on first use and
+// the least recently used unpinned models are evicted to make room.
+class ModelManager {
+public:
+    explicit ModelManager(const ModelManagerConfig& config = ModelManagerConfig());
+    ~ModelManager();
+
+    // Register a model; its footprint is read from the GGUF header. Files without
+    // a GGUF header are sized by file size alone.
+    bool registerModel(const ModelSpec& spec, std::string& error_msg);
+
+    // Route a request type to a registered model
+    bool setRoute(ModelRole role, const std::string& model_id, std::string& error_msg);
+
+    // Resident bridge for the role's model, loading it if needed. The model stays
+    // pinned (not evictable) while any copy of the returned pointer is alive.
+    // A load runs outside the manager's lock: callers acquiring the same model
+    // wait for it, other models stay available meanwhile.
+    std::shared_ptr<LLMBridge> acquire(ModelRole role, std::string& error_msg);
+    std::shared_ptr<LLMBridge> acquireModel(const std::string& model_id, std::string& error_msg);
+
+    // Routed convenience calls
+    LLMResponse generateQuiz(const std::string& prompt,
+                             const std::string& grammar_path,
+                             const GenerationOptions& options = GenerationOptions());
+
+    LLMResponse gradeAnswer(const std::string& prompt,
+                            const std::string& grammar_path,
+                            const GenerationOptions& options = GenerationOptions());
+
+    EmbeddingResponse embed(const std::string& text);
+
+    // Unload a model now; fails if it is pinned
+    bool unload(const std::string& model_id);
+
+    // Change the budget, evicting unpinned models that no longer fit
+    void setMemoryBudget(size_t bytes);
+
+    std::vector<ModelResidency> getResidency() const;
+    ModelManagerStats getStats() const;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace core
+} // namespace studyhive
@@ -0,0 +1,238 @@
+#include "quiz_repair.h"
+#include <algorithm>
+#include <set>
+
+namespace studyhive {
+namespace core {
+
+namespace {
+
+// Structure of a (possibly truncated) quiz payload, found with a byte scan
+// that tracks nesting and string state only
+struct QuizPrefixScan {
+    std::string topic_token;  // Raw JSON string token, if complete
+    std::vector<std::pair<size_t, size_t>> question_spans;
+    bool questions_closed = false;
+};
+
+QuizPrefixScan scanQuizPrefix(const std::string& output) {
+    QuizPrefixScan scan;
+    std::vector<char> stack;
+    bool in_string = false;
+    bool escaped = false;
+    bool expect_key = false;
+    bool in_questions = false;
+    size_t string_start = 0;
+    size_t element_start = 0;
+    std::string current_key;
+
+    for (size_t i = 0; i < output.size(); ++i) {
+        char c = output[i];
+
+        if (in_string) {
+            if (escaped) {
+                escaped = false;
+            } else if (c == '\\') {
+                escaped = true;
+            } else if (c == '"') {
+                in_string = false;
+                if (stack.size() == 1) {
+                    std::string token = output.substr(string_start, i + 1 - string_start);
+                    if (expect_key) {
+                        current_key = token.substr(1, token.size() - 2);
+                        expect_key = false;
+                    } else if (current_key == "topic") {
+                        scan.topic_token = token;
+                    }
+                }
+            }
+            continue;
+        }
+
+        switch (c) {
+            case '"':
+                in_string = true;
+                string_start = i;
+                break;
+            case '{':
+            case '[':
+                stack.push_back(c);
+                if (stack.size() == 1) {
+                    expect_key = (c == '{');
+                } else if (stack.size() == 2 && c == '[' && current_key == "questions") {
+                    in_questions = true;
+                } else if (stack.size() == 3 && c == '{' && in_questions) {
+                    element_start = i;
+                }
+                break;
+            case '}':
+            case ']':
+                if (stack.empty()) return scan;
+                stack.pop_back();
+                if (stack.size() == 2 && c == '}' && in_questions) {
+                    scan.question_spans.emplace_back(element_start, i + 1);
+                } else if (stack.size() == 1 && in_questions) {
+                    in_questions = false;
+                    scan.questions_closed = true;
+                }
+                break;
+            case ',':
+                if (stack.size() == 1) expect_key = true;
+                break;
+            default:
+                break;
+        }
+    }
+
+    return scan;
+}
+
+// Ids must stay unique once questions from several sources are merged
+void appendQuestion(Quiz& quiz, std::set<std::string>& ids, Question question) {
+    std::string id = questionId(question);
+    for (int suffix = 2; ids.count(id); ++suffix) {
+        id = questionId(question) + "_" + std::to_string(suffix);
+    }
+    ids.insert(id);
+    std::visit([&](auto& q) { q.id = id; }, question);
+    quiz.questions.push_back(std::move(question));
+}
+
+} // namespace
+
+namespace quiz_repair {
+
+QuizSalvage salvageQuiz(const validation::ResponseSchemas& schemas,
+                        const std::string& output,
+                        const std::string& fallback_topic,
+                        const std::string& difficulty) {
+    QuizSalvage salvage;
+    QuizPrefixScan scan = scanQuizPrefix(output);
+    salvage.truncated = !scan.questions_closed;
+
+    salvage.quiz.topic = fallback_topic;
+    if (!scan.topic_token.empty()) {
+        try {
+            salvage.quiz.topic = nlohmann::json::parse(scan.topic_token).get<std::string>();
+        } catch (const std::exception&) {
+            // Keep the fallback topic
+        }
+    }
+    salvage.quiz.difficulty = difficulty;
+
+    // Validate each question on its own inside a minimal quiz envelope
+    std::string envelope_head = "{\"topic\":" + nlohmann::json(salvage.quiz.topic).dump() +
+                                ",\"difficulty\":" + nlohmann::json(difficulty).dump() + ",\"questions\":[";
+    std::set<std::string> ids;
+
+    for (const auto& [begin, end] : scan.question_spans) {
+        std::string envelope = envelope_head + output.substr(begin, end - begin) + "]}";
+        Quiz single;
+        std::string error_msg;
+        if (!validation::parseQuiz(schemas, envelope, single, error_msg)) {
+            salvage.dropped_questions++;
+            continue;
+        }
+        appendQuestion(salvage.quiz, ids, std::move(single.questions.front()));
+        salvage.kept_bytes = end;
+    }
+
+    return salvage;
+}
+
+QuizRepairResult repairQuiz(LLMBridge& bridge,
+                            QuestionGenerator* rules,
+                            const QuizRepairRequest& request,
+                            const LLMResponse& failed_response,
+                            const GenerationOptions& options) {
+    QuizRepairResult result;
+    validation::ResponseSchemas schemas = bridge.responseSchemas();
+    QuizSalvage salvage = salvageQuiz(schemas, failed_response.content, request.topic, request.difficulty);
+
+    result.quiz = std::move(salvage.quiz);
+    if (static_cast<int>(result.quiz.questions.size()) > request.num_questions) {
+        result.quiz.questions.resize(request.num_questions);
+    }
+    result.stats.salvaged_questions = static_cast<int>(result.quiz.questions.size());
+    if (!failed_response.content.empty()) {
+        result.stats.salvaged_tokens = static_cast<int>(
+            static_cast<double>(failed_response.tokens_generated) * salvage.kept_bytes /
+            failed_response.content.size());
+    }
+
+    std::set<std::string> ids;
+    for (const auto& question : result.quiz.questions) {
+        ids.insert(questionId(question));
+    }
+
+    // Ask the LLM for just the missing questions
+    int missing = request.num_questions - result.stats.salvaged_questions;
+    LLMResponse top_up;
+    top_up.tokens_generated = 0;
+    if (missing > 0 && bridge.isReady()) {
+        std::vector<std::string> existing_prompts;
+        for (const auto& question : result.quiz.questions) {
+            existing_prompts.push_back(questionPrompt(question));
+        }
+
+        // Only the notes chunks most relevant to the topic, as for the original request
+        std::string prompt = prompts::buildQuizTopUpPrompt(
+            request.topic, request.difficulty, missing, request.notes_content, existing_prompts,
+            [&bridge](const std::string& text) { return bridge.countTokens(text); }, bridge.promptTokenBudget());
+        top_up = bridge.generateQuizAsync(prompt, request.grammar_path, options).get();
+        result.stats.repair_tokens = top_up.tokens_generated;
+
+        // The top-up may itself be cut short; keep whatever is complete
+        QuizSalvage extra = salvageQuiz(schemas, top_up.content, request.topic, request.difficulty);
+        for (auto& question : extra.quiz.questions) {
+            if (missing == 0) break;
+            appendQuestion(result.quiz, ids, std::move(question));
+            result.stats.llm_questions++;
+            missing--;
+        }
+    }
+
+    // Rules engine covers the remainder
+    if (missing > 0 && rules) {
+        ParsedContent parsed;
+        const ParsedContent& content = request.notes_edit
+            ? rules->parseEditedContent(request.notes_content, *request.notes_edit)
+            : (parsed = rules->parseContent(request.notes_content));
+        for (auto& question : rules->generateQuestions(content, request.difficulty, missing, request.seed)) {
+            appendQuestion(result.quiz, ids, std::move(question));
+            result.stats.rules_questions++;
+        }
+    }
+
+    // Full regeneration would decode every question again at the observed per-question cost
+    int llm_kept = result.stats.salvaged_questions + result.stats.llm_questions;
+    if (llm_kept > 0) {
+        int tokens_per_question = (result.stats.salvaged_tokens + result.stats.repair_tokens) / llm_kept;
+        result.stats.full_regeneration_tokens = tokens_per_question * request.num_questions;
+        result.stats.tokens_saved = result.stats.full_regeneration_tokens - result.stats.repair_tokens;
+    }
+
+    QuizMetadata metadata;
+    if (llm_kept > 0) {
+        // Mixed provenance goes in its own field; consumers key on source
+        metadata.source = "device-llm";
+        if (result.stats.rules_questions > 0) {
+            metadata.rules_questions = result.stats.rules_questions;
+        }
+    } else {
+        metadata.source = "rules";
+    }
+    metadata.seed = request.seed;
+    result.quiz.metadata = std::move(metadata);
+
+    result.success = !result.quiz.questions.empty();
+    if (!result.success) {
+        result.error_message = "No questions could be salvaged or generated";
+    }
+    return result;
+}
+
+} // namespace quiz_repair
+
+} // namespace core
+} // namespace studyhive
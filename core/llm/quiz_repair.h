@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include "llama_bridge.h"
+#include "../rules/qgen_rules.h"
+#include "../rules/incremental_parser.h"
+#include "../types/quiz_types.h"
+
+namespace studyhive {
+namespace core {
+
+// Complete, schema-valid questions recovered from a rejected LLM quiz output
+struct QuizSalvage {
+    Quiz quiz;
+    size_t kept_bytes = 0;          // Output prefix covered by the kept questions
+    int dropped_questions = 0;      // Complete but schema-invalid questions
+    bool truncated = false;         // Output ended inside the questions array
+};
+
+struct QuizRepairRequest {
+    std::string topic;
+    std::string difficulty;
+    int num_questions = 5;
+    std::string notes_content;
+    // Set when notes_content is the note last parsed by the rules engine's
+    // parseEditedContent with this edit applied: only the edited paragraphs are re-parsed
+    std::optional<TextEdit> notes_edit;
+    std::string grammar_path;
+    int seed = 42;
+};
+
+struct QuizRepairStats {
+    int salvaged_questions = 0;
+    int llm_questions = 0;    // Generated by the top-up request
+    int rules_questions = 0;  // Filled in by the rules engine
+    int salvaged_tokens = 0;  // Decode tokens of the failed output that were kept
+    int repair_tokens = 0;    // Decode tokens spent on the top-up request
+    int full_regeneration_tokens = 0;  // Estimated cost of regenerating the whole quiz
+    int tokens_saved = 0;     // full_regeneration_tokens - repair_tokens
+};
+
+struct QuizRepairResult {
+    bool success = false;
+    Quiz quiz;
+    QuizRepairStats stats;
+    std::string error_message;
+};
+
+namespace quiz_repair {
+
+// Parse the longest usable prefix of an LLM quiz output. Every complete
+// question that validates against the schema is kept; fallback_topic and
+// difficulty fill in the header when the output lost it.
+QuizSalvage salvageQuiz(const validation::ResponseSchemas& schemas,
+                        const std::string& output,
+                        const std::string& fallback_topic,
+                        const std::string& difficulty);
+
+// Keep what the failed response produced, ask the LLM for only the missing
+// questions and let the rules engine (if given) fill whatever is still short.
+QuizRepairResult repairQuiz(LLMBridge& bridge,
+                            QuestionGenerator* rules,
+                            const QuizRepairRequest& request,
+                            const LLMResponse& failed_response,
+                            const GenerationOptions& options = GenerationOptions());
+
+} // namespace quiz_repair
+
+} // namespace core
+} // namespace studyhive
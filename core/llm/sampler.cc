@@ -0,0 +1,464 @@
+#include "sampler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+// Kernels are picked at compile time (-mavx2 -mfma on x86-64; NEON is baseline
+// on AArch64). Every kernel uses the same fused multiply-adds, rounding and
+// 8-lane accumulation order as the scalar code, so results do not depend on
+// which one runs.
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#define STUDYHIVE_SAMPLING_AVX2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define STUDYHIVE_SAMPLING_NEON 1
+#endif
+
+namespace studyhive {
+namespace core {
+
+namespace sampling {
+
+namespace {
+
+constexpr float kNegInf = -std::numeric_limits<float>::infinity();
+
+// Cephes expf: exp(x) = 2^n * exp(r), |r| <= ln2/2
+constexpr float kExpLow = -87.33654f;  // Smallest x with a normal 2^n
+constexpr float kLog2e = 1.44269504088896341f;
+constexpr float kLn2Hi = 0.693359375f;
+constexpr float kLn2Lo = -2.12194440e-4f;
+constexpr float kP0 = 1.9875691500e-4f;
+constexpr float kP1 = 1.3981999507e-3f;
+constexpr float kP2 = 8.3334519073e-3f;
+constexpr float kP3 = 4.1665795894e-2f;
+constexpr float kP4 = 1.6666665459e-1f;
+constexpr float kP5 = 5.0000001201e-1f;
+
+bool better(const Candidate& a, const Candidate& b) {
+    return a.logit > b.logit || (a.logit == b.logit && a.id < b.id);
+}
+
+float combineLanes(const float acc[8]) {
+    return ((acc[0] + acc[1]) + (acc[2] + acc[3])) + ((acc[4] + acc[5]) + (acc[6] + acc[7]));
+}
+
+// Calls fn(i, bits) for every 8-token block with at least one allowed token;
+// bit j of bits is token i + j. Blocks past n are trimmed; mask words that
+// allow nothing are skipped whole.
+template <typename BlockFn>
+void forEachBlock(size_t n, const uint64_t* mask, BlockFn&& fn) {
+    for (size_t base = 0; base < n; base += 64) {
+        uint64_t word = mask ? mask[base >> 6] : ~uint64_t(0);
+        if (!word) continue;
+        size_t end = std::min(n, base + 64);
+        for (size_t i = base; i < end; i += 8) {
+            uint32_t bits = static_cast<uint32_t>(word >> (i - base)) & 0xFFu;
+            if (n - i < 8) bits &= (1u << (n - i)) - 1;
+            if (bits) fn(i, bits);
+        }
+    }
+}
+
+// Bounded heap of the best candidates; front() is the worst kept entry
+class TopKHeap {
+public:
+    TopKHeap(std::vector<Candidate>& heap, size_t k) : heap_(heap), k_(k) {
+        heap_.clear();
+        heap_.reserve(k);
+    }
+
+    float threshold() const { return heap_.size() < k_ ? kNegInf : heap_.front().logit; }
+
+    void consider(float logit, int32_t id) {
+        Candidate candidate{logit, id};
+        if (heap_.size() < k_) {
+            heap_.push_back(candidate);
+            std::push_heap(heap_.begin(), heap_.end(), better);
+        } else if (better(candidate, heap_.front())) {
+            std::pop_heap(heap_.begin(), heap_.end(), better);
+            heap_.back() = candidate;
+            std::push_heap(heap_.begin(), heap_.end(), better);
+        }
+    }
+
+    void finish() { std::sort_heap(heap_.begin(), heap_.end(), better); }
+
+private:
+    std::vector<Candidate>& heap_;
+    size_t k_;
+};
+
+#if defined(STUDYHIVE_SAMPLING_AVX2)
+
+__m256 laneMask(uint32_t bits) {
+    const __m256i select = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    __m256i spread = _mm256_and_si256(_mm256_set1_epi32(static_cast<int>(bits)), select);
+    return _mm256_castsi256_ps(_mm256_cmpeq_epi32(spread, select));
+}
+
+__m256 expNonPositive8(__m256 x) {
+    x = _mm256_max_ps(x, _mm256_set1_ps(kExpLow));
+    __m256 n = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(kLog2e)),
+                               _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256 r = _mm256_fmadd_ps(n, _mm256_set1_ps(-kLn2Hi), x);
+    r = _mm256_fmadd_ps(n, _mm256_set1_ps(-kLn2Lo), r);
+    __m256 r2 = _mm256_mul_ps(r, r);
+    __m256 p = _mm256_set1_ps(kP0);
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(kP1));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(kP2));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(kP3));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(kP4));
+    p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(kP5));
+    __m256 y = _mm256_add_ps(_mm256_fmadd_ps(p, r2, r), _mm256_set1_ps(1.0f));
+    __m256i exponent = _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127));
+    return _mm256_mul_ps(y, _mm256_castsi256_ps(_mm256_slli_epi32(exponent, 23)));
+}
+
+#elif defined(STUDYHIVE_SAMPLING_NEON)
+
+struct Lanes8 {
+    uint32x4_t lo;
+    uint32x4_t hi;
+};
+
+Lanes8 laneMask(uint32_t bits) {
+    static const uint32_t kLo[4] = {1, 2, 4, 8};
+    static const uint32_t kHi[4] = {16, 32, 64, 128};
+    uint32x4_t spread = vdupq_n_u32(bits);
+    return {vtstq_u32(spread, vld1q_u32(kLo)), vtstq_u32(spread, vld1q_u32(kHi))};
+}
+
+uint32_t laneBits(uint32x4_t lo, uint32x4_t hi) {
+    static const uint32_t kLo[4] = {1, 2, 4, 8};
+    static const uint32_t kHi[4] = {16, 32, 64, 128};
+    return vaddvq_u32(vandq_u32(lo, vld1q_u32(kLo))) + vaddvq_u32(vandq_u32(hi, vld1q_u32(kHi)));
+}
+
+// vfmaq_f32(a, b, c) = a + b * c, fused like std::fma(b, c, a)
+float32x4_t expNonPositive4(float32x4_t x) {
+    x = vmaxq_f32(x, vdupq_n_f32(kExpLow));
+    float32x4_t n = vrndnq_f32(vmulq_f32(x, vdupq_n_f32(kLog2e)));
+    float32x4_t r = vfmaq_f32(x, n, vdupq_n_f32(-kLn2Hi));
+    r = vfmaq_f32(r, n, vdupq_n_f32(-kLn2Lo));
+    float32x4_t r2 = vmulq_f32(r, r);
+    float32x4_t p = vdupq_n_f32(kP0);
+    p = vfmaq_f32(vdupq_n_f32(kP1), p, r);
+    p = vfmaq_f32(vdupq_n_f32(kP2), p, r);
+    p = vfmaq_f32(vdupq_n_f32(kP3), p, r);
+    p = vfmaq_f32(vdupq_n_f32(kP4), p, r);
+    p = vfmaq_f32(vdupq_n_f32(kP5), p, r);
+    float32x4_t y = vaddq_f32(vfmaq_f32(r, p, r2), vdupq_n_f32(1.0f));
+    int32x4_t exponent = vaddq_s32(vcvtq_s32_f32(n), vdupq_n_s32(127));
+    return vmulq_f32(y, vreinterpretq_f32_s32(vshlq_n_s32(exponent, 23)));
+}
+
+#endif
+
+} // namespace
+
+const char* kernelName() {
+#if defined(STUDYHIVE_SAMPLING_AVX2)
+    return "avx2";
+#elif defined(STUDYHIVE_SAMPLING_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+float expNonPositive(float x) {
+    x = std::max(x, kExpLow);
+    float n = std::nearbyint(x * kLog2e);
+    float r = std::fma(n, -kLn2Hi, x);
+    r = std::fma(n, -kLn2Lo, r);
+    float r2 = r * r;
+    float p = kP0;
+    p = std::fma(p, r, kP1);
+    p = std::fma(p, r, kP2);
+    p = std::fma(p, r, kP3);
+    p = std::fma(p, r, kP4);
+    p = std::fma(p, r, kP5);
+    float y = std::fma(p, r2, r) + 1.0f;
+    uint32_t bits = static_cast<uint32_t>(static_cast<int32_t>(n) + 127) << 23;
+    float scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+    return y * scale;
+}
+
+float maskedMax(const float* logits, size_t n, const uint64_t* mask, float inv_temp, bool vectorized) {
+    float best = kNegInf;
+
+    auto scalarBlock = [&](size_t i, uint32_t bits) {
+        for (; bits; bits &= bits - 1) {
+            size_t j = i + __builtin_ctz(bits);
+            best = std::max(best, logits[j] * inv_temp);
+        }
+    };
+
+#if defined(STUDYHIVE_SAMPLING_AVX2)
+    if (vectorized) {
+        const __m256 scale = _mm256_set1_ps(inv_temp);
+        const __m256 neg_inf = _mm256_set1_ps(kNegInf);
+        __m256 vbest = neg_inf;
+        forEachBlock(n, mask, [&](size_t i, uint32_t bits) {
+            if (n - i < 8) return scalarBlock(i, bits);
+            __m256 z = _mm256_mul_ps(_mm256_loadu_ps(logits + i), scale);
+            vbest = _mm256_max_ps(vbest, _mm256_blendv_ps(neg_inf, z, laneMask(bits)));
+        });
+        float lanes[8];
+        _mm256_storeu_ps(lanes, vbest);
+        for (float lane : lanes) best = std::max(best, lane);
+        return best;
+    }
+#elif defined(STUDYHIVE_SAMPLING_NEON)
+    if (vectorized) {
+        const float32x4_t neg_inf = vdupq_n_f32(kNegInf);
+        float32x4_t vbest = neg_inf;
+        forEachBlock(n, mask, [&](size_t i, uint32_t bits) {
+            if (n - i < 8) return scalarBlock(i, bits);
+            Lanes8 lanes = laneMask(bits);
+            float32x4_t lo = vmulq_n_f32(vld1q_f32(logits + i), inv_temp);
+            float32x4_t hi = vmulq_n_f32(vld1q_f32(logits + i + 4), inv_temp);
+            vbest = vmaxq_f32(vbest, vbslq_f32(lanes.lo, lo, neg_inf));
+            vbest = vmaxq_f32(vbest, vbslq_f32(lanes.hi, hi, neg_inf));
+        });
+        return std::max(best, vmaxvq_f32(vbest));
+    }
+#endif
+
+    (void)vectorized;
+    forEachBlock(n, mask, scalarBlock);
+    return best;
+}
+
+float maskedExp(const float* logits, size_t n, const uint64_t* mask, float inv_temp, float max,
+                float* probs, bool vectorized) {
+    if (mask) {
+        std::fill(probs, probs + n, 0.0f);
+    }
+    float acc[8] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+
+    // Token i always accumulates into lane i % 8
+    auto scalarBlock = [&](size_t i, uint32_t bits) {
+        for (; bits; bits &= bits - 1) {
+            size_t lane = __builtin_ctz(bits);
+            float e = expNonPositive(std::fma(logits[i + lane], inv_temp, -max));
+            probs[i + lane] = e;
+            acc[lane] += e;
+        }
+    };
+
+#if defined(STUDYHIVE_SAMPLING_AVX2)
+    if (vectorized) {
+        const __m256 scale = _mm256_set1_ps(inv_temp);
+        const __m256 neg_max = _mm256_set1_ps(-max);
+        __m256 vacc = _mm256_setzero_ps();
+        bool tail = false;
+        size_t tail_i = 0;
+        uint32_t tail_bits = 0;
+        forEachBlock(n, mask, [&](size_t i, uint32_t bits) {
+            if (n - i < 8) {
+                tail = true;
+                tail_i = i;
+                tail_bits = bits;
+                return;
+            }
+            __m256 x = _mm256_fmadd_ps(_mm256_loadu_ps(logits + i), scale, neg_max);
+            __m256 e = _mm256_and_ps(expNonPositive8(x), laneMask(bits));
+            _mm256_storeu_ps(probs + i, e);
+            vacc = _mm256_add_ps(vacc, e);
+        });
+        _mm256_storeu_ps(acc, vacc);
+        if (tail) scalarBlock(tail_i, tail_bits);
+        return combineLanes(acc);
+    }
+#elif defined(STUDYHIVE_SAMPLING_NEON)
+    if (vectorized) {
+        const float32x4_t scale = vdupq_n_f32(inv_temp);
+        const float32x4_t neg_max = vdupq_n_f32(-max);
+        float32x4_t acc_lo = vdupq_n_f32(0.0f);
+        float32x4_t acc_hi = vdupq_n_f32(0.0f);
+        bool tail = false;
+        size_t tail_i = 0;
+        uint32_t tail_bits = 0;
+        forEachBlock(n, mask, [&](size_t i, uint32_t bits) {
+            if (n - i < 8) {
+                tail = true;
+                tail_i = i;
+                tail_bits = bits;
+                return;
+            }
+            Lanes8 lanes = laneMask(bits);
+            float32x4_t lo = expNonPositive4(vfmaq_f32(neg_max, vld1q_f32(logits + i), scale));
+            float32x4_t hi = expNonPositive4(vfmaq_f32(neg_max, vld1q_f32(logits + i + 4), scale));
+            lo = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(lo), lanes.lo));
+            hi = vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(hi), lanes.hi));
+            vst1q_f32(probs + i, lo);
+            vst1q_f32(probs + i + 4, hi);
+            acc_lo = vaddq_f32(acc_lo, lo);
+            acc_hi = vaddq_f32(acc_hi, hi);
+        });
+        vst1q_f32(acc, acc_lo);
+        vst1q_f32(acc + 4, acc_hi);
+        if (tail) scalarBlock(tail_i, tail_bits);
+        return combineLanes(acc);
+    }
+#endif
+
+    (void)vectorized;
+    forEachBlock(n, mask, scalarBlock);
+    return combineLanes(acc);
+}
+
+void maskedTopK(const float* logits, size_t n, const uint64_t* mask, float inv_temp, size_t k,
+                std::vector<Candidate>& out, bool vectorized) {
+    TopKHeap heap(out, k);
+    if (k == 0) return;
+
+    auto scalarBlock = [&](size_t i, uint32_t bits) {
+        for (; bits; bits &= bits - 1) {
+            size_t j = i + __builtin_ctz(bits);
+            float z = logits[j] * inv_temp;
+            if (z >= heap.threshold()) heap.consider(z, static_cast<int32_t>(j));
+        }
+    };
+
+    // Vector blocks only find the lanes that can enter the heap; those go
+    // through the same scalar comparison, so the selected set is identical
+#if defined(STUDYHIVE_SAMPLING_AVX2)
+    if (vectorized) {
+        const __m256 scale = _mm256_set1_ps(inv_temp);
+        forEachBlock(n, mask, [&](size_t i, uint32_t bits) {
+            if (n - i < 8) return scalarBlock(i, bits);
+            __m256 z = _mm256_mul_ps(_mm256_loadu_ps(logits + i), scale);
+            __m256 pass = _mm256_cmp_ps(z, _mm256_set1_ps(heap.threshold()), _CMP_GE_OQ);
+            uint32_t hits = static_cast<uint32_t>(_mm256_movemask_ps(pass)) & bits;
+            if (hits) scalarBlock(i, hits);
+        });
+        heap.finish();
+        return;
+    }
+#elif defined(STUDYHIVE_SAMPLING_NEON)
+    if (vectorized) {
+        forEachBlock(n, mask, [&](size_t i, uint32_t bits) {
+            if (n - i < 8) return scalarBlock(i, bits);
+            float32x4_t threshold = vdupq_n_f32(heap.threshold());
+            uint32x4_t lo = vcgeq_f32(vmulq_n_f32(vld1q_f32(logits + i), inv_temp), threshold);
+            uint32x4_t hi = vcgeq_f32(vmulq_n_f32(vld1q_f32(logits + i + 4), inv_temp), threshold);
+            uint32_t hits = laneBits(lo, hi) & bits;
+            if (hits) scalarBlock(i, hits);
+        });
+        heap.finish();
+        return;
+    }
+#endif
+
+    (void)vectorized;
+    forEachBlock(n, mask, scalarBlock);
+    heap.finish();
+}
+
+} // namespace sampling
+
+TokenSampler::TokenSampler(const SamplingParams& params)
+    : params_(params), rng_(params.seed) {}
+
+void TokenSampler::reseed(uint32_t seed) {
+    params_.seed = seed;
+    rng_.seed(seed);
+}
+
+// 24 random bits; std::uniform_real_distribution differs between standard libraries
+float TokenSampler::uniform() {
+    return static_cast<float>(rng_() >> 8) * (1.0f / 16777216.0f);
+}
+
+int32_t TokenSampler::drawCandidates(size_t count) {
+    float total = 0.0f;
+    for (size_t j = 0; j < count; ++j) total += weights_[j];
+
+    float target = uniform() * total;
+    float acc = 0.0f;
+    for (size_t j = 0; j < count; ++j) {
+        acc += weights_[j];
+        if (acc > target) return candidates_[j].id;
+    }
+    return candidates_[count - 1].id;
+}
+
+int32_t TokenSampler::sample(const float* logits, size_t n_vocab, const TokenMaskTable::Mask* mask) {
+    const uint64_t* bits = mask ? mask->data() : nullptr;
+    bool vectorized = params_.vectorized;
+
+    if (params_.temperature <= 0.0f) {
+        sampling::maskedTopK(logits, n_vocab, bits, 1.0f, 1, candidates_, vectorized);
+        return candidates_.empty() ? -1 : candidates_.front().id;
+    }
+
+    float inv_temp = 1.0f / params_.temperature;
+
+    if (params_.top_k > 0 && static_cast<size_t>(params_.top_k) < n_vocab) {
+        sampling::maskedTopK(logits, n_vocab, bits, inv_temp, params_.top_k, candidates_, vectorized);
+        if (candidates_.empty()) return -1;
+
+        // Softmax over the k survivors only
+        weights_.clear();
+        float total = 0.0f;
+        for (const auto& candidate : candidates_) {
+            weights_.push_back(sampling::expNonPositive(candidate.logit - candidates_.front().logit));
+            total += weights_.back();
+        }
+
+        size_t keep = weights_.size();
+        if (params_.top_p < 1.0f) {
+            float covered = 0.0f;
+            for (keep = 0; keep < weights_.size();) {
+                covered += weights_[keep++];
+                if (covered >= params_.top_p * total) break;
+            }
+        }
+        return drawCandidates(keep);
+    }
+
+    float max = sampling::maskedMax(logits, n_vocab, bits, inv_temp, vectorized);
+    if (max == -std::numeric_limits<float>::infinity()) return -1;
+
+    probs_.resize(n_vocab);
+    float sum = sampling::maskedExp(logits, n_vocab, bits, inv_temp, max, probs_.data(), vectorized);
+
+    if (params_.top_p < 1.0f) {
+        // Grow a partial selection until it holds top_p of the mass
+        for (size_t k = 64;; k *= 4) {
+            k = std::min(k, n_vocab);
+            sampling::maskedTopK(logits, n_vocab, bits, inv_temp, k, candidates_, vectorized);
+            weights_.clear();
+            float covered = 0.0f;
+            for (const auto& candidate : candidates_) {
+                weights_.push_back(probs_[candidate.id]);
+                covered += weights_.back();
+                if (covered >= params_.top_p * sum) break;
+            }
+            if (covered >= params_.top_p * sum || candidates_.size() < k || k == n_vocab) {
+                return drawCandidates(weights_.size());
+            }
+        }
+    }
+
+    // Multinomial over the whole vocabulary
+    float target = uniform() * sum;
+    float acc = 0.0f;
+    int32_t last = -1;
+    for (size_t i = 0; i < n_vocab; ++i) {
+        if (probs_[i] <= 0.0f) continue;
+        acc += probs_[i];
+        last = static_cast<int32_t>(i);
+        if (acc > target) return last;
+    }
+    return last;
+}
+
+} // namespace core
+} // namespace studyhive
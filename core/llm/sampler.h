@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vector>
+#include <random>
+#include <cstdint>
+#include "grammar_mask.h"
+
+namespace studyhive {
+namespace core {
+
+// Fused kernels over temperature-scaled, masked logits. mask is a bitset of
+// allowed tokens (null: all allowed); masked tokens count as -inf.
+namespace sampling {
+
+struct Candidate {
+    float logit;  // Scaled by inv_temp
+    int32_t id;
+};
+
+// "avx2", "neon" or "scalar"
+const char* kernelName();
+
+// exp(x) for x <= 0, shared by all kernels so results match bit for bit
+float expNonPositive(float x);
+
+// Largest scaled logit among allowed tokens (-inf if none)
+float maskedMax(const float* logits, size_t n, const uint64_t* mask, float inv_temp,
+                bool vectorized = true);
+
+// probs[i] = exp(logits[i] * inv_temp - max) for allowed tokens, 0 otherwise.
+// Returns the sum, accumulated in a fixed 8-lane order.
+float maskedExp(const float* logits, size_t n, const uint64_t* mask, float inv_temp, float max,
+                float* probs, bool vectorized = true);
+
+// The k best allowed tokens by scaled logit (ties go to the lower id), best
+// first. Partial selection: a k-element heap fed only by lanes that beat its
+// current worst entry.
+void maskedTopK(const float* logits, size_t n, const uint64_t* mask, float inv_temp, size_t k,
+                std::vector<Candidate>& out, bool vectorized = true);
+
+} // namespace sampling
+
+struct SamplingParams {
+    float temperature = 0.7f;  // <= 0: greedy
+    int top_k = 40;            // <= 0: disabled
+    float top_p = 0.95f;       // >= 1: disabled
+    uint32_t seed = 42;
+    bool vectorized = true;    // false forces the scalar kernels (same results)
+};
+
+// Picks the next token from a full-vocabulary logit array, restricted to the
+// tokens allowed by a grammar mask. For a fixed seed the token sequence is
+// bit-identical across the AVX2, NEON and scalar kernels. One sampler per
+// sequence; not thread-safe.
+class TokenSampler {
+public:
+    explicit TokenSampler(const SamplingParams& params = SamplingParams());
+
+    // Returns -1 if the mask allows no token. mask may be null (all allowed)
+    // and must cover n_vocab bits otherwise.
+    int32_t sample(const float* logits, size_t n_vocab, const TokenMaskTable::Mask* mask);
+
+    // Restart the random stream (e.g. when replaying a cached request)
+    void reseed(uint32_t seed);
+
+    const SamplingParams& params() const { return params_; }
+
+private:
+    SamplingParams params_;
+    std::mt19937 rng_;
+
+    // Scratch, reused across steps
+    std::vector<float> probs_;
+    std::vector<sampling::Candidate> candidates_;
+    std::vector<float> weights_;
+
+    float uniform();
+    int32_t drawCandidates(size_t count);
+};
+
+} // namespace core
+} // namespace studyhive
@@ -0,0 +1,674 @@
+#include "schema_validator.h"
+#include <fstream>
+#include <map>
+#include <cmath>
+#include <stdexcept>
+
+namespace studyhive {
+namespace core {
+
+// Lowers a schema document into CompiledSchema's node table. $ref targets are
+// compiled once and shared, so recursive definitions terminate.
+class SchemaCompiler {
+public:
+    SchemaCompiler(const nlohmann::json& document, CompiledSchema& out)
+        : document_(document), out_(out) {}
+
+    bool compile(std::string& error_msg) {
+        try {
+            out_.root_ = compileNode(document_, "#");
+            return true;
+        } catch (const std::exception& e) {
+            error_msg = e.what();
+            return false;
+        }
+    }
+
+private:
+    using Node = CompiledSchema::Node;
+
+    const nlohmann::json& document_;
+    CompiledSchema& out_;
+    std::map<std::string, int32_t> refs_;
+
+    int32_t allocate() {
+        out_.nodes_.emplace_back();
+        return static_cast<int32_t>(out_.nodes_.size() - 1);
+    }
+
+    int32_t compileNode(const nlohmann::json& schema, const std::string& where) {
+        if (schema.is_object() && schema.contains("$ref")) {
+            return resolveRef(schema["$ref"], where);
+        }
+        int32_t index = allocate();
+        compileInto(index, schema, where);
+        return index;
+    }
+
+    int32_t resolveRef(const nlohmann::json& ref_value, const std::string& where) {
+        if (!ref_value.is_string()) {
+            throw std::runtime_error(where + ": $ref must be a string");
+        }
+        std::string ref = ref_value.get<std::string>();
+        auto it = refs_.find(ref);
+        if (it != refs_.end()) {
+            return it->second;
+        }
+        if (ref.empty() || ref[0] != '#') {
+            throw std::runtime_error(where + ": only local $ref is supported: " + ref);
+        }
+
+        nlohmann::json::json_pointer pointer(ref.substr(1));
+        if (!document_.contains(pointer)) {
+            throw std::runtime_error(where + ": unresolved $ref " + ref);
+        }
+        const nlohmann::json& target = document_.at(pointer);
+        if (target.is_object() && target.contains("$ref")) {
+            throw std::runtime_error(where + ": chained $ref is not supported: " + ref);
+        }
+
+        // Register before compiling so recursive references resolve to this node
+        int32_t index = allocate();
+        refs_[ref] = index;
+        compileInto(index, target, ref);
+        return index;
+    }
+
+    static size_t sizeKeyword(const nlohmann::json& schema, const char* keyword, const std::string& where) {
+        const auto& value = schema[keyword];
+        if (!value.is_number_unsigned()) {
+            throw std::runtime_error(where + ": " + keyword + " must be a non-negative integer");
+        }
+        return value.get<size_t>();
+    }
+
+    static double numberKeyword(const nlohmann::json& schema, const char* keyword, const std::string& where) {
+        const auto& value = schema[keyword];
+        if (!value.is_number()) {
+            throw std::runtime_error(where + ": " + keyword + " must be a number");
+        }
+        return value.get<double>();
+    }
+
+    static uint8_t typeBits(const std::string& name, const std::string& where) {
+        if (name == "null") return CompiledSchema::TYPE_NULL;
+        if (name == "boolean") return CompiledSchema::TYPE_BOOLEAN;
+        if (name == "integer") return CompiledSchema::TYPE_INTEGER;
+        if (name == "number") return CompiledSchema::TYPE_NUMBER | CompiledSchema::TYPE_INTEGER;
+        if (name == "string") return CompiledSchema::TYPE_STRING;
+        if (name == "array") return CompiledSchema::TYPE_ARRAY;
+        if (name == "object") return CompiledSchema::TYPE_OBJECT;
+        throw std::runtime_error(where + ": unknown type '" + name + "'");
+    }
+
+    void compileInto(int32_t index, const nlohmann::json& schema, const std::string& where) {
+        Node node;
+
+        if (schema.is_boolean()) {
+            node.types = schema.get<bool>() ? CompiledSchema::TYPE_ANY : 0;
+            out_.nodes_[index] = std::move(node);
+            return;
+        }
+        if (!schema.is_object()) {
+            throw std::runtime_error(where + ": schema must be an object or boolean");
+        }
+
+        // Refuse keywords we don't enforce rather than silently accepting more
+        for (const char* keyword : {"allOf", "anyOf", "not", "if", "additionalProperties",
+                                    "patternProperties", "propertyNames", "dependencies",
+                                    "minProperties", "maxProperties", "additionalItems",
+                                    "contains", "uniqueItems", "exclusiveMinimum",
+                                    "exclusiveMaximum", "multipleOf"}) {
+            if (schema.contains(keyword)) {
+                throw std::runtime_error(where + ": unsupported keyword '" + keyword + "'");
+            }
+        }
+
+        if (schema.contains("type")) {
+            const auto& type = schema["type"];
+            if (type.is_string()) {
+                node.types = typeBits(type.get<std::string>(), where);
+            } else if (type.is_array()) {
+                node.types = 0;
+                for (const auto& name : type) {
+                    node.types |= typeBits(name.get<std::string>(), where);
+                }
+            } else {
+                throw std::runtime_error(where + ": type must be a string or array");
+            }
+        }
+
+        if (schema.contains("enum")) {
+            if (!schema["enum"].is_array()) {
+                throw std::runtime_error(where + ": enum must be an array");
+            }
+            for (const auto& value : schema["enum"]) {
+                node.enum_values.push_back(value);
+            }
+        }
+        if (schema.contains("const")) {
+            node.enum_values = {schema["const"]};
+        }
+        for (const auto& value : node.enum_values) {
+            if (value.is_structured()) {
+                throw std::runtime_error(where + ": enum/const values must be scalars");
+            }
+        }
+
+        if (schema.contains("properties")) {
+            for (const auto& [name, subschema] : schema["properties"].items()) {
+                node.properties[name].node = compileNode(subschema, where + "/properties/" + name);
+            }
+        }
+
+        if (schema.contains("required")) {
+            for (const auto& name : schema["required"]) {
+                if (node.required.size() == 64) {
+                    throw std::runtime_error(where + ": more than 64 required properties");
+                }
+                node.properties[name.get<std::string>()].required_bit = static_cast<int32_t>(node.required.size());
+                node.required.push_back(name.get<std::string>());
+            }
+        }
+
+        if (schema.contains("items")) {
+            if (schema["items"].is_array()) {
+                throw std::runtime_error(where + ": tuple-form items is not supported");
+            }
+            node.items = compileNode(schema["items"], where + "/items");
+        }
+
+        if (schema.contains("oneOf")) {
+            size_t branch = 0;
+            for (const auto& subschema : schema["oneOf"]) {
+                node.one_of.push_back(compileNode(subschema, where + "/oneOf/" + std::to_string(branch++)));
+            }
+            if (node.one_of.empty()) {
+                throw std::runtime_error(where + ": oneOf must not be empty");
+            }
+        }
+
+        if (schema.contains("minItems")) node.min_items = sizeKeyword(schema, "minItems", where);
+        if (schema.contains("maxItems")) node.max_items = sizeKeyword(schema, "maxItems", where);
+        if (schema.contains("minLength")) node.min_length = sizeKeyword(schema, "minLength", where);
+        if (schema.contains("maxLength")) node.max_length = sizeKeyword(schema, "maxLength", where);
+        if (schema.contains("minimum")) node.minimum = numberKeyword(schema, "minimum", where);
+        if (schema.contains("maximum")) node.maximum = numberKeyword(schema, "maximum", where);
+
+        if (schema.contains("pattern")) {
+            node.pattern_source = schema["pattern"].get<std::string>();
+            try {
+                node.pattern.emplace(node.pattern_source, std::regex::ECMAScript | std::regex::optimize);
+            } catch (const std::regex_error& e) {
+                throw std::runtime_error(where + ": invalid pattern: " + e.what());
+            }
+        }
+
+        out_.nodes_[index] = std::move(node);
+    }
+};
+
+std::shared_ptr<const CompiledSchema> CompiledSchema::compile(const nlohmann::json& schema,
+                                                              std::string& error_msg) {
+    auto compiled = std::make_shared<CompiledSchema>();
+    SchemaCompiler compiler(schema, *compiled);
+    if (!compiler.compile(error_msg)) {
+        return nullptr;
+    }
+    return compiled;
+}
+
+std::shared_ptr<const CompiledSchema> CompiledSchema::compileFile(const std::string& path,
+                                                                  std::string& error_msg) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        error_msg = "Cannot open schema file: " + path;
+        return nullptr;
+    }
+
+    try {
+        return compile(nlohmann::json::parse(file), error_msg);
+    } catch (const std::exception& e) {
+        error_msg = "Invalid schema JSON in " + path + ": " + e.what();
+        return nullptr;
+    }
+}
+
+namespace {
+
+using json = nlohmann::json;
+
+// SAX handler that validates against a CompiledSchema while (optionally)
+// building the DOM.
+//
+// Every value is checked by a set of evaluations: one per subschema it must
+// satisfy, plus one per oneOf branch of those. A failed evaluation that is not
+// a oneOf branch fails its owner in the enclosing container immediately, so a
+// bad document aborts the parse at the first violation; oneOf branches are
+// counted when the value ends.
+class SchemaSaxValidator : public nlohmann::json_sax<json> {
+public:
+    SchemaSaxValidator(const CompiledSchema& schema, json* document)
+        : schema_(schema), document_(document) {
+        // Frame 0 holds the evaluation for the whole document
+        frames_.emplace_back();
+        frames_[0].evals.emplace_back(-1, -1, -1);
+    }
+
+    bool valid() const { return frames_[0].evals[0].valid && complete_; }
+    const std::string& error() const { return frames_[0].evals[0].error; }
+
+    bool null() override {
+        beginValue(scratch_);
+        for (size_t i = 0; i < scratch_.size(); ++i) {
+            checkScalar(scratch_, i, CompiledSchema::TYPE_NULL, "null", [&] { return json(nullptr); });
+        }
+        return endScalar(json(nullptr));
+    }
+
+    bool boolean(bool value) override {
+        beginValue(scratch_);
+        for (size_t i = 0; i < scratch_.size(); ++i) {
+            checkScalar(scratch_, i, CompiledSchema::TYPE_BOOLEAN, "boolean", [&] { return json(value); });
+        }
+        return endScalar(json(value));
+    }
+
+    bool number_integer(json::number_integer_t value) override {
+        return number(static_cast<double>(value), true, json(value));
+    }
+
+    bool number_unsigned(json::number_unsigned_t value) override {
+        return number(static_cast<double>(value), true, json(value));
+    }
+
+    bool number_float(json::number_float_t value, const json::string_t& /*raw*/) override {
+        return number(value, std::isfinite(value) && std::floor(value) == value, json(value));
+    }
+
+    bool string(json::string_t& value) override {
+        beginValue(scratch_);
+        for (size_t i = 0; i < scratch_.size(); ++i) {
+            if (!checkScalar(scratch_, i, CompiledSchema::TYPE_STRING, "string", [&] { return json(value); })) {
+                continue;
+            }
+            const auto& node = schema_.node(scratch_[i].node);
+            if (node.min_length || node.max_length) {
+                size_t length = codePoints(value);
+                if (node.min_length && length < *node.min_length) {
+                    fail(scratch_, i, frames_.size() - 1,
+                         "string shorter than minLength " + std::to_string(*node.min_length));
+                    continue;
+                }
+                if (node.max_length && length > *node.max_length) {
+                    fail(scratch_, i, frames_.size() - 1,
+                         "string longer than maxLength " + std::to_string(*node.max_length));
+                    continue;
+                }
+            }
+            if (node.pattern && !std::regex_search(value, *node.pattern)) {
+                fail(scratch_, i, frames_.size() - 1, "string does not match pattern " + node.pattern_source);
+            }
+        }
+        return endScalar(document_ ? json(std::move(value)) : json());
+    }
+
+    bool binary(json::binary_t& /*value*/) override {
+        return false;  // Not produced by the text parser
+    }
+
+    bool start_object(std::size_t /*elements*/) override {
+        return startContainer(true, CompiledSchema::TYPE_OBJECT, "object");
+    }
+
+    bool key(json::string_t& name) override {
+        Frame& frame = frames_.back();
+        for (auto& eval : frame.evals) {
+            if (!eval.valid || eval.node < 0) continue;
+            const auto& properties = schema_.node(eval.node).properties;
+            auto it = properties.find(name);
+            if (it != properties.end() && it->second.required_bit >= 0) {
+                eval.required_seen |= uint64_t(1) << it->second.required_bit;
+            }
+        }
+        frame.key = std::move(name);
+        return !failed();
+    }
+
+    bool end_object() override {
+        size_t depth = frames_.size() - 1;
+        Frame& frame = frames_.back();
+        for (size_t i = 0; i < frame.evals.size(); ++i) {
+            const Eval& eval = frame.evals[i];
+            if (!eval.valid || eval.node < 0) continue;
+            const auto& node = schema_.node(eval.node);
+            for (size_t bit = 0; bit < node.required.size(); ++bit) {
+                if (!(eval.required_seen & (uint64_t(1) << bit))) {
+                    fail(frame.evals, i, depth - 1, "missing required property \"" + node.required[bit] + "\"", depth);
+                    break;
+                }
+            }
+        }
+        return endContainer();
+    }
+
+    bool start_array(std::size_t /*elements*/) override {
+        return startContainer(false, CompiledSchema::TYPE_ARRAY, "array");
+    }
+
+    bool end_array() override {
+        size_t depth = frames_.size() - 1;
+        Frame& frame = frames_.back();
+        for (size_t i = 0; i < frame.evals.size(); ++i) {
+            const Eval& eval = frame.evals[i];
+            if (!eval.valid || eval.node < 0) continue;
+            const auto& node = schema_.node(eval.node);
+            if (node.min_items && frame.index < *node.min_items) {
+                fail(frame.evals, i, depth - 1,
+                     "array has fewer than " + std::to_string(*node.min_items) + " items", depth);
+            }
+        }
+        return endContainer();
+    }
+
+    bool parse_error(std::size_t /*position*/, const std::string& /*last_token*/,
+                     const nlohmann::detail::exception& ex) override {
+        Eval& root = frames_[0].evals[0];
+        if (root.valid) {
+            root.valid = false;
+            root.error = std::string("Invalid JSON: ") + ex.what();
+        }
+        return false;
+    }
+
+private:
+    struct Eval {
+        Eval(int32_t node_index, int32_t parent_index, int32_t owner_index)
+            : node(node_index), parent(parent_index), owner(owner_index) {}
+
+        int32_t node;     // Schema node, or -1 if unconstrained
+        int32_t parent;   // oneOf evaluation this is a branch of, or -1
+        int32_t owner;    // Evaluation in the enclosing frame (non-branches only)
+        bool valid = true;
+        int32_t matched = 0;        // Valid oneOf branches
+        uint64_t required_seen = 0;
+        std::string error;
+    };
+
+    struct Frame {
+        std::vector<Eval> evals;
+        bool is_object = false;
+        size_t index = 0;  // Items seen so far (arrays)
+        std::string key;   // Current member name (objects)
+        json* dom = nullptr;
+    };
+
+    const CompiledSchema& schema_;
+    json* document_;
+    std::vector<Frame> frames_;
+    std::vector<Eval> scratch_;
+    bool complete_ = false;
+
+    bool failed() const { return !frames_[0].evals[0].valid; }
+
+    // JSON pointer of the value held by frames_[depth - 1]'s current slot
+    std::string pointer(size_t depth) const {
+        std::string path;
+        for (size_t d = 1; d < depth; ++d) {
+            const Frame& frame = frames_[d];
+            path += '/';
+            if (frame.is_object) {
+                for (char c : frame.key) {
+                    if (c == '~') path += "~0";
+                    else if (c == '/') path += "~1";
+                    else path += c;
+                }
+            } else {
+                path += std::to_string(frame.index - 1);
+            }
+        }
+        return path.empty() ? "/" : path;
+    }
+
+    // Mark evals[index] invalid; non-branch failures propagate to the owner
+    // in frames_[owner_depth]. location is the frame depth used for the pointer.
+    void fail(std::vector<Eval>& evals, size_t index, size_t owner_depth, const std::string& reason,
+              size_t location = 0) {
+        Eval& eval = evals[index];
+        if (!eval.valid) return;
+        eval.valid = false;
+        eval.error = pointer(location ? location : frames_.size()) + ": " + reason;
+        propagate(eval, owner_depth);
+    }
+
+    void propagate(const Eval& eval, size_t owner_depth) {
+        const Eval* current = &eval;
+        while (current->parent < 0 && current->owner >= 0) {
+            Eval& owner = frames_[owner_depth].evals[current->owner];
+            if (!owner.valid) return;
+            owner.valid = false;
+            owner.error = current->error;
+            current = &owner;
+            if (owner_depth == 0) return;
+            owner_depth--;
+        }
+    }
+
+    void expand(std::vector<Eval>& evals, int32_t node, int32_t owner, int32_t parent) {
+        int32_t index = static_cast<int32_t>(evals.size());
+        evals.emplace_back(node, parent, parent < 0 ? owner : -1);
+        for (int32_t branch : schema_.node(node).one_of) {
+            expand(evals, branch, owner, index);
+        }
+    }
+
+    // Evaluations the next value must satisfy, derived from the enclosing container
+    void beginValue(std::vector<Eval>& evals) {
+        evals.clear();
+        size_t depth = frames_.size() - 1;
+        Frame& frame = frames_.back();
+
+        if (depth == 0) {
+            expand(evals, schema_.root(), 0, -1);
+            return;
+        }
+
+        if (!frame.is_object) {
+            frame.index++;
+            for (size_t i = 0; i < frame.evals.size(); ++i) {
+                if (!frame.evals[i].valid || frame.evals[i].node < 0) continue;
+                const auto& node = schema_.node(frame.evals[i].node);
+                if (node.max_items && frame.index > *node.max_items) {
+                    fail(frame.evals, i, depth - 1,
+                         "array has more than " + std::to_string(*node.max_items) + " items", depth);
+                    continue;
+                }
+                if (node.items >= 0) {
+                    expand(evals, node.items, static_cast<int32_t>(i), -1);
+                }
+            }
+            return;
+        }
+
+        for (size_t i = 0; i < frame.evals.size(); ++i) {
+            if (!frame.evals[i].valid || frame.evals[i].node < 0) continue;
+            const auto& properties = schema_.node(frame.evals[i].node).properties;
+            auto it = properties.find(frame.key);
+            if (it != properties.end() && it->second.node >= 0) {
+                expand(evals, it->second.node, static_cast<int32_t>(i), -1);
+            }
+        }
+    }
+
+    // Type and enum check shared by all scalars; returns false if the eval is (now) invalid
+    template <typename MakeValue>
+    bool checkScalar(std::vector<Eval>& evals, size_t index, uint8_t type_bit, const char* type_name,
+                     MakeValue&& make_value) {
+        Eval& eval = evals[index];
+        if (!eval.valid || eval.node < 0) return false;
+        const auto& node = schema_.node(eval.node);
+        if (!(node.types & type_bit)) {
+            fail(evals, index, frames_.size() - 1, std::string("unexpected ") + type_name);
+            return false;
+        }
+        if (!node.enum_values.empty()) {
+            json value = make_value();
+            bool found = false;
+            for (const auto& allowed : node.enum_values) {
+                if (allowed == value) {
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) {
+                fail(evals, index, frames_.size() - 1, "value " + value.dump() + " is not allowed");
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool number(double value, bool integral, json&& dom_value) {
+        beginValue(scratch_);
+        uint8_t type_bit = integral ? CompiledSchema::TYPE_INTEGER : CompiledSchema::TYPE_NUMBER;
+        for (size_t i = 0; i < scratch_.size(); ++i) {
+            if (!checkScalar(scratch_, i, type_bit, integral ? "integer" : "number",
+                             [&] { return dom_value; })) {
+                continue;
+            }
+            const auto& node = schema_.node(scratch_[i].node);
+            if (node.minimum && value < *node.minimum) {
+                fail(scratch_, i, frames_.size() - 1, "value below minimum " + json(*node.minimum).dump());
+            } else if (node.maximum && value > *node.maximum) {
+                fail(scratch_, i, frames_.size() - 1, "value above maximum " + json(*node.maximum).dump());
+            }
+        }
+        return endScalar(std::move(dom_value));
+    }
+
+    // Count matching oneOf branches (children before parents)
+    void resolveOneOf(std::vector<Eval>& evals, size_t owner_depth, size_t location) {
+        for (size_t i = evals.size(); i-- > 0;) {
+            Eval& eval = evals[i];
+            if (eval.valid && eval.node >= 0 && !schema_.node(eval.node).one_of.empty() && eval.matched != 1) {
+                std::string reason = "value matches more than one oneOf alternative";
+                if (eval.matched == 0) {
+                    reason = "value matches none of the oneOf alternatives";
+                    std::string separator = " (";
+                    for (size_t j = i + 1; j < evals.size(); ++j) {
+                        if (evals[j].parent == static_cast<int32_t>(i)) {
+                            reason += separator + evals[j].error;
+                            separator = "; ";
+                        }
+                    }
+                    reason += ")";
+                }
+                fail(evals, i, owner_depth, reason, location);
+            }
+            if (eval.parent >= 0 && eval.valid) {
+                evals[eval.parent].matched++;
+            }
+        }
+    }
+
+    json* addValue(json&& value) {
+        Frame& frame = frames_.back();
+        if (frames_.size() == 1) {
+            *document_ = std::move(value);
+            return document_;
+        }
+        if (frame.is_object) {
+            json& slot = (*frame.dom)[frame.key];
+            slot = std::move(value);
+            return &slot;
+        }
+        frame.dom->push_back(std::move(value));
+        return &frame.dom->back();
+    }
+
+    bool endScalar(json&& value) {
+        resolveOneOf(scratch_, frames_.size() - 1, frames_.size());
+        if (frames_.size() == 1) complete_ = true;
+        if (document_ && !failed()) addValue(std::move(value));
+        return !failed();
+    }
+
+    bool startContainer(bool is_object, uint8_t type_bit, const char* type_name) {
+        Frame frame;
+        frame.is_object = is_object;
+        beginValue(frame.evals);
+        for (size_t i = 0; i < frame.evals.size(); ++i) {
+            Eval& eval = frame.evals[i];
+            if (eval.valid && eval.node >= 0 && !(schema_.node(eval.node).types & type_bit)) {
+                fail(frame.evals, i, frames_.size() - 1, std::string("unexpected ") + type_name);
+            }
+        }
+        if (document_ && !failed()) {
+            frame.dom = addValue(is_object ? json::object() : json::array());
+        }
+        frames_.push_back(std::move(frame));
+        return !failed();
+    }
+
+    bool endContainer() {
+        size_t depth = frames_.size() - 1;
+        resolveOneOf(frames_.back().evals, depth - 1, depth);
+        frames_.pop_back();
+        if (frames_.size() == 1) complete_ = true;
+        return !failed();
+    }
+
+    static size_t codePoints(const std::string& value) {
+        size_t count = 0;
+        for (unsigned char c : value) {
+            if ((c & 0xC0) != 0x80) count++;
+        }
+        return count;
+    }
+};
+
+} // namespace
+
+class SchemaEventValidator::Impl {
+public:
+    explicit Impl(const CompiledSchema& schema) : validator(schema, nullptr) {}
+
+    SchemaSaxValidator validator;
+};
+
+SchemaEventValidator::SchemaEventValidator(const CompiledSchema& schema)
+    : impl_(std::make_unique<Impl>(schema)) {}
+
+SchemaEventValidator::~SchemaEventValidator() = default;
+
+nlohmann::json_sax<nlohmann::json>* SchemaEventValidator::handler() {
+    return &impl_->validator;
+}
+
+bool SchemaEventValidator::valid() const {
+    return impl_->validator.valid();
+}
+
+const std::string& SchemaEventValidator::error() const {
+    return impl_->validator.error();
+}
+
+SchemaValidationResult validateWithSchema(const CompiledSchema& schema,
+                                          const std::string& json_str,
+                                          bool build_document) {
+    SchemaValidationResult result;
+    json document;
+    SchemaSaxValidator validator(schema, build_document ? &document : nullptr);
+
+    bool parsed = json::sax_parse(json_str, &validator);
+    result.valid = parsed && validator.valid();
+    if (result.valid) {
+        result.document = std::move(document);
+    } else {
+        result.error_message = validator.error().empty() ? "Invalid JSON" : validator.error();
+    }
+    return result;
+}
+
+} // namespace core
+} // namespace studyhive
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <regex>
+#include <optional>
+#include <unordered_map>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+
+namespace studyhive {
+namespace core {
+
+// JSON Schema (draft-07) compiled into a flat node table for single-pass
+// SAX validation. Supports the keywords used by core/schemas: type, enum,
+// const, required, properties, items, oneOf, $ref (local), min/maxItems,
+// min/maxLength, minimum/maximum and pattern. Annotations (description,
+// title, format) are ignored.
+class CompiledSchema {
+public:
+    // Compile a schema document; returns nullptr and sets error_msg on failure
+    static std::shared_ptr<const CompiledSchema> compile(const nlohmann::json& schema,
+                                                         std::string& error_msg);
+
+    // Load and compile a .json schema file
+    static std::shared_ptr<const CompiledSchema> compileFile(const std::string& path,
+                                                             std::string& error_msg);
+
+    enum TypeBits : uint8_t {
+        TYPE_NULL = 1 << 0,
+        TYPE_BOOLEAN = 1 << 1,
+        TYPE_INTEGER = 1 << 2,
+        TYPE_NUMBER = 1 << 3,  // Also admits integers
+        TYPE_STRING = 1 << 4,
+        TYPE_ARRAY = 1 << 5,
+        TYPE_OBJECT = 1 << 6,
+        TYPE_ANY = 0x7f
+    };
+
+    struct Property {
+        int32_t node = -1;          // Subschema, or -1 if unconstrained
+        int32_t required_bit = -1;  // Index into Node::required, or -1
+    };
+
+    struct Node {
+        uint8_t types = TYPE_ANY;
+        std::vector<nlohmann::json> enum_values;  // enum and const (scalars only)
+        std::vector<std::string> required;
+        std::unordered_map<std::string, Property> properties;
+        int32_t items = -1;
+        std::vector<int32_t> one_of;
+        std::optional<size_t> min_items;
+        std::optional<size_t> max_items;
+        std::optional<size_t> min_length;
+        std::optional<size_t> max_length;
+        std::optional<double> minimum;
+        std::optional<double> maximum;
+        std::string pattern_source;
+        std::optional<std::regex> pattern;
+    };
+
+    int32_t root() const { return root_; }
+    const Node& node(int32_t index) const { return nodes_[index]; }
+    size_t nodeCount() const { return nodes_.size(); }
+
+private:
+    std::vector<Node> nodes_;
+    int32_t root_ = -1;
+
+    friend class SchemaCompiler;
+};
+
+struct SchemaValidationResult {
+    bool valid = false;
+    std::string error_message;  // "<json pointer>: <reason>" on failure
+    nlohmann::json document;    // Built in the same pass; null unless valid
+};
+
+// Parse and validate in one streaming pass. The DOM is only materialized
+// when build_document is set.
+SchemaValidationResult validateWithSchema(const CompiledSchema& schema,
+                                          const std::string& json_str,
+                                          bool build_document = true);
+
+// Validation driven by another parser's SAX events, e.g. a quiz_io reader's
+// observer, so a typed payload is read and validated in the same pass.
+// valid() is only true once a complete document was seen.
+class SchemaEventValidator {
+public:
+    explicit SchemaEventValidator(const CompiledSchema& schema);
+    ~SchemaEventValidator();
+
+    nlohmann::json_sax<nlohmann::json>* handler();
+    bool valid() const;
+    const std::string& error() const;  // First violation; empty if none was seen
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace core
+} // namespace studyhive
@@ -0,0 +1,381 @@
+#include "memory_governor.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <condition_variable>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace studyhive {
+namespace core {
+
+struct MemoryRegistration::State {
+    std::function<void()> unregister;
+};
+
+MemoryRegistration::MemoryRegistration(std::shared_ptr<State> state) : state_(std::move(state)) {}
+
+MemoryRegistration::~MemoryRegistration() {
+    if (state_ && state_->unregister) {
+        state_->unregister();
+    }
+}
+
+class MemoryGovernor::Impl {
+public:
+    explicit Impl(const MemoryGovernorConfig& config) : config_(config) {}
+
+    ~Impl() {
+        stopMonitor();
+    }
+
+    uint64_t add(const MemoryConsumer& consumer) {
+        auto entry = std::make_shared<Entry>();
+        entry->consumer = consumer;
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t id = ++next_id_;
+        consumers_[id] = std::move(entry);
+        return id;
+    }
+
+    // Waits for a running reclaim, so the consumer's callbacks are not in use
+    // when this returns. The mutex is recursive for shrink callbacks that
+    // destroy their own registration (e.g. unloading a model).
+    void remove(uint64_t id) {
+        std::lock_guard<std::recursive_mutex> callbacks(callback_mutex_);
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = consumers_.find(id);
+        if (it != consumers_.end()) {
+            it->second->active = false;
+            consumers_.erase(it);
+        }
+    }
+
+    void startMonitor() {
+        if (config_.poll_interval_ms <= 0) return;
+        monitor_ = std::thread([this]() {
+            std::unique_lock<std::mutex> lock(monitor_mutex_);
+            while (!stopping_) {
+                monitor_cv_.wait_for(lock, std::chrono::milliseconds(config_.poll_interval_ms));
+                if (stopping_) break;
+                lock.unlock();
+                check();
+                lock.lock();
+            }
+        });
+    }
+
+    void stopMonitor() {
+        {
+            std::lock_guard<std::mutex> lock(monitor_mutex_);
+            stopping_ = true;
+        }
+        monitor_cv_.notify_all();
+        if (monitor_.joinable()) {
+            monitor_.join();
+        }
+    }
+
+    size_t check() {
+        std::lock_guard<std::recursive_mutex> callbacks(callback_mutex_);
+        size_t tracked = trackedBytes();
+        MemoryGovernorConfig config = currentConfig();
+
+        memory_probe::SystemMemory system;
+        bool have_system = memory_probe::readSystemMemory(config.cgroup_path, system);
+
+        size_t limit = config.limit_bytes;
+        size_t used = tracked;
+        std::string source = "config";
+        if (limit == 0) {
+            limit = have_system ? system.limit_bytes : 0;
+            used = have_system ? system.used_bytes : tracked;
+            source = limit > 0 ? system.source : "";
+        }
+
+        MemoryPressure pressure = MemoryPressure::NONE;
+        size_t to_free = 0;
+        if (limit > 0 && used > static_cast<size_t>(config.high_watermark * limit)) {
+            pressure = used >= limit ? MemoryPressure::CRITICAL : MemoryPressure::MODERATE;
+            to_free = used - static_cast<size_t>(config.low_watermark * limit);
+        }
+        // PSI says tasks are stalling on memory but not how much to free: give
+        // back a slice per check until the stalls stop
+        if (system.has_psi && system.psi_some_avg10 >= config.psi_threshold) {
+            MemoryPressure psi_pressure = system.psi_full_avg10 >= config.psi_threshold
+                ? MemoryPressure::CRITICAL : MemoryPressure::MODERATE;
+            pressure = std::max(pressure, psi_pressure);
+            to_free = std::max(to_free, static_cast<size_t>(tracked * config.psi_reclaim_fraction));
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            last_.limit_bytes = limit;
+            last_.used_bytes = used;
+            last_.limit_source = source;
+            last_.pressure = pressure;
+            last_.psi_some_avg10 = system.psi_some_avg10;
+            last_.psi_full_avg10 = system.psi_full_avg10;
+        }
+
+        return to_free > 0 ? reclaim(to_free) : 0;
+    }
+
+    size_t reclaim(size_t bytes) {
+        std::lock_guard<std::recursive_mutex> callbacks(callback_mutex_);
+
+        // Lowest tier first; within a tier the largest consumer first
+        std::vector<std::pair<std::shared_ptr<Entry>, size_t>> order;
+        for (const auto& entry : snapshot()) {
+            order.emplace_back(entry, entry->consumer.usage ? entry->consumer.usage() : 0);
+        }
+        std::sort(order.begin(), order.end(), [](const auto& a, const auto& b) {
+            if (a.first->consumer.tier != b.first->consumer.tier) {
+                return a.first->consumer.tier < b.first->consumer.tier;
+            }
+            return a.second > b.second;
+        });
+
+        size_t freed = 0;
+        for (const auto& [entry, usage] : order) {
+            if (freed >= bytes) break;
+            // An earlier callback may have unregistered this one
+            if (!entry->active || usage == 0 || !entry->consumer.shrink) continue;
+            size_t released = entry->consumer.shrink(bytes - freed);
+            freed += released;
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            entry->reclaimed_bytes += released;
+            entry->shrink_calls++;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        last_.reclaimed_bytes += freed;
+        last_.reclaim_runs++;
+        return freed;
+    }
+
+    void setLimit(size_t bytes) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        config_.limit_bytes = bytes;
+    }
+
+    MemoryReport getReport() {
+        std::lock_guard<std::recursive_mutex> callbacks(callback_mutex_);
+        std::vector<ConsumerUsage> consumers;
+        size_t tracked = 0;
+        for (const auto& entry : snapshot()) {
+            ConsumerUsage usage;
+            usage.name = entry->consumer.name;
+            usage.tier = entry->consumer.tier;
+            usage.bytes = entry->consumer.usage ? entry->consumer.usage() : 0;
+            tracked += usage.bytes;
+            std::lock_guard<std::mutex> lock(mutex_);
+            usage.reclaimed_bytes = entry->reclaimed_bytes;
+            usage.shrink_calls = entry->shrink_calls;
+            consumers.push_back(std::move(usage));
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        MemoryReport report = last_;
+        report.tracked_bytes = tracked;
+        report.consumers = std::move(consumers);
+        return report;
+    }
+
+private:
+    struct Entry {
+        MemoryConsumer consumer;
+        bool active = true;
+        size_t reclaimed_bytes = 0;
+        int shrink_calls = 0;
+    };
+
+    MemoryGovernorConfig config_;
+    mutable std::mutex mutex_;
+    std::map<uint64_t, std::shared_ptr<Entry>> consumers_;
+    uint64_t next_id_ = 0;
+    MemoryReport last_;
+
+    // Held while any consumer callback runs
+    std::recursive_mutex callback_mutex_;
+
+    std::thread monitor_;
+    std::mutex monitor_mutex_;
+    std::condition_variable monitor_cv_;
+    bool stopping_ = false;
+
+    MemoryGovernorConfig currentConfig() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return config_;
+    }
+
+    std::vector<std::shared_ptr<Entry>> snapshot() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<std::shared_ptr<Entry>> entries;
+        for (const auto& [id, entry] : consumers_) {
+            entries.push_back(entry);
+        }
+        return entries;
+    }
+
+    // Caller holds callback_mutex_
+    size_t trackedBytes() const {
+        size_t total = 0;
+        for (const auto& entry : snapshot()) {
+            if (entry->consumer.usage) total += entry->consumer.usage();
+        }
+        return total;
+    }
+};
+
+MemoryGovernor::MemoryGovernor(const MemoryGovernorConfig& config)
+    : impl_(std::make_shared<Impl>(config)) {
+    impl_->startMonitor();
+}
+
+MemoryGovernor::~MemoryGovernor() {
+    impl_->stopMonitor();
+}
+
+std::unique_ptr<MemoryRegistration> MemoryGovernor::registerConsumer(const MemoryConsumer& consumer) {
+    uint64_t id = impl_->add(consumer);
+    auto state = std::make_shared<MemoryRegistration::State>();
+    state->unregister = [governor = std::weak_ptr<Impl>(impl_), id]() {
+        if (auto impl = governor.lock()) {
+            impl->remove(id);
+        }
+    };
+    return std::unique_ptr<MemoryRegistration>(new MemoryRegistration(std::move(state)));
+}
+
+size_t MemoryGovernor::check() {
+    return impl_->check();
+}
+
+size_t MemoryGovernor::reclaim(size_t bytes) {
+    return impl_->reclaim(bytes);
+}
+
+void MemoryGovernor::setLimit(size_t bytes) {
+    impl_->setLimit(bytes);
+}
+
+MemoryReport MemoryGovernor::getReport() const {
+    return impl_->getReport();
+}
+
+namespace memory_probe {
+
+namespace {
+
+bool readText(const std::string& path, std::string& text) {
+    std::ifstream file(path);
+    if (!file) return false;
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    text = buffer.str();
+    return true;
+}
+
+// False for "max" and v1's "unlimited" (a page-rounded LONG_MAX)
+bool readBytes(const std::string& path, size_t& value) {
+    std::string text;
+    if (!readText(path, text) || text.empty() || !std::isdigit(static_cast<unsigned char>(text[0]))) {
+        return false;
+    }
+    unsigned long long parsed = std::stoull(text);
+    if (parsed >= (1ull << 60)) return false;
+    value = static_cast<size_t>(parsed);
+    return true;
+}
+
+// /sys/fs/cgroup plus the unified ("0::") path from /proc/self/cgroup
+std::string ownCgroupPath() {
+    std::ifstream file("/proc/self/cgroup");
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.rfind("0::", 0) == 0) {
+            return "/sys/fs/cgroup" + line.substr(3);
+        }
+    }
+    return "/sys/fs/cgroup";
+}
+
+} // namespace
+
+bool parsePressure(const std::string& text, float& some_avg10, float& full_avg10) {
+    bool found = false;
+    std::istringstream lines(text);
+    std::string line;
+    while (std::getline(lines, line)) {
+        size_t pos = line.find("avg10=");
+        if (pos == std::string::npos) continue;
+        float value = std::strtof(line.c_str() + pos + 6, nullptr);
+        if (line.rfind("some", 0) == 0) {
+            some_avg10 = value;
+            found = true;
+        } else if (line.rfind("full", 0) == 0) {
+            full_avg10 = value;
+        }
+    }
+    return found;
+}
+
+bool readSystemMemory(const std::string& cgroup_path, SystemMemory& memory) {
+#ifdef __linux__
+    memory = SystemMemory();
+    std::string root = cgroup_path.empty() ? ownCgroupPath() : cgroup_path;
+
+    try {
+        // cgroup v2, then v1
+        if (readBytes(root + "/memory.max", memory.limit_bytes) &&
+            readBytes(root + "/memory.current", memory.used_bytes)) {
+            memory.source = "cgroup";
+        } else if (readBytes("/sys/fs/cgroup/memory/memory.limit_in_bytes", memory.limit_bytes) &&
+                   readBytes("/sys/fs/cgroup/memory/memory.usage_in_bytes", memory.used_bytes)) {
+            memory.source = "cgroup";
+        } else {
+            // One "Key: value [kB]" per line; some lines (HugePages_*) have no unit
+            std::ifstream meminfo("/proc/meminfo");
+            std::string line;
+            size_t total_kb = 0;
+            size_t available_kb = 0;
+            while (std::getline(meminfo, line)) {
+                std::istringstream fields(line);
+                std::string key;
+                size_t value_kb = 0;
+                if (!(fields >> key >> value_kb)) continue;
+                if (key == "MemTotal:") total_kb = value_kb;
+                if (key == "MemAvailable:") available_kb = value_kb;
+            }
+            if (total_kb > 0) {
+                memory.limit_bytes = total_kb * 1024;
+                memory.used_bytes = (total_kb - std::min(available_kb, total_kb)) * 1024;
+                memory.source = "meminfo";
+            }
+        }
+    } catch (const std::exception&) {
+        memory.limit_bytes = 0;
+        memory.source.clear();
+    }
+
+    std::string pressure;
+    if (readText(root + "/memory.pressure", pressure) || readText("/proc/pressure/memory", pressure)) {
+        memory.has_psi = parsePressure(pressure, memory.psi_some_avg10, memory.psi_full_avg10);
+    }
+    return memory.limit_bytes > 0 || memory.has_psi;
+#else
+    (void)cgroup_path;
+    memory = SystemMemory();
+    return false;
+#endif
+}
+
+} // namespace memory_probe
+
+} // namespace core
+} // namespace studyhive
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+namespace studyhive {
+namespace core {
+
+// Reclaim order under pressure: lower tiers give memory back first
+enum class ReclaimTier {
+    CACHE = 0,       // Result caches and lookup indexes (KVStore, WordNetAdapter)
+    KV_CONTEXT = 1,  // LLM KV cache of an idle context
+    IDLE_MODEL = 2   // Weights of a model with no request in flight
+};
+
+enum class MemoryPressure {
+    NONE,
+    MODERATE,  // Above the high watermark, or PSI stalls above the threshold
+    CRITICAL   // At the limit, or PSI reports full stalls
+};
+
+struct MemoryConsumer {
+    std::string name;
+    ReclaimTier tier = ReclaimTier::CACHE;
+    std::function<size_t()> usage;                    // Bytes currently held
+    std::function<size_t(size_t bytes)> shrink;       // Free about bytes; returns bytes freed
+};
+
+struct MemoryGovernorConfig {
+    size_t limit_bytes = 0;             // 0: cgroup memory.max, else physical RAM
+    float high_watermark = 0.90f;       // Reclaim once usage passes this fraction of the limit
+    float low_watermark = 0.80f;        // ... down to this fraction
+    float psi_threshold = 10.0f;        // memory.pressure "some avg10" (%) treated as pressure
+    float psi_reclaim_fraction = 0.10f; // Of tracked bytes, per check while PSI is above the threshold
+    int poll_interval_ms = 2000;        // Background check; 0: only explicit check() calls
+    std::string cgroup_path;            // Empty: this process's cgroup under /sys/fs/cgroup
+};
+
+struct ConsumerUsage {
+    std::string name;
+    ReclaimTier tier = ReclaimTier::CACHE;
+    size_t bytes = 0;
+    size_t reclaimed_bytes = 0;  // Freed by shrink calls so far
+    int shrink_calls = 0;
+};
+
+struct MemoryReport {
+    size_t limit_bytes = 0;
+    size_t used_bytes = 0;       // Tracked bytes with a configured limit, else the cgroup or system figure
+    size_t tracked_bytes = 0;    // Sum over registered consumers
+    std::string limit_source;    // "config", "cgroup", "meminfo" or empty
+    MemoryPressure pressure = MemoryPressure::NONE;
+    float psi_some_avg10 = 0.0f;
+    float psi_full_avg10 = 0.0f;
+    std::vector<ConsumerUsage> consumers;
+    size_t reclaimed_bytes = 0;
+    int reclaim_runs = 0;
+};
+
+// Handle of a registered consumer. Destroying it unregisters the consumer;
+// once the destructor returns its callbacks are never called again. Safe to
+// destroy from inside a shrink callback and after the governor is gone.
+class MemoryRegistration {
+public:
+    ~MemoryRegistration();
+
+    MemoryRegistration(const MemoryRegistration&) = delete;
+    MemoryRegistration& operator=(const MemoryRegistration&) = delete;
+
+private:
+    friend class MemoryGovernor;
+    struct State;
+    explicit MemoryRegistration(std::shared_ptr<State> state);
+    std::shared_ptr<State> state_;
+};
+
+// One memory budget for every subsystem that holds large allocations. Each
+// registers its usage and a shrink callback; on pressure the governor reclaims
+// tier by tier (largest consumer first within a tier) until usage is back
+// under the low watermark. Pressure comes from the configured limit or, on
+// Linux, from the cgroup (memory.max/current, memory.pressure) or /proc.
+class MemoryGovernor {
+public:
+    explicit MemoryGovernor(const MemoryGovernorConfig& config = MemoryGovernorConfig());
+    ~MemoryGovernor();
+
+    std::unique_ptr<MemoryRegistration> registerConsumer(const MemoryConsumer& consumer);
+
+    // Sample pressure now and reclaim if needed; returns bytes freed
+    size_t check();
+
+    // Free at least bytes, lowest tier first; returns bytes freed
+    size_t reclaim(size_t bytes);
+
+    void setLimit(size_t bytes);
+
+    // Per-consumer usage (sampled now) and the last pressure reading
+    MemoryReport getReport() const;
+
+private:
+    class Impl;
+    std::shared_ptr<Impl> impl_;
+};
+
+namespace memory_probe {
+
+struct SystemMemory {
+    size_t limit_bytes = 0;   // 0: unknown
+    size_t used_bytes = 0;
+    std::string source;       // "cgroup" or "meminfo"
+    bool has_psi = false;
+    float psi_some_avg10 = 0.0f;
+    float psi_full_avg10 = 0.0f;
+};
+
+// Linux only; false elsewhere or when nothing could be read
+bool readSystemMemory(const std::string& cgroup_path, SystemMemory& memory);
+
+// Parse the avg10 fields of a PSI file ("some avg10=1.23 ...\nfull avg10=...")
+bool parsePressure(const std::string& text, float& some_avg10, float& full_avg10);
+
+} // namespace memory_probe
+
+} // namespace core
+} // namespace studyhive
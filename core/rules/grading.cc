@@ -19,24 +19,33 @@ public:
         return true;
     }
 
-    GradingResult gradeMultipleChoice(const nlohmann::json& question,
+    GradingResult grade(const Question& question, const std::string& student_answer) {
+        if (auto* mcq = std::get_if<MultipleChoiceQuestion>(&question)) {
+            return gradeMultipleChoice(*mcq, student_answer);
+        }
+        if (auto* saq = std::get_if<ShortAnswerQuestion>(&question)) {
+            return gradeShortAnswer(*saq, student_answer);
+        }
+        return gradeFillInBlank(std::get<FillInBlankQuestion>(question), student_answer);
+    }
+
+    GradingResult gradeMultipleChoice(const MultipleChoiceQuestion& question,
                                     const std::string& student_answer) {
         auto start_time = std::chrono::high_resolution_clock::now();
         
         GradingResult result;
         result.max_score = 1.0f;
         
-        // Get correct answer
-        std::string correct_answer = question["correctAnswer"];
+        const std::string& correct_answer = question.correct_answer;
         
         // Simple exact match for multiple choice
         if (student_answer == correct_answer) {
             result.total_score = 1.0f;
-            result.feedback = "Correct! " + question["explanation"].get<std::string>();
+            result.feedback = "Correct! " + question.explanation;
         } else {
             result.total_score = 0.0f;
             result.feedback = "Incorrect. The correct answer is: " + correct_answer + 
-                            ". " + question["explanation"].get<std::string>();
+                            ". " + question.explanation;
         }
         
         // Add breakdown
@@ -56,7 +65,7 @@ public:
         return result;
     }
 
-    GradingResult gradeShortAnswer(const nlohmann::json& question,
+    GradingResult gradeShortAnswer(const ShortAnswerQuestion& question,
                                  const std::string& student_answer) {
         auto start_time = std::chrono::high_resolution_clock::now();
         
@@ -64,7 +73,7 @@ public:
         result.max_score = 0.0f;
         
         // Parse rubric
-        auto rubric = rubric::parseRubric(question["rubric"]);
+        auto rubric = rubric::parseRubric(question.rubric);
         
         float total_score = 0.0f;
         for (const auto& criterion : rubric) {
@@ -106,15 +115,14 @@ public:
         return result;
     }
 
-    GradingResult gradeFillInBlank(const nlohmann::json& question,
+    GradingResult gradeFillInBlank(const FillInBlankQuestion& question,
                                  const std::string& student_answer) {
         auto start_time = std::chrono::high_resolution_clock::now();
         
         GradingResult result;
         result.max_score = 1.0f;
         
-        // Get correct answer
-        std::string correct_answer = question["correctAnswer"];
+        const std::string& correct_answer = question.correct_answer;
         
         // Normalize answers for comparison
         std::string normalized_student = normalizeAnswer(student_answer);
@@ -145,13 +153,13 @@ public:
         
         // Generate feedback
         if (result.total_score >= 0.8f) {
-            result.feedback = "Correct! " + question["explanation"].get<std::string>();
+            result.feedback = "Correct! " + question.explanation;
         } else if (result.total_score >= 0.5f) {
             result.feedback = "Partially correct. The correct answer is: " + correct_answer + 
-                            ". " + question["explanation"].get<std::string>();
+                            ". " + question.explanation;
         } else {
             result.feedback = "Incorrect. The correct answer is: " + correct_answer + 
-                            ". " + question["explanation"].get<std::string>();
+                            ". " + question.explanation;
         }
         
         auto end_time = std::chrono::high_resolution_clock::now();
@@ -247,17 +255,21 @@ bool GradingEngine::initialize() {
     return impl_->initialize();
 }
 
-GradingResult GradingEngine::gradeMultipleChoice(const nlohmann::json& question,
+GradingResult GradingEngine::grade(const Question& question, const std::string& student_answer) {
+    return impl_->grade(question, student_answer);
+}
+
+GradingResult GradingEngine::gradeMultipleChoice(const MultipleChoiceQuestion& question,
                                                 const std::string& student_answer) {
     return impl_->gradeMultipleChoice(question, student_answer);
 }
 
-GradingResult GradingEngine::gradeShortAnswer(const nlohmann::json& question,
+GradingResult GradingEngine::gradeShortAnswer(const ShortAnswerQuestion& question,
                                             const std::string& student_answer) {
     return impl_->gradeShortAnswer(question, student_answer);
 }
 
-GradingResult GradingEngine::gradeFillInBlank(const nlohmann::json& question,
+GradingResult GradingEngine::gradeFillInBlank(const FillInBlankQuestion& question,
                                             const std::string& student_answer) {
     return impl_->gradeFillInBlank(question, student_answer);
 }
@@ -360,7 +372,7 @@ float calculateKeywordScore(const std::string& answer,
 }
 
 std::string generateFeedback(const GradingResult& result,
-                           const nlohmann::json& question) {
+                           const ShortAnswerQuestion& question) {
     std::string feedback = "Score: " + std::to_string(result.total_score) + 
                           "/" + std::to_string(result.max_score) + " points. ";
     
@@ -404,6 +416,30 @@ bool validateGradingResult(const GradingResult& result) {
     return true;
 }
 
+GradePayload toGradePayload(const GradingResult& result, const std::string& question_id) {
+    GradePayload payload;
+    payload.question_id = question_id;
+    payload.total_score = result.total_score;
+    payload.max_score = result.max_score;
+    payload.feedback = result.feedback;
+
+    for (const auto& criterion : result.breakdown) {
+        GradeBreakdownItem item;
+        item.criterion = criterion.criterion_name;
+        item.awarded_points = criterion.awarded_points;
+        item.max_points = criterion.max_points;
+        item.reasoning = criterion.reasoning;
+        item.keywords = criterion.found_keywords;
+        payload.breakdown.push_back(std::move(item));
+    }
+
+    GradeMetadata metadata;
+    metadata.source = "rules";
+    metadata.processing_time_ms = result.processing_time_ms;
+    payload.metadata = std::move(metadata);
+    return payload;
+}
+
 } // namespace grading
 
 // Rubric parsing utilities
@@ -439,6 +475,25 @@ GradingCriterion convertToCriterion(const nlohmann::json& criterion_json) {
     return criterion;
 }
 
+std::vector<GradingCriterion> parseRubric(const std::vector<RubricCriterion>& rubric) {
+    std::vector<GradingCriterion> criteria;
+    criteria.reserve(rubric.size());
+    
+    for (const auto& criterion : rubric) {
+        criteria.push_back(convertToCriterion(criterion));
+    }
+    
+    return criteria;
+}
+
+GradingCriterion convertToCriterion(const RubricCriterion& rubric_criterion) {
+    GradingCriterion criterion;
+    criterion.name = rubric_criterion.criterion;
+    criterion.max_points = rubric_criterion.points;
+    criterion.keywords = rubric_criterion.keywords;
+    return criterion;
+}
+
 bool validateRubric(const nlohmann::json& rubric_json) {
     if (!rubric_json.is_array()) {
         return false;
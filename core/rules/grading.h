@@ -4,6 +4,7 @@
 #include <vector>
 #include <memory>
 #include <nlohmann/json.hpp>
+#include "../types/quiz_types.h"
 
 namespace studyhive {
 namespace core {
@@ -16,14 +17,6 @@ struct GradingCriterion {
     float weight = 1.0f;
 };
 
-struct GradingResult {
-    float total_score;
-    float max_score;
-    std::vector<CriterionResult> breakdown;
-    std::string feedback;
-    float processing_time_ms;
-};
-
 struct CriterionResult {
     std::string criterion_name;
     float awarded_points;
@@ -33,6 +26,14 @@ struct CriterionResult {
     std::vector<std::string> missing_keywords;
 };
 
+struct GradingResult {
+    float total_score;
+    float max_score;
+    std::vector<CriterionResult> breakdown;
+    std::string feedback;
+    float processing_time_ms;
+};
+
 class GradingEngine {
 public:
     GradingEngine();
@@ -41,16 +42,19 @@ public:
     // Initialize the grading engine
     bool initialize();
 
+    // Grade an answer to any question type
+    GradingResult grade(const Question& question, const std::string& student_answer);
+
     // Grade a multiple choice answer
-    GradingResult gradeMultipleChoice(const nlohmann::json& question,
+    GradingResult gradeMultipleChoice(const MultipleChoiceQuestion& question,
                                     const std::string& student_answer);
 
     // Grade a short answer question
-    GradingResult gradeShortAnswer(const nlohmann::json& question,
+    GradingResult gradeShortAnswer(const ShortAnswerQuestion& question,
                                  const std::string& student_answer);
 
     // Grade a fill-in-the-blank answer
-    GradingResult gradeFillInBlank(const nlohmann::json& question,
+    GradingResult gradeFillInBlank(const FillInBlankQuestion& question,
                                  const std::string& student_answer);
 
     // Add custom grading criterion
@@ -84,11 +88,14 @@ float calculateKeywordScore(const std::string& answer,
 
 // Generate feedback based on grading results
 std::string generateFeedback(const GradingResult& result,
-                           const nlohmann::json& question);
+                           const ShortAnswerQuestion& question);
 
 // Validate grading result
 bool validateGradingResult(const GradingResult& result);
 
+// Convert to the wire payload (core/schemas/grade.json)
+GradePayload toGradePayload(const GradingResult& result, const std::string& question_id);
+
 } // namespace grading
 
 // Rubric parsing utilities
@@ -100,6 +107,10 @@ std::vector<GradingCriterion> parseRubric(const nlohmann::json& rubric_json);
 // Convert rubric to grading criteria
 GradingCriterion convertToCriterion(const nlohmann::json& criterion_json);
 
+// Typed equivalents of the above
+std::vector<GradingCriterion> parseRubric(const std::vector<RubricCriterion>& rubric);
+GradingCriterion convertToCriterion(const RubricCriterion& criterion);
+
 // Validate rubric format
 bool validateRubric(const nlohmann::json& rubric_json);
 
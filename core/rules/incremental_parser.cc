@@ -0,0 +1,242 @@
+#include "incremental_parser.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iterator>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace studyhive {
+namespace core {
+
+namespace {
+
+// Paragraphs are keyed by their text, looked up by view: a hit compares the
+// bytes, so equal hashes of different text never share a parse
+struct ParagraphHash {
+    using is_transparent = void;
+
+    size_t operator()(std::string_view text) const {
+        return std::hash<std::string_view>()(text);
+    }
+};
+
+struct CachedParagraph {
+    ParsedContent content;
+    size_t uses = 0;   // Occurrences in the current notes
+};
+
+using ParagraphCache = std::unordered_map<std::string, CachedParagraph, ParagraphHash, std::equal_to<>>;
+using Paragraph = ParagraphCache::value_type;
+
+// Word -> number of paragraph occurrences that contain it
+using WordRefs = std::unordered_map<std::string, size_t>;
+
+// Count one paragraph occurrence in (delta 1) or out (delta -1); words whose
+// count reaches or leaves zero are inserted into or erased from sorted
+size_t adjustRefs(WordRefs& refs, std::vector<std::string>& sorted, const std::vector<std::string>& words,
+                  int delta) {
+    for (const auto& word : words) {
+        if (delta > 0) {
+            if (refs[word]++ == 0) {
+                sorted.insert(std::lower_bound(sorted.begin(), sorted.end(), word), word);
+            }
+            continue;
+        }
+        auto it = refs.find(word);
+        if (it == refs.end()) continue;
+        if (--it->second == 0) {
+            refs.erase(it);
+            sorted.erase(std::lower_bound(sorted.begin(), sorted.end(), word));
+        }
+    }
+    return words.size();
+}
+
+size_t commonPrefix(std::string_view a, std::string_view b) {
+    size_t n = std::min(a.size(), b.size());
+    return std::mismatch(a.begin(), a.begin() + n, b.begin()).first - a.begin();
+}
+
+size_t commonSuffix(std::string_view a, std::string_view b) {
+    size_t n = std::min(a.size(), b.size());
+    return std::mismatch(a.rbegin(), a.rbegin() + n, b.rbegin()).first - a.rbegin();
+}
+
+} // namespace
+
+class IncrementalParser::Impl {
+public:
+    IncrementalParseStats update(const std::string& notes) {
+        auto start = std::chrono::steady_clock::now();
+        return apply(notes, diff(notes), start);
+    }
+
+    IncrementalParseStats update(const std::string& notes, const TextEdit& edit) {
+        auto start = std::chrono::steady_clock::now();
+        bool fits = edit.offset <= size_ && edit.removed_bytes <= size_ - edit.offset &&
+                    notes.size() == size_ - edit.removed_bytes + edit.inserted_bytes;
+        return apply(notes, fits ? edit : diff(notes), start);
+    }
+
+    const ParsedContent& content() {
+        return content_;
+    }
+
+    void reset() {
+        cache_.clear();
+        paragraphs_.clear();
+        size_ = 0;
+        concept_refs_.clear();
+        keyword_refs_.clear();
+        content_ = ParsedContent{};
+    }
+
+private:
+    ParagraphCache cache_;
+    std::vector<Paragraph*> paragraphs_;   // Paragraphs of the current notes, in order
+    size_t size_ = 0;                      // Bytes in the current notes
+    WordRefs concept_refs_;
+    WordRefs keyword_refs_;
+    ParsedContent content_;                // Merged parse, kept current by every update
+
+    // Range of the notes that differs from the previous text
+    TextEdit diff(std::string_view notes) const {
+        size_t prefix = 0;
+        for (const Paragraph* paragraph : paragraphs_) {
+            size_t same = commonPrefix(paragraph->first, notes.substr(prefix));
+            prefix += same;
+            if (same < paragraph->first.size()) break;
+        }
+
+        size_t limit = std::min(size_, notes.size()) - prefix;
+        size_t suffix = 0;
+        for (auto it = paragraphs_.rbegin(); it != paragraphs_.rend() && suffix < limit; ++it) {
+            size_t same = commonSuffix((*it)->first, notes.substr(0, notes.size() - suffix));
+            suffix += same;
+            if (same < (*it)->first.size()) break;
+        }
+        suffix = std::min(suffix, limit);
+        return TextEdit{prefix, size_ - prefix - suffix, notes.size() - prefix - suffix};
+    }
+
+    IncrementalParseStats apply(const std::string& notes, const TextEdit& edit,
+                                std::chrono::steady_clock::time_point start) {
+        IncrementalParseStats stats;
+        if (paragraphs_.empty() || edit.removed_bytes != 0 || edit.inserted_bytes != 0) {
+            // A cut after a '.' depends on the whitespace that follows it, so
+            // the paragraph before the edited one is re-split too; paragraphs
+            // after the one holding the end of the edit keep their cuts
+            size_t first = 0, last = 0, window_begin = 0, window_end = 0;
+            if (!paragraphs_.empty()) {
+                size_t index = 0, begin = 0, end = paragraphs_[0]->first.size();
+                while (index + 1 < paragraphs_.size() && end <= edit.offset) {
+                    begin = end;
+                    end += paragraphs_[++index]->first.size();
+                }
+                first = index > 0 ? index - 1 : 0;
+                window_begin = index > 0 ? begin - paragraphs_[first]->first.size() : 0;
+                while (index + 1 < paragraphs_.size() && end <= edit.offset + edit.removed_bytes) {
+                    end += paragraphs_[++index]->first.size();
+                }
+                last = index + 1;
+                window_end = end;
+            }
+            std::string_view window = std::string_view(notes).substr(
+                window_begin, window_end - window_begin - edit.removed_bytes + edit.inserted_bytes);
+            splice(first, last, window, stats);
+        }
+        size_ = notes.size();
+
+        stats.paragraphs = paragraphs_.size();
+        stats.reused_paragraphs = stats.paragraphs - stats.reparsed_paragraphs;
+        std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        stats.time_ms = elapsed.count();
+        return stats;
+    }
+
+    // Replace paragraphs_[first, last) with the paragraphs of window
+    void splice(size_t first, size_t last, std::string_view window, IncrementalParseStats& stats) {
+        std::vector<Paragraph*> added;
+        for (const auto& span : parsing::splitParagraphs(window)) {
+            added.push_back(acquire(window.substr(span.offset, span.length), stats));
+        }
+
+        spliceSentences(&ParsedContent::definitions, first, last, added);
+        spliceSentences(&ParsedContent::formulas, first, last, added);
+        spliceSentences(&ParsedContent::examples, first, last, added);
+
+        for (size_t i = first; i < last; ++i) {
+            release(paragraphs_[i], stats);
+        }
+        paragraphs_.erase(paragraphs_.begin() + first, paragraphs_.begin() + last);
+        paragraphs_.insert(paragraphs_.begin() + first, added.begin(), added.end());
+    }
+
+    Paragraph* acquire(std::string_view text, IncrementalParseStats& stats) {
+        auto it = cache_.find(text);
+        if (it == cache_.end()) {
+            it = cache_.emplace(std::string(text), CachedParagraph{}).first;
+            it->second.content = parsing::scanContent(text);
+            stats.reparsed_paragraphs++;
+            stats.reparsed_bytes += text.size();
+        }
+        it->second.uses++;
+        countWords(it->second.content, 1, stats);
+        return &*it;
+    }
+
+    void release(Paragraph* paragraph, IncrementalParseStats& stats) {
+        countWords(paragraph->second.content, -1, stats);
+        if (--paragraph->second.uses == 0) {
+            cache_.erase(paragraph->first);
+        }
+    }
+
+    void countWords(const ParsedContent& part, int delta, IncrementalParseStats& stats) {
+        stats.word_updates += adjustRefs(concept_refs_, content_.concepts, part.concepts, delta);
+        stats.word_updates += adjustRefs(keyword_refs_, content_.keywords, part.keywords, delta);
+    }
+
+    // Sentences keep paragraph order: swap the removed paragraphs' run for the added ones'
+    void spliceSentences(std::vector<std::string> ParsedContent::*field, size_t first, size_t last,
+                         const std::vector<Paragraph*>& added) {
+        size_t at = 0, count = 0;
+        for (size_t i = 0; i < last; ++i) {
+            (i < first ? at : count) += (paragraphs_[i]->second.content.*field).size();
+        }
+        std::vector<std::string> sentences;
+        for (const Paragraph* paragraph : added) {
+            const auto& part = paragraph->second.content.*field;
+            sentences.insert(sentences.end(), part.begin(), part.end());
+        }
+
+        auto& merged = content_.*field;
+        auto pos = merged.erase(merged.begin() + at, merged.begin() + at + count);
+        merged.insert(pos, std::make_move_iterator(sentences.begin()), std::make_move_iterator(sentences.end()));
+    }
+};
+
+IncrementalParser::IncrementalParser() : impl_(std::make_unique<Impl>()) {}
+
+IncrementalParser::~IncrementalParser() = default;
+
+IncrementalParseStats IncrementalParser::update(const std::string& notes) {
+    return impl_->update(notes);
+}
+
+IncrementalParseStats IncrementalParser::update(const std::string& notes, const TextEdit& edit) {
+    return impl_->update(notes, edit);
+}
+
+const ParsedContent& IncrementalParser::content() {
+    return impl_->content();
+}
+
+void IncrementalParser::reset() {
+    impl_->reset();
+}
+
+} // namespace core
+} // namespace studyhive
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <cstddef>
+#include "qgen_rules.h"
+
+namespace studyhive {
+namespace core {
+
+struct IncrementalParseStats {
+    size_t paragraphs = 0;            // In the notes just parsed
+    size_t reparsed_paragraphs = 0;   // Not in the cache: scanned this update
+    size_t reparsed_bytes = 0;
+    size_t reused_paragraphs = 0;     // Taken from the cache or left in place
+    size_t word_updates = 0;          // Concept/keyword reference count changes
+    float time_ms = 0.0f;
+};
+
+// One edit of the note: removed_bytes at offset were replaced by
+// inserted_bytes, which now sit at [offset, offset + inserted_bytes)
+struct TextEdit {
+    size_t offset = 0;
+    size_t removed_bytes = 0;
+    size_t inserted_bytes = 0;
+};
+
+// Keeps the parse of one note current across edits. The notes are split into
+// paragraphs (parsing::splitParagraphs), each keyed by its text with its
+// partial ParsedContent cached. An edit re-splits only the paragraphs around
+// the edited range, looks those up (scanning text that is new), and splices
+// them and their sentences into the merged parse; per-word reference counts
+// keep the merged concepts and keywords sorted without touching the rest.
+// Paragraphs leave the cache when their last occurrence is edited away.
+class IncrementalParser {
+public:
+    IncrementalParser();
+    ~IncrementalParser();
+
+    // Bring the parse up to date with the current text of the note. Without
+    // an edit range the changed range is found by comparing against the
+    // previous text (one memcmp pass, no hashing or splitting outside it).
+    IncrementalParseStats update(const std::string& notes);
+
+    // Same, for a known edit: work is proportional to the edited paragraphs.
+    // An edit that does not fit the previous text falls back to update(notes).
+    IncrementalParseStats update(const std::string& notes, const TextEdit& edit);
+
+    // Equal to parsing::scanContent of the notes last passed to update()
+    const ParsedContent& content();
+
+    // Drop the cache and the current parse
+    void reset();
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace core
+} // namespace studyhive
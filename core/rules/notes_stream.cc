@@ -0,0 +1,201 @@
+#include "notes_stream.h"
+#include "../llm/gguf_reader.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <set>
+#include <vector>
+
+namespace studyhive {
+namespace core {
+
+namespace {
+
+inline bool isSpaceChar(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+template <typename T>
+void appendAll(std::vector<T>& to, std::vector<T>& from) {
+    to.insert(to.end(), std::make_move_iterator(from.begin()), std::make_move_iterator(from.end()));
+}
+
+} // namespace
+
+class NotesStreamParser::Impl {
+public:
+    explicit Impl(const NotesStreamOptions& options) : options_(options) {
+        options_.window_bytes = std::max<size_t>(options_.window_bytes, 1);
+    }
+
+    void feed(std::string_view data) {
+        auto start = std::chrono::steady_clock::now();
+        while (!data.empty()) {
+            size_t take = std::min(data.size(), options_.window_bytes);
+            pending_.append(data.data(), take);
+            data.remove_prefix(take);
+
+            size_t parsed = consume(false);
+            pending_.erase(0, parsed);
+        }
+        addTime(start);
+    }
+
+    void finish() {
+        auto start = std::chrono::steady_clock::now();
+        consume(true);
+        pending_.clear();
+        pending_.shrink_to_fit();
+
+        content_.concepts.assign(concepts_.begin(), concepts_.end());
+        content_.keywords.assign(keywords_.begin(), keywords_.end());
+        concepts_.clear();
+        keywords_.clear();
+        addTime(start);
+    }
+
+    const ParsedContent& content() const { return content_; }
+    NotesStreamStats stats() const { return stats_; }
+
+private:
+    NotesStreamOptions options_;
+    std::string pending_;             // Unparsed tail of fed data
+    size_t checked_ = 0;              // Prefix of the pending text known to hold no cut
+    std::set<std::string> concepts_;
+    std::set<std::string> keywords_;
+    ParsedContent content_;
+    NotesStreamStats stats_;
+
+    // Parse the longest prefix of the pending text that can be cut off (all
+    // of it when final); returns its length
+    size_t consume(bool final) {
+        std::string_view text(pending_);
+        stats_.peak_pending_bytes = std::max(stats_.peak_pending_bytes, text.size());
+
+        size_t cut = final ? text.size() : findCut(text);
+        if (cut == 0) return 0;
+
+        ParsedContent part = parsing::scanContent(text.substr(0, cut));
+        concepts_.insert(std::make_move_iterator(part.concepts.begin()), std::make_move_iterator(part.concepts.end()));
+        keywords_.insert(std::make_move_iterator(part.keywords.begin()), std::make_move_iterator(part.keywords.end()));
+        part.concepts.clear();
+        part.keywords.clear();
+        if (options_.on_sentences) {
+            options_.on_sentences(std::move(part));
+        } else {
+            appendAll(content_.definitions, part.definitions);
+            appendAll(content_.formulas, part.formulas);
+            appendAll(content_.examples, part.examples);
+        }
+
+        stats_.bytes += cut;
+        stats_.steps++;
+        checked_ = 0;
+        return cut;
+    }
+
+    void addTime(std::chrono::steady_clock::time_point start) {
+        std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        stats_.time_ms += elapsed.count();
+    }
+
+    // After the last '.' followed by whitespace; the final byte cannot be
+    // judged until the next one arrives. 0 if there is none yet.
+    size_t findCut(std::string_view text) {
+        if (text.size() < 2) return 0;
+        size_t from = std::max<size_t>(checked_, 1);
+        for (size_t i = text.size() - 1; i >= from; --i) {
+            if (text[i - 1] == '.' && isSpaceChar(text[i])) return i;
+        }
+        checked_ = text.size();
+
+        // No sentence end for too long: give up exactness for this sentence,
+        // cutting after whitespace if there is any and mid-word otherwise
+        if (text.size() > options_.max_sentence_bytes) {
+            stats_.forced_cuts++;
+            for (size_t i = text.size() - 1; i > 0; --i) {
+                if (isSpaceChar(text[i - 1])) return i;
+            }
+            return text.size();
+        }
+        return 0;
+    }
+};
+
+NotesStreamParser::NotesStreamParser(const NotesStreamOptions& options)
+    : impl_(std::make_unique<Impl>(options)) {}
+
+NotesStreamParser::~NotesStreamParser() = default;
+
+void NotesStreamParser::feed(std::string_view data) {
+    impl_->feed(data);
+}
+
+void NotesStreamParser::finish() {
+    impl_->finish();
+}
+
+const ParsedContent& NotesStreamParser::content() const {
+    return impl_->content();
+}
+
+NotesStreamStats NotesStreamParser::stats() const {
+    return impl_->stats();
+}
+
+bool parseNotesFile(const std::string& path, const NotesStreamOptions& options, ParsedContent& content,
+                    NotesStreamStats& stats, std::string& error_msg) {
+    NotesStreamParser parser(options);
+
+    std::error_code ec;
+    auto size = std::filesystem::file_size(path, ec);
+    if (ec) {
+        error_msg = "Cannot open " + path;
+        return false;
+    }
+
+    MappedFile file;
+    if (size > 0 && !file.open(path, error_msg)) {
+        return false;
+    }
+
+    // The parser copies what it has not parsed yet, so pages can be dropped
+    // as soon as they are fed: only about one window of the mapping stays resident
+    std::string_view text(reinterpret_cast<const char*>(file.data()), file.size());
+    size_t window = std::max<size_t>(options.window_bytes, 1);
+    for (size_t begin = 0; begin < text.size(); begin += window) {
+        size_t length = std::min(window, text.size() - begin);
+        parser.feed(text.substr(begin, length));
+        file.release(begin, length);
+    }
+    parser.finish();
+
+    content = parser.content();
+    stats = parser.stats();
+    return true;
+}
+
+bool parseNotesStream(std::istream& input, const NotesStreamOptions& options, ParsedContent& content,
+                      NotesStreamStats& stats, std::string& error_msg) {
+    NotesStreamParser parser(options);
+    std::vector<char> block(std::max<size_t>(options.window_bytes, 1));
+
+    while (input) {
+        input.read(block.data(), static_cast<std::streamsize>(block.size()));
+        std::streamsize count = input.gcount();
+        if (count <= 0) break;
+        parser.feed(std::string_view(block.data(), static_cast<size_t>(count)));
+    }
+    if (input.bad()) {
+        error_msg = "Read error in notes stream";
+        return false;
+    }
+
+    parser.finish();
+    content = parser.content();
+    stats = parser.stats();
+    return true;
+}
+
+} // namespace core
+} // namespace studyhive
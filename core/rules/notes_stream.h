@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <istream>
+#include <functional>
+#include <memory>
+#include <cstddef>
+#include "qgen_rules.h"
+
+namespace studyhive {
+namespace core {
+
+struct NotesStreamOptions {
+    size_t window_bytes = 1 << 20;          // Text taken per step
+    size_t max_sentence_bytes = 4 << 20;    // A longer run with no sentence end is cut (at whitespace if any)
+
+    // Receives the definitions, formulas and examples of each step (concepts
+    // and keywords empty) instead of collecting them, so memory does not
+    // grow with the length of the notes
+    std::function<void(ParsedContent&& sentences)> on_sentences;
+};
+
+struct NotesStreamStats {
+    size_t bytes = 0;               // Parsed so far
+    size_t steps = 0;               // Pieces handed to the scanner
+    size_t peak_pending_bytes = 0;  // Largest unparsed tail held (window plus carried sentence)
+    size_t forced_cuts = 0;         // Sentences cut for exceeding max_sentence_bytes
+    float time_ms = 0.0f;
+};
+
+// Parses notes that arrive in pieces, with memory bounded by the window plus
+// the longest sentence (at most max_sentence_bytes). Each step scans the
+// pending text up to its last sentence end followed by whitespace (where no
+// match can continue, see parsing::splitChunks) and carries the rest over. Concepts and keywords are
+// merged into sorted sets as they come; sentences are collected or passed to
+// on_sentences. Apart from forced cuts the result equals parsing::scanContent
+// of the whole text.
+class NotesStreamParser {
+public:
+    explicit NotesStreamParser(const NotesStreamOptions& options = NotesStreamOptions());
+    ~NotesStreamParser();
+
+    // Next bytes of the notes, split anywhere
+    void feed(std::string_view data);
+
+    // Parse the remaining tail; content() is complete afterwards
+    void finish();
+
+    const ParsedContent& content() const;
+    NotesStreamStats stats() const;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+// Memory-map path and feed it window by window, dropping pages once fed
+bool parseNotesFile(const std::string& path, const NotesStreamOptions& options, ParsedContent& content,
+                    NotesStreamStats& stats, std::string& error_msg);
+
+// Read input in window_bytes blocks until EOF
+bool parseNotesStream(std::istream& input, const NotesStreamOptions& options, ParsedContent& content,
+                      NotesStreamStats& stats, std::string& error_msg);
+
+} // namespace core
+} // namespace studyhive
@@ -1,8 +1,14 @@
 #include "qgen_rules.h"
+#include "incremental_parser.h"
+#include "notes_stream.h"
 #include <random>
 #include <sstream>
 #include <algorithm>
 #include <regex>
+#include <stdexcept>
+#include <unordered_set>
+#include <atomic>
+#include <thread>
 
 namespace studyhive {
 namespace core {
@@ -20,22 +26,32 @@ public:
     }
 
     ParsedContent parseContent(const std::string& notes) {
-        ParsedContent content;
-        
-        content.concepts = parsing::extractConcepts(notes);
-        content.definitions = parsing::extractDefinitions(notes);
-        content.formulas = parsing::extractFormulas(notes);
-        content.examples = parsing::extractExamples(notes);
-        content.keywords = parsing::extractKeywords(notes);
-        
-        return content;
+        return parsing::scanContentParallel(notes, ParallelParseOptions());
+    }
+
+    const ParsedContent& parseEditedContent(const std::string& notes, const TextEdit& edit) {
+        editing_.update(notes, edit);
+        return editing_.content();
+    }
+
+    bool parseContentFile(const std::string& path, ParsedContent& content, std::string& error_msg) {
+        NotesStreamStats stats;
+        return parseNotesFile(path, NotesStreamOptions(), content, stats, error_msg);
     }
 
-    std::vector<nlohmann::json> generateQuestions(const ParsedContent& content,
-                                                 const std::string& difficulty,
-                                                 int num_questions,
-                                                 int seed = 42) {
-        std::vector<nlohmann::json> questions;
+    ParsedSpans parseContentSpans(std::shared_ptr<const std::string> notes) {
+        return parsing::scanSpans(std::move(notes));
+    }
+
+    ParsedContent parseContentParallel(const std::string& notes, const ParallelParseOptions& options) {
+        return parsing::scanContentParallel(notes, options);
+    }
+
+    std::vector<Question> generateQuestions(const ParsedContent& content,
+                                            const std::string& difficulty,
+                                            int num_questions,
+                                            int seed = 42) {
+        std::vector<Question> questions;
         
         if (content.concepts.empty()) {
             return questions;
@@ -45,9 +61,9 @@ public:
         
         // Filter templates by difficulty
         std::vector<QuestionTemplate> suitable_templates;
-        for (const auto& template : templates_) {
-            if (isDifficultySuitable(template, difficulty)) {
-                suitable_templates.push_back(template);
+        for (const auto& question_template : templates_) {
+            if (isDifficultySuitable(question_template, difficulty)) {
+                suitable_templates.push_back(question_template);
             }
         }
 
@@ -63,7 +79,7 @@ public:
             try {
                 auto question = generation::applyTemplate(selected_template, content, difficulty, seed + i);
                 if (generation::validateQuestion(question)) {
-                    questions.push_back(question);
+                    questions.push_back(std::move(question));
                 }
             } catch (const std::exception& e) {
                 // Skip invalid questions
@@ -78,20 +94,21 @@ public:
         return templates_;
     }
 
-    void addTemplate(const QuestionTemplate& template) {
-        templates_.push_back(template);
+    void addTemplate(const QuestionTemplate& question_template) {
+        templates_.push_back(question_template);
     }
 
 private:
     std::vector<QuestionTemplate> templates_;
+    IncrementalParser editing_;   // Parse of the note passed to parseEditedContent
 
-    bool isDifficultySuitable(const QuestionTemplate& template, const std::string& difficulty) {
+    bool isDifficultySuitable(const QuestionTemplate& question_template, const std::string& difficulty) {
         if (difficulty == "easy") {
-            return template.difficulty_weight <= 2;
+            return question_template.difficulty_weight <= 2;
         } else if (difficulty == "medium") {
-            return template.difficulty_weight >= 2 && template.difficulty_weight <= 4;
+            return question_template.difficulty_weight >= 2 && question_template.difficulty_weight <= 4;
         } else if (difficulty == "hard") {
-            return template.difficulty_weight >= 3;
+            return question_template.difficulty_weight >= 3;
         }
         return true;
     }
@@ -110,10 +127,26 @@ ParsedContent QuestionGenerator::parseContent(const std::string& notes) {
     return impl_->parseContent(notes);
 }
 
-std::vector<nlohmann::json> QuestionGenerator::generateQuestions(const ParsedContent& content,
-                                                               const std::string& difficulty,
-                                                               int num_questions,
-                                                               int seed) {
+const ParsedContent& QuestionGenerator::parseEditedContent(const std::string& notes, const TextEdit& edit) {
+    return impl_->parseEditedContent(notes, edit);
+}
+
+bool QuestionGenerator::parseContentFile(const std::string& path, ParsedContent& content, std::string& error_msg) {
+    return impl_->parseContentFile(path, content, error_msg);
+}
+
+ParsedSpans QuestionGenerator::parseContentSpans(std::shared_ptr<const std::string> notes) {
+    return impl_->parseContentSpans(std::move(notes));
+}
+
+ParsedContent QuestionGenerator::parseContentParallel(const std::string& notes, const ParallelParseOptions& options) {
+    return impl_->parseContentParallel(notes, options);
+}
+
+std::vector<Question> QuestionGenerator::generateQuestions(const ParsedContent& content,
+                                                          const std::string& difficulty,
+                                                          int num_questions,
+                                                          int seed) {
     return impl_->generateQuestions(content, difficulty, num_questions, seed);
 }
 
@@ -121,101 +154,101 @@ std::vector<QuestionTemplate> QuestionGenerator::getTemplates() const {
     return impl_->getTemplates();
 }
 
-void QuestionGenerator::addTemplate(const QuestionTemplate& template) {
-    impl_->addTemplate(template);
+void QuestionGenerator::addTemplate(const QuestionTemplate& question_template) {
+    impl_->addTemplate(question_template);
 }
 
 // Template definitions
 namespace templates {
 
 QuestionTemplate createConceptMCQ() {
-    QuestionTemplate template;
-    template.id = "concept_mcq";
-    template.type = "multiple_choice";
-    template.prompt_template = "What is {concept}?";
-    template.required_fields = {"concept"};
-    template.difficulty_weight = 2;
-    return template;
+    QuestionTemplate question_template;
+    question_template.id = "concept_mcq";
+    question_template.type = "multiple_choice";
+    question_template.prompt_template = "What is {concept}?";
+    question_template.required_fields = {"concept"};
+    question_template.difficulty_weight = 2;
+    return question_template;
 }
 
 QuestionTemplate createDefinitionMCQ() {
-    QuestionTemplate template;
-    template.id = "definition_mcq";
-    template.type = "multiple_choice";
-    template.prompt_template = "Which of the following best defines {concept}?";
-    template.required_fields = {"concept"};
-    template.difficulty_weight = 3;
-    return template;
+    QuestionTemplate question_template;
+    question_template.id = "definition_mcq";
+    question_template.type = "multiple_choice";
+    question_template.prompt_template = "Which of the following best defines {concept}?";
+    question_template.required_fields = {"concept"};
+    question_template.difficulty_weight = 3;
+    return question_template;
 }
 
 QuestionTemplate createFormulaMCQ() {
-    QuestionTemplate template;
-    template.id = "formula_mcq";
-    template.type = "multiple_choice";
-    template.prompt_template = "What is the formula for {concept}?";
-    template.required_fields = {"concept"};
-    template.difficulty_weight = 3;
-    return template;
+    QuestionTemplate question_template;
+    question_template.id = "formula_mcq";
+    question_template.type = "multiple_choice";
+    question_template.prompt_template = "What is the formula for {concept}?";
+    question_template.required_fields = {"concept"};
+    question_template.difficulty_weight = 3;
+    return question_template;
 }
 
 QuestionTemplate createExampleMCQ() {
-    QuestionTemplate template;
-    template.id = "example_mcq";
-    template.type = "multiple_choice";
-    template.prompt_template = "Which of the following is an example of {concept}?";
-    template.required_fields = {"concept"};
-    template.difficulty_weight = 2;
-    return template;
+    QuestionTemplate question_template;
+    question_template.id = "example_mcq";
+    question_template.type = "multiple_choice";
+    question_template.prompt_template = "Which of the following is an example of {concept}?";
+    question_template.required_fields = {"concept"};
+    question_template.difficulty_weight = 2;
+    return question_template;
 }
 
 QuestionTemplate createConceptExplanation() {
-    QuestionTemplate template;
-    template.id = "concept_explanation";
-    template.type = "short_answer";
-    template.prompt_template = "Explain what {concept} is and how it works.";
-    template.required_fields = {"concept"};
-    template.difficulty_weight = 4;
-    return template;
+    QuestionTemplate question_template;
+    question_template.id = "concept_explanation";
+    question_template.type = "short_answer";
+    question_template.prompt_template = "Explain what {concept} is and how it works.";
+    question_template.required_fields = {"concept"};
+    question_template.difficulty_weight = 4;
+    return question_template;
 }
 
 QuestionTemplate createProcessDescription() {
-    QuestionTemplate template;
-    template.id = "process_description";
-    template.type = "short_answer";
-    template.prompt_template = "Describe the process of {concept} step by step.";
-    template.required_fields = {"concept"};
-    template.difficulty_weight = 4;
-    return template;
+    QuestionTemplate question_template;
+    question_template.id = "process_description";
+    question_template.type = "short_answer";
+    question_template.prompt_template = "Describe the process of {concept} step by step.";
+    question_template.required_fields = {"concept"};
+    question_template.difficulty_weight = 4;
+    return question_template;
 }
 
 QuestionTemplate createComparisonQuestion() {
-    QuestionTemplate template;
-    template.id = "comparison";
-    template.type = "short_answer";
-    template.prompt_template = "Compare and contrast {concept1} and {concept2}.";
-    template.required_fields = {"concept1", "concept2"};
-    template.difficulty_weight = 5;
-    return template;
+    QuestionTemplate question_template;
+    question_template.id = "comparison";
+    question_template.type = "short_answer";
+    question_template.prompt_template = "Compare and contrast {concept1} and {concept2}.";
+    question_template.required_fields = {"concept1", "concept2"};
+    question_template.difficulty_weight = 5;
+    return question_template;
 }
 
 QuestionTemplate createClozeQuestion() {
-    QuestionTemplate template;
-    template.id = "cloze";
-    template.type = "fill_in_blank";
-    template.prompt_template = "Complete the following: {concept} is _____.";
-    template.required_fields = {"concept"};
-    template.difficulty_weight = 2;
-    return template;
+    QuestionTemplate question_template;
+    question_template.id = "cloze";
+    question_template.type = "fill_in_blank";
+    question_template.prompt_template = "Complete the following: {concept} is _____.";
+    question_template.required_fields = {"concept"};
+    question_template.difficulty_weight = 2;
+    return question_template;
 }
 
 QuestionTemplate createFormulaCompletion() {
-    QuestionTemplate template;
-    template.id = "formula_completion";
-    template.type = "fill_in_blank";
-    template.prompt_template = "Complete the formula: {formula}";
-    template.required_fields = {"formula"};
-    template.difficulty_weight = 3;
-    return template;
+    QuestionTemplate question_template;
+    question_template.id = "formula_completion";
+    question_template.type = "fill_in_blank";
+    question_template.prompt_template = "Complete the formula: {formula}";
+    question_template.required_fields = {"formula"};
+    question_template.difficulty_weight = 3;
+    return question_template;
 }
 
 std::vector<QuestionTemplate> getAllTemplates() {
@@ -237,136 +270,485 @@ std::vector<QuestionTemplate> getAllTemplates() {
 // Content parsing utilities
 namespace parsing {
 
-std::vector<std::string> extractConcepts(const std::string& text) {
-    std::vector<std::string> concepts;
-    
-    // Simple extraction based on capitalization and common patterns
-    std::regex concept_pattern(R"(\b[A-Z][a-zA-Z]*(?:\s+[A-Z][a-zA-Z]*)*\b)");
-    std::sregex_iterator iter(text.begin(), text.end(), concept_pattern);
-    std::sregex_iterator end;
-    
-    for (; iter != end; ++iter) {
-        std::string concept = iter->str();
-        if (concept.length() > 2 && concept.length() < 50) {
-            concepts.push_back(concept);
+namespace {
+
+// Character classes of the original std::regex patterns ("C" locale)
+inline bool isWordChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+inline bool isAlphaChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+inline bool isSpaceChar(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+inline char toLowerAscii(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+const char* const kDefinitionCues[] = {"is", "are", "means", "refers to", "can be defined as"};
+const char* const kExampleCues[] = {"for example", "such as", "including"};
+
+// Case-insensitive cue at a word start, ending on a word boundary
+bool cueAt(std::string_view text, size_t pos, const char* cue) {
+    size_t i = 0;
+    for (; cue[i]; ++i) {
+        if (pos + i >= text.size() || toLowerAscii(text[pos + i]) != cue[i]) return false;
+    }
+    return pos + i == text.size() || !isWordChar(text[pos + i]);
+}
+
+template <size_t N>
+bool anyCueAt(std::string_view text, size_t pos, const char* const (&cues)[N]) {
+    for (const char* cue : cues) {
+        if (cueAt(text, pos, cue)) return true;
+    }
+    return false;
+}
+
+// "e.g." closing the sentence that ends at dot, directly followed by a word:
+// the example pattern then runs on to the next full stop. Returns its
+// position, or npos.
+size_t abbreviatedExampleEnd(std::string_view text, size_t sentence_begin, size_t dot) {
+    if (dot == sentence_begin || toLowerAscii(text[dot - 1]) != 'e') return std::string_view::npos;
+    if (dot - 1 > 0 && isWordChar(text[dot - 2])) return std::string_view::npos;
+    if (dot + 3 >= text.size() || toLowerAscii(text[dot + 1]) != 'g' || text[dot + 2] != '.' ||
+        !isWordChar(text[dot + 3])) {
+        return std::string_view::npos;
+    }
+    return text.find('.', dot + 3);
+}
+
+void appendClean(std::string_view text, std::string& out) {
+    bool pending_space = false;
+    for (char c : text) {
+        if (isSpaceChar(c)) {
+            pending_space = pending_space || !out.empty();
+            continue;
         }
+        if (pending_space) out.push_back(' ');
+        pending_space = false;
+        out.push_back(c);
     }
-    
-    // Remove duplicates
-    std::sort(concepts.begin(), concepts.end());
-    concepts.erase(std::unique(concepts.begin(), concepts.end()), concepts.end());
-    
-    return concepts;
 }
 
-std::vector<std::string> extractDefinitions(const std::string& text) {
-    std::vector<std::string> definitions;
-    
-    // Look for sentences with definition indicators
-    std::regex definition_pattern(R"([^.]*\b(is|are|means|refers to|can be defined as)\b[^.]*\.)", std::regex_constants::icase);
-    std::sregex_iterator iter(text.begin(), text.end(), definition_pattern);
-    std::sregex_iterator end;
-    
-    for (; iter != end; ++iter) {
-        definitions.push_back(cleanText(iter->str()));
+// Spans of distinct words, first occurrence of each, sorted by text
+class DistinctWords {
+public:
+    void add(std::string_view text, size_t offset, size_t length) {
+        if (seen_.insert(text.substr(offset, length)).second) {
+            spans_.push_back(TextSpan{offset, length});
+        }
     }
-    
-    return definitions;
+
+    std::vector<TextSpan> sorted(std::string_view text) {
+        std::sort(spans_.begin(), spans_.end(), [text](const TextSpan& a, const TextSpan& b) {
+            return text.substr(a.offset, a.length) < text.substr(b.offset, b.length);
+        });
+        return std::move(spans_);
+    }
+
+private:
+    std::unordered_set<std::string_view> seen_;
+    std::vector<TextSpan> spans_;
+};
+
+// One pass over the notes: words are tokenized as maximal [A-Za-z0-9_] runs
+// and sentences end at each '.', reproducing what the previous std::regex
+// patterns matched:
+//   concepts     capitalized alphabetic words joined by whitespace only
+//   keywords     alphabetic words of 4 to 20 letters
+//   definitions  sentences containing is / are / means / refers to / can be defined as
+//   formulas     sentences containing '='
+//   examples     sentences containing for example / such as / including / e.g.
+// Text after the last '.' only contributes words. Sentence spans include the '.'.
+void scanInto(std::string_view text, ParsedSpans& spans) {
+    const size_t n = text.size();
+    DistinctWords concepts, keywords;
+
+    size_t sentence_begin = 0;
+    size_t examples_resume = 0;  // An "e.g." example can swallow the following sentence
+    bool has_definition = false;
+    bool has_example = false;
+    bool has_equals = false;
+
+    size_t concept_begin = std::string_view::npos;
+    size_t concept_end = 0;
+    bool gap_is_space = true;    // Only whitespace since the last word
+
+    auto flushConcept = [&]() {
+        if (concept_begin == std::string_view::npos) return;
+        size_t length = concept_end - concept_begin;
+        if (length > 2 && length < 50) concepts.add(text, concept_begin, length);
+        concept_begin = std::string_view::npos;
+    };
+
+    size_t i = 0;
+    while (i < n) {
+        char c = text[i];
+
+        if (isWordChar(c)) {
+            size_t word_begin = i;
+            bool alphabetic = true;
+            while (i < n && isWordChar(text[i])) {
+                alphabetic = alphabetic && isAlphaChar(text[i]);
+                ++i;
+            }
+            size_t length = i - word_begin;
+
+            if (alphabetic && length >= 4 && length <= 20) keywords.add(text, word_begin, length);
+
+            bool capitalized = alphabetic && text[word_begin] >= 'A' && text[word_begin] <= 'Z';
+            if (capitalized && concept_begin != std::string_view::npos && gap_is_space) {
+                concept_end = i;
+            } else {
+                flushConcept();
+                if (capitalized) {
+                    concept_begin = word_begin;
+                    concept_end = i;
+                }
+            }
+            gap_is_space = true;
+
+            if (!has_definition) has_definition = anyCueAt(text, word_begin, kDefinitionCues);
+            if (!has_example) has_example = anyCueAt(text, word_begin, kExampleCues);
+            continue;
+        }
+
+        if (c == '.') {
+            flushConcept();
+
+            TextSpan sentence{sentence_begin, i + 1 - sentence_begin};
+            if (has_definition) spans.definitions.push_back(sentence);
+            if (has_equals) spans.formulas.push_back(sentence);
+            if (sentence_begin >= examples_resume) {
+                size_t extended_end = abbreviatedExampleEnd(text, sentence_begin, i);
+                if (extended_end != std::string_view::npos) {
+                    spans.examples.push_back(TextSpan{sentence_begin, extended_end + 1 - sentence_begin});
+                    examples_resume = extended_end + 1;
+                } else if (has_example) {
+                    spans.examples.push_back(sentence);
+                }
+            }
+
+            sentence_begin = i + 1;
+            has_definition = has_example = has_equals = false;
+        } else if (c == '=') {
+            has_equals = true;
+        }
+
+        if (!isSpaceChar(c)) gap_is_space = false;
+        ++i;
+    }
+    flushConcept();
+
+    spans.concepts = concepts.sorted(text);
+    spans.keywords = keywords.sorted(text);
 }
 
-std::vector<std::string> extractFormulas(const std::string& text) {
-    std::vector<std::string> formulas;
-    
-    // Look for mathematical expressions
-    std::regex formula_pattern(R"([^.]*[=+\-*/^()0-9\s]+[^.]*\.)");
-    std::sregex_iterator iter(text.begin(), text.end(), formula_pattern);
-    std::sregex_iterator end;
-    
-    for (; iter != end; ++iter) {
-        std::string formula = iter->str();
-        if (formula.find('=') != std::string::npos) {
-            formulas.push_back(cleanText(formula));
+ParsedContent materializeSpans(std::string_view text, const ParsedSpans& spans) {
+    ParsedContent content;
+    auto raw = [text](const std::vector<TextSpan>& from, std::vector<std::string>& to) {
+        to.reserve(from.size());
+        for (const auto& span : from) to.emplace_back(text.substr(span.offset, span.length));
+    };
+    auto cleaned = [text](const std::vector<TextSpan>& from, std::vector<std::string>& to) {
+        to.resize(from.size());
+        for (size_t i = 0; i < from.size(); ++i) appendClean(text.substr(from[i].offset, from[i].length), to[i]);
+    };
+    raw(spans.concepts, content.concepts);
+    cleaned(spans.definitions, content.definitions);
+    cleaned(spans.formulas, content.formulas);
+    cleaned(spans.examples, content.examples);
+    raw(spans.keywords, content.keywords);
+    return content;
+}
+
+// True if the whitespace run starting at pos holds a blank line
+bool blankLineAt(std::string_view text, size_t pos) {
+    int newlines = 0;
+    for (size_t i = pos; i < text.size() && isSpaceChar(text[i]); ++i) {
+        if (text[i] == '\n' && ++newlines == 2) return true;
+    }
+    return false;
+}
+
+// Position just after a sentence end at or after from where the notes can be
+// cut without changing any result: the '.' is followed by whitespace, so no
+// sentence, word or "e.g." example continues past it. Prefers a paragraph
+// break (the whitespace holds a blank line) up to limit.
+size_t findCut(std::string_view text, size_t from, size_t limit) {
+    size_t fallback = std::string_view::npos;
+    for (size_t dot = text.find('.', from); dot != std::string_view::npos; dot = text.find('.', dot + 1)) {
+        if (dot + 1 >= text.size() || !isSpaceChar(text[dot + 1])) continue;
+        if (fallback == std::string_view::npos) fallback = dot + 1;
+        if (dot >= limit) break;
+        if (blankLineAt(text, dot + 1)) return dot + 1;
+    }
+    return fallback;
+}
+
+int resolveThreads(int threads) {
+    if (threads > 0) return threads;
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// fn(index) for every chunk on up to threads workers (the caller is one)
+template <typename Fn>
+void forEachChunk(size_t chunk_count, int threads, Fn&& fn) {
+    std::atomic<size_t> next{0};
+    auto work = [&]() {
+        for (size_t index = next++; index < chunk_count; index = next++) {
+            fn(index);
         }
+    };
+
+    std::vector<std::thread> workers;
+    size_t worker_count = std::min<size_t>(resolveThreads(threads), chunk_count);
+    for (size_t i = 1; i < worker_count; ++i) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
     }
-    
-    return formulas;
 }
 
-std::vector<std::string> extractExamples(const std::string& text) {
-    std::vector<std::string> examples;
-    
-    // Look for sentences with example indicators
-    std::regex example_pattern(R"([^.]*\b(for example|such as|including|e\.g\.)\b[^.]*\.)", std::regex_constants::icase);
-    std::sregex_iterator iter(text.begin(), text.end(), example_pattern);
-    std::sregex_iterator end;
-    
-    for (; iter != end; ++iter) {
-        examples.push_back(cleanText(iter->str()));
+template <typename T>
+void appendAll(std::vector<T>& to, std::vector<T>& from) {
+    to.insert(to.end(), std::make_move_iterator(from.begin()), std::make_move_iterator(from.end()));
+}
+
+void shiftSpans(std::vector<TextSpan>& spans, size_t offset) {
+    for (auto& span : spans) span.offset += offset;
+}
+
+// Chunks of about chunk_bytes, or one chunk if the notes are too short to split
+std::vector<TextSpan> planChunks(std::string_view text, const ParallelParseOptions& options) {
+    size_t threads = static_cast<size_t>(resolveThreads(options.threads));
+    if (threads <= 1 || text.size() < 2 * options.min_chunk_bytes) {
+        return parsing::splitChunks(text, text.size());
     }
-    
-    return examples;
+    // A few chunks per worker evens out paragraphs of uneven size
+    size_t chunk_bytes = std::max(options.min_chunk_bytes, text.size() / (threads * 4));
+    return parsing::splitChunks(text, chunk_bytes);
 }
 
-std::vector<std::string> extractKeywords(const std::string& text) {
-    std::vector<std::string> keywords;
-    
-    // Extract important terms (longer words, technical terms)
-    std::regex keyword_pattern(R"(\b[a-zA-Z]{4,}\b)");
-    std::sregex_iterator iter(text.begin(), text.end(), keyword_pattern);
-    std::sregex_iterator end;
-    
-    for (; iter != end; ++iter) {
-        std::string keyword = iter->str();
-        if (keyword.length() >= 4 && keyword.length() <= 20) {
-            keywords.push_back(keyword);
+} // namespace
+
+ParsedContent scanContent(std::string_view text) {
+    ParsedSpans spans;
+    scanInto(text, spans);
+    return materializeSpans(text, spans);
+}
+
+ParsedSpans scanSpans(std::shared_ptr<const std::string> notes) {
+    ParsedSpans spans;
+    spans.notes = std::move(notes);
+    if (spans.notes) scanInto(*spans.notes, spans);
+    return spans;
+}
+
+std::vector<TextSpan> splitChunks(std::string_view text, size_t chunk_bytes) {
+    std::vector<TextSpan> chunks;
+    size_t begin = 0;
+    while (chunk_bytes > 0 && text.size() - begin > chunk_bytes) {
+        size_t cut = findCut(text, begin + chunk_bytes, begin + 2 * chunk_bytes);
+        if (cut == std::string_view::npos) break;
+        chunks.push_back(TextSpan{begin, cut - begin});
+        begin = cut;
+    }
+    chunks.push_back(TextSpan{begin, text.size() - begin});
+    return chunks;
+}
+
+std::vector<TextSpan> splitParagraphs(std::string_view text) {
+    std::vector<TextSpan> paragraphs;
+    size_t begin = 0;
+    for (size_t dot = text.find('.'); dot != std::string_view::npos; dot = text.find('.', dot + 1)) {
+        if (dot + 1 < text.size() && blankLineAt(text, dot + 1)) {
+            paragraphs.push_back(TextSpan{begin, dot + 1 - begin});
+            begin = dot + 1;
         }
     }
-    
-    // Remove duplicates and common words
-    std::sort(keywords.begin(), keywords.end());
-    keywords.erase(std::unique(keywords.begin(), keywords.end()), keywords.end());
-    
-    return keywords;
+    if (begin < text.size() || paragraphs.empty()) {
+        paragraphs.push_back(TextSpan{begin, text.size() - begin});
+    }
+    return paragraphs;
+}
+
+ParsedContent scanContentParallel(const std::string& text, const ParallelParseOptions& options) {
+    auto chunks = planChunks(text, options);
+    if (chunks.size() == 1) return scanContent(text);
+
+    std::string_view notes(text);
+    std::vector<ParsedContent> parts(chunks.size());
+    forEachChunk(chunks.size(), options.threads, [&](size_t index) {
+        std::string_view chunk = notes.substr(chunks[index].offset, chunks[index].length);
+        ParsedSpans spans;
+        scanInto(chunk, spans);
+        parts[index] = materializeSpans(chunk, spans);
+    });
+
+    // Sentences keep chunk order; word sets are merged with the serial sort/unique
+    ParsedContent content;
+    for (auto& part : parts) {
+        appendAll(content.concepts, part.concepts);
+        appendAll(content.definitions, part.definitions);
+        appendAll(content.formulas, part.formulas);
+        appendAll(content.examples, part.examples);
+        appendAll(content.keywords, part.keywords);
+    }
+    for (auto* words : {&content.concepts, &content.keywords}) {
+        std::sort(words->begin(), words->end());
+        words->erase(std::unique(words->begin(), words->end()), words->end());
+    }
+    return content;
+}
+
+ParsedSpans scanSpansParallel(std::shared_ptr<const std::string> notes, const ParallelParseOptions& options) {
+    if (!notes) return ParsedSpans{};
+    auto chunks = planChunks(*notes, options);
+    if (chunks.size() == 1) return scanSpans(std::move(notes));
+
+    std::string_view text(*notes);
+    std::vector<ParsedSpans> parts(chunks.size());
+    forEachChunk(chunks.size(), options.threads, [&](size_t index) {
+        scanInto(text.substr(chunks[index].offset, chunks[index].length), parts[index]);
+    });
+
+    ParsedSpans spans;
+    for (size_t index = 0; index < parts.size(); ++index) {
+        auto& part = parts[index];
+        for (auto* list : {&part.concepts, &part.definitions, &part.formulas, &part.examples, &part.keywords}) {
+            shiftSpans(*list, chunks[index].offset);
+        }
+        appendAll(spans.concepts, part.concepts);
+        appendAll(spans.definitions, part.definitions);
+        appendAll(spans.formulas, part.formulas);
+        appendAll(spans.examples, part.examples);
+        appendAll(spans.keywords, part.keywords);
+    }
+
+    // Stable: of equal words the earliest chunk's (first) occurrence is kept
+    auto less = [text](const TextSpan& a, const TextSpan& b) {
+        return text.substr(a.offset, a.length) < text.substr(b.offset, b.length);
+    };
+    auto equal = [text](const TextSpan& a, const TextSpan& b) {
+        return text.substr(a.offset, a.length) == text.substr(b.offset, b.length);
+    };
+    for (auto* words : {&spans.concepts, &spans.keywords}) {
+        std::stable_sort(words->begin(), words->end(), less);
+        words->erase(std::unique(words->begin(), words->end(), equal), words->end());
+    }
+
+    spans.notes = std::move(notes);
+    return spans;
+}
+
+std::vector<std::string> extractConcepts(const std::string& text) {
+    return scanContent(text).concepts;
+}
+
+std::vector<std::string> extractDefinitions(const std::string& text) {
+    return scanContent(text).definitions;
+}
+
+std::vector<std::string> extractFormulas(const std::string& text) {
+    return scanContent(text).formulas;
+}
+
+std::vector<std::string> extractExamples(const std::string& text) {
+    return scanContent(text).examples;
+}
+
+std::vector<std::string> extractKeywords(const std::string& text) {
+    return scanContent(text).keywords;
 }
 
 std::string cleanText(const std::string& text) {
-    std::string cleaned = text;
-    
-    // Remove extra whitespace
-    std::regex whitespace_pattern(R"(\s+)");
-    cleaned = std::regex_replace(cleaned, whitespace_pattern, " ");
-    
-    // Trim leading/trailing whitespace
-    cleaned.erase(0, cleaned.find_first_not_of(" \t\n\r"));
-    cleaned.erase(cleaned.find_last_not_of(" \t\n\r") + 1);
-    
+    // Collapse whitespace runs to one space and trim
+    std::string cleaned;
+    cleaned.reserve(text.size());
+    appendClean(text, cleaned);
     return cleaned;
 }
 
 } // namespace parsing
 
+// ParsedSpans implementation
+std::string_view ParsedSpans::view(const TextSpan& span) const {
+    if (!notes || span.offset > notes->size()) return {};
+    return std::string_view(*notes).substr(span.offset, span.length);
+}
+
+std::string ParsedSpans::text(const TextSpan& span) const {
+    std::string cleaned;
+    parsing::appendClean(view(span), cleaned);
+    return cleaned;
+}
+
+TextSpan ParsedSpans::paragraphOf(const TextSpan& span) const {
+    if (!notes || span.offset > notes->size()) return TextSpan{};
+    std::string_view text(*notes);
+    size_t span_begin = span.offset;
+    size_t span_end = std::min(text.size(), span.offset + span.length);
+
+    // Sentence spans start with the whitespace after the previous '.'
+    while (span_begin < span_end && parsing::isSpaceChar(text[span_begin])) ++span_begin;
+    while (span_end > span_begin && parsing::isSpaceChar(text[span_end - 1])) --span_end;
+
+    // Paragraphs are separated by blank lines: whitespace runs holding two newlines
+    size_t begin = span_begin;
+    int newlines = 0;
+    for (size_t i = span_begin; i > 0; --i) {
+        char c = text[i - 1];
+        if (!parsing::isSpaceChar(c)) {
+            begin = i - 1;
+            newlines = 0;
+        } else if (c == '\n' && ++newlines == 2) {
+            break;
+        }
+    }
+
+    size_t end = span_end;
+    newlines = 0;
+    for (size_t i = span_end; i < text.size(); ++i) {
+        char c = text[i];
+        if (!parsing::isSpaceChar(c)) {
+            end = i + 1;
+            newlines = 0;
+        } else if (c == '\n' && ++newlines == 2) {
+            break;
+        }
+    }
+
+    return TextSpan{begin, end - begin};
+}
+
+ParsedContent ParsedSpans::materialize() const {
+    if (!notes) return ParsedContent{};
+    return parsing::materializeSpans(*notes, *this);
+}
+
 // Question generation utilities
 namespace generation {
 
-std::vector<nlohmann::json> generateMCOptions(const std::string& correct_answer,
-                                            const std::vector<std::string>& distractors,
-                                            int num_options) {
-    std::vector<nlohmann::json> options;
+std::vector<MCOption> generateMCOptions(const std::string& correct_answer,
+                                       const std::vector<std::string>& distractors,
+                                       int num_options) {
+    std::vector<MCOption> options;
     
     // Add correct answer
-    nlohmann::json correct_option;
-    correct_option["value"] = correct_answer;
-    correct_option["label"] = correct_answer;
-    options.push_back(correct_option);
+    options.push_back(MCOption{correct_answer, correct_answer});
     
     // Add distractors
     for (const auto& distractor : distractors) {
         if (options.size() >= static_cast<size_t>(num_options)) break;
-        
-        nlohmann::json option;
-        option["value"] = distractor;
-        option["label"] = distractor;
-        options.push_back(option);
+        options.push_back(MCOption{distractor, distractor});
     }
     
     // Shuffle options
@@ -377,14 +759,14 @@ std::vector<nlohmann::json> generateMCOptions(const std::string& correct_answer,
     return options;
 }
 
-std::vector<std::string> generateDistractors(const std::string& concept,
+std::vector<std::string> generateDistractors(const std::string& target_concept,
                                            const std::vector<std::string>& available_concepts,
                                            int num_distractors) {
     std::vector<std::string> distractors;
     
     // Simple distractor generation - use other concepts
     for (const auto& other_concept : available_concepts) {
-        if (other_concept != concept && distractors.size() < static_cast<size_t>(num_distractors)) {
+        if (other_concept != target_concept && distractors.size() < static_cast<size_t>(num_distractors)) {
             distractors.push_back(other_concept);
         }
     }
@@ -395,75 +777,76 @@ std::vector<std::string> generateDistractors(const std::string& concept,
     return distractors;
 }
 
-nlohmann::json applyTemplate(const QuestionTemplate& template,
-                           const ParsedContent& content,
-                           const std::string& difficulty,
-                           int seed) {
-    nlohmann::json question;
-    
+Question applyTemplate(const QuestionTemplate& question_template,
+                       const ParsedContent& content,
+                       const std::string& difficulty,
+                       int seed) {
     // Generate unique ID
     std::stringstream id_stream;
-    id_stream << template.type << "_" << seed;
-    question["id"] = id_stream.str();
-    question["type"] = template.type;
+    id_stream << question_template.type << "_" << seed;
+    std::string id = id_stream.str();
     
     // Apply template to generate prompt
-    std::string prompt = template.prompt_template;
+    std::string prompt = question_template.prompt_template;
     
     // Simple template substitution
     if (prompt.find("{concept}") != std::string::npos && !content.concepts.empty()) {
         std::mt19937 rng(seed);
         std::uniform_int_distribution<int> dist(0, content.concepts.size() - 1);
-        std::string concept = content.concepts[dist(rng)];
-        prompt = std::regex_replace(prompt, std::regex(R"(\{concept\})"), concept);
+        const std::string& selected_concept = content.concepts[dist(rng)];
+        prompt = std::regex_replace(prompt, std::regex(R"(\{concept\})"), selected_concept);
     }
     
-    question["prompt"] = prompt;
-    
     // Generate question-specific content based on type
-    if (template.type == "multiple_choice") {
+    if (question_template.type == "multiple_choice") {
         // Generate options
         std::string correct_answer = "Correct Answer"; // TODO: Generate based on content
         auto distractors = generateDistractors(correct_answer, content.concepts, 3);
-        auto options = generateMCOptions(correct_answer, distractors, 4);
         
-        question["options"] = options;
-        question["correctAnswer"] = correct_answer;
-        question["explanation"] = "This is the correct answer because..."; // TODO: Generate explanation
-        
-    } else if (template.type == "short_answer") {
-        question["sampleAnswer"] = "Sample answer based on the content..."; // TODO: Generate sample answer
-        question["rubric"] = nlohmann::json::array();
+        MultipleChoiceQuestion question;
+        question.id = id;
+        question.prompt = prompt;
+        question.options = generateMCOptions(correct_answer, distractors, 4);
+        question.correct_answer = correct_answer;
+        question.explanation = "This is the correct answer because..."; // TODO: Generate explanation
+        return question;
+    }
+    
+    if (question_template.type == "short_answer") {
+        ShortAnswerQuestion question;
+        question.id = id;
+        question.prompt = prompt;
+        question.sample_answer = "Sample answer based on the content..."; // TODO: Generate sample answer
         
         // Add basic rubric
-        nlohmann::json criterion;
-        criterion["criterion"] = "Understanding";
-        criterion["points"] = 5;
-        criterion["keywords"] = nlohmann::json::array({"understand", "explain", "describe"});
-        question["rubric"].push_back(criterion);
-        
-    } else if (template.type == "fill_in_blank") {
-        question["correctAnswer"] = "Correct Answer"; // TODO: Generate based on content
-        question["explanation"] = "This is correct because..."; // TODO: Generate explanation
+        question.rubric.push_back(RubricCriterion{"Understanding", 5, {"understand", "explain", "describe"}});
+        return question;
     }
     
-    return question;
+    if (question_template.type == "fill_in_blank") {
+        FillInBlankQuestion question;
+        question.id = id;
+        question.prompt = prompt;
+        question.correct_answer = "Correct Answer"; // TODO: Generate based on content
+        question.explanation = "This is correct because..."; // TODO: Generate explanation
+        return question;
+    }
+    
+    throw std::invalid_argument("Unknown question type: " + question_template.type);
 }
 
-bool validateQuestion(const nlohmann::json& question) {
+bool validateQuestion(const Question& question) {
     // Basic validation
-    if (!question.contains("id") || !question.contains("type") || !question.contains("prompt")) {
+    if (questionId(question).empty() || questionPrompt(question).empty()) {
         return false;
     }
     
-    std::string type = question["type"];
-    
-    if (type == "multiple_choice") {
-        return question.contains("options") && question.contains("correctAnswer");
-    } else if (type == "short_answer") {
-        return question.contains("sampleAnswer") && question.contains("rubric");
-    } else if (type == "fill_in_blank") {
-        return question.contains("correctAnswer");
+    if (auto* mcq = std::get_if<MultipleChoiceQuestion>(&question)) {
+        return !mcq->options.empty() && !mcq->correct_answer.empty();
+    } else if (auto* saq = std::get_if<ShortAnswerQuestion>(&question)) {
+        return !saq->sample_answer.empty() && !saq->rubric.empty();
+    } else if (auto* fib = std::get_if<FillInBlankQuestion>(&question)) {
+        return !fib->correct_answer.empty();
     }
     
     return false;
@@ -1,9 +1,10 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
-#include <nlohmann/json.hpp>
+#include "../types/quiz_types.h"
 
 namespace studyhive {
 namespace core {
@@ -24,6 +25,44 @@ struct ParsedContent {
     std::vector<std::string> keywords;
 };
 
+// Byte range of the notes text
+struct TextSpan {
+    size_t offset = 0;
+    size_t length = 0;
+};
+
+// ParsedContent as spans into the notes, which it keeps alive: parsing copies
+// no text, and sentences are normalized (cleanText) only when asked for.
+// Field order and sort/unique semantics match ParsedContent; concepts and
+// keywords point at the first occurrence of each distinct word.
+struct ParsedSpans {
+    std::shared_ptr<const std::string> notes;
+    std::vector<TextSpan> concepts;
+    std::vector<TextSpan> definitions;
+    std::vector<TextSpan> formulas;
+    std::vector<TextSpan> examples;
+    std::vector<TextSpan> keywords;
+
+    // Raw text of a span (valid while notes is alive)
+    std::string_view view(const TextSpan& span) const;
+
+    // Whitespace-normalized text, as in ParsedContent
+    std::string text(const TextSpan& span) const;
+
+    // Paragraph (blank-line separated, trimmed) containing span, to cite the source
+    TextSpan paragraphOf(const TextSpan& span) const;
+
+    // Copy everything out; equal to parsing::scanContent(*notes)
+    ParsedContent materialize() const;
+};
+
+struct TextEdit;
+
+struct ParallelParseOptions {
+    int threads = 0;                        // 0: hardware concurrency
+    size_t min_chunk_bytes = 256 * 1024;    // Shorter notes are parsed serially
+};
+
 class QuestionGenerator {
 public:
     QuestionGenerator();
@@ -32,20 +71,37 @@ public:
     // Initialize the generator with templates and rules
     bool initialize();
 
-    // Parse notes content into structured data
+    // Parse notes content into structured data (in chunks on worker threads
+    // once the notes reach ParallelParseOptions::min_chunk_bytes)
     ParsedContent parseContent(const std::string& notes);
 
+    // Parse a note as it is edited: notes is the note last passed here with
+    // edit applied, and only the paragraphs around the edit are re-scanned
+    // (IncrementalParser). The result is valid until the next call.
+    const ParsedContent& parseEditedContent(const std::string& notes, const TextEdit& edit);
+
+    // Stream a notes file through the parser (parseNotesFile), so memory
+    // does not grow with the size of the file
+    bool parseContentFile(const std::string& path, ParsedContent& content, std::string& error_msg);
+
+    // Same parse without copying text out of the notes
+    ParsedSpans parseContentSpans(std::shared_ptr<const std::string> notes);
+
+    // parseContent with explicit chunking options; same result as parsing::scanContent
+    ParsedContent parseContentParallel(const std::string& notes,
+                                       const ParallelParseOptions& options = ParallelParseOptions());
+
     // Generate quiz questions based on parsed content
-    std::vector<nlohmann::json> generateQuestions(const ParsedContent& content,
-                                                 const std::string& difficulty,
-                                                 int num_questions,
-                                                 int seed = 42);
+    std::vector<Question> generateQuestions(const ParsedContent& content,
+                                            const std::string& difficulty,
+                                            int num_questions,
+                                            int seed = 42);
 
     // Get available question templates
     std::vector<QuestionTemplate> getTemplates() const;
 
     // Add custom question template
-    void addTemplate(const QuestionTemplate& template);
+    void addTemplate(const QuestionTemplate& question_template);
 
 private:
     class Impl;
@@ -78,6 +134,26 @@ std::vector<QuestionTemplate> getAllTemplates();
 // Content parsing utilities
 namespace parsing {
 
+// Fill every ParsedContent field in one linear pass (what parseContent uses);
+// the extract* functions below return single fields of the same scan
+ParsedContent scanContent(std::string_view text);
+
+// Same scan, recorded as spans into notes
+ParsedSpans scanSpans(std::shared_ptr<const std::string> notes);
+
+// Cut text into pieces of about chunk_bytes that parse independently: each
+// cut follows a sentence end, preferably at a paragraph break
+std::vector<TextSpan> splitChunks(std::string_view text, size_t chunk_bytes);
+
+// Paragraphs that parse independently: cut after each '.' followed by a blank
+// line (a paragraph with no full stop before the blank line runs on)
+std::vector<TextSpan> splitParagraphs(std::string_view text);
+
+// scanContent / scanSpans over splitChunks pieces on worker threads, merged in
+// text order (concepts and keywords re-sorted and deduplicated as in the serial scan)
+ParsedContent scanContentParallel(const std::string& text, const ParallelParseOptions& options);
+ParsedSpans scanSpansParallel(std::shared_ptr<const std::string> notes, const ParallelParseOptions& options);
+
 // Extract concepts from text
 std::vector<std::string> extractConcepts(const std::string& text);
 
@@ -102,23 +178,23 @@ std::string cleanText(const std::string& text);
 namespace generation {
 
 // Generate multiple choice options with distractors
-std::vector<nlohmann::json> generateMCOptions(const std::string& correct_answer,
-                                             const std::vector<std::string>& distractors,
-                                             int num_options = 4);
+std::vector<MCOption> generateMCOptions(const std::string& correct_answer,
+                                        const std::vector<std::string>& distractors,
+                                        int num_options = 4);
 
 // Generate distractors using WordNet
-std::vector<std::string> generateDistractors(const std::string& concept,
+std::vector<std::string> generateDistractors(const std::string& target_concept,
                                            const std::vector<std::string>& available_concepts,
                                            int num_distractors = 3);
 
 // Apply template to content
-nlohmann::json applyTemplate(const QuestionTemplate& template,
-                           const ParsedContent& content,
-                           const std::string& difficulty,
-                           int seed);
+Question applyTemplate(const QuestionTemplate& question_template,
+                       const ParsedContent& content,
+                       const std::string& difficulty,
+                       int seed);
 
 // Validate generated question
-bool validateQuestion(const nlohmann::json& question);
+bool validateQuestion(const Question& question);
 
 } // namespace generation
 
@@ -1,57 +1,328 @@
 #include "engine_selector.h"
+#include "../llm/llama_bridge.h"
+#include "../rules/grading.h"
+#include "../cache/kv_store.h"
+#include "../wordnet/wn_adapter.h"
+#include "../download/model_downloader.h"
+#include "../download/model_delta.h"
+#include "../download/sha256.h"
+#include "../download/verification_cache.h"
 #include <filesystem>
 #include <fstream>
 #include <chrono>
 #include <thread>
+#include <optional>
+#include <mutex>
+#include <deque>
+#include <list>
+#include <algorithm>
+#include <future>
+#include <atomic>
+#include <condition_variable>
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#include <sys/qos.h>
+#endif
 
 namespace studyhive {
 namespace core {
 
+namespace {
+
+struct Outcome {
+    float latency_ms;
+    bool success;
+};
+
+// Best effort: background CPU and I/O priority for the calling thread
+void lowerThreadPriority() {
+#if defined(__linux__)
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19);
+#ifdef SYS_ioprio_set
+    syscall(SYS_ioprio_set, 1 /* IOPRIO_WHO_PROCESS */, 0, 3 << 13 /* IOPRIO_CLASS_IDLE */);
+#endif
+#elif defined(__APPLE__)
+    pthread_set_qos_class_self_np(QOS_CLASS_BACKGROUND, 0);
+#endif
+}
+
+size_t engineIndex(Engine engine) { return engine == Engine::LLM ? 0 : 1; }
+size_t typeIndex(RequestType type) { return type == RequestType::GRADING ? 1 : 0; }
+
+float elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool llmSucceeded(const LLMResponse& response) {
+    // Truncated output (deadline, max tokens) counts as a failure
+    return response.success && response.stop_reason == StopReason::COMPLETED;
+}
+
+// LLM grading request that lost a hedge race, kept until its future resolves
+struct PendingGrade {
+    std::future<LLMResponse> response;
+    CancellationToken cancel_token;
+    KVStore* cache = nullptr;  // Null: cancelled, result discarded
+    validation::ResponseSchemas schemas;  // Of the bridge that ran it
+    std::string question_id;
+    std::string student_answer;
+};
+
+EngineTelemetry summarize(const std::deque<Outcome>& window) {
+    EngineTelemetry telemetry;
+    telemetry.samples = window.size();
+    if (window.empty()) {
+        return telemetry;
+    }
+
+    std::vector<float> latencies;
+    latencies.reserve(window.size());
+    size_t successes = 0;
+    float total = 0.0f;
+    for (const auto& outcome : window) {
+        latencies.push_back(outcome.latency_ms);
+        total += outcome.latency_ms;
+        if (outcome.success) ++successes;
+    }
+
+    size_t p90 = (latencies.size() * 9) / 10;
+    if (p90 >= latencies.size()) p90 = latencies.size() - 1;
+    std::nth_element(latencies.begin(), latencies.begin() + p90, latencies.end());
+
+    telemetry.success_rate = static_cast<float>(successes) / window.size();
+    telemetry.mean_latency_ms = total / window.size();
+    telemetry.p90_latency_ms = latencies[p90];
+    return telemetry;
+}
+
+} // namespace
+
 class EngineSelector::Impl {
 public:
     Impl() : connectivity_status_(ConnectivityStatus::UNKNOWN),
+             model_installed_(false),
              forced_engine_(std::nullopt),
              download_queued_(false),
              download_progress_(0.0f) {}
 
+    ~Impl() {
+        stopModelDownload();
+        stopVerification();
+        stopPrewarm();
+        {
+            std::lock_guard<std::mutex> lock(memory_mutex_);
+            setMemoryConsumers(nullptr, nullptr, nullptr);
+        }
+
+        // The reaper waits for the pending futures; stop their decoding first
+        std::thread reaper;
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex_);
+            for (auto& pending : pending_grades_) {
+                pending.cancel_token.cancel();
+            }
+            reaper = std::move(reaper_thread_);
+        }
+        pending_cv_.notify_all();
+        if (reaper.joinable()) {
+            reaper.join();
+        }
+    }
+
     bool initialize(const EngineConfig& config) {
+        // Both threads read config_; a queued download restarts below
+        stopVerification();
+        stopModelDownload();
         config_ = config;
+        verification_cache_.reset();
+        memory_governor_->setLimit(config.memory_limit_bytes);
         
         // Check if model is installed
+        stopPrewarm();
+        prewarm_state_ = PrewarmState::NOT_STARTED;
         model_installed_ = checkModelInstallation();
         
         // Initialize connectivity monitoring (platform-specific)
         initializeConnectivityMonitoring();
-        
+
+        startPrewarm();
+        if (download_queued_ && connectivity_status_ == ConnectivityStatus::ONLINE) {
+            startModelDownload();
+        }
         return true;
     }
 
-    Engine chooseEngine() {
-        // Check for forced engine selection
-        if (forced_engine_.has_value()) {
-            return forced_engine_.value();
+    Engine chooseEngine(const RoutingRequest& request) {
+        RoutingDecision decision;
+        {
+            std::lock_guard<std::mutex> lock(routing_mutex_);
+            auto now = std::chrono::steady_clock::now();
+            decision = decide(request, now);
+            if (decision.reason == RoutingReason::PROBE) {
+                last_llm_activity_[typeIndex(request.type)] = now;
+            }
+            last_decisions_[typeIndex(request.type)] = decision;
+            decision_order_[typeIndex(request.type)] = ++decision_count_;
         }
 
-        // If rules-only mode is forced
-        if (config_.force_rules_only) {
-            return Engine::RULES;
+        // No model installed (one still being verified is not replaced)
+        if (decision.reason == RoutingReason::MODEL_NOT_INSTALLED &&
+            model_verification_ != ModelVerification::VERIFYING &&
+            getConnectivityStatus() == ConnectivityStatus::ONLINE) {
+            // Prompt to download model if not already queued
+            if (!download_queued_) {
+                queueModelDownload();
+            }
         }
 
-        // If model is installed, prefer LLM (works offline too)
-        if (model_installed_) {
-            return Engine::LLM;
+        return decision.engine;
+    }
+
+    void requestStarted(Engine engine) {
+        if (engine == Engine::LLM) {
+            cancelPrewarm();
         }
+        std::lock_guard<std::mutex> lock(routing_mutex_);
+        ++in_flight_[engineIndex(engine)];
+    }
 
-        // No model installed
-        if (getConnectivityStatus() == ConnectivityStatus::ONLINE) {
-            // Prompt to download model if not already queued
-            if (!download_queued_) {
-                queueModelDownload();
+    void recordResult(Engine engine, RequestType type, float latency_ms, bool success) {
+        std::lock_guard<std::mutex> lock(routing_mutex_);
+        int& in_flight = in_flight_[engineIndex(engine)];
+        if (in_flight > 0) --in_flight;
+
+        auto& window = outcomes_[engineIndex(engine)][typeIndex(type)];
+        window.push_back({std::max(latency_ms, 0.0f), success});
+        while (window.size() > std::max<size_t>(routing_config_.window_size, 1)) {
+            window.pop_front();
+        }
+
+        if (engine == Engine::LLM) {
+            last_llm_activity_[typeIndex(type)] = std::chrono::steady_clock::now();
+        }
+    }
+
+    void setRoutingConfig(const RoutingConfig& config) {
+        std::lock_guard<std::mutex> lock(routing_mutex_);
+        routing_config_ = config;
+        for (auto& per_engine : outcomes_) {
+            for (auto& window : per_engine) {
+                while (window.size() > std::max<size_t>(config.window_size, 1)) {
+                    window.pop_front();
+                }
             }
         }
-        
-        // Use rules engine as fallback
-        return Engine::RULES;
+    }
+
+    HedgedGrade gradeHedged(const Question& question, const std::string& student_answer,
+                            LLMBridge& bridge, GradingEngine& rules, const HedgeOptions& options) {
+        auto start = std::chrono::steady_clock::now();
+        HedgedGrade result;
+        const std::string& question_id = questionId(question);
+        const auto* short_answer = std::get_if<ShortAnswerQuestion>(&question);
+
+        if (short_answer && options.cache) {
+            std::string source;
+            if (quiz_cache::getCachedGrade(*options.cache, question_id, student_answer, "device-llm",
+                                           result.grade, source)) {
+                result.engine = Engine::LLM;
+                result.cache_hit = true;
+                result.llm_valid = true;
+                result.total_time_ms = elapsedMs(start);
+                return result;
+            }
+        }
+
+        bool rules_forced = config_.force_rules_only;
+        {
+            std::lock_guard<std::mutex> lock(routing_mutex_);
+            rules_forced = rules_forced || forced_engine_ == Engine::RULES;
+        }
+        bool hedge = short_answer && model_installed_ && !rules_forced && bridge.isReady();
+        bool keep_late = options.finish_late_llm && options.cache;
+
+        // Start the LLM first so it decodes while the rules engine runs
+        std::future<LLMResponse> llm_future;
+        CancellationToken cancel_token;
+        if (hedge) {
+            GenerationOptions generation;
+            generation.cancel_token = cancel_token;
+            float bridge_deadline_ms = keep_late ? std::max(options.late_deadline_ms, options.deadline_ms)
+                                                 : options.deadline_ms;
+            generation.deadline = start + std::chrono::microseconds(static_cast<int64_t>(bridge_deadline_ms * 1000.0f));
+            requestStarted(Engine::LLM);
+            llm_future = bridge.gradeAnswerAsync(prompts::buildGradePrompt(*short_answer, student_answer),
+                                                 options.grammar_path, generation);
+        }
+
+        requestStarted(Engine::RULES);
+        GradingResult rules_result = rules.grade(question, student_answer);
+        recordResult(Engine::RULES, RequestType::GRADING, rules_result.processing_time_ms,
+                     grading::validateGradingResult(rules_result));
+        result.rules_time_ms = rules_result.processing_time_ms;
+        result.grade = grading::toGradePayload(rules_result, question_id);
+
+        if (!hedge) {
+            result.total_time_ms = elapsedMs(start);
+            return result;
+        }
+
+        auto deadline = start + std::chrono::microseconds(static_cast<int64_t>(options.deadline_ms * 1000.0f));
+        if (llm_future.wait_until(deadline) == std::future_status::ready) {
+            LLMResponse response = llm_future.get();
+            recordResult(Engine::LLM, RequestType::GRADING, response.processing_time_ms, llmSucceeded(response));
+
+            GradePayload llm_grade;
+            if (!llmSucceeded(response)) {
+                result.llm_error = response.success ? "LLM output truncated" : response.error_message;
+            } else if (validation::parseGradePayload(bridge.responseSchemas(), response.content, llm_grade,
+                                                     result.llm_error)) {
+                if (options.cache) {
+                    quiz_cache::cacheGrade(*options.cache, question_id, student_answer, "device-llm", llm_grade);
+                }
+                result.grade = std::move(llm_grade);
+                result.engine = Engine::LLM;
+                result.llm_valid = true;
+            }
+        } else {
+            // Rules grade wins; the LLM is cancelled or left to finish for the cache
+            result.llm_error = keep_late ? "LLM missed the deadline; finishing in background"
+                                         : "LLM missed the deadline";
+            if (!keep_late) {
+                cancel_token.cancel();
+            }
+
+            PendingGrade pending;
+            pending.response = std::move(llm_future);
+            pending.cancel_token = cancel_token;
+            pending.cache = keep_late ? options.cache : nullptr;
+            pending.schemas = bridge.responseSchemas();
+            pending.question_id = question_id;
+            pending.student_answer = student_answer;
+            std::lock_guard<std::mutex> lock(pending_mutex_);
+            pending_grades_.push_back(std::move(pending));
+            if (!reaper_running_) {
+                // A previous reaper that found the list empty is on its way out
+                if (reaper_thread_.joinable()) {
+                    reaper_thread_.join();
+                }
+                reaper_running_ = true;
+                reaper_thread_ = std::thread([this]() { reapPendingGrades(); });
+            }
+        }
+
+        result.total_time_ms = elapsedMs(start);
+        return result;
+    }
+
+    EngineTelemetry getTelemetry(Engine engine, RequestType type) const {
+        std::lock_guard<std::mutex> lock(routing_mutex_);
+        return summarize(outcomes_[engineIndex(engine)][typeIndex(type)]);
     }
 
     bool isModelInstalled() const {
@@ -87,6 +358,7 @@ public:
     }
 
     void clearModelDownloadQueue() {
+        stopModelDownload();
         download_queued_ = false;
         download_progress_ = 0.0f;
     }
@@ -96,31 +368,253 @@ public:
     }
 
     void setDownloadProgressCallback(std::function<void(float)> callback) {
-        download_progress_callback_ = callback;
+        std::lock_guard<std::mutex> lock(progress_callback_mutex_);
+        download_progress_callback_ = std::move(callback);
+    }
+
+    void setDownloadTransport(std::shared_ptr<DownloadTransport> transport) {
+        download_transport_ = transport;
     }
 
     void forceEngine(Engine engine) {
-        forced_engine_ = engine;
+        {
+            std::lock_guard<std::mutex> lock(routing_mutex_);
+            forced_engine_ = engine;
+        }
+        if (engine == Engine::LLM) {
+            startPrewarm();
+        }
+    }
+
+    void setPrewarmBridge(LLMBridge* bridge) {
+        stopPrewarm();
+        {
+            std::lock_guard<std::mutex> lock(prewarm_mutex_);
+            prewarm_bridge_ = bridge;
+        }
+        {
+            std::lock_guard<std::mutex> lock(memory_mutex_);
+            setMemoryConsumers(bridge, memory_cache_, memory_wordnet_);
+        }
+        prewarm_state_ = PrewarmState::NOT_STARTED;
+        prewarm_progress_ = 0.0f;
+        startPrewarm();
+    }
+
+    bool startPrewarm() {
+        std::lock_guard<std::mutex> lock(prewarm_mutex_);
+        PrewarmState state = prewarm_state_;
+        if (!prewarm_bridge_ || !model_installed_ || !prewarm_bridge_->isReady() ||
+            state == PrewarmState::RUNNING || state == PrewarmState::DONE) {
+            return false;
+        }
+        if (prewarm_thread_.joinable()) {
+            prewarm_thread_.join();
+        }
+
+        PrewarmOptions options;
+        prewarm_cancel_ = options.cancel_token;
+        options.progress = [this](float progress) { prewarm_progress_ = progress; };
+        prewarm_state_ = PrewarmState::RUNNING;
+        prewarm_progress_ = 0.0f;
+        prewarm_thread_ = std::thread([this, bridge = prewarm_bridge_, options]() {
+            lowerThreadPriority();
+            PrewarmResult result = bridge->prewarm(options);
+            prewarm_state_ = result.completed ? PrewarmState::DONE
+                           : result.cancelled ? PrewarmState::CANCELLED : PrewarmState::FAILED;
+        });
+        return true;
+    }
+
+    // Does not wait: the prewarm stops at its next step on its own
+    void cancelPrewarm() {
+        std::lock_guard<std::mutex> lock(prewarm_mutex_);
+        prewarm_cancel_.cancel();
+    }
+
+    void stopPrewarm() {
+        std::thread thread;
+        {
+            std::lock_guard<std::mutex> lock(prewarm_mutex_);
+            prewarm_cancel_.cancel();
+            thread = std::move(prewarm_thread_);
+        }
+        if (thread.joinable()) {
+            thread.join();
+        }
     }
 
     void resetToAutomatic() {
+        std::lock_guard<std::mutex> lock(routing_mutex_);
         forced_engine_ = std::nullopt;
     }
 
     EngineSelector::EngineStatus getStatus() const {
-        Engine current_engine = chooseEngine();
-        
+        std::lock_guard<std::mutex> lock(routing_mutex_);
+
+        // What a default request would get now, without recording it
+        Engine current_engine = decide(RoutingRequest(), std::chrono::steady_clock::now()).engine;
+
+        std::vector<RoutingDecision> last_decisions;
+        size_t first = decision_order_[0] <= decision_order_[1] ? 0 : 1;
+        for (size_t index : {first, 1 - first}) {
+            if (last_decisions_[index]) last_decisions.push_back(*last_decisions_[index]);
+        }
+
         return {
             .current_engine = current_engine,
             .ai_boost_enabled = (current_engine == Engine::LLM),
             .model_available = model_installed_,
             .connectivity = connectivity_status_,
             .download_queued = download_queued_,
-            .download_progress = download_progress_
+            .download_progress = download_progress_,
+            .download_is_delta = download_is_delta_,
+            .download_error = getDownloadError(),
+            .model_verification = model_verification_,
+            .prewarm_state = prewarm_state_,
+            .prewarm_progress = prewarm_progress_,
+            .llm_queue_depth = in_flight_[engineIndex(Engine::LLM)],
+            .last_decisions = std::move(last_decisions)
         };
     }
 
+    void attachCache(KVStore* cache) {
+        std::lock_guard<std::mutex> lock(memory_mutex_);
+        setMemoryConsumers(memory_bridge_, cache, memory_wordnet_);
+    }
+
+    void attachWordNet(WordNetAdapter* wordnet) {
+        std::lock_guard<std::mutex> lock(memory_mutex_);
+        setMemoryConsumers(memory_bridge_, memory_cache_, wordnet);
+    }
+
+    MemoryReport getMemoryReport() const {
+        return memory_governor_->getReport();
+    }
+
 private:
+    // Caller holds routing_mutex_
+    RoutingDecision decide(const RoutingRequest& request,
+                           std::chrono::steady_clock::time_point now) const {
+        RoutingDecision decision;
+        decision.type = request.type;
+        decision.deadline_ms = request.deadline_ms;
+        decision.llm_queue_depth = in_flight_[engineIndex(Engine::LLM)];
+
+        EngineTelemetry llm = summarize(outcomes_[engineIndex(Engine::LLM)][typeIndex(request.type)]);
+        EngineTelemetry rules = summarize(outcomes_[engineIndex(Engine::RULES)][typeIndex(request.type)]);
+
+        // Requests ahead in the queue each take about the mean; ours about the p90
+        if (llm.samples > 0) {
+            decision.llm_estimate_ms = llm.mean_latency_ms * decision.llm_queue_depth + llm.p90_latency_ms;
+        }
+        decision.rules_estimate_ms = rules.p90_latency_ms;
+
+        auto route = [&decision](Engine engine, RoutingReason reason) {
+            decision.engine = engine;
+            decision.reason = reason;
+            return decision;
+        };
+
+        // Check for forced engine selection
+        if (forced_engine_.has_value()) {
+            return route(forced_engine_.value(), RoutingReason::FORCED);
+        }
+
+        // If rules-only mode is forced
+        if (config_.force_rules_only) {
+            return route(Engine::RULES, RoutingReason::RULES_ONLY);
+        }
+
+        if (!model_installed_) {
+            return route(Engine::RULES, RoutingReason::MODEL_NOT_INSTALLED);
+        }
+
+        if (decision.llm_queue_depth >= routing_config_.max_llm_queue_depth) {
+            return route(Engine::RULES, RoutingReason::QUEUE_DEPTH);
+        }
+
+        // If model is installed, prefer LLM (works offline too) until telemetry says otherwise
+        if (llm.samples < routing_config_.min_samples) {
+            return route(Engine::LLM, RoutingReason::NO_TELEMETRY);
+        }
+
+        // Avoiding the LLM starves its telemetry; let one request through now and
+        // then while it is idle so a recovered LLM gets picked up again
+        bool probe_due = decision.llm_queue_depth == 0 &&
+            std::chrono::duration<float, std::milli>(now - last_llm_activity_[typeIndex(request.type)]).count() >=
+                routing_config_.probe_interval_ms;
+
+        if (llm.success_rate < routing_config_.min_llm_success_rate) {
+            return probe_due ? route(Engine::LLM, RoutingReason::PROBE)
+                             : route(Engine::RULES, RoutingReason::LOW_SUCCESS_RATE);
+        }
+
+        float margin = routing_config_.deadline_margin;
+        if (request.deadline_ms <= 0.0f || decision.llm_estimate_ms * margin <= request.deadline_ms) {
+            return route(Engine::LLM, RoutingReason::WITHIN_DEADLINE);
+        }
+
+        if (decision.rules_estimate_ms * margin <= request.deadline_ms) {
+            return probe_due ? route(Engine::LLM, RoutingReason::PROBE)
+                             : route(Engine::RULES, RoutingReason::DEADLINE_RISK);
+        }
+
+        return route(decision.llm_estimate_ms <= decision.rules_estimate_ms ? Engine::LLM : Engine::RULES,
+                     RoutingReason::BEST_EFFORT);
+    }
+
+    // Runs on reaper_thread_: settles each hedge loser as soon as its request
+    // ends, in whatever order they finish, and exits once none are left
+    void reapPendingGrades() {
+        std::unique_lock<std::mutex> lock(pending_mutex_);
+        while (!pending_grades_.empty()) {
+            std::vector<PendingGrade> finished;
+            for (auto it = pending_grades_.begin(); it != pending_grades_.end();) {
+                if (it->response.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                    finished.push_back(std::move(*it));
+                    it = pending_grades_.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            if (finished.empty()) {
+                pending_cv_.wait_for(lock, kReapPollInterval);
+                continue;
+            }
+
+            lock.unlock();
+            for (auto& pending : finished) {
+                settlePendingGrade(pending);
+            }
+            lock.lock();
+        }
+        reaper_running_ = false;
+    }
+
+    void settlePendingGrade(PendingGrade& pending) {
+        LLMResponse response = pending.response.get();
+
+        // Cancelled at the hedge deadline (or at shutdown): it leaves the queue
+        // but says nothing about whether the LLM would have succeeded
+        if (!pending.cache || response.stop_reason == StopReason::CANCELLED) {
+            std::lock_guard<std::mutex> lock(routing_mutex_);
+            int& in_flight = in_flight_[engineIndex(Engine::LLM)];
+            if (in_flight > 0) --in_flight;
+            return;
+        }
+
+        recordResult(Engine::LLM, RequestType::GRADING, response.processing_time_ms, llmSucceeded(response));
+
+        GradePayload grade;
+        std::string error_msg;
+        if (llmSucceeded(response) &&
+            validation::parseGradePayload(pending.schemas, response.content, grade, error_msg)) {
+            quiz_cache::cacheGrade(*pending.cache, pending.question_id, pending.student_answer,
+                                   "device-llm", grade);
+        }
+    }
+
     bool checkModelInstallation() {
         if (config_.model_path.empty()) {
             return false;
@@ -129,7 +623,7 @@ private:
         std::filesystem::path model_path(config_.model_path);
         
         // Check if file exists and has reasonable size (> 100MB)
-        if (!std::filesystem::exists(model_path)) {
+        if (!std::filesystem::exists(model_path) || delta::interrupted(config_.model_path)) {
             return false;
         }
 
@@ -138,10 +632,147 @@ private:
             return false;
         }
 
-        // TODO: Add SHA-256 verification
-        // For now, just check file existence and size
-        
-        return true;
+        return verifyModel();
+    }
+
+    // SHA-256 check without rehashing the whole file at every startup: a cached
+    // verification whose file identity still matches only gets a sampled check
+    // now and, when due, a full parallel rehash in the background; a file with
+    // no cached verification is hashed in the background before it is offered
+    bool verifyModel() {
+        if (config_.model_sha256.empty()) {
+            model_verification_ = ModelVerification::NOT_CHECKED;
+            return true;
+        }
+
+        std::string error_msg;
+        FileIdentity identity;
+        if (!integrity::identify(config_.model_path, identity, error_msg)) {
+            model_verification_ = ModelVerification::FAILED;
+            return false;
+        }
+
+        VerificationCache& cache = verificationCache();
+        VerificationRecord record;
+        if (cache.lookup(identity, record)) {
+            if (!sha256::digestEquals(record.sha256, config_.model_sha256)) {
+                // A known older revision: outdated, but a source for a delta
+                model_verification_ = ModelVerification::FAILED;
+                return false;
+            }
+            if (!integrity::sampleCheck(config_.model_path, record, config_.verify_sample_chunks, error_msg)) {
+                cache.invalidate(config_.model_path);
+                cache.save(error_msg);
+                model_verification_ = ModelVerification::FAILED;
+                return false;
+            }
+
+            model_verification_ = ModelVerification::SAMPLED;
+            int64_t age_hours = (std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count() - record.verified_at) / 3600;
+            if (age_hours >= config_.full_verify_interval_hours) {
+                startBackgroundVerification(record);
+            } else {
+                model_verification_ = ModelVerification::VERIFIED;
+            }
+            return true;
+        }
+
+        // First time this file is seen (or it was copied or restored): hash it
+        // in the background rather than holding up initialize()
+        model_verification_ = ModelVerification::VERIFYING;
+        startInitialVerification();
+        return false;
+    }
+
+    VerificationCache& verificationCache() {
+        if (!verification_cache_) {
+            std::string path = config_.verification_cache_path.empty()
+                ? config_.model_path + ".verified.json" : config_.verification_cache_path;
+            verification_cache_ = std::make_unique<VerificationCache>(path);
+            std::string error_msg;
+            verification_cache_->load(error_msg);
+        }
+        return *verification_cache_;
+    }
+
+    void startBackgroundVerification(VerificationRecord record) {
+        verify_cancel_ = false;
+        verify_thread_ = std::thread([this, record = std::move(record)]() mutable {
+            // Leave most cores to foreground work
+            int threads = std::max(1u, std::thread::hardware_concurrency() / 4);
+            std::string error_msg;
+            if (integrity::fullCheck(config_.model_path, record, static_cast<int>(threads), &verify_cancel_, error_msg)) {
+                record.verified_at = std::chrono::duration_cast<std::chrono::seconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+                verification_cache_->store(record);
+                verification_cache_->save(error_msg);
+                model_verification_ = ModelVerification::VERIFIED;
+            } else if (!verify_cancel_) {
+                verification_cache_->invalidate(config_.model_path);
+                verification_cache_->save(error_msg);
+                model_verification_ = ModelVerification::FAILED;
+                model_installed_ = false;
+            }
+        });
+    }
+
+    // One pass computes the published digest and the chunk digests used by
+    // later checks; the model is marked installed only if the digest matches
+    void startInitialVerification() {
+        verify_cancel_ = false;
+        verify_thread_ = std::thread([this]() {
+            integrity::HashOptions options;
+            options.threads = std::max(1u, std::thread::hardware_concurrency() / 4);
+            options.cancel = &verify_cancel_;
+            VerificationRecord record;
+            std::string error_msg;
+            if (!integrity::hashFile(config_.model_path, options, record, error_msg)) {
+                if (!verify_cancel_) {
+                    model_verification_ = ModelVerification::FAILED;
+                }
+                return;
+            }
+
+            // Kept even on a mismatch, so an older revision is recognised for delta updates
+            verification_cache_->store(record);
+            verification_cache_->save(error_msg);
+            if (!sha256::digestEquals(record.sha256, config_.model_sha256)) {
+                model_verification_ = ModelVerification::FAILED;
+                return;
+            }
+            model_verification_ = ModelVerification::VERIFIED;
+            model_installed_ = true;
+            startPrewarm();
+        });
+    }
+
+    void stopVerification() {
+        verify_cancel_ = true;
+        if (verify_thread_.joinable()) {
+            verify_thread_.join();
+        }
+    }
+
+    // The downloader hashed every chunk while downloading; record that as a
+    // full verification
+    void recordDownloadVerification(const DownloadResult& result) {
+        VerificationRecord record;
+        std::string error_msg;
+        if (!integrity::identify(config_.model_path, record.identity, error_msg)) {
+            return;
+        }
+        record.sha256 = result.sha256;
+        record.chunk_bytes = result.chunk_bytes;
+        record.chunk_digests = result.chunk_digests;
+        record.chunk_root = integrity::chunkRoot(result.chunk_digests);
+        record.verified_at = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+
+        VerificationCache& cache = verificationCache();
+        cache.store(record);
+        cache.save(error_msg);
+        model_verification_ = ModelVerification::VERIFIED;
     }
 
     void initializeConnectivityMonitoring() {
@@ -151,34 +782,261 @@ private:
     }
 
     void startModelDownload() {
-        // TODO: Implement actual model download with progress tracking
-        // This would download Phi-3 Mini Instruct GGUF model
-        // For now, simulate download progress
-        
-        std::thread([this]() {
-            for (int i = 0; i <= 100; i += 10) {
-                download_progress_ = i / 100.0f;
-                
+        std::lock_guard<std::mutex> lock(download_mutex_);
+        if (download_active_) {
+            return;
+        }
+        if (download_thread_.joinable()) {
+            download_thread_.join();
+        }
+        if (config_.model_url.empty() || config_.model_path.empty()) {
+            download_error_ = "No model URL configured";
+            return;
+        }
+
+        // The download rewrites the file a verification would be reading
+        stopVerification();
+        std::optional<ModelDelta> delta = findModelDelta();
+        download_active_ = true;
+        download_cancel_ = false;
+        download_is_delta_ = delta.has_value();
+        download_error_.clear();
+        download_thread_ = std::thread([this, delta]() {
+            bool installed = delta && applyModelDelta(*delta);
+
+            DownloadResult result;
+            if (!installed && !download_cancel_) {
+                download_is_delta_ = false;
+                DownloadConfig download_config;
+                download_config.url = config_.model_url;
+                download_config.dest_path = config_.model_path;
+                download_config.expected_sha256 = config_.model_sha256;
+                download_config.parallel_chunks = config_.download_parallel_chunks;
+                result = runDownloader(download_config);
+                if (result.success) {
+                    // Verified while downloading; no second hash pass
+                    delta::clearInterrupted(config_.model_path);
+                    recordDownloadVerification(result);
+                    installed = true;
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(download_mutex_);
+            if (installed) {
+                download_progress_ = 1.0f;
+                model_installed_ = true;
+                download_queued_ = false;
+                download_error_.clear();
+                // New weights on disk: the previous prewarm no longer counts
+                if (prewarm_state_ != PrewarmState::RUNNING) {
+                    prewarm_state_ = PrewarmState::NOT_STARTED;
+                }
+                startPrewarm();
+            } else {
+                // Stays queued; the next start resumes from the chunk map
+                download_error_ = download_cancel_ ? "Download cancelled" : result.error_message;
+            }
+            download_active_ = false;
+        });
+    }
+
+    // A configured delta whose source is the installed file, going by the
+    // verification cache (so no rehash)
+    std::optional<ModelDelta> findModelDelta() {
+        if (config_.model_deltas.empty() || delta::interrupted(config_.model_path)) {
+            return std::nullopt;
+        }
+        std::string error_msg;
+        FileIdentity identity;
+        VerificationRecord record;
+        if (!integrity::identify(config_.model_path, identity, error_msg) ||
+            !verificationCache().lookup(identity, record)) {
+            return std::nullopt;
+        }
+        for (const auto& candidate : config_.model_deltas) {
+            if (sha256::digestEquals(candidate.from_sha256, record.sha256)) {
+                return candidate;
+            }
+        }
+        return std::nullopt;
+    }
+
+    // Runs on download_thread_; stopModelDownload cancels whichever downloader is current
+    DownloadResult runDownloader(const DownloadConfig& download_config) {
+        std::shared_ptr<ModelDownloader> downloader;
+        {
+            std::lock_guard<std::mutex> lock(download_mutex_);
+            if (download_cancel_) {
+                DownloadResult result;
+                result.error_message = "Download cancelled";
+                return result;
+            }
+            downloader_ = std::make_shared<ModelDownloader>(download_config, download_transport_);
+            downloader_->setProgressCallback([this](float progress) {
+                download_progress_ = progress;
+                std::lock_guard<std::mutex> lock(progress_callback_mutex_);
                 if (download_progress_callback_) {
-                    download_progress_callback_(download_progress_);
+                    download_progress_callback_(progress);
                 }
-                
-                std::this_thread::sleep_for(std::chrono::milliseconds(500));
+            });
+            downloader = downloader_;
+        }
+        return downloader->run();
+    }
+
+    // Download the delta and patch the model in place. The model is marked
+    // unavailable meanwhile (callers unload it before queueing an update). On
+    // failure the caller falls back to a full download.
+    bool applyModelDelta(const ModelDelta& model_delta) {
+        DownloadConfig download_config;
+        download_config.url = model_delta.url;
+        download_config.dest_path = config_.model_path + ".delta";
+        download_config.expected_sha256 = model_delta.sha256;
+        download_config.parallel_chunks = config_.download_parallel_chunks;
+        DownloadResult download = runDownloader(download_config);
+        if (!download.success) {
+            return false;
+        }
+
+        // Unavailable first so no new prewarm starts, then stop the one
+        // reading the file before it is patched
+        bool was_installed = model_installed_.exchange(false);
+        stopPrewarm();
+        PatchOptions options;
+        options.verify_source = false;  // Identity matched a verified record
+        options.cancel = &download_cancel_;
+        PatchResult patch = delta::apply(config_.model_path, download_config.dest_path, options);
+        std::error_code ec;
+        std::filesystem::remove(download_config.dest_path, ec);
+
+        VerificationCache& cache = verificationCache();
+        std::string error_msg;
+        if (patch.success) {
+            // The record describes the patched file either way; only a digest
+            // matching model_sha256 makes it the verified revision
+            cache.store(patch.record);
+            cache.save(error_msg);
+            if (!config_.model_sha256.empty() &&
+                !sha256::digestEquals(patch.record.sha256, config_.model_sha256)) {
+                model_verification_ = ModelVerification::FAILED;
+                return false;
             }
-            
-            // Mark model as installed
-            model_installed_ = true;
-            download_queued_ = false;
-        }).detach();
+            model_verification_ = ModelVerification::VERIFIED;
+            return true;
+        }
+
+        if (patch.file_modified) {
+            cache.invalidate(config_.model_path);
+            cache.save(error_msg);
+            model_verification_ = ModelVerification::FAILED;
+        } else {
+            model_installed_ = was_installed;
+        }
+        return false;
+    }
+
+    void stopModelDownload() {
+        std::thread thread;
+        {
+            std::lock_guard<std::mutex> lock(download_mutex_);
+            download_cancel_ = true;
+            if (downloader_) {
+                downloader_->cancel();
+            }
+            thread = std::move(download_thread_);
+        }
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+
+    std::string getDownloadError() const {
+        std::lock_guard<std::mutex> lock(download_mutex_);
+        return download_error_;
+    }
+
+    // Detach the consumers that changed, then attach their replacements.
+    // Caller holds memory_mutex_
+    void setMemoryConsumers(LLMBridge* bridge, KVStore* cache, WordNetAdapter* wordnet) {
+        if (bridge != memory_bridge_) {
+            if (memory_bridge_) memory_bridge_->attachMemoryGovernor(nullptr);
+            if (bridge) bridge->attachMemoryGovernor(memory_governor_.get());
+            memory_bridge_ = bridge;
+        }
+        if (cache != memory_cache_) {
+            if (memory_cache_) memory_cache_->attachMemoryGovernor(nullptr);
+            if (cache) cache->attachMemoryGovernor(memory_governor_.get());
+            memory_cache_ = cache;
+        }
+        if (wordnet != memory_wordnet_) {
+            if (memory_wordnet_) memory_wordnet_->attachMemoryGovernor(nullptr);
+            if (wordnet) wordnet->attachMemoryGovernor(memory_governor_.get());
+            memory_wordnet_ = wordnet;
+        }
     }
 
     EngineConfig config_;
     ConnectivityStatus connectivity_status_;
-    bool model_installed_;
+    std::atomic<bool> model_installed_;
     std::optional<Engine> forced_engine_;
-    bool download_queued_;
-    float download_progress_;
+    std::atomic<bool> download_queued_;
+    std::atomic<float> download_progress_;
+
+    // Set by the app, called from the download threads
+    std::mutex progress_callback_mutex_;
     std::function<void(float)> download_progress_callback_;
+
+    // Model download, run on download_thread_
+    mutable std::mutex download_mutex_;
+    std::shared_ptr<DownloadTransport> download_transport_;  // Null: built-in HTTP
+    std::shared_ptr<ModelDownloader> downloader_;
+    std::thread download_thread_;
+    bool download_active_ = false;
+    std::atomic<bool> download_cancel_{false};
+    std::atomic<bool> download_is_delta_{false};
+    std::string download_error_;
+
+    // Model prewarm, run on prewarm_thread_
+    std::mutex prewarm_mutex_;
+    LLMBridge* prewarm_bridge_ = nullptr;
+    std::thread prewarm_thread_;
+    CancellationToken prewarm_cancel_;
+    std::atomic<PrewarmState> prewarm_state_{PrewarmState::NOT_STARTED};
+    std::atomic<float> prewarm_progress_{0.0f};
+
+    // Memory budget for the attached bridge, cache and WordNet index; the
+    // governor polls on its own thread
+    std::unique_ptr<MemoryGovernor> memory_governor_ = std::make_unique<MemoryGovernor>();
+    std::mutex memory_mutex_;
+    LLMBridge* memory_bridge_ = nullptr;
+    KVStore* memory_cache_ = nullptr;
+    WordNetAdapter* memory_wordnet_ = nullptr;
+
+    // Model integrity
+    std::unique_ptr<VerificationCache> verification_cache_;
+    std::atomic<ModelVerification> model_verification_{ModelVerification::NOT_CHECKED};
+    std::atomic<bool> verify_cancel_{false};
+    std::thread verify_thread_;
+
+    // Routing telemetry, updated from request completion threads; also
+    // guards forced_engine_, which decide() reads
+    mutable std::mutex routing_mutex_;
+    RoutingConfig routing_config_;
+    std::deque<Outcome> outcomes_[2][2];  // [engine][request type]
+    int in_flight_[2] = {0, 0};
+    std::chrono::steady_clock::time_point last_llm_activity_[2];
+    std::optional<RoutingDecision> last_decisions_[2];
+    uint64_t decision_order_[2] = {0, 0};
+    uint64_t decision_count_ = 0;
+
+    // Hedge losers still decoding, settled on reaper_thread_, which polls
+    // them (a std::future has no completion callback)
+    static constexpr std::chrono::milliseconds kReapPollInterval{5};
+    std::mutex pending_mutex_;
+    std::condition_variable pending_cv_;
+    std::list<PendingGrade> pending_grades_;
+    std::thread reaper_thread_;
+    bool reaper_running_ = false;
 };
 
 // EngineSelector implementation
@@ -191,7 +1049,44 @@ bool EngineSelector::initialize(const EngineConfig& config) {
 }
 
 Engine EngineSelector::chooseEngine() {
-    return impl_->chooseEngine();
+    return impl_->chooseEngine(RoutingRequest());
+}
+
+Engine EngineSelector::chooseEngine(const RoutingRequest& request) {
+    return impl_->chooseEngine(request);
+}
+
+void EngineSelector::requestStarted(Engine engine) {
+    impl_->requestStarted(engine);
+}
+
+void EngineSelector::recordResult(Engine engine, RequestType type, float latency_ms, bool success) {
+    impl_->recordResult(engine, type, latency_ms, success);
+}
+
+void EngineSelector::recordResult(RequestType type, const LLMResponse& response) {
+    // Truncated output (deadline, max tokens) counts as a failure
+    impl_->recordResult(Engine::LLM, type, response.processing_time_ms,
+                        response.success && response.stop_reason == StopReason::COMPLETED);
+}
+
+void EngineSelector::recordResult(const GradingResult& result) {
+    impl_->recordResult(Engine::RULES, RequestType::GRADING, result.processing_time_ms,
+                        grading::validateGradingResult(result));
+}
+
+void EngineSelector::setRoutingConfig(const RoutingConfig& config) {
+    impl_->setRoutingConfig(config);
+}
+
+HedgedGrade EngineSelector::gradeHedged(const Question& question, const std::string& student_answer,
+                                        LLMBridge& bridge, GradingEngine& rules,
+                                        const HedgeOptions& options) {
+    return impl_->gradeHedged(question, student_answer, bridge, rules, options);
+}
+
+EngineTelemetry EngineSelector::getTelemetry(Engine engine, RequestType type) const {
+    return impl_->getTelemetry(engine, type);
 }
 
 bool EngineSelector::isModelInstalled() const {
@@ -226,6 +1121,34 @@ void EngineSelector::setDownloadProgressCallback(std::function<void(float)> call
     impl_->setDownloadProgressCallback(callback);
 }
 
+void EngineSelector::setDownloadTransport(std::shared_ptr<DownloadTransport> transport) {
+    impl_->setDownloadTransport(transport);
+}
+
+void EngineSelector::setPrewarmBridge(LLMBridge* bridge) {
+    impl_->setPrewarmBridge(bridge);
+}
+
+bool EngineSelector::startPrewarm() {
+    return impl_->startPrewarm();
+}
+
+void EngineSelector::cancelPrewarm() {
+    impl_->cancelPrewarm();
+}
+
+void EngineSelector::attachCache(KVStore* cache) {
+    impl_->attachCache(cache);
+}
+
+void EngineSelector::attachWordNet(WordNetAdapter* wordnet) {
+    impl_->attachWordNet(wordnet);
+}
+
+MemoryReport EngineSelector::getMemoryReport() const {
+    return impl_->getMemoryReport();
+}
+
 void EngineSelector::forceEngine(Engine engine) {
     impl_->forceEngine(engine);
 }
@@ -238,5 +1161,21 @@ EngineSelector::EngineStatus EngineSelector::getStatus() const {
     return impl_->getStatus();
 }
 
+const char* EngineSelector::reasonName(RoutingReason reason) {
+    switch (reason) {
+        case RoutingReason::FORCED: return "forced";
+        case RoutingReason::RULES_ONLY: return "rules_only";
+        case RoutingReason::MODEL_NOT_INSTALLED: return "model_not_installed";
+        case RoutingReason::NO_TELEMETRY: return "no_telemetry";
+        case RoutingReason::WITHIN_DEADLINE: return "within_deadline";
+        case RoutingReason::DEADLINE_RISK: return "deadline_risk";
+        case RoutingReason::BEST_EFFORT: return "best_effort";
+        case RoutingReason::QUEUE_DEPTH: return "queue_depth";
+        case RoutingReason::LOW_SUCCESS_RATE: return "low_success_rate";
+        case RoutingReason::PROBE: return "probe";
+    }
+    return "unknown";
+}
+
 } // namespace core
 } // namespace studyhive
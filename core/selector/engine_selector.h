@@ -3,6 +3,9 @@
 #include <string>
 #include <functional>
 #include <memory>
+#include <vector>
+#include "../types/quiz_types.h"
+#include "../memory/memory_governor.h"
 
 namespace studyhive {
 namespace core {
@@ -18,8 +21,120 @@ enum class ConnectivityStatus {
     OFFLINE
 };
 
+enum class RequestType {
+    QUIZ_GENERATION,
+    GRADING
+};
+
+// Why chooseEngine picked an engine
+enum class RoutingReason {
+    FORCED,               // forceEngine()
+    RULES_ONLY,           // EngineConfig::force_rules_only
+    MODEL_NOT_INSTALLED,
+    NO_TELEMETRY,         // Too few LLM samples to judge; LLM by default
+    WITHIN_DEADLINE,      // LLM estimate meets the deadline (or there is none)
+    DEADLINE_RISK,        // LLM estimate misses the deadline, rules meet it
+    BEST_EFFORT,          // Both estimates miss the deadline; the faster one
+    QUEUE_DEPTH,          // LLM queue at or above RoutingConfig::max_llm_queue_depth
+    LOW_SUCCESS_RATE,     // LLM failures above RoutingConfig::min_llm_success_rate
+    PROBE                 // Periodic LLM request to refresh stale telemetry
+};
+
+struct RoutingRequest {
+    RequestType type = RequestType::QUIZ_GENERATION;
+    float deadline_ms = 0.0f;  // <= 0: no deadline
+};
+
+struct RoutingConfig {
+    size_t window_size = 32;               // Recent outcomes kept per engine and request type
+    size_t min_samples = 3;                // LLM samples before telemetry overrides the default
+    float min_llm_success_rate = 0.6f;
+    int max_llm_queue_depth = 4;           // In-flight LLM requests before shedding to rules
+    float deadline_margin = 1.1f;          // Estimates are inflated by this factor before comparison
+    float probe_interval_ms = 30000.0f;    // Route one idle request to the LLM after this long without a sample
+};
+
+// Rolling outcome statistics over the last RoutingConfig::window_size requests
+struct EngineTelemetry {
+    size_t samples = 0;
+    float success_rate = 1.0f;
+    float mean_latency_ms = 0.0f;
+    float p90_latency_ms = 0.0f;
+};
+
+struct RoutingDecision {
+    Engine engine = Engine::RULES;
+    RoutingReason reason = RoutingReason::MODEL_NOT_INSTALLED;
+    RequestType type = RequestType::QUIZ_GENERATION;
+    float deadline_ms = 0.0f;
+    float llm_estimate_ms = 0.0f;    // Expected latency including queueing (0 if unknown)
+    float rules_estimate_ms = 0.0f;
+    int llm_queue_depth = 0;
+};
+
+struct LLMResponse;
+struct GradingResult;
+class LLMBridge;
+class GradingEngine;
+class KVStore;
+class WordNetAdapter;
+class DownloadTransport;
+
+struct HedgeOptions {
+    float deadline_ms = 1500.0f;      // The LLM result is used only if it validates by then
+    std::string grammar_path;         // Grading grammar for the LLM
+    KVStore* cache = nullptr;         // Optional: LLM grades are read from and written here
+    bool finish_late_llm = false;     // With a cache: let a late LLM finish in the background
+                                      // and cache it instead of cancelling it
+    float late_deadline_ms = 30000.0f;  // Upper bound for such a background LLM request
+};
+
+struct HedgedGrade {
+    GradePayload grade;
+    Engine engine = Engine::RULES;    // Engine whose result was returned
+    bool cache_hit = false;           // LLM grade served from HedgeOptions::cache
+    bool llm_valid = false;           // LLM answered with a valid grade before the deadline
+    std::string llm_error;            // Why the LLM result was not used (if it was not)
+    float rules_time_ms = 0.0f;
+    float total_time_ms = 0.0f;
+};
+
+// Background prewarm of the installed model (see LLMBridge::prewarm)
+enum class PrewarmState {
+    NOT_STARTED,
+    RUNNING,
+    DONE,
+    CANCELLED,    // A real request arrived first
+    FAILED
+};
+
+// How far the installed model file has been checked against model_sha256
+enum class ModelVerification {
+    NOT_CHECKED,  // No model_sha256 configured
+    SAMPLED,      // Cached verification still matches and a sample of chunks rehashed
+    VERIFYING,    // No cached verification: first full hash running in the background;
+                  // the model becomes available once it matches
+    VERIFIED,     // Fully hashed (now or at download) and matching
+    FAILED
+};
+
+// Binary patch from an older model revision (see core/download/model_delta.h)
+struct ModelDelta {
+    std::string from_sha256;  // Installed revision the patch applies to
+    std::string url;
+    std::string sha256;       // Digest of the delta file itself
+};
+
 struct EngineConfig {
     std::string model_path;
+    std::string model_url;         // Source for queueModelDownload
+    std::string model_sha256;      // Expected digest (hex); empty: not verified
+    int download_parallel_chunks = 4;
+    std::vector<ModelDelta> model_deltas;  // Tried before a full download when one matches the installed file
+    std::string verification_cache_path;  // Empty: model_path + ".verified.json"
+    int verify_sample_chunks = 8;         // Chunks rehashed at startup for a cached verification
+    int full_verify_interval_hours = 168; // Background full rehash when the last one is older (0: always)
+    size_t memory_limit_bytes = 0;        // Memory governor budget; 0: cgroup limit or physical RAM
     std::string grammar_path;
     int max_tokens = 2048;
     float temperature = 0.7f;
@@ -36,8 +151,35 @@ public:
     bool initialize(const EngineConfig& config);
 
     // Choose the appropriate engine based on model availability and connectivity
+    // (a quiz generation request without a deadline)
     Engine chooseEngine();
 
+    // Choose per request: the LLM when its recent latency, queue depth and success
+    // rate say it will answer within the deadline, the rules engine otherwise
+    Engine chooseEngine(const RoutingRequest& request);
+
+    // Telemetry feed. Call requestStarted when a request is handed to an engine and
+    // exactly one recordResult when it finishes; the difference is the queue depth.
+    void requestStarted(Engine engine);
+    void recordResult(Engine engine, RequestType type, float latency_ms, bool success);
+    void recordResult(RequestType type, const LLMResponse& response);
+    void recordResult(const GradingResult& result);  // Rules engine grading
+
+    void setRoutingConfig(const RoutingConfig& config);
+
+    // Hedged grading: the rules engine grades immediately while the LLM grades in
+    // parallel. Returns the LLM grade if it validates before the deadline and the
+    // rules grade otherwise; the LLM request is then cancelled, or finished in the
+    // background and cached when HedgeOptions::finish_late_llm is set (only such a
+    // finished request counts in the LLM telemetry). Only short answers are hedged
+    // (the rules engine is exact for the other types). The bridge and cache must
+    // outlive the selector when background requests are enabled.
+    HedgedGrade gradeHedged(const Question& question, const std::string& student_answer,
+                            LLMBridge& bridge, GradingEngine& rules,
+                            const HedgeOptions& options = HedgeOptions());
+
+    EngineTelemetry getTelemetry(Engine engine, RequestType type) const;
+
     // Check if the local LLM model is installed and valid
     bool isModelInstalled() const;
 
@@ -62,12 +204,39 @@ public:
     // Set model download progress callback
     void setDownloadProgressCallback(std::function<void(float)> callback);
 
+    // Byte-range transport for the model download (e.g. the platform HTTPS
+    // stack); the built-in plain HTTP client is used otherwise
+    void setDownloadTransport(std::shared_ptr<DownloadTransport> transport);
+
+    // Bridge to prewarm on an idle-priority thread whenever the model becomes
+    // available (initialize, a finished download, forceEngine(LLM)); its KV
+    // cache and weights are also put under the memory budget. Null detaches.
+    // The bridge must stay alive while attached.
+    void setPrewarmBridge(LLMBridge* bridge);
+
+    // Prewarm now; false if no ready bridge, no model, or already running or done
+    bool startPrewarm();
+
+    // Stop a running prewarm (requestStarted(Engine::LLM) does this too)
+    void cancelPrewarm();
+
+    // Result cache and WordNet index under the selector's memory governor,
+    // which reclaims them before the LLM's KV cache and idle weights. Null
+    // detaches; each must stay alive while attached.
+    void attachCache(KVStore* cache);
+    void attachWordNet(WordNetAdapter* wordnet);
+
+    // Usage per attached consumer and the last pressure reading
+    MemoryReport getMemoryReport() const;
+
     // Force engine selection (for testing or user preference)
     void forceEngine(Engine engine);
 
     // Reset to automatic selection
     void resetToAutomatic();
 
+    static const char* reasonName(RoutingReason reason);
+
     // Get current engine status for UI
     struct EngineStatus {
         Engine current_engine;
@@ -76,6 +245,13 @@ public:
         ConnectivityStatus connectivity;
         bool download_queued;
         float download_progress;
+        bool download_is_delta;      // The running (or last) download is a delta patch
+        std::string download_error;  // Last failed download attempt, if any
+        ModelVerification model_verification;
+        PrewarmState prewarm_state;
+        float prewarm_progress;      // Fraction of weights and KV cache paged in
+        int llm_queue_depth;
+        std::vector<RoutingDecision> last_decisions;  // Most recent per request type, in routing order
     };
     
     EngineStatus getStatus() const;
@@ -0,0 +1,191 @@
+// Notes parsing equivalence test: chunked parallel parsing, streaming (fed in
+// pieces, from a stream and from a mapped file) and incremental parsing across
+// edits must all produce the ParsedContent of the serial parsing::scanContent
+// on a fixed corpus. Reports every mismatch and exits non-zero if there was any.
+//
+// Usage: notes_parse_test [notes_file...]
+//
+// The built-in corpus covers the scanner's corner cases; files given on the
+// command line (e.g. test-notes.md) are checked the same way.
+
+#include "../rules/qgen_rules.h"
+#include "../rules/incremental_parser.h"
+#include "../rules/notes_stream.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <sstream>
+
+using namespace studyhive::core;
+
+namespace {
+
+const char* kCorpus =
+    "# Cell Biology\n\n"
+    "Photosynthesis is the process by which plants convert light energy into chemical energy. "
+    "It occurs in the chloroplasts.\n\n"
+    "The equation is 6CO2 + 6H2O = C6H12O6 + 6O2. Energy E = mc^2 relates mass and energy.\n\n"
+    "For example, a leaf in sunlight produces glucose. Enzymes such as Rubisco fix carbon.\n"
+    "Many reactions, e.g. glycolysis, release energy. See also e.g.the Krebs cycle.\n\n\n"
+    "Mitochondria are the powerhouse of the cell. ATP means adenosine triphosphate.\n"
+    "Words like thesis, island and examplefor must not trigger cues. Vitamin B12 and CO2Level "
+    "are glued tokens.\n \n"
+    "A paragraph without a full stop runs on\n\n"
+    "into the next one. Osmosis refers to the movement of water across a membrane.\n"
+    "\tTabs\tand  double  spaces are normalized. x = y + 2. Ratio: a/b = 3.5 e.g. 7/2.\n\n"
+    "Diffusion is defined as net movement from high to low concentration. Such as... ellipses. "
+    "Last sentence has no newline.";
+
+int g_failures = 0;
+
+bool sameContent(const ParsedContent& a, const ParsedContent& b) {
+    return a.concepts == b.concepts && a.definitions == b.definitions && a.formulas == b.formulas &&
+           a.examples == b.examples && a.keywords == b.keywords;
+}
+
+void check(bool ok, const std::string& what) {
+    if (!ok) {
+        g_failures++;
+        std::cout << "FAILED: " << what << "\n";
+    }
+}
+
+void checkParallel(const std::string& name, const std::string& text, const ParsedContent& expected) {
+    for (size_t chunk_bytes : {size_t(1), size_t(64), size_t(1024), size_t(64 * 1024)}) {
+        for (int threads : {1, 4}) {
+            ParallelParseOptions options;
+            options.threads = threads;
+            options.min_chunk_bytes = chunk_bytes;
+            std::string label = name + ", " + std::to_string(chunk_bytes) + " byte chunks, " +
+                                std::to_string(threads) + " threads";
+            check(sameContent(expected, parsing::scanContentParallel(text, options)), "parallel: " + label);
+            auto spans = parsing::scanSpansParallel(std::make_shared<const std::string>(text), options);
+            check(sameContent(expected, spans.materialize()), "parallel spans: " + label);
+        }
+    }
+
+    QuestionGenerator generator;
+    check(sameContent(expected, generator.parseContent(text)), "QuestionGenerator::parseContent: " + name);
+}
+
+void checkStream(const std::string& name, const std::string& text, const ParsedContent& expected) {
+    for (size_t window : {size_t(1), size_t(16), size_t(4096)}) {
+        for (size_t piece : {size_t(1), size_t(7), size_t(1000)}) {
+            NotesStreamOptions options;
+            options.window_bytes = window;
+            NotesStreamParser parser(options);
+            for (size_t at = 0; at < text.size(); at += piece) {
+                parser.feed(std::string_view(text).substr(at, piece));
+            }
+            parser.finish();
+            check(sameContent(expected, parser.content()) && parser.stats().forced_cuts == 0,
+                  "stream: " + name + ", " + std::to_string(window) + " byte windows, " +
+                  std::to_string(piece) + " byte pieces");
+        }
+
+        NotesStreamOptions options;
+        options.window_bytes = window;
+        std::istringstream input(text);
+        ParsedContent streamed;
+        NotesStreamStats stats;
+        std::string error;
+        check(parseNotesStream(input, options, streamed, stats, error) && sameContent(expected, streamed),
+              "parseNotesStream: " + name + ", " + std::to_string(window) + " byte windows " + error);
+    }
+
+    auto path = std::filesystem::temp_directory_path() / "notes_parse_test.txt";
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << text;
+    }
+    for (size_t window : {size_t(4096), size_t(1) << 20}) {
+        NotesStreamOptions options;
+        options.window_bytes = window;
+        ParsedContent streamed;
+        NotesStreamStats stats;
+        std::string error;
+        check(parseNotesFile(path.string(), options, streamed, stats, error) && sameContent(expected, streamed),
+              "parseNotesFile: " + name + ", " + std::to_string(window) + " byte windows " + error);
+    }
+
+    QuestionGenerator generator;
+    ParsedContent streamed;
+    std::string error;
+    check(generator.parseContentFile(path.string(), streamed, error) && sameContent(expected, streamed),
+          "QuestionGenerator::parseContentFile: " + name + " " + error);
+    std::filesystem::remove(path);
+}
+
+// Fixed edits (seeded) applied in turn; every update is checked against a full scan
+void checkIncremental(const std::string& name, std::string text) {
+    static const char* kInserts[] = {"Osmosis is diffusion of water. ", "\n\n", ". ", "e.g. ", "x = 2. ",
+                                     "For example, roots. ", "Cell", " ", "\n", ""};
+    std::mt19937 rng(1234);
+    IncrementalParser with_range;
+    IncrementalParser without_range;
+    QuestionGenerator generator;
+    with_range.update(text);
+    without_range.update(text);
+    generator.parseEditedContent(text, TextEdit{0, 0, text.size()});
+
+    for (int step = 0; step < 200; ++step) {
+        size_t offset = rng() % (text.size() + 1);
+        size_t removed = std::min<size_t>(rng() % 48, text.size() - offset);
+        std::string inserted = kInserts[rng() % std::size(kInserts)];
+        text.replace(offset, removed, inserted);
+        TextEdit edit{offset, removed, inserted.size()};
+
+        ParsedContent expected = parsing::scanContent(text);
+        std::string label = name + ", edit " + std::to_string(step);
+        with_range.update(text, edit);
+        check(sameContent(expected, with_range.content()), "incremental with range: " + label);
+        without_range.update(text);
+        check(sameContent(expected, without_range.content()), "incremental without range: " + label);
+        check(sameContent(expected, generator.parseEditedContent(text, edit)),
+              "QuestionGenerator::parseEditedContent: " + label);
+    }
+}
+
+void checkCorpus(const std::string& name, const std::string& text) {
+    ParsedContent expected = parsing::scanContent(text);
+    checkParallel(name, text, expected);
+    checkStream(name, text, expected);
+    checkIncremental(name, text);
+
+    // Past min_chunk_bytes, so parseContent takes the chunked path
+    std::string large;
+    while (large.size() < 2 * ParallelParseOptions().min_chunk_bytes) {
+        large += text;
+        large += "\n\n";
+    }
+    ParsedContent expected_large = parsing::scanContent(large);
+    QuestionGenerator generator;
+    check(sameContent(expected_large, generator.parseContent(large)),
+          "QuestionGenerator::parseContent: " + name + " x" + std::to_string(large.size() / text.size()));
+    checkStream(name + " (large)", large, expected_large);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    checkCorpus("built-in corpus", kCorpus);
+
+    for (int i = 1; i < argc; ++i) {
+        std::ifstream file(argv[i], std::ios::binary);
+        if (!file) {
+            std::cout << "FAILED: cannot open " << argv[i] << "\n";
+            return 1;
+        }
+        std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        checkCorpus(argv[i], text);
+    }
+
+    if (g_failures > 0) {
+        std::cout << g_failures << " checks failed\n";
+        return 1;
+    }
+    std::cout << "all notes parsing paths match parsing::scanContent\n";
+    return 0;
+}
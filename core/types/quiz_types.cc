@@ -0,0 +1,758 @@
+#include "quiz_types.h"
+#include <array>
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <stdexcept>
+
+namespace studyhive {
+namespace core {
+
+namespace {
+
+// Pull parser over the input buffer. Keys without escapes are returned as
+// views into the input; only string values are copied out. An observer sees
+// every value as a SAX event (skipped members included), and a false return
+// from it aborts the read.
+class JsonReader {
+public:
+    explicit JsonReader(std::string_view src, quiz_io::ReadObserver* observer = nullptr)
+        : src_(src), pos_(0), observer_(observer) {}
+
+    [[noreturn]] void fail(const std::string& what) const {
+        throw std::runtime_error(what + " at offset " + std::to_string(pos_));
+    }
+
+    char peek() {
+        skipSpace();
+        return pos_ < src_.size() ? src_[pos_] : '\0';
+    }
+
+    bool consume(char c) {
+        if (peek() != c) return false;
+        pos_++;
+        return true;
+    }
+
+    void expect(char c) {
+        if (!consume(c)) fail(std::string("expected '") + c + "'");
+    }
+
+    void expectEnd() {
+        if (peek() != '\0') fail("trailing characters");
+    }
+
+    template <typename OnMember>
+    void readObject(OnMember&& on_member) {
+        expect('{');
+        if (observer_) accept(observer_->start_object(static_cast<std::size_t>(-1)));
+        if (!consume('}')) {
+            do {
+                std::string_view name = readKey();
+                if (observer_) {
+                    observed_.assign(name);
+                    accept(observer_->key(observed_));
+                }
+                expect(':');
+                on_member(name);
+            } while (consume(','));
+            expect('}');
+        }
+        if (observer_) accept(observer_->end_object());
+    }
+
+    template <typename OnItem>
+    void readArray(OnItem&& on_item) {
+        expect('[');
+        if (observer_) accept(observer_->start_array(static_cast<std::size_t>(-1)));
+        if (!consume(']')) {
+            do {
+                on_item();
+            } while (consume(','));
+            expect(']');
+        }
+        if (observer_) accept(observer_->end_array());
+    }
+
+    // The observer gets the value itself; it must not move from it
+    std::string readString() {
+        std::string value;
+        readStringInto(value);
+        if (observer_) accept(observer_->string(value));
+        return value;
+    }
+
+    std::vector<std::string> readStringArray() {
+        std::vector<std::string> values;
+        readArray([&] { values.push_back(readString()); });
+        return values;
+    }
+
+    double readNumber() {
+        std::string_view token = numberToken();
+        observeNumber(token);
+        double value = 0.0;
+        auto [end, ec] = std::from_chars(token.data(), token.data() + token.size(), value);
+        if (ec != std::errc() || end != token.data() + token.size()) fail("invalid number");
+        return value;
+    }
+
+    int64_t readInteger() {
+        std::string_view token = numberToken();
+        observeNumber(token);
+        int64_t value = 0;
+        auto [end, ec] = std::from_chars(token.data(), token.data() + token.size(), value);
+        if (ec == std::errc() && end == token.data() + token.size()) return value;
+
+        // 5.0 and 5e0 are integers too
+        double real = 0.0;
+        auto [real_end, real_ec] = std::from_chars(token.data(), token.data() + token.size(), real);
+        if (real_ec != std::errc() || real_end != token.data() + token.size() ||
+            std::floor(real) != real || std::fabs(real) > 9.0e18) {
+            fail("expected integer");
+        }
+        return static_cast<int64_t>(real);
+    }
+
+    void skipValue() {
+        switch (peek()) {
+            case '{':
+                readObject([&](std::string_view) { skipValue(); });
+                break;
+            case '[':
+                readArray([&] { skipValue(); });
+                break;
+            case '"':
+                if (observer_) readString();
+                else readKey();
+                break;
+            case 't':
+                literal("true");
+                if (observer_) accept(observer_->boolean(true));
+                break;
+            case 'f':
+                literal("false");
+                if (observer_) accept(observer_->boolean(false));
+                break;
+            case 'n':
+                literal("null");
+                if (observer_) accept(observer_->null());
+                break;
+            default:
+                observeNumber(numberToken());
+                break;
+        }
+    }
+
+private:
+    std::string_view src_;
+    size_t pos_;
+    std::string key_buffer_;
+    quiz_io::ReadObserver* observer_;
+    std::string observed_;  // Key or number text handed to the observer
+
+    void accept(bool accepted) const {
+        if (!accepted) fail("rejected by observer");
+    }
+
+    // Integer tokens go out as (un)signed like nlohmann's parser emits them,
+    // falling back to floating point when out of range
+    void observeNumber(std::string_view token) {
+        if (!observer_) return;
+        const char* first = token.data();
+        const char* last = token.data() + token.size();
+        if (token.find_first_of(".eE") == std::string_view::npos) {
+            if (token.front() == '-') {
+                int64_t value = 0;
+                auto [end, ec] = std::from_chars(first, last, value);
+                if (ec == std::errc() && end == last) return accept(observer_->number_integer(value));
+            } else {
+                uint64_t value = 0;
+                auto [end, ec] = std::from_chars(first, last, value);
+                if (ec == std::errc() && end == last) return accept(observer_->number_unsigned(value));
+            }
+        }
+        double value = 0.0;
+        auto [end, ec] = std::from_chars(first, last, value);
+        if (ec != std::errc() || end != last) fail("invalid number");
+        observed_.assign(token);
+        accept(observer_->number_float(value, observed_));
+    }
+
+    void skipSpace() {
+        while (pos_ < src_.size()) {
+            char c = src_[pos_];
+            if (c != ' ' && c != '\n' && c != '\r' && c != '\t') break;
+            pos_++;
+        }
+    }
+
+    void literal(std::string_view word) {
+        if (src_.substr(pos_, word.size()) != word) fail("invalid literal");
+        pos_ += word.size();
+    }
+
+    std::string_view numberToken() {
+        skipSpace();
+        size_t start = pos_;
+        if (pos_ < src_.size() && src_[pos_] == '-') pos_++;
+        while (pos_ < src_.size()) {
+            char c = src_[pos_];
+            if ((c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-') {
+                pos_++;
+            } else {
+                break;
+            }
+        }
+        if (pos_ == start) fail("unexpected character");
+        return src_.substr(start, pos_ - start);
+    }
+
+    std::string_view readKey() {
+        expect('"');
+        size_t start = pos_;
+        while (pos_ < src_.size() && src_[pos_] != '"' && src_[pos_] != '\\') {
+            if (static_cast<unsigned char>(src_[pos_]) < 0x20) fail("control character in string");
+            pos_++;
+        }
+        if (pos_ < src_.size() && src_[pos_] == '"') {
+            return src_.substr(start, pos_++ - start);
+        }
+        pos_ = start - 1;
+        key_buffer_.clear();
+        readStringInto(key_buffer_);
+        return key_buffer_;
+    }
+
+    void readStringInto(std::string& out) {
+        expect('"');
+        while (true) {
+            size_t run_start = pos_;
+            while (pos_ < src_.size() && src_[pos_] != '"' && src_[pos_] != '\\' &&
+                   static_cast<unsigned char>(src_[pos_]) >= 0x20) {
+                pos_++;
+            }
+            out.append(src_.data() + run_start, pos_ - run_start);
+            if (pos_ >= src_.size()) fail("unterminated string");
+
+            char c = src_[pos_++];
+            if (c == '"') return;
+            if (c != '\\') fail("control character in string");
+            if (pos_ >= src_.size()) fail("unterminated string");
+            switch (src_[pos_++]) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': appendCodePoint(out, readEscapedCodePoint()); break;
+                default: fail("invalid escape");
+            }
+        }
+    }
+
+    uint32_t readHex4() {
+        if (pos_ + 4 > src_.size()) fail("invalid \\u escape");
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = src_[pos_++];
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= c - '0';
+            else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+            else fail("invalid \\u escape");
+        }
+        return value;
+    }
+
+    uint32_t readEscapedCodePoint() {
+        uint32_t code = readHex4();
+        if (code >= 0xD800 && code <= 0xDBFF) {
+            if (src_.substr(pos_, 2) != "\\u") fail("unpaired surrogate");
+            pos_ += 2;
+            uint32_t low = readHex4();
+            if (low < 0xDC00 || low > 0xDFFF) fail("unpaired surrogate");
+            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+        } else if (code >= 0xDC00 && code <= 0xDFFF) {
+            fail("unpaired surrogate");
+        }
+        return code;
+    }
+
+    static void appendCodePoint(std::string& out, uint32_t code) {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+};
+
+// Tracks which required members were seen in one object
+class RequiredFields {
+public:
+    RequiredFields(const char* object_name, std::initializer_list<const char*> names)
+        : object_name_(object_name), count_(names.size()) {
+        std::copy(names.begin(), names.end(), names_.begin());
+    }
+
+    void mark(size_t index) { seen_ |= uint32_t(1) << index; }
+
+    void check(const JsonReader& reader) const {
+        for (size_t i = 0; i < count_; ++i) {
+            if (!(seen_ & (uint32_t(1) << i))) {
+                reader.fail(std::string(object_name_) + " is missing \"" + names_[i] + "\"");
+            }
+        }
+    }
+
+private:
+    const char* object_name_;
+    std::array<const char*, 8> names_;
+    size_t count_;
+    uint32_t seen_ = 0;
+};
+
+MCOption readOption(JsonReader& reader) {
+    MCOption option;
+    RequiredFields required("option", {"value", "label"});
+    reader.readObject([&](std::string_view name) {
+        if (name == "value") { option.value = reader.readString(); required.mark(0); }
+        else if (name == "label") { option.label = reader.readString(); required.mark(1); }
+        else reader.skipValue();
+    });
+    required.check(reader);
+    return option;
+}
+
+RubricCriterion readCriterion(JsonReader& reader) {
+    RubricCriterion criterion;
+    RequiredFields required("rubric criterion", {"criterion", "points", "keywords"});
+    reader.readObject([&](std::string_view name) {
+        if (name == "criterion") { criterion.criterion = reader.readString(); required.mark(0); }
+        else if (name == "points") { criterion.points = static_cast<int>(reader.readInteger()); required.mark(1); }
+        else if (name == "keywords") { criterion.keywords = reader.readStringArray(); required.mark(2); }
+        else reader.skipValue();
+    });
+    required.check(reader);
+    return criterion;
+}
+
+// "type" may arrive after the fields it selects, so collect the union first
+Question readQuestionValue(JsonReader& reader) {
+    std::string id, type, prompt, sample_answer, correct_answer, explanation;
+    std::vector<MCOption> options;
+    std::vector<RubricCriterion> rubric;
+    bool has_options = false, has_correct = false, has_explanation = false;
+    bool has_sample = false, has_rubric = false;
+    RequiredFields required("question", {"id", "type", "prompt"});
+
+    reader.readObject([&](std::string_view name) {
+        if (name == "id") { id = reader.readString(); required.mark(0); }
+        else if (name == "type") { type = reader.readString(); required.mark(1); }
+        else if (name == "prompt") { prompt = reader.readString(); required.mark(2); }
+        else if (name == "options") {
+            reader.readArray([&] { options.push_back(readOption(reader)); });
+            has_options = true;
+        }
+        else if (name == "correctAnswer") { correct_answer = reader.readString(); has_correct = true; }
+        else if (name == "explanation") { explanation = reader.readString(); has_explanation = true; }
+        else if (name == "sampleAnswer") { sample_answer = reader.readString(); has_sample = true; }
+        else if (name == "rubric") {
+            reader.readArray([&] { rubric.push_back(readCriterion(reader)); });
+            has_rubric = true;
+        }
+        else reader.skipValue();
+    });
+    required.check(reader);
+
+    if (type == "multiple_choice") {
+        if (!has_options || !has_correct || !has_explanation) {
+            reader.fail("multiple_choice question " + id + " is missing options, correctAnswer or explanation");
+        }
+        return MultipleChoiceQuestion{std::move(id), std::move(prompt), std::move(options),
+                                      std::move(correct_answer), std::move(explanation)};
+    }
+    if (type == "short_answer") {
+        if (!has_sample || !has_rubric) {
+            reader.fail("short_answer question " + id + " is missing sampleAnswer or rubric");
+        }
+        return ShortAnswerQuestion{std::move(id), std::move(prompt), std::move(sample_answer), std::move(rubric)};
+    }
+    if (type == "fill_in_blank") {
+        if (!has_correct || !has_explanation) {
+            reader.fail("fill_in_blank question " + id + " is missing correctAnswer or explanation");
+        }
+        return FillInBlankQuestion{std::move(id), std::move(prompt), std::move(correct_answer),
+                                   std::move(explanation)};
+    }
+    reader.fail("unknown question type '" + type + "'");
+}
+
+QuizMetadata readQuizMetadata(JsonReader& reader) {
+    QuizMetadata metadata;
+    reader.readObject([&](std::string_view name) {
+        if (name == "source") metadata.source = reader.readString();
+        else if (name == "generatedAt") metadata.generated_at = reader.readString();
+        else if (name == "seed") metadata.seed = reader.readInteger();
+        else if (name == "rulesQuestions") metadata.rules_questions = reader.readInteger();
+        else reader.skipValue();
+    });
+    return metadata;
+}
+
+Quiz readQuizValue(JsonReader& reader) {
+    Quiz quiz;
+    RequiredFields required("quiz", {"topic", "difficulty", "questions"});
+    reader.readObject([&](std::string_view name) {
+        if (name == "topic") { quiz.topic = reader.readString(); required.mark(0); }
+        else if (name == "difficulty") { quiz.difficulty = reader.readString(); required.mark(1); }
+        else if (name == "questions") {
+            reader.readArray([&] { quiz.questions.push_back(readQuestionValue(reader)); });
+            required.mark(2);
+        }
+        else if (name == "metadata") quiz.metadata = readQuizMetadata(reader);
+        else reader.skipValue();
+    });
+    required.check(reader);
+    return quiz;
+}
+
+GradeBreakdownItem readBreakdownItem(JsonReader& reader) {
+    GradeBreakdownItem item;
+    RequiredFields required("breakdown item", {"criterion", "awardedPoints", "maxPoints", "reasoning"});
+    reader.readObject([&](std::string_view name) {
+        if (name == "criterion") { item.criterion = reader.readString(); required.mark(0); }
+        else if (name == "awardedPoints") { item.awarded_points = reader.readNumber(); required.mark(1); }
+        else if (name == "maxPoints") { item.max_points = reader.readNumber(); required.mark(2); }
+        else if (name == "reasoning") { item.reasoning = reader.readString(); required.mark(3); }
+        else if (name == "keywords") item.keywords = reader.readStringArray();
+        else reader.skipValue();
+    });
+    required.check(reader);
+    return item;
+}
+
+GradeMetadata readGradeMetadata(JsonReader& reader) {
+    GradeMetadata metadata;
+    reader.readObject([&](std::string_view name) {
+        if (name == "source") metadata.source = reader.readString();
+        else if (name == "gradedAt") metadata.graded_at = reader.readString();
+        else if (name == "processingTimeMs") metadata.processing_time_ms = reader.readNumber();
+        else reader.skipValue();
+    });
+    return metadata;
+}
+
+GradePayload readGradeValue(JsonReader& reader) {
+    GradePayload grade;
+    RequiredFields required("grade", {"questionId", "totalScore", "maxScore", "breakdown"});
+    reader.readObject([&](std::string_view name) {
+        if (name == "questionId") { grade.question_id = reader.readString(); required.mark(0); }
+        else if (name == "totalScore") { grade.total_score = reader.readNumber(); required.mark(1); }
+        else if (name == "maxScore") { grade.max_score = reader.readNumber(); required.mark(2); }
+        else if (name == "breakdown") {
+            reader.readArray([&] { grade.breakdown.push_back(readBreakdownItem(reader)); });
+            required.mark(3);
+        }
+        else if (name == "feedback") grade.feedback = reader.readString();
+        else if (name == "metadata") grade.metadata = readGradeMetadata(reader);
+        else reader.skipValue();
+    });
+    required.check(reader);
+    return grade;
+}
+
+template <typename T, typename ReadValue>
+bool readDocument(std::string_view json, T& out, std::string& error_msg, quiz_io::ReadObserver* observer,
+                  ReadValue&& read_value) {
+    try {
+        JsonReader reader(json, observer);
+        T value = read_value(reader);
+        reader.expectEnd();
+        out = std::move(value);
+        return true;
+    } catch (const std::exception& e) {
+        error_msg = "Invalid payload: " + std::string(e.what());
+        return false;
+    }
+}
+
+// Compact writer; output matches nlohmann::json::dump() up to member order
+class JsonWriter {
+public:
+    explicit JsonWriter(std::string& out) : out_(out) {}
+
+    void beginObject() { separate(); out_ += '{'; need_comma_ = false; }
+    void endObject() { out_ += '}'; need_comma_ = true; }
+    void beginArray() { separate(); out_ += '['; need_comma_ = false; }
+    void endArray() { out_ += ']'; need_comma_ = true; }
+
+    void key(std::string_view name) {
+        separate();
+        writeString(name);
+        out_ += ':';
+        need_comma_ = false;
+    }
+
+    void value(std::string_view text) { separate(); writeString(text); need_comma_ = true; }
+
+    void value(int64_t number) {
+        separate();
+        char buffer[24];
+        auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), number);
+        out_.append(buffer, end);
+        need_comma_ = true;
+    }
+
+    void value(double number) {
+        separate();
+        if (!std::isfinite(number)) {
+            out_ += "null";  // Same as nlohmann::json
+        } else {
+            char buffer[32];
+            auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), number);
+            std::string_view text(buffer, end - buffer);
+            out_ += text;
+            // Keep the value a JSON float so it round-trips as a number, not an integer
+            if (text.find_first_of(".e") == std::string_view::npos) out_ += ".0";
+        }
+        need_comma_ = true;
+    }
+
+    void value(const std::vector<std::string>& strings) {
+        beginArray();
+        for (const auto& text : strings) value(std::string_view(text));
+        endArray();
+    }
+
+    template <typename T>
+    void member(std::string_view name, const T& field) {
+        key(name);
+        value(field);
+    }
+
+private:
+    std::string& out_;
+    bool need_comma_ = false;
+
+    void separate() {
+        if (need_comma_) out_ += ',';
+    }
+
+    void writeString(std::string_view text) {
+        static const char* hex = "0123456789abcdef";
+        out_ += '"';
+        size_t run_start = 0;
+        for (size_t i = 0; i < text.size(); ++i) {
+            unsigned char c = static_cast<unsigned char>(text[i]);
+            if (c >= 0x20 && c != '"' && c != '\\') continue;
+            out_.append(text.data() + run_start, i - run_start);
+            run_start = i + 1;
+            switch (c) {
+                case '"': out_ += "\\\""; break;
+                case '\\': out_ += "\\\\"; break;
+                case '\b': out_ += "\\b"; break;
+                case '\f': out_ += "\\f"; break;
+                case '\n': out_ += "\\n"; break;
+                case '\r': out_ += "\\r"; break;
+                case '\t': out_ += "\\t"; break;
+                default:
+                    out_ += "\\u00";
+                    out_ += hex[c >> 4];
+                    out_ += hex[c & 0xF];
+            }
+        }
+        out_.append(text.data() + run_start, text.size() - run_start);
+        out_ += '"';
+    }
+};
+
+void writeQuestionValue(JsonWriter& writer, const Question& question) {
+    writer.beginObject();
+    writer.member("id", std::string_view(questionId(question)));
+    writer.member("type", std::string_view(questionType(question)));
+    writer.member("prompt", std::string_view(questionPrompt(question)));
+
+    if (auto* mcq = std::get_if<MultipleChoiceQuestion>(&question)) {
+        writer.key("options");
+        writer.beginArray();
+        for (const auto& option : mcq->options) {
+            writer.beginObject();
+            writer.member("value", std::string_view(option.value));
+            writer.member("label", std::string_view(option.label));
+            writer.endObject();
+        }
+        writer.endArray();
+        writer.member("correctAnswer", std::string_view(mcq->correct_answer));
+        writer.member("explanation", std::string_view(mcq->explanation));
+    } else if (auto* saq = std::get_if<ShortAnswerQuestion>(&question)) {
+        writer.member("sampleAnswer", std::string_view(saq->sample_answer));
+        writer.key("rubric");
+        writer.beginArray();
+        for (const auto& criterion : saq->rubric) {
+            writer.beginObject();
+            writer.member("criterion", std::string_view(criterion.criterion));
+            writer.member("points", static_cast<int64_t>(criterion.points));
+            writer.member("keywords", criterion.keywords);
+            writer.endObject();
+        }
+        writer.endArray();
+    } else if (auto* fib = std::get_if<FillInBlankQuestion>(&question)) {
+        writer.member("correctAnswer", std::string_view(fib->correct_answer));
+        writer.member("explanation", std::string_view(fib->explanation));
+    }
+
+    writer.endObject();
+}
+
+} // namespace
+
+const char* questionType(const Question& question) {
+    switch (question.index()) {
+        case 0: return "multiple_choice";
+        case 1: return "short_answer";
+        default: return "fill_in_blank";
+    }
+}
+
+const std::string& questionId(const Question& question) {
+    return std::visit([](const auto& q) -> const std::string& { return q.id; }, question);
+}
+
+const std::string& questionPrompt(const Question& question) {
+    return std::visit([](const auto& q) -> const std::string& { return q.prompt; }, question);
+}
+
+namespace quiz_io {
+
+bool readQuiz(std::string_view json, Quiz& quiz, std::string& error_msg, ReadObserver* observer) {
+    return readDocument(json, quiz, error_msg, observer, readQuizValue);
+}
+
+bool readQuestion(std::string_view json, Question& question, std::string& error_msg, ReadObserver* observer) {
+    return readDocument(json, question, error_msg, observer, readQuestionValue);
+}
+
+bool readGradePayload(std::string_view json, GradePayload& grade, std::string& error_msg, ReadObserver* observer) {
+    return readDocument(json, grade, error_msg, observer, readGradeValue);
+}
+
+std::string writeQuiz(const Quiz& quiz) {
+    std::string out;
+    out.reserve(256 + quiz.questions.size() * 512);
+    JsonWriter writer(out);
+
+    writer.beginObject();
+    writer.member("topic", std::string_view(quiz.topic));
+    writer.member("difficulty", std::string_view(quiz.difficulty));
+    writer.key("questions");
+    writer.beginArray();
+    for (const auto& question : quiz.questions) {
+        writeQuestionValue(writer, question);
+    }
+    writer.endArray();
+
+    if (quiz.metadata) {
+        writer.key("metadata");
+        writer.beginObject();
+        if (quiz.metadata->source) writer.member("source", std::string_view(*quiz.metadata->source));
+        if (quiz.metadata->generated_at) writer.member("generatedAt", std::string_view(*quiz.metadata->generated_at));
+        if (quiz.metadata->seed) writer.member("seed", *quiz.metadata->seed);
+        if (quiz.metadata->rules_questions) writer.member("rulesQuestions", *quiz.metadata->rules_questions);
+        writer.endObject();
+    }
+
+    writer.endObject();
+    return out;
+}
+
+std::string writeQuestion(const Question& question) {
+    std::string out;
+    JsonWriter writer(out);
+    writeQuestionValue(writer, question);
+    return out;
+}
+
+std::string writeGradePayload(const GradePayload& grade) {
+    std::string out;
+    out.reserve(256 + grade.breakdown.size() * 256);
+    JsonWriter writer(out);
+
+    writer.beginObject();
+    writer.member("questionId", std::string_view(grade.question_id));
+    writer.member("totalScore", grade.total_score);
+    writer.member("maxScore", grade.max_score);
+    writer.key("breakdown");
+    writer.beginArray();
+    for (const auto& item : grade.breakdown) {
+        writer.beginObject();
+        writer.member("criterion", std::string_view(item.criterion));
+        writer.member("awardedPoints", item.awarded_points);
+        writer.member("maxPoints", item.max_points);
+        writer.member("reasoning", std::string_view(item.reasoning));
+        if (item.keywords) writer.member("keywords", *item.keywords);
+        writer.endObject();
+    }
+    writer.endArray();
+
+    if (grade.feedback) writer.member("feedback", std::string_view(*grade.feedback));
+
+    if (grade.metadata) {
+        writer.key("metadata");
+        writer.beginObject();
+        if (grade.metadata->source) writer.member("source", std::string_view(*grade.metadata->source));
+        if (grade.metadata->graded_at) writer.member("gradedAt", std::string_view(*grade.metadata->graded_at));
+        if (grade.metadata->processing_time_ms) {
+            writer.member("processingTimeMs", *grade.metadata->processing_time_ms);
+        }
+        writer.endObject();
+    }
+
+    writer.endObject();
+    return out;
+}
+
+// The DOM conversions go through the wire format; they only run at API
+// boundaries, and this keeps a single definition of the mapping.
+nlohmann::json toJson(const Quiz& quiz) {
+    return nlohmann::json::parse(writeQuiz(quiz));
+}
+
+nlohmann::json toJson(const Question& question) {
+    return nlohmann::json::parse(writeQuestion(question));
+}
+
+nlohmann::json toJson(const GradePayload& grade) {
+    return nlohmann::json::parse(writeGradePayload(grade));
+}
+
+bool fromJson(const nlohmann::json& json, Quiz& quiz, std::string& error_msg) {
+    return readQuiz(json.dump(), quiz, error_msg);
+}
+
+bool fromJson(const nlohmann::json& json, Question& question, std::string& error_msg) {
+    return readQuestion(json.dump(), question, error_msg);
+}
+
+bool fromJson(const nlohmann::json& json, GradePayload& grade, std::string& error_msg) {
+    return readGradePayload(json.dump(), grade, error_msg);
+}
+
+} // namespace quiz_io
+
+} // namespace core
+} // namespace studyhive
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <variant>
+#include <optional>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+
+namespace studyhive {
+namespace core {
+
+// Plain structs mirroring core/schemas/quiz.json and grade.json. Field order
+// follows the schema and is the order the writer emits.
+
+struct MCOption {
+    std::string value;
+    std::string label;
+};
+
+struct RubricCriterion {
+    std::string criterion;
+    int points = 0;
+    std::vector<std::string> keywords;
+};
+
+struct MultipleChoiceQuestion {
+    std::string id;
+    std::string prompt;
+    std::vector<MCOption> options;
+    std::string correct_answer;
+    std::string explanation;
+};
+
+struct ShortAnswerQuestion {
+    std::string id;
+    std::string prompt;
+    std::string sample_answer;
+    std::vector<RubricCriterion> rubric;
+};
+
+struct FillInBlankQuestion {
+    std::string id;
+    std::string prompt;
+    std::string correct_answer;
+    std::string explanation;
+};
+
+using Question = std::variant<MultipleChoiceQuestion, ShortAnswerQuestion, FillInBlankQuestion>;
+
+struct QuizMetadata {
+    std::optional<std::string> source;
+    std::optional<std::string> generated_at;
+    std::optional<int64_t> seed;
+    std::optional<int64_t> rules_questions;  // Rules engine questions in a device-llm quiz
+};
+
+struct Quiz {
+    std::string topic;
+    std::string difficulty;
+    std::vector<Question> questions;
+    std::optional<QuizMetadata> metadata;
+};
+
+struct GradeBreakdownItem {
+    std::string criterion;
+    double awarded_points = 0.0;
+    double max_points = 0.0;
+    std::string reasoning;
+    std::optional<std::vector<std::string>> keywords;
+};
+
+struct GradeMetadata {
+    std::optional<std::string> source;
+    std::optional<std::string> graded_at;
+    std::optional<double> processing_time_ms;
+};
+
+struct GradePayload {
+    std::string question_id;
+    double total_score = 0.0;
+    double max_score = 0.0;
+    std::vector<GradeBreakdownItem> breakdown;
+    std::optional<std::string> feedback;
+    std::optional<GradeMetadata> metadata;
+};
+
+// Wire "type" value of a question ("multiple_choice", "short_answer", "fill_in_blank")
+const char* questionType(const Question& question);
+const std::string& questionId(const Question& question);
+const std::string& questionPrompt(const Question& question);
+
+// Streaming reader/writer for the wire format in core/schemas. The reader
+// checks structure and required fields (not value constraints; see
+// validation::) and skips unknown members.
+namespace quiz_io {
+
+// Receives every value the reader passes as a SAX event, so a schema
+// validator (SchemaEventValidator) can check the document in the same pass
+using ReadObserver = nlohmann::json_sax<nlohmann::json>;
+
+bool readQuiz(std::string_view json, Quiz& quiz, std::string& error_msg, ReadObserver* observer = nullptr);
+bool readQuestion(std::string_view json, Question& question, std::string& error_msg,
+                  ReadObserver* observer = nullptr);
+bool readGradePayload(std::string_view json, GradePayload& grade, std::string& error_msg,
+                      ReadObserver* observer = nullptr);
+
+std::string writeQuiz(const Quiz& quiz);
+std::string writeQuestion(const Question& question);
+std::string writeGradePayload(const GradePayload& grade);
+
+// DOM conversion for API boundaries that still speak nlohmann::json
+nlohmann::json toJson(const Quiz& quiz);
+nlohmann::json toJson(const Question& question);
+nlohmann::json toJson(const GradePayload& grade);
+
+bool fromJson(const nlohmann::json& json, Quiz& quiz, std::string& error_msg);
+bool fromJson(const nlohmann::json& json, Question& question, std::string& error_msg);
+bool fromJson(const nlohmann::json& json, GradePayload& grade, std::string& error_msg);
+
+} // namespace quiz_io
+
+} // namespace core
+} // namespace studyhive
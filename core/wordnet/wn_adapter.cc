@@ -1,8 +1,10 @@
 #include "wn_adapter.h"
+#include "../memory/memory_governor.h"
 #include <fstream>
 #include <sstream>
 #include <algorithm>
 #include <map>
+#include <mutex>
 
 namespace studyhive {
 namespace core {
@@ -18,7 +20,11 @@ public:
         // For now, create a mock implementation
         
         // Load basic word relationships
-        loadMockData();
+        {
+            std::lock_guard<std::mutex> lock(data_mutex_);
+            loadMockData();
+            loaded_ = true;
+        }
         
         initialized_ = true;
         return true;
@@ -30,6 +36,8 @@ public:
         if (!initialized_) return synonyms;
         
         // TODO: Implement actual WordNet lookup
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        ensureLoaded();
         // For now, use mock data
         auto it = mock_synonyms_.find(word);
         if (it != mock_synonyms_.end()) {
@@ -45,6 +53,8 @@ public:
         if (!initialized_) return antonyms;
         
         // TODO: Implement actual WordNet lookup
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        ensureLoaded();
         auto it = mock_antonyms_.find(word);
         if (it != mock_antonyms_.end()) {
             antonyms = it->second;
@@ -59,6 +69,8 @@ public:
         if (!initialized_) return hypernyms;
         
         // TODO: Implement actual WordNet lookup
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        ensureLoaded();
         auto it = mock_hypernyms_.find(word);
         if (it != mock_hypernyms_.end()) {
             hypernyms = it->second;
@@ -73,6 +85,8 @@ public:
         if (!initialized_) return hyponyms;
         
         // TODO: Implement actual WordNet lookup
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        ensureLoaded();
         auto it = mock_hyponyms_.find(word);
         if (it != mock_hyponyms_.end()) {
             hyponyms = it->second;
@@ -103,6 +117,8 @@ public:
         
         // TODO: Implement actual WordNet lookup
         // For now, check if word exists in our mock data
+        std::lock_guard<std::mutex> lock(data_mutex_);
+        ensureLoaded();
         return mock_synonyms_.find(word) != mock_synonyms_.end();
     }
 
@@ -152,9 +168,60 @@ public:
         return distractors;
     }
 
+    void attachMemoryGovernor(MemoryGovernor* governor) {
+        memory_registration_.reset();
+        if (!governor) return;
+
+        MemoryConsumer consumer;
+        consumer.name = "wordnet";
+        consumer.tier = ReclaimTier::CACHE;
+        consumer.usage = [this]() {
+            std::lock_guard<std::mutex> lock(data_mutex_);
+            return loaded_ ? indexBytes() : size_t(0);
+        };
+        consumer.shrink = [this](size_t) {
+            std::lock_guard<std::mutex> lock(data_mutex_);
+            if (!loaded_) return size_t(0);
+            size_t freed = indexBytes();
+            mock_synonyms_.clear();
+            mock_antonyms_.clear();
+            mock_hypernyms_.clear();
+            mock_hyponyms_.clear();
+            loaded_ = false;
+            return freed;
+        };
+        memory_registration_ = governor->registerConsumer(consumer);
+    }
+
 private:
     bool initialized_;
     std::string wordnet_path_;
+
+    // Guards the index, which the memory governor may drop from its own thread
+    std::mutex data_mutex_;
+    bool loaded_ = false;
+
+    // Caller holds data_mutex_
+    void ensureLoaded() {
+        if (!loaded_) {
+            loadMockData();
+            loaded_ = true;
+        }
+    }
+
+    // Approximate heap footprint of the index (strings plus map nodes); caller holds data_mutex_
+    size_t indexBytes() const {
+        size_t bytes = 0;
+        for (const auto* relation : {&mock_synonyms_, &mock_antonyms_, &mock_hypernyms_, &mock_hyponyms_}) {
+            for (const auto& [word, related] : *relation) {
+                bytes += 64 + sizeof(std::string) + word.capacity();
+                for (const auto& other : related) {
+                    bytes += sizeof(std::string) + other.capacity();
+                }
+            }
+        }
+        return bytes;
+    }
     
     // Mock data for demonstration
     std::map<std::string, std::vector<std::string>> mock_synonyms_;
@@ -191,6 +258,9 @@ private:
         mock_hyponyms_["color"] = {"red", "blue", "green", "yellow"};
         mock_hyponyms_["fruit"] = {"apple", "banana", "orange", "grape"};
     }
+
+    // Declared last: unregistered before the index its callbacks read is destroyed
+    std::unique_ptr<MemoryRegistration> memory_registration_;
 };
 
 // WordNetAdapter implementation
@@ -226,6 +296,10 @@ bool WordNetAdapter::wordExists(const std::string& word, const std::string& pos)
     return impl_->wordExists(word, pos);
 }
 
+void WordNetAdapter::attachMemoryGovernor(MemoryGovernor* governor) {
+    impl_->attachMemoryGovernor(governor);
+}
+
 std::vector<std::string> WordNetAdapter::getRelatedWords(const std::string& word, int max_count) {
     return impl_->getRelatedWords(word, max_count);
 }
@@ -258,7 +332,7 @@ std::vector<std::string> generateMCQDistractors(const std::string& correct_answe
     return distractors;
 }
 
-std::vector<std::string> findRelatedConcepts(const std::string& concept,
+std::vector<std::string> findRelatedConcepts(const std::string& target_concept,
                                            const std::vector<std::string>& available_concepts) {
     std::vector<std::string> related;
     
@@ -266,7 +340,7 @@ std::vector<std::string> findRelatedConcepts(const std::string& concept,
     // For now, use simple string similarity
     
     for (const auto& available_concept : available_concepts) {
-        if (available_concept != concept && !areWordsTooSimilar(concept, available_concept)) {
+        if (available_concept != target_concept && !areWordsTooSimilar(target_concept, available_concept)) {
             related.push_back(available_concept);
         }
     }
@@ -7,6 +7,8 @@
 namespace studyhive {
 namespace core {
 
+class MemoryGovernor;
+
 struct WordNetEntry {
     std::string word;
     std::string pos;  // part of speech: n, v, a, r
@@ -49,6 +51,10 @@ public:
     // Get words similar in meaning but different enough for distractors
     std::vector<std::string> getDistractorWords(const std::string& word, int max_count = 5);
 
+    // Register the in-memory index with the governor as a cache-tier consumer.
+    // A shrunk index is reloaded on the next lookup (null detaches).
+    void attachMemoryGovernor(MemoryGovernor* governor);
+
 private:
     class Impl;
     std::unique_ptr<Impl> impl_;
@@ -63,7 +69,7 @@ std::vector<std::string> generateMCQDistractors(const std::string& correct_answe
                                                int num_distractors = 3);
 
 // Find words related to a concept
-std::vector<std::string> findRelatedConcepts(const std::string& concept,
+std::vector<std::string> findRelatedConcepts(const std::string& target_concept,
                                            const std::vector<std::string>& available_concepts);
 
 // Check if two words are too similar (shouldn't be used as distractors)